@@ -0,0 +1,1062 @@
+/**
+ * @file bench.cpp
+ *
+ * Benchmarks de aed2::map, usando Google Benchmark.  Cada benchmark se corre
+ * también sobre std::map para tener una referencia; como el nombre de cada
+ * benchmark incluye el tipo del diccionario, los resultados de ambos quedan
+ * uno al lado del otro.
+ *
+ * Compilación:
+ * \code{.unparsed}
+ * g++ -std=c++17 -O2 -DNDEBUG bench.cpp -o bench -lbenchmark -lbenchmark_main -pthread
+ * \endcode
+ *
+ * Para seguir regresiones conviene guardar los resultados en JSON y compararlos
+ * con los de otra versión usando tools/compare.py de Google Benchmark:
+ * \code{.unparsed}
+ * ./bench --benchmark_out=antes.json --benchmark_out_format=json
+ * ./bench --benchmark_out=despues.json --benchmark_out_format=json
+ * compare.py benchmarks antes.json despues.json
+ * \endcode
+ *
+ * La suite completa tarda bastante con los tamaños más grandes; con
+ * --benchmark_filter se puede elegir un subconjunto (e.g., `--benchmark_filter=Buscar.+/1000000`).
+ */
+#include "map.h"
+#include "btree_map.h"
+#include "persistent_map.h"
+#include "concurrent_map.h"
+#include "sharded_map.h"
+#include "mapped_map.h"
+#include "flat_map.h"
+#include "frozen_map.h"
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+
+/////////////////////////////////////
+// Generación de datos de entrada  //
+/////////////////////////////////////
+
+/**
+ * @brief Devuelve las claves 0..n-1 en un orden aleatorio (pero fijo entre corridas).
+ */
+std::vector<int> clavesAleatorias(size_t n)
+{
+	std::vector<int> res(n);
+	for(size_t i = 0; i < n; ++i) res[i] = static_cast<int>(i);
+	std::shuffle(res.begin(), res.end(), std::mt19937(42));
+	return res;
+}
+
+/**
+ * @brief Significado grande (256 bytes), para medir el costo de mover y copiar valores.
+ */
+struct Grande
+{
+	std::array<std::uint64_t, 32> datos;
+};
+
+/**
+ * @brief Construye la clave asociada al entero \P{k}.  El orden de las claves es el
+ * de los enteros.
+ */
+template <typename T>
+T clave(int k);
+
+template <>
+int clave<int>(int k)
+{ return k; }
+
+template <>
+std::int64_t clave<std::int64_t>(int k)
+{ return std::int64_t(k) << 32; }
+
+template <>
+std::string clave<std::string>(int k)
+{
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "clave/%010d", k);
+	return buffer;
+}
+
+/**
+ * @brief Convierte los enteros de \P{ks} en claves, para no construirlas durante la medición.
+ */
+template <typename T>
+std::vector<T> claves(const std::vector<int>& ks)
+{
+	std::vector<T> res;
+	res.reserve(ks.size());
+	for(int k : ks) res.push_back(clave<T>(k));
+	return res;
+}
+
+/**
+ * @brief Construye el significado asociado a la clave \P{k}.
+ */
+template <typename T>
+T significado(int k);
+
+template <>
+int significado<int>(int k)
+{ return k; }
+
+template <>
+std::int64_t significado<std::int64_t>(int k)
+{ return k; }
+
+template <>
+std::string significado<std::string>(int k)
+{ return "significado " + std::to_string(k); }
+
+template <>
+Grande significado<Grande>(int k)
+{
+	Grande res{};
+	res.datos[0] = static_cast<std::uint64_t>(k);
+	return res;
+}
+
+template <typename MAP_T>
+void llenar(MAP_T& dicc, const std::vector<int>& claves)
+{
+	for(int k : claves) dicc.insert({clave<typename MAP_T::key_type>(k), significado<typename MAP_T::mapped_type>(k)});
+}
+
+/**
+ * Un aed2::flat_map se llena armando un aed2::map y congelándolo, como se usa en la práctica:
+ * insertar de a uno claves aleatorias costaría \O(n^2).
+ */
+template <typename K, typename V, typename C, typename A>
+void llenar(aed2::flat_map<K, V, C, A>& dicc, const std::vector<int>& claves)
+{
+	aed2::map<K, V, C, A> armado;
+	llenar(armado, claves);
+	dicc = aed2::freeze(std::move(armado));
+}
+
+/**
+ * Un aed2::frozen_map se arma a partir de un aed2::map, en O(n).
+ */
+template <typename K, typename V, typename C>
+void llenar(aed2::frozen_map<K, V, C>& dicc, const std::vector<int>& claves)
+{
+	aed2::map<K, V, C> armado;
+	llenar(armado, claves);
+	dicc = aed2::frozen_map<K, V, C>(armado);
+}
+
+/**
+ * @brief Tamaños de 10^3 a 10^7.
+ */
+void tamanios(benchmark::internal::Benchmark* b)
+{
+	for(int n = 1000; n <= 10000000; n *= 10) b->Arg(n);
+}
+
+/**
+ * @brief Tamaños de 10^3 a 10^6, para los diccionarios con valores grandes, donde 10^7
+ * valores (y su copia) no entran cómodamente en memoria.
+ */
+void tamaniosChicos(benchmark::internal::Benchmark* b)
+{
+	for(int n = 1000; n <= 1000000; n *= 10) b->Arg(n);
+}
+
+/**
+ * @brief Registra el benchmark \P{BM} para aed2::map y std::map, con claves enteras, claves
+ * std::string y significados grandes.
+ */
+#define BENCHMARK_DICCIONARIOS(BM) \
+	BENCHMARK_TEMPLATE(BM, aed2::map<int, int>)->Apply(tamanios); \
+	BENCHMARK_TEMPLATE(BM, std::map<int, int>)->Apply(tamanios); \
+	BENCHMARK_TEMPLATE(BM, aed2::map<std::string, int>)->Apply(tamanios); \
+	BENCHMARK_TEMPLATE(BM, std::map<std::string, int>)->Apply(tamanios); \
+	BENCHMARK_TEMPLATE(BM, aed2::map<int, Grande>)->Apply(tamaniosChicos); \
+	BENCHMARK_TEMPLATE(BM, std::map<int, Grande>)->Apply(tamaniosChicos)
+
+//////////////////////////////////////
+// Inserción                        //
+//////////////////////////////////////
+
+/**
+ * Tiempo de insertar state.range(0) valores, sin hint, en un diccionario vacío.  Con
+ * \P{aleatorio} las claves llegan en orden aleatorio; si no, en orden creciente.  La
+ * destrucción del diccionario no se mide.
+ */
+template <typename MAP_T, bool aleatorio>
+void insertarSinHint(benchmark::State& state)
+{
+	using K = typename MAP_T::key_type;
+	using V = typename MAP_T::mapped_type;
+	std::vector<int> orden = clavesAleatorias(state.range(0));
+	if(not aleatorio) std::sort(orden.begin(), orden.end());
+	std::vector<K> ks = claves<K>(orden);
+	V s = significado<V>(0);
+	for(auto _ : state) {
+		auto dicc = std::make_unique<MAP_T>();
+		for(const K& k : ks) dicc->insert({k, s});
+		state.PauseTiming();
+		dicc.reset();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename MAP_T>
+void BM_InsertarAleatorio(benchmark::State& state)
+{ insertarSinHint<MAP_T, true>(state); }
+
+template <typename MAP_T>
+void BM_InsertarSecuencial(benchmark::State& state)
+{ insertarSinHint<MAP_T, false>(state); }
+
+BENCHMARK_DICCIONARIOS(BM_InsertarAleatorio);
+BENCHMARK_DICCIONARIOS(BM_InsertarSecuencial);
+// aed2::persistent_map copia un camino por inserción
+BENCHMARK_TEMPLATE(BM_InsertarAleatorio, aed2::persistent_map<int, int>)->Apply(tamanios);
+
+/**
+ * Tiempo de insertar state.range(0) valores en orden creciente usando end() como hint,
+ * que en ese caso siempre es un buen hint.
+ */
+template <typename MAP_T>
+void BM_InsertarConHint(benchmark::State& state)
+{
+	using K = typename MAP_T::key_type;
+	using V = typename MAP_T::mapped_type;
+	std::vector<int> orden = clavesAleatorias(state.range(0));
+	std::sort(orden.begin(), orden.end());
+	std::vector<K> ks = claves<K>(orden);
+	V s = significado<V>(0);
+	for(auto _ : state) {
+		auto dicc = std::make_unique<MAP_T>();
+		for(const K& k : ks) dicc->insert(dicc->end(), {k, s});
+		state.PauseTiming();
+		dicc.reset();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DICCIONARIOS(BM_InsertarConHint);
+
+//////////////////////////////////////
+// Búsquedas                        //
+//////////////////////////////////////
+
+/**
+ * Llamadas a find, en orden aleatorio, sobre un diccionario con las claves pares
+ * 0..2n-2.  Con \P{acierto} las claves buscadas existen; si no, son las impares.
+ */
+template <typename MAP_T, bool acierto>
+void buscar(benchmark::State& state)
+{
+	using K = typename MAP_T::key_type;
+	size_t n = state.range(0);
+	std::vector<int> orden = clavesAleatorias(n);
+	MAP_T dicc;
+	for(int k : orden) dicc.insert({clave<K>(2 * k), significado<typename MAP_T::mapped_type>(k)});
+	for(int& k : orden) k = 2 * k + (acierto ? 0 : 1);
+	std::vector<K> buscadas = claves<K>(orden);
+
+	size_t i = 0;
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(dicc.find(buscadas[i]));
+		if(++i == n) i = 0;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template <typename MAP_T>
+void BM_BuscarAcierto(benchmark::State& state)
+{ buscar<MAP_T, true>(state); }
+
+template <typename MAP_T>
+void BM_BuscarFallo(benchmark::State& state)
+{ buscar<MAP_T, false>(state); }
+
+BENCHMARK_DICCIONARIOS(BM_BuscarAcierto);
+BENCHMARK_DICCIONARIOS(BM_BuscarFallo);
+
+/**
+ * Llamadas a lower_bound, en orden aleatorio, con claves que no están en el diccionario
+ * (las impares, sobre un diccionario con las claves pares).
+ */
+template <typename MAP_T>
+void BM_LowerBound(benchmark::State& state)
+{
+	using K = typename MAP_T::key_type;
+	size_t n = state.range(0);
+	std::vector<int> orden = clavesAleatorias(n);
+	MAP_T dicc;
+	for(int k : orden) dicc.insert({clave<K>(2 * k), significado<typename MAP_T::mapped_type>(k)});
+	for(int& k : orden) k = 2 * k + 1;
+	std::vector<K> buscadas = claves<K>(orden);
+
+	size_t i = 0;
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(dicc.lower_bound(buscadas[i]));
+		if(++i == n) i = 0;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DICCIONARIOS(BM_LowerBound);
+
+/**
+ * Llamadas a operator[] con claves existentes, en orden aleatorio.
+ */
+template <typename MAP_T>
+void BM_OperadorCorchetesAcierto(benchmark::State& state)
+{
+	using K = typename MAP_T::key_type;
+	size_t n = state.range(0);
+	std::vector<int> orden = clavesAleatorias(n);
+	MAP_T dicc;
+	llenar(dicc, orden);
+	std::vector<K> buscadas = claves<K>(orden);
+
+	size_t i = 0;
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(dicc[buscadas[i]]);
+		if(++i == n) i = 0;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DICCIONARIOS(BM_OperadorCorchetesAcierto);
+
+//////////////////////////////////////
+// Borrado                          //
+//////////////////////////////////////
+
+/**
+ * Tiempo de borrar, por clave y en orden aleatorio, todos los valores de un diccionario
+ * de state.range(0) elementos.  La construcción no se mide.
+ */
+template <typename MAP_T>
+void BM_Borrar(benchmark::State& state)
+{
+	using K = typename MAP_T::key_type;
+	std::vector<int> orden = clavesAleatorias(state.range(0));
+	std::vector<K> ks = claves<K>(orden);
+	std::shuffle(ks.begin(), ks.end(), std::mt19937(7));
+	for(auto _ : state) {
+		state.PauseTiming();
+		MAP_T dicc;
+		llenar(dicc, orden);
+		state.ResumeTiming();
+		for(const K& k : ks) dicc.erase(k);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DICCIONARIOS(BM_Borrar);
+
+//////////////////////////////////////
+// Recorrido, copia y vaciado       //
+//////////////////////////////////////
+
+/**
+ * Tiempo de recorrer con iteradores un diccionario de state.range(0) elementos.
+ */
+template <typename MAP_T>
+void BM_Recorrer(benchmark::State& state)
+{
+	MAP_T dicc;
+	llenar(dicc, clavesAleatorias(state.range(0)));
+	for(auto _ : state) {
+		for(const auto& v : dicc) benchmark::DoNotOptimize(&v);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DICCIONARIOS(BM_Recorrer);
+BENCHMARK_TEMPLATE(BM_Recorrer, aed2::flat_map<int, int>)->Apply(tamanios);
+
+/**
+ * Tiempo de copiar (con el constructor por copia) un diccionario de state.range(0)
+ * elementos.  La destrucción de la copia no se mide.
+ */
+template <typename MAP_T>
+void BM_Copiar(benchmark::State& state)
+{
+	MAP_T dicc;
+	llenar(dicc, clavesAleatorias(state.range(0)));
+	for(auto _ : state) {
+		auto copia = std::make_unique<MAP_T>(dicc);
+		state.PauseTiming();
+		copia.reset();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DICCIONARIOS(BM_Copiar);
+// En aed2::persistent_map la copia (snapshot) comparte todos los nodos y cuesta O(1)
+BENCHMARK_TEMPLATE(BM_Copiar, aed2::persistent_map<int, int>)->Apply(tamanios);
+
+/**
+ * Tiempo de vaciar con clear un diccionario de state.range(0) elementos.  El llenado
+ * no se mide.
+ */
+template <typename MAP_T>
+void BM_Clear(benchmark::State& state)
+{
+	std::vector<int> orden = clavesAleatorias(state.range(0));
+	MAP_T dicc;
+	for(auto _ : state) {
+		state.PauseTiming();
+		llenar(dicc, orden);
+		state.ResumeTiming();
+		dicc.clear();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DICCIONARIOS(BM_Clear);
+
+/////////////////
+// Destrucción //
+/////////////////
+
+/**
+ * Tiempo de destruir un diccionario de state.range(0) elementos.  La construcción
+ * no se mide.
+ */
+template <typename MAP_T>
+void BM_Destructor(benchmark::State& state)
+{
+	auto claves = clavesAleatorias(state.range(0));
+	for(auto _ : state) {
+		state.PauseTiming();
+		auto* dicc = new MAP_T();
+		llenar(*dicc, claves);
+		state.ResumeTiming();
+		delete dicc;
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// La construcción domina el tiempo de cada iteración, así que fijamos pocas iteraciones.
+BENCHMARK_TEMPLATE(BM_Destructor, aed2::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Iterations(10);
+BENCHMARK_TEMPLATE(BM_Destructor, std::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Iterations(10);
+BENCHMARK_TEMPLATE(BM_Destructor, aed2::map<int, std::string>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Iterations(10);
+BENCHMARK_TEMPLATE(BM_Destructor, std::map<int, std::string>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Iterations(10);
+
+///////////////////////////////////////////
+// operator[]: comparaciones por llamada //
+///////////////////////////////////////////
+
+/**
+ * @brief Comparador de enteros que cuenta sus invocaciones en una variable global.
+ */
+size_t comparaciones = 0;
+
+struct ContadorCompare
+{
+	bool operator () (int a, int b) const
+	{
+		++comparaciones;
+		return a < b;
+	}
+};
+
+/**
+ * Llamadas a operator[] sobre un diccionario con las claves pares 0..2n-2.  Con
+ * state.range(1) == 0 las claves buscadas existen (hit); con state.range(1) == 1
+ * son impares y se insertan (miss; se borran fuera de la medición).  El contador
+ * comparaciones_por_llamada reporta cuántas veces se invocó al comparador.
+ */
+template <typename MAP_T>
+void BM_OperadorCorchetes(benchmark::State& state)
+{
+	size_t n = state.range(0);
+	bool miss = state.range(1) == 1;
+	MAP_T dicc;
+	auto claves = clavesAleatorias(n);
+	for(int k : claves) dicc[2 * k] = k;
+
+	size_t llamadas = 0;
+	comparaciones = 0;
+	size_t comparaciones_medidas = 0;
+	for(auto _ : state) {
+		for(size_t i = 0; i < 64; ++i) {
+			int k = 2 * claves[(llamadas + i) % n] + (miss ? 1 : 0);
+			benchmark::DoNotOptimize(dicc[k]);
+		}
+		llamadas += 64;
+		comparaciones_medidas += comparaciones;
+		if(miss) {
+			state.PauseTiming();
+			for(size_t i = 0; i < 64; ++i) dicc.erase(2 * claves[(llamadas - 64 + i) % n] + 1);
+			state.ResumeTiming();
+		}
+		comparaciones = 0;
+	}
+	state.counters["comparaciones_por_llamada"] = static_cast<double>(comparaciones_medidas) / llamadas;
+	state.SetItemsProcessed(llamadas);
+}
+
+BENCHMARK_TEMPLATE(BM_OperadorCorchetes, aed2::map<int, int, ContadorCompare>)
+	->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_OperadorCorchetes, std::map<int, int, ContadorCompare>)
+	->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {0, 1}});
+
+//////////////////////////////////////
+// Búsquedas con claves std::string //
+//////////////////////////////////////
+
+/**
+ * Llamadas a find y lower_bound sobre un diccionario de state.range(0) claves
+ * std::string con un prefijo común largo, de forma que cada comparación recorra
+ * varios caracteres.  Con std::less<std::string>, aed2::map compara de a tres vías.
+ */
+template <typename MAP_T>
+void BM_BusquedaString(benchmark::State& state)
+{
+	size_t n = state.range(0);
+	auto claves = clavesAleatorias(n);
+	std::vector<std::string> buscadas;
+	MAP_T dicc;
+	for(int k : claves) {
+		buscadas.push_back("prefijo/compartido/por/todas/las/claves/" + std::to_string(k));
+		dicc[buscadas.back()] = k;
+	}
+
+	size_t i = 0;
+	for(auto _ : state) {
+		const std::string& k = buscadas[i++ % n];
+		benchmark::DoNotOptimize(dicc.find(k));
+		benchmark::DoNotOptimize(dicc.lower_bound(k));
+	}
+	state.SetItemsProcessed(state.iterations() * 2);
+}
+
+BENCHMARK_TEMPLATE(BM_BusquedaString, aed2::map<std::string, int>)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_BusquedaString, std::map<std::string, int>)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+
+/**
+ * Como BM_BusquedaString, pero las claves buscadas llegan como std::string_view sobre un
+ * único buffer, como las que arma un parser.  Con std::less<> la búsqueda es heterogénea;
+ * con std::less<std::string> hay que construir (y pedir memoria para) un std::string por llamada.
+ */
+template <typename MAP_T>
+void BM_BusquedaStringView(benchmark::State& state)
+{
+	size_t n = state.range(0);
+	auto claves = clavesAleatorias(n);
+	std::string buffer;
+	std::vector<std::pair<size_t, size_t>> posiciones;
+	MAP_T dicc;
+	for(int k : claves) {
+		std::string clave = "prefijo/compartido/por/todas/las/claves/" + std::to_string(k);
+		posiciones.emplace_back(buffer.size(), clave.size());
+		buffer += clave;
+		dicc[clave] = k;
+	}
+
+	size_t i = 0;
+	for(auto _ : state) {
+		auto [desde, largo] = posiciones[i++ % n];
+		std::string_view k(buffer.data() + desde, largo);
+		if constexpr(std::is_same_v<typename MAP_T::key_compare, std::less<>>) {
+			benchmark::DoNotOptimize(dicc.find(k));
+		} else {
+			benchmark::DoNotOptimize(dicc.find(std::string(k)));
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_BusquedaStringView, aed2::map<std::string, int>)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_BusquedaStringView, aed2::map<std::string, int, std::less<>>)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_BusquedaStringView, std::map<std::string, int, std::less<>>)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+
+/////////////////////////////////////////
+// Búsquedas en diccionarios grandes   //
+/////////////////////////////////////////
+
+/**
+ * Llamadas a lower_bound en orden aleatorio sobre un diccionario de state.range(0)
+ * claves enteras.  Con millones de claves el árbol no entra en cache y el tiempo
+ * de cada búsqueda lo dominan los cache misses de cada nivel descendido; aed2::btree_map
+ * desciende muchos menos niveles que los árboles binarios, y aed2::frozen_map superpone
+ * los misses de los últimos niveles con prefetch.
+ */
+template <typename MAP_T>
+void BM_LowerBoundAleatorio(benchmark::State& state)
+{
+	size_t n = state.range(0);
+	auto orden = clavesAleatorias(n);
+	MAP_T dicc;
+	llenar(dicc, orden);
+	auto buscadas = claves<typename MAP_T::key_type>(orden);
+
+	size_t i = 0;
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(dicc.lower_bound(buscadas[i++ % n]));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::btree_map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, std::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::flat_map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::frozen_map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+/**
+ * Comparador equivalente a std::less, pero que aed2::simd_key_search no reconoce:
+ * fuerza a aed2::btree_map a buscar dentro de los nodos con la búsqueda binaria escalar.
+ */
+template <typename T>
+struct MenorEscalar : std::less<T> {};
+
+/**
+ * Búsqueda dentro de los nodos de aed2::btree_map: comparación vectorial contra toda
+ * la fila de claves del nodo vs. búsqueda binaria escalar, para claves de 32 y 64 bits.
+ */
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::btree_map<int, int, MenorEscalar<int>>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::btree_map<std::int64_t, std::int64_t>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_LowerBoundAleatorio, aed2::btree_map<std::int64_t, std::int64_t, MenorEscalar<std::int64_t>>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+/**
+ * aed2::map::find_batch sobre state.range(0) claves enteras, buscando de a state.range(1)
+ * claves aleatorias por llamada (la mitad existentes).  Con lotes de 1 clave se llama a find,
+ * que es la referencia: los descensos se hacen de a uno y sus cache misses se esperan en serie.
+ */
+void BM_BuscarEnLotes(benchmark::State& state)
+{
+	size_t n = state.range(0), lote = state.range(1);
+	auto orden = clavesAleatorias(n);
+	aed2::map<int, int> dicc;
+	for(int k : orden) dicc.insert({2 * k, k});
+	for(size_t i = 0; i < n; i += 2) orden[i] = 2 * orden[i] + 1;
+	for(size_t i = 1; i < n; i += 2) orden[i] = 2 * orden[i];
+	std::vector<aed2::map<int, int>::iterator> res(lote);
+
+	size_t i = 0;
+	for(auto _ : state) {
+		if(i + lote > n) i = 0;
+		if(lote == 1) {
+			res[0] = dicc.find(orden[i]);
+		} else {
+			dicc.find_batch(orden.begin() + i, orden.begin() + i + lote, res.begin());
+		}
+		benchmark::DoNotOptimize(res.data());
+		i += lote;
+	}
+	state.SetItemsProcessed(state.iterations() * lote);
+}
+
+BENCHMARK(BM_BuscarEnLotes)->ArgsProduct({{1 << 16, 1 << 22}, {1, 4, 16, 64, 256}});
+
+/**
+ * Inserción de un lote ordenado de state.range(1) claves, repartidas entre las 2^20 de un
+ * aed2::map, con insert_sorted_batch (state.range(0) == 1) o insertando de a una
+ * (state.range(0) == 0).  Fuera de la medición se borran las claves insertadas.  Con
+ * lotes densos insert_sorted_batch compara mucho menos, lo que se nota con claves
+ * std::string; con claves enteras las comparaciones son baratas y domina el costo de
+ * recorrer el árbol.
+ */
+template <typename K>
+void BM_InsertarLoteOrdenado(benchmark::State& state)
+{
+	bool conDedo = state.range(0) == 1;
+	int n = 1 << 20, m = state.range(1);
+	aed2::map<K, int> dicc;
+	for(int k : clavesAleatorias(n)) dicc.insert({clave<K>(2 * k), k});
+	std::vector<std::pair<K, int>> lote;
+	for(int i = 0; i < m; ++i) lote.push_back({clave<K>(2 * int(std::int64_t(i) * n / m) + 1), i});
+
+	for(auto _ : state) {
+		if(conDedo) {
+			dicc.insert_sorted_batch(lote.begin(), lote.end());
+		} else {
+			for(auto& v : lote) dicc.insert(v);
+		}
+		state.PauseTiming();
+		for(auto& v : lote) dicc.erase(v.first);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * m);
+}
+
+BENCHMARK_TEMPLATE(BM_InsertarLoteOrdenado, int)->ArgsProduct({{0, 1}, {1 << 8, 1 << 12, 1 << 16, 1 << 19}});
+BENCHMARK_TEMPLATE(BM_InsertarLoteOrdenado, std::string)->ArgsProduct({{0, 1}, {1 << 8, 1 << 12, 1 << 16, 1 << 19}});
+
+/////////////////////////////////////////
+// Construcción desde un rango ordenado //
+/////////////////////////////////////////
+
+/**
+ * Tiempo de construir un diccionario de state.range(0) elementos a partir de un
+ * vector ordenado, con el constructor por rango.  aed2::map detecta que el rango
+ * está ordenado y arma el árbol balanceado sin insertar.
+ */
+template <typename MAP_T>
+void BM_ConstruirOrdenado(benchmark::State& state)
+{
+	std::vector<std::pair<int, int>> valores;
+	for(int i = 0; i < state.range(0); ++i) valores.push_back({i, i});
+	for(auto _ : state) {
+		MAP_T dicc(valores.begin(), valores.end());
+		benchmark::DoNotOptimize(dicc);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_ConstruirOrdenado, aed2::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_ConstruirOrdenado, std::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+/**
+ * Tiempo de congelar (aed2::freeze) un aed2::map de state.range(0) elementos en un
+ * aed2::flat_map.
+ */
+void BM_Congelar(benchmark::State& state)
+{
+	aed2::map<int, int> dicc;
+	llenar(dicc, clavesAleatorias(state.range(0)));
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(aed2::freeze(dicc));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Congelar)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+//////////////////////
+// Archivos mapeados //
+//////////////////////
+
+/**
+ * Escribe en un archivo temporal un aed2::mapped_map<int, int> con las claves pares de
+ * 0 a 2 * (\P{n} - 1) y devuelve su ruta.
+ */
+std::string escribirArchivo(size_t n)
+{
+	std::vector<std::pair<int, int>> valores;
+	for(size_t i = 0; i < n; ++i) valores.push_back({2 * static_cast<int>(i), static_cast<int>(i)});
+	std::string ruta = "/tmp/aed2_bench_" + std::to_string(n) + ".map";
+	aed2::mapped_map<int, int>::write(ruta, valores.begin(), valores.end());
+	return ruta;
+}
+
+/**
+ * Tiempo de abrir un archivo de state.range(0) valores y hacer 1000 búsquedas.  Con
+ * \P{mapear}, el archivo se abre como aed2::mapped_map y se busca directamente en el mapeo;
+ * si no, se carga en un aed2::map con el constructor de rangos ordenados, que es lo más
+ * rápido que se puede reconstruir el árbol en memoria.
+ */
+template <bool mapear>
+void BM_AbrirArchivo(benchmark::State& state)
+{
+	std::string ruta = escribirArchivo(state.range(0));
+	std::mt19937 gen(state.range(0));
+	for(auto _ : state) {
+		aed2::mapped_map<int, int> archivo(ruta);
+		size_t encontrados = 0;
+		if constexpr(mapear) {
+			for(int i = 0; i < 1000; ++i) encontrados += archivo.count(static_cast<int>(gen() % (2 * state.range(0))));
+		} else {
+			aed2::map<int, int> dicc(aed2::sorted_unique, archivo.begin(), archivo.end());
+			for(int i = 0; i < 1000; ++i) encontrados += dicc.find(static_cast<int>(gen() % (2 * state.range(0)))) != dicc.end();
+		}
+		benchmark::DoNotOptimize(encontrados);
+	}
+	std::remove(ruta.c_str());
+}
+
+BENCHMARK_TEMPLATE(BM_AbrirArchivo, true)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_AbrirArchivo, false)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+///////////////////
+// Serialización //
+///////////////////
+
+/**
+ * @brief streambuf que escribe en un std::string reservado de antemano, para no medir las
+ * realocaciones de std::stringstream.
+ */
+struct BufferDeEscritura : std::streambuf
+{
+	std::string datos;
+
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		datos.append(s, static_cast<size_t>(n));
+		return n;
+	}
+};
+
+/**
+ * @brief streambuf que lee de un bloque de memoria sin copiarlo.
+ */
+struct BufferDeLectura : std::streambuf
+{
+	BufferDeLectura(const std::string& datos)
+	{
+		char* p = const_cast<char*>(datos.data());
+		setg(p, p, p + datos.size());
+	}
+};
+
+/**
+ * Tiempo de serializar un aed2::map<int, int> de state.range(0) claves al azar con la
+ * codificación \P{cod}.  Los bytes procesados son los de la salida.
+ */
+template <aed2::serial_encoding cod>
+void BM_Serializar(benchmark::State& state)
+{
+	aed2::map<int, int> dicc;
+	llenar(dicc, clavesAleatorias(state.range(0)));
+	BufferDeEscritura buffer;
+	std::ostream os(&buffer);
+	for(auto _ : state) {
+		buffer.datos.clear();
+		dicc.serialize(os, cod);
+	}
+	state.SetBytesProcessed(state.iterations() * buffer.datos.size());
+	state.counters["bytes/valor"] = static_cast<double>(buffer.datos.size()) / state.range(0);
+}
+
+/**
+ * Tiempo de cargar con deserialize un aed2::map<int, int> de state.range(0) claves al azar
+ * serializado con la codificación \P{cod}, incluida la destrucción del diccionario anterior.
+ */
+template <aed2::serial_encoding cod>
+void BM_Deserializar(benchmark::State& state)
+{
+	aed2::map<int, int> dicc;
+	llenar(dicc, clavesAleatorias(state.range(0)));
+	BufferDeEscritura buffer;
+	std::ostream os(&buffer);
+	dicc.serialize(os, cod);
+	for(auto _ : state) {
+		BufferDeLectura lectura(buffer.datos);
+		std::istream is(&lectura);
+		dicc.deserialize(is);
+	}
+	state.SetBytesProcessed(state.iterations() * buffer.datos.size());
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_Serializar, aed2::serial_encoding::fixed)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Serializar, aed2::serial_encoding::varint)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Deserializar, aed2::serial_encoding::fixed)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Deserializar, aed2::serial_encoding::varint)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+//////////////////////////
+// Borrado de un rango //
+//////////////////////////
+
+/**
+ * Tiempo de borrar con erase(first, last) la mitad central de un diccionario de
+ * state.range(0) elementos.  aed2::map separa el rango partiendo el árbol y une
+ * los extremos, con lo cual no rebalancea por cada valor borrado.
+ */
+template <typename MAP_T>
+void BM_BorrarRango(benchmark::State& state)
+{
+	std::vector<std::pair<int, int>> valores;
+	for(int i = 0; i < state.range(0); ++i) valores.push_back({i, i});
+	for(auto _ : state) {
+		state.PauseTiming();
+		{
+			MAP_T dicc(valores.begin(), valores.end());
+			auto first = dicc.find(state.range(0) / 4), last = dicc.find(3 * state.range(0) / 4);
+			state.ResumeTiming();
+			dicc.erase(first, last);
+			benchmark::DoNotOptimize(dicc);
+			state.PauseTiming();
+		}
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * (state.range(0) / 2));
+}
+
+BENCHMARK_TEMPLATE(BM_BorrarRango, aed2::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_BorrarRango, std::map<int, int>)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+/////////////////////////////
+// Unión de diccionarios //
+/////////////////////////////
+
+struct Secuencial {};
+struct Paralela {};
+
+void fusionar(std::map<int, int>& dicc, std::map<int, int>& otro, Secuencial) { dicc.merge(otro); }
+void fusionar(aed2::map<int, int>& dicc, aed2::map<int, int>& otro, Secuencial) { dicc.merge(std::move(otro)); }
+void fusionar(aed2::map<int, int>& dicc, aed2::map<int, int>& otro, Paralela) { dicc.merge(aed2::parallel, std::move(otro)); }
+
+/**
+ * Tiempo de fusionar un diccionario de state.range(0) claves al azar con otro de
+ * state.range(0) / state.range(1) claves al azar.  std::map::merge inserta los
+ * nodos de a uno; aed2::map::merge parte y une los árboles, con lo cual cuesta
+ * menos cuanto más chico es el otro diccionario, y con aed2::parallel reparte las
+ * llamadas recursivas entre los hilos disponibles.
+ */
+template <typename MAP_T, typename MODO>
+void BM_Fusionar(benchmark::State& state)
+{
+	std::mt19937 gen(7);
+	MAP_T grande, chico;
+	while(grande.size() < static_cast<size_t>(state.range(0))) grande.insert({static_cast<int>(gen()), 0});
+	while(chico.size() < static_cast<size_t>(state.range(0) / state.range(1))) chico.insert({static_cast<int>(gen()), 1});
+	for(auto _ : state) {
+		state.PauseTiming();
+		{
+			MAP_T dicc = grande, otro = chico;
+			state.ResumeTiming();
+			fusionar(dicc, otro, MODO{});
+			benchmark::DoNotOptimize(dicc);
+			state.PauseTiming();
+		}
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * (state.range(0) / state.range(1)));
+}
+
+void tamaniosFusion(benchmark::internal::Benchmark* b)
+{
+	for(int n = 1 << 14; n <= 1 << 20; n <<= 3)
+		for(int proporcion : {1, 16, 1024})
+			b->Args({n, proporcion});
+}
+
+BENCHMARK_TEMPLATE(BM_Fusionar, aed2::map<int, int>, Secuencial)->Apply(tamaniosFusion)->Iterations(20);
+BENCHMARK_TEMPLATE(BM_Fusionar, aed2::map<int, int>, Paralela)->Apply(tamaniosFusion)->Iterations(20)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Fusionar, std::map<int, int>, Secuencial)->Apply(tamaniosFusion)->Iterations(20);
+
+////////////////////////////
+// Lecturas concurrentes //
+////////////////////////////
+
+/**
+ * aed2::map protegido con un único mutex, que es la forma de compartirlo entre
+ * hilos sin aed2::concurrent_map.
+ */
+class MapConMutex
+{
+public:
+	bool contains(int k)
+	{
+		std::lock_guard<std::mutex> lock(m);
+		return dicc.find(k) != dicc.end();
+	}
+
+	void insert_or_assign(int k, int v)
+	{
+		std::lock_guard<std::mutex> lock(m);
+		dicc.insert_or_assign(k, v);
+	}
+
+private:
+	aed2::map<int, int> dicc;
+	std::mutex m;
+};
+
+/** Cantidad de claves de los diccionarios compartidos */
+const int clavesCompartidas = 1 << 20;
+
+/** Llena \P{dicc} con las claves pares menores a 2 * clavesCompartidas */
+template <typename DICC_T>
+bool llenarCompartido(DICC_T& dicc)
+{
+	for(int i = 0; i < clavesCompartidas; ++i) dicc.insert_or_assign(2 * i, i);
+	return true;
+}
+
+/**
+ * Throughput de búsquedas al azar (la mitad exitosas) sobre un diccionario de
+ * clavesCompartidas claves compartido por todos los hilos.  Si conEscritor, el
+ * hilo 0 redefine claves al azar en lugar de buscar.  Con un mutex las búsquedas
+ * se serializan; con aed2::concurrent_map cada hilo usa su propio contador de
+ * lectores y las búsquedas escalan con la cantidad de núcleos.
+ */
+template <typename DICC_T, bool conEscritor>
+void BM_LecturasConcurrentes(benchmark::State& state)
+{
+	static DICC_T dicc;
+	static bool lleno = llenarCompartido(dicc);
+	benchmark::DoNotOptimize(lleno);
+	std::mt19937 gen(state.thread_index());
+	if(conEscritor and state.thread_index() == 0) {
+		for(auto _ : state) {
+			int k = 2 * static_cast<int>(gen() % clavesCompartidas);
+			dicc.insert_or_assign(k, k);
+		}
+		state.SetLabel("con un escritor");
+	} else {
+		size_t encontrados = 0;
+		for(auto _ : state) {
+			encontrados += dicc.contains(static_cast<int>(gen() % (2 * clavesCompartidas)));
+		}
+		benchmark::DoNotOptimize(encontrados);
+		state.SetItemsProcessed(state.iterations());
+	}
+}
+
+BENCHMARK_TEMPLATE(BM_LecturasConcurrentes, aed2::concurrent_map<int, int>, false)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LecturasConcurrentes, MapConMutex, false)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LecturasConcurrentes, aed2::concurrent_map<int, int>, true)->ThreadRange(2, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LecturasConcurrentes, MapConMutex, true)->ThreadRange(2, 32)->UseRealTime();
+
+/////////////////////////////
+// Escrituras concurrentes //
+/////////////////////////////
+
+/**
+ * aed2::sharded_map con 64 fragmentos del mismo ancho sobre las claves de
+ * BM_EscriturasConcurrentes.
+ */
+class MapFragmentado : public aed2::sharded_map<int, int>
+{
+public:
+	MapFragmentado() : aed2::sharded_map<int, int>(limites()) {}
+
+private:
+	static std::vector<int> limites()
+	{
+		std::vector<int> res;
+		for(int i = 1; i < 64; ++i) res.push_back(i * (2 * clavesCompartidas / 64));
+		return res;
+	}
+};
+
+/**
+ * Throughput de redefiniciones de claves al azar sobre un diccionario de
+ * clavesCompartidas claves compartido por todos los hilos.  Con un mutex o con
+ * aed2::concurrent_map las escrituras se ejecutan de a una; con aed2::sharded_map
+ * sólo compiten las escrituras que caen en el mismo fragmento.
+ */
+template <typename DICC_T>
+void BM_EscriturasConcurrentes(benchmark::State& state)
+{
+	static DICC_T dicc;
+	static bool lleno = llenarCompartido(dicc);
+	benchmark::DoNotOptimize(lleno);
+	std::mt19937 gen(state.thread_index());
+	for(auto _ : state) {
+		int k = 2 * static_cast<int>(gen() % clavesCompartidas);
+		dicc.insert_or_assign(k, k);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_EscriturasConcurrentes, MapFragmentado)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_EscriturasConcurrentes, MapConMutex)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_EscriturasConcurrentes, aed2::concurrent_map<int, int>)->ThreadRange(1, 32)->UseRealTime();
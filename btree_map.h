@@ -0,0 +1,1848 @@
+/**
+ * @file btree_map.h
+ *
+ * Módulo C++ que implementa un diccionario ordenado sobre un árbol B+, con la misma interfaz
+ * que aed2::map.
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef BTREE_MAP_H_
+#define BTREE_MAP_H_
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <cassert>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace aed2{
+
+/**
+ * @brief Búsqueda vectorial (SIMD) de claves dentro de un nodo.
+ *
+ * Indica si las claves de tipo \T{Key} ordenadas con \T{Compare} se pueden contar con instrucciones vectoriales.
+ * Cuando \P{value} es true, menores<paso>(k, n, x) devuelve la cantidad de claves menores a \P{x} entre las \P{n}
+ * claves k[0], k[paso], ..., k[(n - 1) \CDOT paso], y noMayores<paso>(k, n, x) la de claves menores o iguales.  Como
+ * las claves de un nodo están ordenadas, estas cantidades son la posición de lower_bound y upper_bound.
+ *
+ * En lugar de una búsqueda binaria, cuyos saltos dependen de cada comparación y el procesador predice mal, se
+ * compara \P{x} contra todas las claves de a varias por instrucción (con AVX2 si el compilador lo habilita, e.g.
+ * con `-mavx2` o `-march=native`, o si no con SSE2, o con SSE4.2 para claves de 8 bytes), y se suman los carriles
+ * que resultaron menores.  Un \P{paso} de 2 permite contar las claves de los valores de una hoja cuando cada
+ * significado ocupa lo mismo que una clave: cada vector tiene claves y significados intercalados, y la máscara
+ * se queda sólo con los carriles de las claves.  Sin instrucciones vectoriales (o con \P{paso} mayor a 2) se
+ * cuenta con un ciclo sin saltos condicionales.
+ *
+ * La búsqueda vectorial está disponible cuando \T{Key} es un entero de 4 u 8 bytes y \T{Compare} es
+ * std::less<Key> o std::less<>.  En cualquier otro caso \P{value} es false y aed2::btree_map usa búsquedas
+ * binarias.
+ */
+template<class Key, class Compare, class = void>
+struct simd_key_search {
+    static constexpr bool value = false;
+};
+
+/** \overload */
+template<class Key, class Compare>
+struct simd_key_search<Key, Compare, std::enable_if_t<std::is_integral<Key>::value and (sizeof(Key) == 4 or sizeof(Key) == 8)
+        and (std::is_same<Compare, std::less<Key>>::value or std::is_same<Compare, std::less<>>::value)>> {
+    static constexpr bool value = true;
+
+    /** @brief Cantidad de claves menores a \P{x} entre k[0], k[paso], ..., k[(n - 1) \CDOT paso] */
+    template<size_t paso = 1>
+    static size_t menores(const Key* k, size_t n, Key x) {
+        return contar<paso, true>(k, n, x);
+    }
+
+    /** @brief Cantidad de claves menores o iguales a \P{x} entre k[0], k[paso], ..., k[(n - 1) \CDOT paso] */
+    template<size_t paso = 1>
+    static size_t noMayores(const Key* k, size_t n, Key x) {
+        return contar<paso, false>(k, n, x);
+    }
+
+private:
+#if defined(__AVX2__)
+    /** \brief Vectores de 256 bits */
+    struct Registro {
+        static constexpr bool disponible = true;
+        static constexpr size_t carriles = 32 / sizeof(Key);
+        static __m256i cargar(const Key* p) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        }
+        static __m256i repetir(Key x) {
+            if constexpr(sizeof(Key) == 4) return _mm256_set1_epi32(static_cast<std::int32_t>(x));
+            else return _mm256_set1_epi64x(static_cast<long long>(x));
+        }
+        /** \brief Carriles en -1 donde \P{a} es mayor que \P{b} (comparando con signo) y en 0 donde no */
+        static __m256i mayores(__m256i a, __m256i b) {
+            if constexpr(sizeof(Key) == 4) return _mm256_cmpgt_epi32(a, b);
+            else return _mm256_cmpgt_epi64(a, b);
+        }
+        static __m256i restar(__m256i a, __m256i b) {
+            if constexpr(sizeof(Key) == 4) return _mm256_sub_epi32(a, b);
+            else return _mm256_sub_epi64(a, b);
+        }
+        static __m256i cero() { return _mm256_setzero_si256(); }
+        static __m256i y(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+        static __m256i desplazar(__m256i a, __m256i sesgo) { return _mm256_xor_si256(a, sesgo); }
+        static void guardar(Key* p, __m256i a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+    };
+#elif defined(__SSE2__)
+    /** \brief Vectores de 128 bits.  La comparación de enteros de 8 bytes requiere SSE4.2 */
+    struct Registro {
+#if defined(__SSE4_2__)
+        static constexpr bool disponible = true;
+#else
+        static constexpr bool disponible = sizeof(Key) == 4;
+#endif
+        static constexpr size_t carriles = 16 / sizeof(Key);
+        static __m128i cargar(const Key* p) {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        }
+        static __m128i repetir(Key x) {
+            if constexpr(sizeof(Key) == 4) return _mm_set1_epi32(static_cast<std::int32_t>(x));
+            else return _mm_set1_epi64x(static_cast<long long>(x));
+        }
+        /** \brief Carriles en -1 donde \P{a} es mayor que \P{b} (comparando con signo) y en 0 donde no */
+        static __m128i mayores(__m128i a, __m128i b) {
+            if constexpr(sizeof(Key) == 4){
+                return _mm_cmpgt_epi32(a, b);
+            }else{
+#if defined(__SSE4_2__)
+                return _mm_cmpgt_epi64(a, b);
+#else
+                return _mm_setzero_si128();
+#endif
+            }
+        }
+        static __m128i restar(__m128i a, __m128i b) {
+            if constexpr(sizeof(Key) == 4) return _mm_sub_epi32(a, b);
+            else return _mm_sub_epi64(a, b);
+        }
+        static __m128i cero() { return _mm_setzero_si128(); }
+        static __m128i y(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+        static __m128i desplazar(__m128i a, __m128i sesgo) { return _mm_xor_si128(a, sesgo); }
+        static void guardar(Key* p, __m128i a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+    };
+#else
+    /** \brief Sin instrucciones vectoriales */
+    struct Registro {
+        static constexpr bool disponible = false;
+    };
+#endif
+
+    /**
+     * \brief Cuenta las claves menores (si \P{estricto}) o menores o iguales a \P{x}.  Cada comparación vectorial
+     * deja -1 en los carriles que cumplen la condición; restándolas se acumula una cuenta por carril, que se suma
+     * al final.  Las instrucciones vectoriales comparan con signo; para claves sin signo se invierte el bit más
+     * significativo de ambos lados, lo que preserva el orden.
+     */
+    template<size_t paso, bool estricto>
+    static size_t contar(const Key* k, size_t n, Key x) {
+        size_t res = 0, i = 0;
+        if constexpr(Registro::disponible and paso <= 2){
+            constexpr size_t porVector = Registro::carriles / paso;
+            Key carriles[Registro::carriles];
+            for(size_t j = 0; j < Registro::carriles; ++j) carriles[j] = j % paso == 0 ? Key(~Key(0)) : Key(0);
+            const auto mascara = Registro::cargar(carriles);
+            const auto sesgo = Registro::repetir(std::is_signed<Key>::value ? Key(0) : Key(Key(1) << (8 * sizeof(Key) - 1)));
+            const auto vx = Registro::desplazar(Registro::repetir(x), sesgo);
+            auto cuenta = Registro::cero();
+            for(; i + porVector <= n; i += porVector){
+                auto vk = Registro::desplazar(Registro::cargar(k + i * paso), sesgo);
+                cuenta = Registro::restar(cuenta, Registro::y(estricto ? Registro::mayores(vx, vk) : Registro::mayores(vk, vx), mascara));
+            }
+            Registro::guardar(carriles, cuenta);
+            for(size_t j = 0; j < Registro::carriles; j += paso) res += static_cast<size_t>(carriles[j]);
+            if constexpr(not estricto) res = i - res;
+        }
+        for(; i < n; ++i){
+            res += estricto ? (k[i * paso] < x) : not (x < k[i * paso]);
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado sobre un árbol B+.
+ *
+ * El módulo aed2::btree_map tiene exactamente la misma interfaz que aed2::map, por lo que se puede usar uno u
+ * otro cambiando un renombre de tipos.  La diferencia está en la estructura: en lugar de un árbol binario con un
+ * valor por nodo, se usa un árbol B+ cuyos nodos ocupan aproximadamente \T{NodeBytes} bytes (unas pocas líneas de
+ * cache).  Cada nodo guarda muchas claves contiguas, de modo que una búsqueda visita \O(\LOG_B(\SIZE(d))) nodos
+ * en lugar de \O(\LOG(\SIZE(d))), y dentro de cada nodo la búsqueda binaria recorre memoria contigua.  En
+ * diccionarios de millones de elementos, donde el costo de una búsqueda está dominado por los cache misses,
+ * esto reduce varias veces la cantidad de misses por búsqueda.
+ *
+ * \par Estructura
+ * \parblock
+ * - Los valores se guardan únicamente en las \e hojas, ordenados, y las hojas forman una lista doblemente
+ *   enlazada (circular, a través de una hoja \e cabecera sin valores que representa la posición pasando-el-último).
+ * - Los nodos \e internos guardan copias de claves que sirven de separadores: el hijo i de un nodo interno
+ *   tiene las claves mayores o iguales al separador i-1 y menores al separador i.
+ * - Todas las hojas están a la misma profundidad, y todo nodo salvo la raíz está lleno al menos hasta la mitad.
+ * \endparblock
+ *
+ * Los iteradores son un par (hoja, posición).  Recorrer el diccionario es recorrer la lista de hojas, con lo cual
+ * cada incremento es \O(1) en peor caso.
+ *
+ * @tparam Key tipo de la clave.  Además de lo pedido por aed2::map, tiene que tener constructor por copia (para los
+ * separadores).
+ * @tparam Meaning tipo del significado.
+ * @tparam Compare tipo del comparador.
+ * @tparam NodeBytes tamaño, en bytes, al que se ajusta la capacidad de cada nodo.  Cada hoja tiene lugar para al menos 3
+ * valores y cada nodo interno para al menos 3 separadores, aun si no entran en \T{NodeBytes}.
+ * @tparam Alloc allocator estándar de C++ del que se obtiene la memoria de los nodos.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map; además, llamamos \a B a la capacidad de los nodos, que depende de \T{NodeBytes}.
+ *
+ * \par Aspectos generales de aliasing
+ * A diferencia de aed2::map, las inserciones y los borrados mueven valores dentro de las hojas y entre hojas
+ * vecinas, por lo que <b>invalidan todos los iteradores, referencias y punteros a los valores</b>, salvo el
+ * iterador pasando-el-último, que se mantiene válido mientras no se aplique swap.  Las operaciones que no
+ * modifican la estructura (búsquedas, acceso a los significados, recorridos) no invalidan nada.
+ *
+ * \attention Mover un valor de lugar mueve su significado pero copia su clave, ya que en el valor la clave es
+ * constante.  Se asume que mover valores y copiar claves no lanza excepciones.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>,
+  std::size_t NodeBytes = 256,
+  class Alloc = std::allocator<std::pair<const Key, Meaning>>
+>
+class btree_map {
+	struct Nodo;
+	struct Enlace;
+	struct Hoja;
+	struct Interno;
+public:
+    //forward declarations
+    class iterator;
+    class const_iterator;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Renombre para poder acceder al tipo del allocator.  Compatible con estándar C++. */
+    using allocator_type = Alloc;
+    /** \brief Renombre para poder acceder al tipo de referencia de los valores guardados.  Compatible con estándar C++. */
+    using reference = value_type&;
+    /** \brief Renombre para poder acceder al tipo de referencia constante de los valores guardados.  Compatible con estándar C++. */
+    using const_reference = const value_type&;
+    /** \brief Renombre para poder acceder al tipo de los punteros de los valores guardados.  Compatible con estándar C++. */
+    using pointer = value_type*;
+    /** \brief Renombre para poder acceder al tipo de los punteros de los valores constantes guardados.  Compatible con estándar C++. */
+    using const_pointer = const value_type*;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+    /** \brief Iterador para recorrer un diccionario en orden inverso.  Compatible con estándar C++. */
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    /** \brief Iterador para recorrer un diccionario constante en orden inverso.  Compatible con estándar C++. */
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción, asignación y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Constructor por defecto del diccionario.  Ver aed2::map::map().
+     *
+     * \complexity{\O(1)}
+     */
+    explicit btree_map(Compare c = Compare(), const Alloc& a = Alloc()) : lt(c), alloc(a) {}
+
+    /**
+     * @brief Constructor por copia.  Copia la estructura del árbol nodo por nodo, sin comparar claves.
+     *
+     * \complexity{\O(\COPY(\P{other}))}
+     */
+    btree_map(const btree_map& other)
+        : lt(other.lt),
+          alloc(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc)) {
+        copiarArbol(other);
+    }
+
+    /**
+     * @brief Constructor por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    btree_map(btree_map&& other) noexcept(std::is_nothrow_copy_constructible<Compare>::value and std::is_nothrow_swappable<Compare>::value)
+        : lt(other.lt), alloc(other.alloc) {
+        swap(other);
+    }
+
+    /**
+     * @brief Constructor a partir de un rango de valores.  Ver aed2::map::map(iterator, iterator, Compare, const Alloc&).
+     *
+     * \complexity{\O(\a n \CDOT \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this})), donde \a n es la longitud del rango;
+     * \O(\a n) amortizado si el rango está ordenado.}
+     */
+    template<class iterator>
+    btree_map(iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc()) : lt(c), alloc(a) {
+        for(; first != last; ++first) insert(end(), *first);
+    }
+
+    /**
+     * @brief Operador de asignación por copia.  Ver aed2::map::operator=(const map&).
+     *
+     * \complexity{\O(\DEL(\P{*this}) \PLUS \COPY(\P{other}))}
+     */
+    btree_map& operator=(const btree_map& other) {
+        if(this != &other){
+            clear();
+            lt = other.lt;
+            copiarArbol(other);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Operador de asignación por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    btree_map& operator=(btree_map&& other) noexcept(std::is_nothrow_swappable<Compare>::value) {
+        clear();
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    ~btree_map(){
+        clear();
+    }
+
+    /**
+     * @brief Devuelve una copia del allocator del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    allocator_type get_allocator() const {
+        return alloc;
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Busqueda y acceso a los valores */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    const Meaning& at(const Key& key) const {
+        return find(key)->second;
+    }
+
+    /** \overload */
+    Meaning& at(const Key& key) {
+        return find(key)->second;
+    }
+
+    /**
+     * @brief Devuelve el significado de \P{key}, definiéndolo con \T{Meaning}() si no existe.  Ver aed2::map::operator[].
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \a B)}
+     */
+    Meaning& operator[](const Key& key) {
+        return try_emplace(key)->second;
+    }
+
+    /** \overload */
+    Meaning& operator[](Key&& key) {
+        return try_emplace(std::move(key))->second;
+    }
+
+    /**
+     * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    iterator find(const Key& key) {
+        Lugar l = lugar(key);
+        return l.existe ? iterator(l.hoja, l.pos) : end();
+    }
+
+    /** \overload */
+    const_iterator find(const Key& key) const {
+        Lugar l = lugar(key);
+        return l.existe ? const_iterator(l.hoja, l.pos) : end();
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     *
+     * \note Se visitan \O(\LOG_B(\SIZE(\P{*this}))) nodos; en cada uno se hace una búsqueda binaria sobre claves contiguas.
+     */
+    const_iterator lower_bound(const Key& key) const {
+        Lugar l = lugar(key);
+        return l.hoja == nullptr ? end() : const_iterator(posicion(l.hoja, l.pos));
+    }
+
+    /** \overload */
+    iterator lower_bound(const Key& key) {
+        Lugar l = lugar(key);
+        return l.hoja == nullptr ? end() : posicion(l.hoja, l.pos);
+    }
+    //@}
+
+    ///////////////////////////////////
+    /** \name Tamaño del diccionario */
+    ///////////////////////////////////
+    //@{
+    /**
+     * @brief Indica si el diccionario esta vacío
+     *
+     * \complexity{\O(1)}
+     */
+    bool empty() const {
+        return raiz == nullptr;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores en el dicconario
+     *
+     * \complexity{\O(1)}
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de bytes que ocupa cada hoja, que tiene lugar para hasta leaf_capacity() valores.
+     *
+     * \complexity{\O(1)}
+     */
+    static constexpr size_t node_size() {
+        return sizeof(Hoja);
+    }
+
+    /**
+     * @brief Devuelve la cantidad máxima de valores que entran en una hoja.
+     *
+     * \complexity{\O(1)}
+     */
+    static constexpr size_t leaf_capacity() {
+        return capacidadHoja;
+    }
+    //@}
+
+	//////////////////////////////////////////////
+    /** \name Inserción, borrado y modificación */
+    //////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Inserta \P{value} en el diccionario.  Ver aed2::map::insert.
+     *
+     * \aliasing{Invalida todos los iteradores salvo el pasando-el-último (ver aed2::btree_map).}
+     *
+     * \complexity{
+     *  - Peor caso: \O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \a B \PLUS \COPY(\P{value}))
+     *  - Si \P{hint} apunta a lower_bound(\P{value}.first) y no es el primer valor de su hoja:
+     *  \O(\CMP(\P{*this}) \PLUS \a B \PLUS \COPY(\P{value})) amortizado.
+     * }
+     */
+    iterator insert(const_iterator hint, const value_type& value) {
+        Lugar l = lugarConHint(hint, value.first);
+        if(l.existe) return iterator(l.hoja, l.pos);
+        return construirEn(l, value);
+    }
+
+    /** \overload */
+    iterator insert(const value_type& value) {
+        Lugar l = lugar(value.first);
+        if(l.existe) return iterator(l.hoja, l.pos);
+        return construirEn(l, value);
+    }
+
+    /** \overload */
+    iterator insert(const_iterator hint, value_type&& value) {
+        Lugar l = lugarConHint(hint, value.first);
+        if(l.existe) return iterator(l.hoja, l.pos);
+        return construirEn(l, std::move(value));
+    }
+
+    /** \overload */
+    iterator insert(value_type&& value) {
+        Lugar l = lugar(value.first);
+        if(l.existe) return iterator(l.hoja, l.pos);
+        return construirEn(l, std::move(value));
+    }
+
+    /**
+     * @brief Inserta un valor construido a partir de \P{args}.  Ver aed2::map::emplace.
+     *
+     * \complexity{Idem insert, reemplazando \COPY(\P{value}) por el costo de construir (y mover) el valor.}
+     *
+     * \attention El valor se construye en una variable temporal para conocer su clave y luego se mueve a la hoja.
+     */
+    template<class... Args>
+    iterator emplace(Args&&... args) {
+        return emplace_hint(end(), std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        value_type valor(std::forward<Args>(args)...);
+        return insert(hint, std::move(valor));
+    }
+
+    /**
+     * @brief Si \P{key} no está definida, la define con significado \T{Meaning}(\P{args}...).  Ver aed2::map::try_emplace.
+     *
+     * \complexity{Idem insert, reemplazando \COPY(\P{value}) por el costo de construir el valor.}
+     */
+    template<class... Args>
+    iterator try_emplace(const Key& key, Args&&... args) {
+        return try_emplace(end(), key, std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(Key&& key, Args&&... args) {
+        return try_emplace(end(), std::move(key), std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(const_iterator hint, const Key& key, Args&&... args) {
+        Lugar l = lugarConHint(hint, key);
+        if(l.existe) return iterator(l.hoja, l.pos);
+        return construirEn(l, std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(const_iterator hint, Key&& key, Args&&... args) {
+        Lugar l = lugarConHint(hint, key);
+        if(l.existe) return iterator(l.hoja, l.pos);
+        return construirEn(l, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @brief Inserta \P{value}, reemplazando el significado si la clave ya estaba definida.  Ver aed2::map::insert_or_assign.
+     *
+     * \complexity{Idem insert.}
+     */
+    iterator insert_or_assign(const_iterator hint, const value_type& value) {
+        return asignarOConstruir(lugarConHint(hint, value.first), value);
+    }
+
+    /** \overload */
+    iterator insert_or_assign(const value_type& value) {
+        return asignarOConstruir(lugar(value.first), value);
+    }
+
+    /** \overload */
+    iterator insert_or_assign(const_iterator hint, value_type&& value) {
+        return asignarOConstruir(lugarConHint(hint, value.first), std::move(value));
+    }
+
+    /** \overload */
+    iterator insert_or_assign(value_type&& value) {
+        return asignarOConstruir(lugar(value.first), std::move(value));
+    }
+
+    /** \overload */
+    template<class M>
+    iterator insert_or_assign(const Key& key, M&& obj) {
+        Lugar l = lugar(key);
+        if(l.existe){
+            valores(l.hoja)[l.pos].second = std::forward<M>(obj);
+            return iterator(l.hoja, l.pos);
+        }
+        return construirEn(l, key, std::forward<M>(obj));
+    }
+
+    /**
+     * @brief Elimina el valor apuntado por \P{pos}.  Ver aed2::map::erase(const_iterator).
+     *
+     * Si la hoja de \P{pos} queda con menos de la mitad de sus valores, toma un valor de una hoja vecina o se fusiona
+     * con ella; las fusiones pueden propagarse hacia la raíz.
+     *
+     * @retval res iterador al valor siguiente al eliminado
+     *
+     * \aliasing{Invalida todos los iteradores salvo el pasando-el-último (ver aed2::btree_map).}
+     *
+     * \complexity{\O(\DEL(\P{*pos}) \PLUS \a B \CDOT \LOG_B(\SIZE(\P{*this})))}
+     */
+    iterator erase(const_iterator pos) {
+        Hoja* h = static_cast<Hoja*>(const_cast<Enlace*>(pos.n));
+        size_t i = pos.i;
+        destruirValor(valores(h) + i);
+        mover(valores(h) + i + 1, h->cantidad - i - 1, valores(h) + i);
+        --h->cantidad;
+        --count;
+        if(h == raiz){
+            if(h->cantidad == 0){
+                desenlazar(h);
+                liberar(h);
+                raiz = nullptr;
+                return end();
+            }
+            return posicion(h, i);
+        }
+        if(h->cantidad >= minimoHoja){
+            return posicion(h, i);
+        }
+
+        Interno* p = h->padre;
+        size_t k = indiceHijo(p, h);
+        Hoja* izq = k > 0 ? static_cast<Hoja*>(p->hijos[k-1]) : nullptr;
+        Hoja* der = k < p->cantidad ? static_cast<Hoja*>(p->hijos[k+1]) : nullptr;
+        if(izq != nullptr and izq->cantidad > minimoHoja){
+            mover(valores(h), h->cantidad, valores(h) + 1);
+            mover(valores(izq) + izq->cantidad - 1, 1, valores(h));
+            --izq->cantidad;
+            ++h->cantidad;
+            asignarSeparador(p, k-1, valores(h)[0].first);
+            return posicion(h, i + 1);
+        }
+        if(der != nullptr and der->cantidad > minimoHoja){
+            mover(valores(der), 1, valores(h) + h->cantidad);
+            mover(valores(der) + 1, der->cantidad - 1, valores(der));
+            --der->cantidad;
+            ++h->cantidad;
+            asignarSeparador(p, k, valores(der)[0].first);
+            return posicion(h, i);
+        }
+        if(izq != nullptr){
+            size_t base = izq->cantidad;
+            fusionarHojas(izq, h, p, k-1);
+            return posicion(izq, base + i);
+        }
+        fusionarHojas(h, der, p, k);
+        return posicion(h, i);
+    }
+
+    /**
+     * @brief Elimina el valor cuya clave es \P{key}.  Ver aed2::map::erase(const Key&).
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\DEL(\P{*pos}) \PLUS \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \a B \CDOT \LOG_B(\SIZE(\P{*this})))}
+     */
+    void erase(const Key& key) {
+        erase(find(key));
+    }
+
+    /**
+     * @brief Vacía el diccionario.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    void clear() {
+        if(raiz != nullptr){
+            destruirNodo(raiz);
+        }
+        raiz = nullptr;
+        cabecera.anterior = cabecera.siguiente = &cabecera;
+        count = 0;
+    }
+
+    /**
+     * @brief Intercambia los contenidos de \P{*this} y \P{other}.  Ver aed2::map::swap.
+     *
+     * \complexity{\O(1)}
+     */
+    void swap(btree_map& other) noexcept(std::is_nothrow_swappable<Compare>::value) {
+        using std::swap;
+        swap(lt, other.lt);
+        swap(alloc, other.alloc);
+        swap(count, other.count);
+        swap(raiz, other.raiz);
+        swap(cabecera.anterior, other.cabecera.anterior);
+        swap(cabecera.siguiente, other.cabecera.siguiente);
+        arreglarCabecera();
+        other.arreglarCabecera();
+    }
+    //@}
+
+    //////////////////////////////////////
+    /** \name Recorridos e iteradores */
+    //////////////////////////////////////
+    //@{
+    /** @brief Iterador al primer valor (o end() si el diccionario es vacío).  \complexity{\O(1)} */
+    iterator begin() {
+        return iterator(cabecera.siguiente, 0);
+    }
+
+    /** \overload */
+    const_iterator begin() const {
+        return const_iterator(cabecera.siguiente, 0);
+    }
+
+    /** \overload */
+    const_iterator cbegin() {
+        return begin();
+    }
+
+    /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+    iterator end() {
+        return iterator(&cabecera, 0);
+    }
+
+    /** \overload */
+    const_iterator end() const {
+        return const_iterator(&cabecera, 0);
+    }
+
+    /** \overload */
+    const_iterator cend() {
+        return end();
+    }
+
+    /** @brief Iterador al primer valor del recorrido inverso.  \complexity{\O(1)} */
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    /** \overload */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /** \overload */
+    const_reverse_iterator crbegin() {
+        return rbegin();
+    }
+
+    /** @brief Iterador a la posición pasando-el-último del recorrido inverso.  \complexity{\O(1)} */
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    /** \overload */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /** \overload */
+    const_reverse_iterator crend() {
+        return rend();
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación.
+     *
+     * Función de debugging que chequea que las hojas estén todas a la misma profundidad y llenas al menos hasta la
+     * mitad (salvo la raíz), que las claves respeten los separadores, que los punteros a los padres y la lista de
+     * hojas sean consistentes, y que la cantidad de valores sea \P{count}.
+     *
+     * \complexity{\O(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        if(raiz == nullptr){
+            return count == 0 and cabecera.siguiente == &cabecera and cabecera.anterior == &cabecera;
+        }
+        if(raiz->padre != nullptr){
+            return false;
+        }
+        const Enlace* ultima = &cabecera;
+        size_t valoresVistos = 0;
+        int profundidad = -1;
+        if(not verificarNodo(raiz, nullptr, nullptr, 0, profundidad, ultima, valoresVistos)){
+            return false;
+        }
+        return ultima->siguiente == &cabecera and cabecera.anterior == ultima and valoresVistos == count;
+    }
+#endif
+
+    /**
+     * @brief Iterador que permite modificar los significados.  Ver aed2::map::iterator.
+     *
+     * Un iterador es un par (hoja, posición); la posición pasando-el-último es la cabecera con posición 0.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = btree_map::value_type;
+        using reference = btree_map::reference;
+        using pointer = btree_map::pointer;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor del iterador nulo.  \complexity{\O(1)} */
+        iterator() {}
+
+        /** @brief Valor apuntado.  \pre el iterador no es nulo ni pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return valores(static_cast<Hoja*>(n))[i];
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return &**this;
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1)} */
+        iterator& operator++() {
+            avanzar();
+            return *this;
+        }
+
+        /** \overload */
+        iterator operator++(int) {
+            iterator ret = *this;
+            avanzar();
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{\O(1)} */
+        iterator& operator--() {
+            retroceder();
+            return *this;
+        }
+
+        /** \overload */
+        iterator operator--(int) {
+            iterator ret = *this;
+            retroceder();
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(iterator other) const {
+            return n == other.n and i == other.i;
+        }
+
+        /** \overload */
+        bool operator!=(iterator other) const {
+            return not (*this == other);
+        }
+
+    private:
+        iterator(Enlace* hoja, size_t pos) : n(hoja), i(pos) {}
+
+        /** \brief Hoja (o cabecera) a la que apunta el iterador */
+        Enlace* n{nullptr};
+        /** \brief Posición del valor dentro de la hoja */
+        size_t i{0};
+        friend class btree_map;
+
+        void avanzar(){
+            if(++i >= n->cantidad){
+                n = n->siguiente;
+                i = 0;
+            }
+        }
+
+        void retroceder(){
+            if(i == 0){
+                n = n->anterior;
+                i = n->cantidad == 0 ? 0 : n->cantidad - 1;
+            }else{
+                --i;
+            }
+        }
+    };
+
+    /**
+     * @brief Iterador que no permite modificar los significados.  Ver aed2::map::const_iterator.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = btree_map::value_type;
+        using reference = btree_map::const_reference;
+        using pointer = btree_map::const_pointer;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor del iterador nulo.  \complexity{\O(1)} */
+        const_iterator() {}
+
+        /** @brief Conversión desde iterator.  \complexity{\O(1)} */
+        const_iterator(iterator it) : n(it.n), i(it.i) {}
+
+        /** @brief Valor apuntado.  \pre el iterador no es nulo ni pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return valores(static_cast<const Hoja*>(n))[i];
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return &**this;
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1)} */
+        const_iterator& operator++() {
+            avanzar();
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator++(int) {
+            const_iterator ret = *this;
+            avanzar();
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{\O(1)} */
+        const_iterator& operator--() {
+            retroceder();
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator--(int) {
+            const_iterator ret = *this;
+            retroceder();
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(const_iterator other) const {
+            return n == other.n and i == other.i;
+        }
+
+        /** \overload */
+        bool operator!=(const_iterator other) const {
+            return not (*this == other);
+        }
+
+    private:
+        const_iterator(const Enlace* hoja, size_t pos) : n(hoja), i(pos) {}
+
+        /** \brief Hoja (o cabecera) a la que apunta el iterador */
+        const Enlace* n{nullptr};
+        /** \brief Posición del valor dentro de la hoja */
+        size_t i{0};
+        friend class btree_map;
+
+        void avanzar(){
+            if(++i >= n->cantidad){
+                n = n->siguiente;
+                i = 0;
+            }
+        }
+
+        void retroceder(){
+            if(i == 0){
+                n = n->anterior;
+                i = n->cantidad == 0 ? 0 : n->cantidad - 1;
+            }else{
+                --i;
+            }
+        }
+    };
+
+private:
+    /**
+     * \brief Parte común a hojas y nodos internos.
+     *
+     * \par Estructura de representación
+     * - \P{padre}: nodo interno que tiene a este nodo como hijo, o nullptr para la raíz y la cabecera.
+     * - \P{cantidad}: cantidad de valores (en una hoja) o de separadores (en un nodo interno).
+     * - \P{hoja}: true para las hojas y la cabecera.
+     */
+    struct Nodo {
+        Interno* padre{nullptr};
+        std::uint16_t cantidad{0};
+        bool hoja{true};
+    };
+
+    /**
+     * \brief Nodo de la lista doblemente enlazada de hojas.  La cabecera es un Enlace sin valores (con cantidad 0);
+     * el resto son hojas, que siempre tienen al menos un valor.
+     */
+    struct Enlace : Nodo {
+        Enlace* anterior{this};
+        Enlace* siguiente{this};
+    };
+
+    /** \brief Capacidad de las hojas: la cantidad de valores que entran en \T{NodeBytes}, pero al menos 3 */
+    static constexpr size_t capacidadHoja = std::max<size_t>(3,
+            NodeBytes > sizeof(Enlace) ? (NodeBytes - sizeof(Enlace)) / sizeof(value_type) : 0);
+    /** \brief Capacidad de los nodos internos: la cantidad de separadores que entran en \T{NodeBytes}, pero al menos 3 */
+    static constexpr size_t capacidadInterno = std::max<size_t>(3,
+            NodeBytes > sizeof(Nodo) + sizeof(Nodo*) ? (NodeBytes - sizeof(Nodo) - sizeof(Nodo*)) / (sizeof(Key) + sizeof(Nodo*)) : 0);
+    /** \brief Cantidad mínima de valores de una hoja que no es la raíz */
+    static constexpr size_t minimoHoja = capacidadHoja / 2;
+    /** \brief Cantidad mínima de separadores de un nodo interno que no es la raíz */
+    static constexpr size_t minimoInterno = capacidadInterno / 2;
+    /** \brief Cota para la altura del árbol: cada nodo interno no raíz tiene al menos dos hijos */
+    static constexpr size_t alturaMaxima = 8 * sizeof(size_t);
+
+    static_assert(capacidadHoja <= UINT16_MAX and capacidadInterno <= UINT16_MAX, "NodeBytes demasiado grande");
+
+    /** \brief Búsqueda vectorial dentro de los nodos, si las claves la admiten; ver aed2::simd_key_search */
+    using vectorial = simd_key_search<Key, Compare>;
+
+    /** \brief Hoja del árbol: hasta capacidadHoja valores, ordenados, en memoria sin inicializar */
+    struct Hoja : Enlace {
+        alignas(value_type) unsigned char memoria[capacidadHoja * sizeof(value_type)];
+    };
+
+    /** \brief Nodo interno: hasta capacidadInterno separadores y uno más de hijos */
+    struct Interno : Nodo {
+        Interno() { this->hoja = false; }
+        alignas(Key) unsigned char memoria[capacidadInterno * sizeof(Key)];
+        Nodo* hijos[capacidadInterno + 1];
+    };
+
+    using traits_hoja = typename std::allocator_traits<Alloc>::template rebind_traits<Hoja>;
+    using traits_interno = typename std::allocator_traits<Alloc>::template rebind_traits<Interno>;
+
+    /**
+     * \brief Resultado de buscar una clave.  Si \P{existe}, el valor con la clave está en \P{hoja} en la posición
+     * \P{pos}; si no, es la posición en la que habría que insertarlo (con \P{hoja} nulo si el diccionario es vacío).
+     */
+    struct Lugar {
+        Hoja* hoja;
+        size_t pos;
+        bool existe;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - \P{raiz} es nulo si y solo si \P{count} es 0; si no, \P{raiz} no tiene padre.
+     * - Todas las hojas están a la misma profundidad; la lista de hojas que empieza y termina en \P{cabecera}
+     *   las recorre de izquierda a derecha.
+     * - Las hojas tienen entre 1 y capacidadHoja valores y los nodos internos entre 1 y capacidadInterno
+     *   separadores; salvo la raíz, tienen al menos minimoHoja y minimoInterno, respectivamente.
+     * - Los valores de cada hoja están ordenados en forma estricta con respecto a \P{lt}.  Para cada nodo interno
+     *   con separadores s_0..s_{k-1}, las claves del hijo i son mayores o iguales a s_{i-1} (si i > 0) y menores
+     *   a s_i (si i < k).
+     * - \P{count} es la cantidad total de valores.
+     * \endparblock
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /** \brief Orden total para comparar claves. */
+    Compare lt;
+    /** \brief Allocator del que se obtienen los nodos */
+    Alloc alloc;
+    /** \brief Cantidad de elementos en el diccionario */
+    size_t count{0};
+    /** \brief Raíz del árbol (nullptr si el diccionario es vacío) */
+    Nodo* raiz{nullptr};
+    /** \brief Cabecera de la lista circular de hojas; representa la posición pasando-el-último */
+    Enlace cabecera;
+    //@}
+
+    /////////////////////////////////
+    /** \name Funciones auxiliares */
+    /////////////////////////////////
+    //@{
+    /** \brief Arreglo de valores de la hoja \P{h} */
+    static value_type* valores(Hoja* h) {
+        return std::launder(reinterpret_cast<value_type*>(h->memoria));
+    }
+
+    /** \overload */
+    static const value_type* valores(const Hoja* h) {
+        return std::launder(reinterpret_cast<const value_type*>(h->memoria));
+    }
+
+    /** \brief Arreglo de separadores del nodo interno \P{n} */
+    static Key* claves(Interno* n) {
+        return std::launder(reinterpret_cast<Key*>(n->memoria));
+    }
+
+    /** \overload */
+    static const Key* claves(const Interno* n) {
+        return std::launder(reinterpret_cast<const Key*>(n->memoria));
+    }
+
+    /** \brief Iterador a la posición \P{i} de \P{h}, o al primer valor de la hoja siguiente si \P{i} es la cantidad de valores de \P{h} */
+    static iterator posicion(Hoja* h, size_t i) {
+        return i < h->cantidad ? iterator(h, i) : iterator(h->siguiente, 0);
+    }
+
+        /**
+         * \brief mover
+         *
+         * \Descripcion Mueve los \P{n} objetos que empiezan en \P{origen} a la memoria que empieza en \P{destino},
+         * destruyendo los originales.  Los rangos se pueden superponer.  Si \T{T} se puede reubicar copiando su
+         * memoria (i.e., es trivialmente copiable, o es el par de dos tipos trivialmente copiables), usa memmove.
+         *
+         * \complexity{\O(\P{n})}
+         */
+    template<class T>
+    static void mover(T* origen, size_t n, T* destino) {
+        if(n == 0 or origen == destino){
+            return;
+        }
+        if constexpr(reubicable<T>::value){
+            std::memmove(static_cast<void*>(destino), static_cast<const void*>(origen), n * sizeof(T));
+        }else if(std::less<T*>()(destino, origen)){
+            for(size_t j = 0; j < n; ++j){
+                ::new(static_cast<void*>(destino + j)) T(std::move(origen[j]));
+                origen[j].~T();
+            }
+        }else{
+            for(size_t j = n; j-- > 0;){
+                ::new(static_cast<void*>(destino + j)) T(std::move(origen[j]));
+                origen[j].~T();
+            }
+        }
+    }
+
+    /** \brief Indica si \T{T} se puede reubicar copiando su memoria */
+    template<class T>
+    struct reubicable : std::is_trivially_copyable<T> {};
+
+    /** \overload */
+    template<class K, class V>
+    struct reubicable<std::pair<const K, V>>
+        : std::integral_constant<bool, std::is_trivially_copyable<K>::value and std::is_trivially_copyable<V>::value> {};
+
+    /** \brief Destruye el valor apuntado por \P{v} */
+    void destruirValor(value_type* v) {
+        std::allocator_traits<Alloc>::destroy(alloc, v);
+    }
+
+    /** \brief Reemplaza el separador \P{i} de \P{n} por una copia de \P{key} */
+    static void asignarSeparador(Interno* n, size_t i, const Key& key) {
+        claves(n)[i].~Key();
+        ::new(static_cast<void*>(claves(n) + i)) Key(key);
+    }
+
+    /** \brief Índice de \P{hijo} entre los hijos de \P{p}.  \complexity{\O(\a B)} */
+    static size_t indiceHijo(const Interno* p, const Nodo* hijo) {
+        size_t i = 0;
+        while(p->hijos[i] != hijo) ++i;
+        return i;
+    }
+
+    /** \brief Crea una hoja vacía.  \complexity{\O(1)} */
+    Hoja* crearHoja() {
+        typename traits_hoja::allocator_type a(alloc);
+        Hoja* h = traits_hoja::allocate(a, 1);
+        return ::new(static_cast<void*>(h)) Hoja();
+    }
+
+    /** \brief Crea un nodo interno vacío.  \complexity{\O(1)} */
+    Interno* crearInterno() {
+        typename traits_interno::allocator_type a(alloc);
+        Interno* n = traits_interno::allocate(a, 1);
+        return ::new(static_cast<void*>(n)) Interno();
+    }
+
+    /** \brief Devuelve la memoria de la hoja \P{h}, cuyos valores ya fueron destruidos.  \complexity{\O(1)} */
+    void liberar(Hoja* h) {
+        typename traits_hoja::allocator_type a(alloc);
+        h->~Hoja();
+        traits_hoja::deallocate(a, h, 1);
+    }
+
+    /** \brief Devuelve la memoria del nodo interno \P{n}, cuyos separadores ya fueron destruidos.  \complexity{\O(1)} */
+    void liberar(Interno* n) {
+        typename traits_interno::allocator_type a(alloc);
+        n->~Interno();
+        traits_interno::deallocate(a, n, 1);
+    }
+
+        /**
+         * \brief destruirNodo
+         *
+         * \Descripcion Destruye los valores (o separadores) del subárbol de \P{n} y devuelve la memoria de sus nodos.
+         * No actualiza la lista de hojas.  Los hijos nulos (de un nodo interno a medio copiar) se ignoran.
+         *
+         * \complexity{\O(\DEL(\P{n}))}
+         */
+    void destruirNodo(Nodo* n) {
+        if(n->hoja){
+            Hoja* h = static_cast<Hoja*>(n);
+            if(not std::is_trivially_destructible<value_type>::value){
+                for(size_t i = 0; i < h->cantidad; ++i) destruirValor(valores(h) + i);
+            }
+            liberar(h);
+        }else{
+            Interno* in = static_cast<Interno*>(n);
+            for(size_t i = 0; i <= in->cantidad; ++i){
+                if(in->hijos[i] != nullptr) destruirNodo(in->hijos[i]);
+            }
+            for(size_t i = 0; i < in->cantidad; ++i) claves(in)[i].~Key();
+            liberar(in);
+        }
+    }
+
+    /** \brief Engancha la hoja \P{h} en la lista de hojas, a continuación de \P{anterior}.  \complexity{\O(1)} */
+    static void enlazarDespues(Enlace* anterior, Enlace* h) {
+        h->anterior = anterior;
+        h->siguiente = anterior->siguiente;
+        anterior->siguiente->anterior = h;
+        anterior->siguiente = h;
+    }
+
+    /** \brief Desengancha la hoja \P{h} de la lista de hojas.  \complexity{\O(1)} */
+    static void desenlazar(Enlace* h) {
+        h->anterior->siguiente = h->siguiente;
+        h->siguiente->anterior = h->anterior;
+    }
+
+    /** \brief Hace que la primera y la última hoja apunten a la cabecera (luego de swap).  \complexity{\O(1)} */
+    void arreglarCabecera() {
+        if(raiz == nullptr){
+            cabecera.anterior = cabecera.siguiente = &cabecera;
+        }else{
+            cabecera.siguiente->anterior = &cabecera;
+            cabecera.anterior->siguiente = &cabecera;
+        }
+    }
+
+        /**
+         * \brief lugar
+         *
+         * \Descripcion Desciende desde la raíz hasta la hoja donde está (o debería estar) \P{key}.  En cada nodo interno
+         * elige el hijo con una búsqueda binaria sobre los separadores; en la hoja, busca la primera clave mayor o igual
+         * a \P{key}.  Cada paso de las búsquedas binarias hace una sola comparación.  Si las claves admiten búsqueda
+         * vectorial (ver aed2::simd_key_search), en lugar de las búsquedas binarias se cuentan los separadores no
+         * mayores y las claves menores a \P{key}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+    Lugar lugar(const Key& key) const {
+        if(raiz == nullptr){
+            return Lugar{nullptr, 0, false};
+        }
+        Nodo* n = raiz;
+        while(not n->hoja){
+            Interno* in = static_cast<Interno*>(n);
+            const Key* k = claves(in);
+            size_t desde = 0, hasta = in->cantidad;
+            if constexpr(vectorial::value){
+                desde = vectorial::noMayores(k, hasta, key);
+            }else{
+                while(desde < hasta){
+                    size_t medio = (desde + hasta) / 2;
+                    if(lt(key, k[medio])){
+                        hasta = medio;
+                    }else{
+                        desde = medio + 1;
+                    }
+                }
+            }
+            n = in->hijos[desde];
+        }
+        Hoja* h = static_cast<Hoja*>(n);
+        const value_type* v = valores(h);
+        size_t desde = 0, hasta = h->cantidad;
+        if constexpr(vectorial::value and sizeof(value_type) % sizeof(Key) == 0){
+            desde = vectorial::template menores<sizeof(value_type) / sizeof(Key)>(&v[0].first, hasta, key);
+        }else{
+            while(desde < hasta){
+                size_t medio = (desde + hasta) / 2;
+                if(lt(v[medio].first, key)){
+                    desde = medio + 1;
+                }else{
+                    hasta = medio;
+                }
+            }
+        }
+        return Lugar{h, desde, desde < h->cantidad and not lt(key, v[desde].first)};
+    }
+
+        /**
+         * \brief lugarConHint
+         *
+         * \Descripcion Idem lugar, pero si \P{hint} apunta a lower_bound(\P{key}) y el valor anterior está en la misma
+         * hoja (o \P{hint} es end()), el lugar es la posición de \P{hint} y no hace falta descender desde la raíz.
+         *
+         * \complexity{
+         * - Peor caso: \O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))
+         * - Si \P{hint} es bueno y no es el primer valor de su hoja: \O(\CMP(\P{*this}))
+         * }
+         */
+    Lugar lugarConHint(const_iterator hint, const Key& key) const {
+        if(not esBuenHint(hint, key)){
+            return lugar(key);
+        }
+        if(hint == end()){
+            Hoja* ultima = static_cast<Hoja*>(cabecera.anterior);
+            return Lugar{ultima, ultima->cantidad, false};
+        }
+        Hoja* h = static_cast<Hoja*>(const_cast<Enlace*>(hint.n));
+        if(not lt(key, hint->first)){
+            return Lugar{h, hint.i, true};
+        }
+        if(hint.i > 0){
+            return Lugar{h, hint.i, false};
+        }
+        return lugar(key);
+    }
+
+        /**
+         * \brief esBuenHint
+         *
+         * \Descripcion Devuelve true si \P{hint} apunta al primer valor con clave mayor o igual a \P{key}, o a end() cuando
+         * \P{key} es mayor a todas las claves de un diccionario no vacío.
+         *
+         * \complexity{\O(\CMP(\P{*this}))}
+         */
+    bool esBuenHint(const_iterator hint, const Key& key) const {
+        if(hint == end()){
+            return not(empty()) and lt(std::prev(hint)->first, key);
+        }
+        if(lt(hint->first, key)){
+            return false;
+        }
+        if(hint == begin()){
+            return true;
+        }
+        return lt(std::prev(hint)->first, key);
+    }
+
+        /**
+         * \brief construirEn
+         *
+         * \Descripcion Construye un valor con \P{args} en el lugar \P{l}, obtenido con lugar o lugarConHint, y devuelve un
+         * iterador al valor construido.  Si la hoja está llena, la divide (ver dividirEInsertar).
+         *
+         * \complexity{\O(\a B \PLUS costo de construir el valor) amortizado}
+         */
+    template<class... Args>
+    iterator construirEn(Lugar l, Args&&... args) {
+        Hoja* h = l.hoja;
+        if(h == nullptr){
+            h = crearHoja();
+            try{
+                std::allocator_traits<Alloc>::construct(alloc, valores(h), std::forward<Args>(args)...);
+            }catch(...){
+                liberar(h);
+                throw;
+            }
+            h->cantidad = 1;
+            enlazarDespues(&cabecera, h);
+            raiz = h;
+            ++count;
+            return iterator(h, 0);
+        }
+        if(h->cantidad < capacidadHoja){
+            mover(valores(h) + l.pos, h->cantidad - l.pos, valores(h) + l.pos + 1);
+            try{
+                std::allocator_traits<Alloc>::construct(alloc, valores(h) + l.pos, std::forward<Args>(args)...);
+            }catch(...){
+                mover(valores(h) + l.pos + 1, h->cantidad - l.pos, valores(h) + l.pos);
+                throw;
+            }
+            ++h->cantidad;
+            ++count;
+            return iterator(h, l.pos);
+        }
+        return dividirEInsertar(h, l.pos, value_type(std::forward<Args>(args)...));
+    }
+
+        /**
+         * \brief asignarOConstruir
+         *
+         * \Descripcion Si en el lugar \P{l} ya existe la clave, le asigna el significado de \P{value}; si no, construye
+         * \P{value} en \P{l}.
+         *
+         * \complexity{\O(\a B \PLUS costo de copiar (o mover) \P{value}) amortizado}
+         */
+    template<class V>
+    iterator asignarOConstruir(Lugar l, V&& value) {
+        if(l.existe){
+            valores(l.hoja)[l.pos].second = std::forward<V>(value).second;
+            return iterator(l.hoja, l.pos);
+        }
+        return construirEn(l, std::forward<V>(value));
+    }
+
+        /**
+         * \brief dividirEInsertar
+         *
+         * \Descripcion Inserta \P{nuevo} en la posición \P{p} de la hoja llena \P{h}.  Los capacidadHoja + 1 valores se
+         * reparten entre \P{h} y una hoja nueva, que se engancha a su derecha; la primera clave de la hoja nueva se
+         * inserta como separador en el padre (ver insertarEnPadre).  Todos los nodos necesarios se piden antes de mover
+         * cualquier valor, de forma que si el allocator falla el diccionario no se modifica.
+         *
+         * \complexity{\O(\a B \CDOT \LOG_B(\SIZE(\P{*this})))}
+         */
+    iterator dividirEInsertar(Hoja* h, size_t p, value_type&& nuevo) {
+        Interno* reservados[alturaMaxima];
+        size_t cantidadReservados = reservarInternos(h, reservados);
+        Hoja* r;
+        try{
+            r = crearHoja();
+        }catch(...){
+            while(cantidadReservados > 0) liberar(reservados[--cantidadReservados]);
+            throw;
+        }
+
+        const size_t total = capacidadHoja + 1;
+        const size_t izq = (total + 1) / 2;
+        value_type* v = valores(h);
+        value_type* vr = valores(r);
+        if(p < izq){
+            mover(v + izq - 1, capacidadHoja - (izq - 1), vr);
+            mover(v + p, izq - 1 - p, v + p + 1);
+            std::allocator_traits<Alloc>::construct(alloc, v + p, std::move(nuevo));
+        }else{
+            mover(v + izq, p - izq, vr);
+            std::allocator_traits<Alloc>::construct(alloc, vr + p - izq, std::move(nuevo));
+            mover(v + p, capacidadHoja - p, vr + p - izq + 1);
+        }
+        h->cantidad = izq;
+        r->cantidad = total - izq;
+        enlazarDespues(h, r);
+        ++count;
+
+        insertarEnPadre(h, Key(vr[0].first), r, reservados, cantidadReservados);
+        return p < izq ? iterator(h, p) : iterator(r, p - izq);
+    }
+
+        /**
+         * \brief reservarInternos
+         *
+         * \Descripcion Pide los nodos internos que necesita insertarEnPadre para dividir los ancestros llenos de \P{h}
+         * (y, si todos están llenos, para crear una nueva raíz), y devuelve cuántos son.
+         *
+         * \complexity{\O(\LOG_B(\SIZE(\P{*this})))}
+         */
+    size_t reservarInternos(const Nodo* h, Interno** reservados) {
+        size_t necesarios = 0;
+        const Interno* p = h->padre;
+        while(p != nullptr and p->cantidad == capacidadInterno){
+            ++necesarios;
+            p = p->padre;
+        }
+        if(p == nullptr){
+            ++necesarios;
+        }
+        size_t cantidad = 0;
+        try{
+            while(cantidad < necesarios) reservados[cantidad++] = crearInterno();
+        }catch(...){
+            while(cantidad > 0) liberar(reservados[--cantidad]);
+            throw;
+        }
+        return cantidad;
+    }
+
+        /**
+         * \brief insertarEnPadre
+         *
+         * \Descripcion Luego de dividir \P{izq}, inserta el separador \P{sep} y el nodo nuevo \P{der} a la derecha de \P{izq}
+         * en su padre.  Si el padre está lleno, los capacidadInterno + 1 separadores se reparten entre el padre y un nodo
+         * nuevo, y el separador del medio sube al abuelo, repitiendo el proceso.  Si \P{izq} es la raíz, se crea una raíz
+         * nueva.  Los nodos nuevos se toman de \P{reservados}.
+         *
+         * \complexity{\O(\a B \CDOT \LOG_B(\SIZE(\P{*this})))}
+         */
+    void insertarEnPadre(Nodo* izq, Key sep, Nodo* der, Interno** reservados, size_t cantidadReservados) {
+        Interno* p = izq->padre;
+        if(p == nullptr){
+            Interno* nueva = reservados[--cantidadReservados];
+            ::new(static_cast<void*>(claves(nueva))) Key(std::move(sep));
+            nueva->hijos[0] = izq;
+            nueva->hijos[1] = der;
+            nueva->cantidad = 1;
+            izq->padre = der->padre = nueva;
+            raiz = nueva;
+            return;
+        }
+        size_t i = indiceHijo(p, izq);
+        Key* k = claves(p);
+        if(p->cantidad < capacidadInterno){
+            mover(k + i, p->cantidad - i, k + i + 1);
+            std::copy_backward(p->hijos + i + 1, p->hijos + p->cantidad + 1, p->hijos + p->cantidad + 2);
+            ::new(static_cast<void*>(k + i)) Key(std::move(sep));
+            p->hijos[i+1] = der;
+            der->padre = p;
+            ++p->cantidad;
+            return;
+        }
+
+        // Pensando en los capacidadInterno + 1 separadores que quedarían al insertar sep en la posición i (y der
+        // como hijo i+1), p se queda con los primeros mitad, el siguiente sube al padre y el resto va a r.
+        Interno* r = reservados[--cantidadReservados];
+        const size_t total = capacidadInterno + 1;
+        const size_t mitad = total / 2;
+        Key* kr = claves(r);
+        Key promovido(std::move(i < mitad ? k[mitad-1] : i == mitad ? sep : k[mitad]));
+        if(i < mitad){
+            k[mitad-1].~Key();
+            mover(k + mitad, capacidadInterno - mitad, kr);
+            std::copy(p->hijos + mitad, p->hijos + capacidadInterno + 1, r->hijos);
+            mover(k + i, mitad - 1 - i, k + i + 1);
+            ::new(static_cast<void*>(k + i)) Key(std::move(sep));
+            std::copy_backward(p->hijos + i + 1, p->hijos + mitad, p->hijos + mitad + 1);
+            p->hijos[i+1] = der;
+        }else if(i == mitad){
+            mover(k + mitad, capacidadInterno - mitad, kr);
+            r->hijos[0] = der;
+            std::copy(p->hijos + mitad + 1, p->hijos + capacidadInterno + 1, r->hijos + 1);
+        }else{
+            k[mitad].~Key();
+            mover(k + mitad + 1, i - mitad - 1, kr);
+            ::new(static_cast<void*>(kr + i - mitad - 1)) Key(std::move(sep));
+            mover(k + i, capacidadInterno - i, kr + i - mitad);
+            std::copy(p->hijos + mitad + 1, p->hijos + i + 1, r->hijos);
+            r->hijos[i - mitad] = der;
+            std::copy(p->hijos + i + 1, p->hijos + capacidadInterno + 1, r->hijos + i - mitad + 1);
+        }
+        p->cantidad = mitad;
+        r->cantidad = total - mitad - 1;
+        der->padre = p;
+        for(size_t j = 0; j <= r->cantidad; ++j) r->hijos[j]->padre = r;
+        insertarEnPadre(p, std::move(promovido), r, reservados, cantidadReservados);
+    }
+
+        /**
+         * \brief quitarSeparador
+         *
+         * \Descripcion Quita de \P{p} el separador \P{k} y el hijo \P{k}+1 (que ya fue fusionado con el hijo \P{k}).
+         *
+         * \complexity{\O(\a B)}
+         */
+    void quitarSeparador(Interno* p, size_t k) {
+        claves(p)[k].~Key();
+        mover(claves(p) + k + 1, p->cantidad - k - 1, claves(p) + k);
+        std::copy(p->hijos + k + 2, p->hijos + p->cantidad + 1, p->hijos + k + 1);
+        --p->cantidad;
+    }
+
+        /**
+         * \brief fusionarHojas
+         *
+         * \Descripcion Mueve los valores de la hoja \P{b} al final de su hermana izquierda \P{a}, donde \P{a} y \P{b} son
+         * los hijos \P{k} y \P{k}+1 de \P{p}.  Luego quita \P{b} del árbol y rebalancea \P{p}.
+         *
+         * \complexity{\O(\a B \CDOT \LOG_B(\SIZE(\P{*this})))}
+         */
+    void fusionarHojas(Hoja* a, Hoja* b, Interno* p, size_t k) {
+        mover(valores(b), b->cantidad, valores(a) + a->cantidad);
+        a->cantidad += b->cantidad;
+        b->cantidad = 0;
+        desenlazar(b);
+        liberar(b);
+        quitarSeparador(p, k);
+        rebalancearInterno(p);
+    }
+
+        /**
+         * \brief rebalancearInterno
+         *
+         * \Descripcion Restablece el invariante en el nodo interno \P{n}, al que se le acaba de quitar un separador.  Si
+         * \P{n} es la raíz y quedó sin separadores, su único hijo pasa a ser la raíz.  Si no, y quedó con menos de
+         * minimoInterno separadores, rota un separador a través del padre desde un hermano que tenga de más o, si
+         * ninguno tiene, se fusiona con un hermano bajando el separador del padre, y repite el proceso en el padre.
+         *
+         * \complexity{\O(\a B \CDOT \LOG_B(\SIZE(\P{*this})))}
+         */
+    void rebalancearInterno(Interno* n) {
+        while(true){
+            if(n == raiz){
+                if(n->cantidad == 0){
+                    raiz = n->hijos[0];
+                    raiz->padre = nullptr;
+                    liberar(n);
+                }
+                return;
+            }
+            if(n->cantidad >= minimoInterno){
+                return;
+            }
+            Interno* p = n->padre;
+            size_t k = indiceHijo(p, n);
+            Interno* izq = k > 0 ? static_cast<Interno*>(p->hijos[k-1]) : nullptr;
+            Interno* der = k < p->cantidad ? static_cast<Interno*>(p->hijos[k+1]) : nullptr;
+            Key* kn = claves(n);
+            Key* kp = claves(p);
+            if(izq != nullptr and izq->cantidad > minimoInterno){
+                mover(kn, n->cantidad, kn + 1);
+                std::copy_backward(n->hijos, n->hijos + n->cantidad + 1, n->hijos + n->cantidad + 2);
+                mover(kp + k - 1, 1, kn);
+                mover(claves(izq) + izq->cantidad - 1, 1, kp + k - 1);
+                n->hijos[0] = izq->hijos[izq->cantidad];
+                n->hijos[0]->padre = n;
+                --izq->cantidad;
+                ++n->cantidad;
+                return;
+            }
+            if(der != nullptr and der->cantidad > minimoInterno){
+                mover(kp + k, 1, kn + n->cantidad);
+                mover(claves(der), 1, kp + k);
+                n->hijos[n->cantidad + 1] = der->hijos[0];
+                n->hijos[n->cantidad + 1]->padre = n;
+                mover(claves(der) + 1, der->cantidad - 1, claves(der));
+                std::copy(der->hijos + 1, der->hijos + der->cantidad + 1, der->hijos);
+                --der->cantidad;
+                ++n->cantidad;
+                return;
+            }
+            if(izq != nullptr){
+                fusionarInternos(izq, n, p, k-1);
+            }else{
+                fusionarInternos(n, der, p, k);
+            }
+            n = p;
+        }
+    }
+
+        /**
+         * \brief fusionarInternos
+         *
+         * \Descripcion Fusiona los nodos internos \P{a} y \P{b}, hijos \P{k} y \P{k}+1 de \P{p}: el separador \P{k} de \P{p}
+         * baja al final de \P{a}, seguido de los separadores e hijos de \P{b}.  Luego quita \P{b} de \P{p} sin rebalancear.
+         *
+         * \complexity{\O(\a B)}
+         */
+    void fusionarInternos(Interno* a, Interno* b, Interno* p, size_t k) {
+        Key* ka = claves(a);
+        ::new(static_cast<void*>(ka + a->cantidad)) Key(std::move(claves(p)[k]));
+        mover(claves(b), b->cantidad, ka + a->cantidad + 1);
+        for(size_t j = 0; j <= b->cantidad; ++j){
+            a->hijos[a->cantidad + 1 + j] = b->hijos[j];
+            b->hijos[j]->padre = a;
+        }
+        a->cantidad += 1 + b->cantidad;
+        b->cantidad = 0;
+        liberar(b);
+        quitarSeparador(p, k);
+    }
+
+        /**
+         * \brief copiarArbol
+         *
+         * \Descripcion Copia en \P{*this}, que debe estar vacío, la estructura de \P{other} nodo por nodo (sin comparar
+         * claves) y luego engancha las hojas copiadas en la lista.  Si alguna copia lanza una excepción, se destruye lo
+         * copiado hasta el momento y \P{*this} queda vacío.
+         *
+         * \complexity{\O(\COPY(\P{other}))}
+         */
+    void copiarArbol(const btree_map& other) {
+        if(other.raiz == nullptr){
+            return;
+        }
+        raiz = copiarNodo(other.raiz, nullptr);
+        Enlace* ultima = &cabecera;
+        enlazarHojas(raiz, ultima);
+        count = other.count;
+    }
+
+        /**
+         * \brief copiarNodo
+         *
+         * \Descripcion Devuelve una copia del subárbol de \P{origen}, colgada de \P{padre}.  Las hojas copiadas no quedan
+         * enganchadas en ninguna lista.
+         *
+         * \complexity{\O(\COPY(\P{origen}))}
+         */
+    Nodo* copiarNodo(const Nodo* origen, Interno* padre) {
+        if(origen->hoja){
+            const Hoja* o = static_cast<const Hoja*>(origen);
+            Hoja* h = crearHoja();
+            h->padre = padre;
+            try{
+                while(h->cantidad < o->cantidad){
+                    std::allocator_traits<Alloc>::construct(alloc, valores(h) + h->cantidad, valores(o)[h->cantidad]);
+                    ++h->cantidad;
+                }
+            }catch(...){
+                destruirNodo(h);
+                throw;
+            }
+            return h;
+        }
+        const Interno* o = static_cast<const Interno*>(origen);
+        Interno* n = crearInterno();
+        n->padre = padre;
+        std::fill(n->hijos, n->hijos + capacidadInterno + 1, nullptr);
+        try{
+            n->hijos[0] = copiarNodo(o->hijos[0], n);
+            while(n->cantidad < o->cantidad){
+                size_t i = n->cantidad;
+                Nodo* hijo = copiarNodo(o->hijos[i+1], n);
+                try{
+                    ::new(static_cast<void*>(claves(n) + i)) Key(claves(o)[i]);
+                }catch(...){
+                    destruirNodo(hijo);
+                    throw;
+                }
+                n->hijos[i+1] = hijo;
+                ++n->cantidad;
+            }
+        }catch(...){
+            destruirNodo(n);
+            throw;
+        }
+        return n;
+    }
+
+    /** \brief Engancha las hojas del subárbol de \P{n}, de izquierda a derecha, a continuación de \P{ultima}.  \complexity{\O(\SIZE(\P{n}))} */
+    static void enlazarHojas(Nodo* n, Enlace*& ultima) {
+        if(n->hoja){
+            enlazarDespues(ultima, static_cast<Hoja*>(n));
+            ultima = static_cast<Hoja*>(n);
+            return;
+        }
+        Interno* in = static_cast<Interno*>(n);
+        for(size_t i = 0; i <= in->cantidad; ++i) enlazarHojas(in->hijos[i], ultima);
+    }
+
+#ifdef DEBUG
+        /**
+         * \brief verificarNodo
+         *
+         * \Descripcion Auxiliar de verificarRep.  Verifica el subárbol de \P{n}, que está a profundidad \P{nivel} y cuyas
+         * claves deben ser mayores o iguales a *\P{menor} y menores a *\P{mayor} (cuando no son nulos).  \P{profundidad}
+         * es la profundidad de las hojas (-1 si todavía no se visitó ninguna), \P{ultima} la última hoja visitada y
+         * \P{valoresVistos} la cantidad de valores de las hojas visitadas.
+         *
+         * \complexity{\O(\SIZE(\P{n}) \CDOT \CMP(\P{*this}))}
+         */
+    bool verificarNodo(const Nodo* n, const Key* menor, const Key* mayor, int nivel, int& profundidad,
+                       const Enlace*& ultima, size_t& valoresVistos) const {
+        if(n->cantidad == 0 or (n != raiz and n->cantidad < (n->hoja ? minimoHoja : minimoInterno))){
+            return false;
+        }
+        if(n->hoja){
+            const Hoja* h = static_cast<const Hoja*>(n);
+            if(profundidad == -1){
+                profundidad = nivel;
+            }
+            if(profundidad != nivel or h->anterior != ultima or ultima->siguiente != h){
+                return false;
+            }
+            const value_type* v = valores(h);
+            for(size_t i = 0; i < h->cantidad; ++i){
+                if((menor != nullptr and lt(v[i].first, *menor)) or (mayor != nullptr and not lt(v[i].first, *mayor))
+                   or (i > 0 and not lt(v[i-1].first, v[i].first))){
+                    return false;
+                }
+            }
+            ultima = h;
+            valoresVistos += h->cantidad;
+            return true;
+        }
+        const Interno* in = static_cast<const Interno*>(n);
+        const Key* k = claves(in);
+        for(size_t i = 0; i < in->cantidad; ++i){
+            if((menor != nullptr and lt(k[i], *menor)) or (mayor != nullptr and not lt(k[i], *mayor))
+               or (i > 0 and not lt(k[i-1], k[i]))){
+                return false;
+            }
+        }
+        for(size_t i = 0; i <= in->cantidad; ++i){
+            if(in->hijos[i]->padre != in or not verificarNodo(in->hijos[i], i > 0 ? k + i - 1 : menor,
+                    i < in->cantidad ? k + i : mayor, nivel + 1, profundidad, ultima, valoresVistos)){
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+    //@}
+};
+
+//////////////////////////////////////
+/** \name Operadores de comparación */
+//////////////////////////////////////
+//@{
+/**
+ * \relates aed2::btree_map
+ * @brief Operador de igualdad entre dos diccionarios.  Ver aed2::operator==(const map&, const map&).
+ *
+ * \complexity{ \O((\SIZE(m1) + \SIZE(m2)) \CDOT (\CMP(m1) + \CMP(m2)))}
+ */
+template<class K, class V, class C, std::size_t B, class A>
+bool operator==(const btree_map<K, V, C, B, A>& m1, const btree_map<K, V, C, B, A>& m2) {
+	return m1.size() == m2.size() and std::equal(m1.begin(), m1.end(), m2.begin());
+}
+
+/**
+ * \relates aed2::btree_map
+ * @brief Renombre de not(\P{m1} == \P{m2})
+ */
+template<class K, class V, class C, std::size_t B, class A>
+bool operator!=(const btree_map<K, V, C, B, A>& m1, const btree_map<K, V, C, B, A>& m2) {
+	return not(m1 == m2);
+}
+
+/**
+ * \relates aed2::btree_map
+ * @brief Operador de orden lexicografico entre diccionarios.  Ver aed2::operator<(const map&, const map&).
+ *
+ * \complexity{ \O((\SIZE(m1) + \SIZE(m2)) \CDOT (\CMP(m1) + \CMP(m2)))}
+ */
+template<class K, class V, class C, std::size_t B, class A>
+bool operator<(const btree_map<K, V, C, B, A>& m1, const btree_map<K, V, C, B, A>& m2) {
+	return std::lexicographical_compare(m1.begin(), m1.end(), m2.begin(), m2.end());
+}
+
+/**
+ * \relates aed2::btree_map
+ * @brief Renombre de \P{m2} < \P{m1}
+ */
+template<class K, class V, class C, std::size_t B, class A>
+bool operator>(const btree_map<K, V, C, B, A>& m1, const btree_map<K, V, C, B, A>& m2) {
+	return m2 < m1;
+}
+
+/**
+ * \relates aed2::btree_map
+ * @brief Renombre de not(\P{m2} < \P{m1})
+ */
+template<class K, class V, class C, std::size_t B, class A>
+bool operator<=(const btree_map<K, V, C, B, A>& m1, const btree_map<K, V, C, B, A>& m2) {
+	return not(m2 < m1);
+}
+
+/**
+ * \relates aed2::btree_map
+ * @brief Renombre de not(\P{m1} < \P{m2})
+ */
+template<class K, class V, class C, std::size_t B, class A>
+bool operator>=(const btree_map<K, V, C, B, A>& m1, const btree_map<K, V, C, B, A>& m2) {
+	return not(m1 < m2);
+}
+//@}
+
+/**
+ * \relates aed2::btree_map
+ * @brief Implementa la función swap para cumplir con el concepto swappable
+ *
+ * \complexity{\O(1)}
+ */
+template<class K, class V, class C, std::size_t B, class A>
+void swap(btree_map<K, V, C, B, A>& m1, btree_map<K, V, C, B, A>& m2) noexcept(noexcept(m1.swap(m2))) {
+	m1.swap(m2);
+}
+
+}
+
+#endif /* BTREE_MAP_H_ */
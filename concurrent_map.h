@@ -0,0 +1,567 @@
+/**
+ * @file concurrent_map.h
+ *
+ * Módulo C++ que implementa un diccionario ordenado que se puede compartir entre varios hilos, con lecturas que no
+ * toman locks.
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef CONCURRENT_MAP_H_
+#define CONCURRENT_MAP_H_
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <cassert>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include "persistent_map.h"
+
+namespace aed2{
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado que admite lecturas y escrituras concurrentes.
+ *
+ * aed2::map no se puede usar desde varios hilos a la vez si alguno lo modifica: una inserción rota nodos que otra
+ * búsqueda puede estar recorriendo.  aed2::concurrent_map resuelve esto sin que las lecturas tomen locks, con un
+ * árbol cuyos nodos no se modifican nunca una vez publicados:
+ * - Las escrituras (insert, insert_or_assign, erase, clear) se serializan con un mutex.  Cada una copia los
+ *   \O(\LOG(\SIZE(d))) nodos del camino que modifica, comparte el resto con la versión anterior y publica la raíz
+ *   nueva con una única escritura atómica.
+ * - Las lecturas se hacen a través de una vista (aed2::concurrent_map::reader) que toma la raíz vigente al
+ *   crearse y la recorre como si fuese un diccionario constante: find, lower_bound, upper_bound y los iteradores
+ *   ven siempre la misma versión, aunque haya escrituras en el medio.  Crear y destruir la vista cuesta dos
+ *   operaciones atómicas sobre un contador que, en general, ningún otro hilo usa.
+ * - Los nodos que dejan de pertenecer a la versión vigente se liberan recién cuando ninguna vista los puede
+ *   estar recorriendo, con un esquema de períodos de gracia (ver \ref Concurrencia).
+ *
+ * Las versiones son las de aed2::persistent_map, cuyo árbol no tiene punteros al padre y se balancea por peso
+ * (\cite HiraiYamamoto2011) en lugar de por color, para que las rotaciones de una inserción o un borrado sólo
+ * toquen nodos del camino o sus hijos.  Una versión se puede sacar del diccionario como aed2::persistent_map con
+ * snapshot(), sin tomar locks; a diferencia de una vista, una versión así no retrasa la liberación de ningún
+ * nodo que no le pertenezca, por lo que se puede guardar indefinidamente.
+ *
+ * @tparam Key tipo de la clave.  Además de lo pedido por aed2::map, tiene que tener constructor por copia.
+ * @tparam Meaning tipo del significado.  Tiene que tener constructor por copia.
+ * @tparam Compare tipo del comparador.  Se usa desde varios hilos a la vez, por lo que no puede tener estado
+ * mutable sin sincronizar.
+ * @tparam Alloc allocator estándar de C++ del que se obtiene la memoria de los nodos.  Sólo se usa desde el hilo que
+ * escribe, con el mutex tomado.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map.
+ *
+ * \par Aspectos generales de aliasing
+ * Los valores se ven únicamente a través de las vistas, como referencias constantes, y se mantienen válidos
+ * mientras exista la vista que los devolvió.  Una escritura nunca modifica un valor: insert_or_assign construye
+ * un nodo nuevo con el significado nuevo.
+ *
+ * \attention Las vistas retrasan la liberación de los nodos que reemplazan las escrituras.  Conviene que vivan lo
+ * que dura una consulta y no más.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>,
+  class Alloc = std::allocator<std::pair<const Key, Meaning>>
+>
+class concurrent_map {
+    using Nodo = typename persistent_map<Key, Meaning, Compare, Alloc>::Nodo;
+
+    /** \brief Cantidad de contadores de lectores por fase; cada hilo usa siempre el mismo */
+    static constexpr unsigned franjas = 64;
+
+public:
+    //forward declarations
+    class reader;
+
+    /** \brief Tipo de las versiones del diccionario, que devuelve snapshot. */
+    using snapshot_type = persistent_map<Key, Meaning, Compare, Alloc>;
+    /** \brief Iterador de una vista.  Ver aed2::persistent_map::const_iterator. */
+    using const_iterator = typename snapshot_type::const_iterator;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Renombre para poder acceder al tipo del allocator.  Compatible con estándar C++. */
+    using allocator_type = Alloc;
+    /** \brief Renombre para poder acceder al tipo de referencia constante de los valores guardados.  Compatible con estándar C++. */
+    using const_reference = const value_type&;
+    /** \brief Renombre para poder acceder al tipo de los punteros de los valores constantes guardados.  Compatible con estándar C++. */
+    using const_pointer = const value_type*;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Constructor por defecto del diccionario.  Ver aed2::map::map().
+     *
+     * \complexity{\O(1)}
+     */
+    explicit concurrent_map(Compare c = Compare(), const Alloc& a = Alloc()) : vigente(c, a), pendientes(allocator_versiones(a)),
+        anteriores(allocator_versiones(a)) {}
+
+    /**
+     * @brief Constructor a partir de un rango de valores.  Si hay claves repetidas, se queda con la primera.
+     *
+     * \complexity{\O(\a n \CDOT \LOG(\a n) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type))), donde \a n es la longitud del rango}
+     */
+    template<class iterator>
+    concurrent_map(iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc()) : concurrent_map(c, a) {
+        for(; first != last; ++first) insert(*first);
+    }
+
+    /** @brief El diccionario no se puede copiar: ver aed2::concurrent_map::reader para leer una versión */
+    concurrent_map(const concurrent_map&) = delete;
+
+    /** @brief El diccionario no se puede asignar */
+    concurrent_map& operator=(const concurrent_map&) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * \pre Ningún otro hilo está usando el diccionario ni tiene vistas suyas.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    ~concurrent_map() = default;
+
+    /**
+     * @brief Devuelve una copia del allocator del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    allocator_type get_allocator() const {
+        return vigente.get_allocator();
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Lectura */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve una vista de la versión vigente del diccionario, sobre la que se pueden hacer búsquedas y
+     * recorridos sin tomar locks.
+     *
+     * \aliasing{La vista no ve las escrituras posteriores a su creación.}
+     *
+     * \complexity{\O(1)}
+     */
+    reader read() const {
+        return reader(this);
+    }
+
+    /**
+     * @brief Devuelve la versión vigente del diccionario como un aed2::persistent_map, sin tomar locks.
+     *
+     * A diferencia de una vista, la versión devuelta no retrasa la liberación de los nodos que reemplazan las
+     * escrituras posteriores: sólo retiene los suyos.  Por eso se puede guardar todo lo que haga falta (por
+     * ejemplo, para un reporte consistente sobre un diccionario que se sigue modificando) y pasar a otros hilos.
+     *
+     * \aliasing{La versión no ve las escrituras posteriores, y modificarla no modifica \P{*this}.}
+     *
+     * \complexity{\O(1)}
+     */
+    snapshot_type snapshot() const {
+        reader vista = read();
+        return snapshot_type(vigente, const_cast<Nodo*>(vista.raiz));
+    }
+
+    /**
+     * @brief Indica si la clave \P{key} está definida en la versión vigente.  Equivale a read().contains(\P{key}).
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    bool contains(const Key& key) const {
+        return read().contains(key);
+    }
+
+    /**
+     * @brief Devuelve 1 si la clave \P{key} está definida en la versión vigente y 0 si no.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    size_t count(const Key& key) const {
+        return read().count(key);
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores de la versión vigente.
+     *
+     * \complexity{\O(1)}
+     */
+    size_t size() const {
+        return read().size();
+    }
+
+    /**
+     * @brief Indica si la versión vigente es vacía.
+     *
+     * \complexity{\O(1)}
+     */
+    bool empty() const {
+        return read().empty();
+    }
+    //@}
+
+	//////////////////////////////////////////////
+    /** \name Escritura */
+    //////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Inserta \P{value} si su clave no está definida.  Las escrituras se ejecutan de a una.
+     *
+     * @returns true si se insertó \P{value}.
+     *
+     * \aliasing{Las vistas existentes no ven el valor nuevo.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{res \IGOBS \LNOT def?(value.first, self) \LAND (res \IMPLIES_L *this \IGOBS definir(value.first, value.second, self))
+     * \LAND (\LNOT res \IMPLIES_L *this \IGOBS self)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type))), más la espera del mutex}
+     */
+    bool insert(const value_type& value) {
+        std::lock_guard<std::mutex> lock(escritura);
+        if(vigente.contains(value.first)) return false;
+        prepararPublicacion();
+        snapshot_type anterior = vigente;
+        vigente.insert(value);
+        publicar(std::move(anterior));
+        return true;
+    }
+
+    /**
+     * @brief Define \P{key} con el significado \P{m}, reemplazando el anterior si la clave ya estaba definida.
+     *
+     * @returns true si la clave no estaba definida.
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS definir(key, m, self) \LAND res \IGOBS \LNOT def?(key, self)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type))), más la espera del mutex}
+     */
+    template<class M>
+    bool insert_or_assign(const Key& key, M&& m) {
+        std::lock_guard<std::mutex> lock(escritura);
+        prepararPublicacion();
+        snapshot_type anterior = vigente;
+        bool nueva = vigente.insert_or_assign(key, std::forward<M>(m));
+        publicar(std::move(anterior));
+        return nueva;
+    }
+
+    /**
+     * @brief Elimina el valor de clave \P{key}, si existe.
+     *
+     * @returns la cantidad de valores eliminados (0 o 1).
+     *
+     * \aliasing{Las vistas existentes siguen viendo el valor eliminado.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS borrar(key, self) \LAND res \IGOBS \IF def?(key, self) \THEN 1 \ELSE 0 \FI}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type))), más la espera del mutex}
+     */
+    size_t erase(const Key& key) {
+        std::lock_guard<std::mutex> lock(escritura);
+        if(not vigente.contains(key)) return 0;
+        prepararPublicacion();
+        snapshot_type anterior = vigente;
+        vigente.erase(key);
+        publicar(std::move(anterior));
+        return 1;
+    }
+
+    /**
+     * @brief Elimina todos los valores del diccionario.
+     *
+     * \aliasing{Las vistas existentes siguen viendo todos los valores.}
+     *
+     * \complexity{\O(1) más la espera del mutex; los valores se destruyen en alguna escritura posterior, cuando
+     * ninguna vista los puede estar recorriendo.}
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(escritura);
+        prepararPublicacion();
+        snapshot_type anterior = vigente;
+        vigente.clear();
+        publicar(std::move(anterior));
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación de la versión vigente.
+     *
+     * Función de debugging que chequea que las claves estén ordenadas, que los tamaños de los subárboles sean
+     * correctos y que los nodos estén balanceados por peso.
+     *
+     * \pre No hay escrituras concurrentes.
+     *
+     * \complexity{\O(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        return vigente.verificarRep() and raiz.load() == vigente.raiz;
+    }
+#endif
+
+    /**
+     * @brief Vista de una versión del diccionario.
+     *
+     * Una vista fija la versión vigente al crearse y ofrece sobre ella la interfaz de búsqueda y recorrido de un
+     * aed2::map constante.  Ninguna de sus operaciones toma locks, y ninguna escritura posterior a su creación
+     * la afecta.  Una vista se usa desde un solo hilo y no se puede copiar, pero se puede mover.
+     *
+     * \attention Los nodos de la versión vista no se liberan mientras la vista exista.
+     */
+    class reader {
+    public:
+        /** @brief Constructor por movimiento.  \P{other} queda sin versión y sólo se puede destruir.  \complexity{\O(1)} */
+        reader(reader&& other) : dicc(other.dicc), raiz(other.raiz), fase(other.fase), franja(other.franja) {
+            other.dicc = nullptr;
+        }
+
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+
+        /** @brief Destructor.  Libera la versión vista.  \complexity{\O(1)} */
+        ~reader() {
+            if(dicc != nullptr) dicc->salir(fase, franja);
+        }
+
+        /**
+         * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+         *
+         * \pre \aedpre{def?(key, *this)}
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+        const Meaning& at(const Key& key) const {
+            return find(key)->second;
+        }
+
+        /**
+         * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+        const_iterator find(const Key& key) const {
+            return dicc->vigente.buscarIterador(raiz, key);
+        }
+
+        /**
+         * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+        const_iterator lower_bound(const Key& key) const {
+            return dicc->vigente.primeroNoMenor(raiz, key);
+        }
+
+        /**
+         * @brief Devuelve un iterador al primer valor con clave mayor a \P{key}.  Ver aed2::map::upper_bound.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+        const_iterator upper_bound(const Key& key) const {
+            return dicc->vigente.primeroMayor(raiz, key);
+        }
+
+        /**
+         * @brief Indica si la clave \P{key} está definida.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+        bool contains(const Key& key) const {
+            return dicc->vigente.buscar(raiz, key) != nullptr;
+        }
+
+        /** @brief Devuelve 1 si la clave \P{key} está definida y 0 si no.  \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))} */
+        size_t count(const Key& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        /** @brief Indica si la versión vista es vacía.  \complexity{\O(1)} */
+        bool empty() const {
+            return raiz == nullptr;
+        }
+
+        /** @brief Devuelve la cantidad de valores de la versión vista.  \complexity{\O(1)} */
+        size_t size() const {
+            return snapshot_type::tamanio(raiz);
+        }
+
+        /** @brief Iterador al primer valor.  \complexity{\O(\LOG(\SIZE(\P{*this})))} */
+        const_iterator begin() const {
+            return snapshot_type::primero(raiz);
+        }
+
+        /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+        const_iterator end() const {
+            return const_iterator();
+        }
+
+    private:
+        explicit reader(const concurrent_map* d) : dicc(d), franja(franjaDelHilo()) {
+            fase = dicc->entrar(franja);
+            raiz = dicc->raiz.load();
+        }
+
+        /** \brief Diccionario visto, o nullptr si la vista fue movida */
+        const concurrent_map* dicc;
+        /** \brief Raíz de la versión vista */
+        const Nodo* raiz;
+        /** \brief Fase en la que se contó la vista */
+        unsigned fase;
+        /** \brief Contador de la fase en el que se contó la vista */
+        unsigned franja;
+        friend class concurrent_map;
+    };
+
+private:
+    using allocator_versiones = typename std::allocator_traits<Alloc>::template rebind_alloc<snapshot_type>;
+
+    /** \brief Contador de lectores, en su propia línea de cache para que los hilos no compitan por ella */
+    struct alignas(64) Contador {
+        std::atomic<size_t> lectores{0};
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - \P{raiz} es la raíz de \P{vigente}.
+     * - Todas las vistas contadas en la fase 1 - \P{fase} se crearon antes de publicar las versiones que
+     *   reemplazaron a las de \P{pendientes}; todas las contadas en la fase \P{fase}, antes de publicar las versiones
+     *   de las escrituras posteriores.
+     * \endparblock
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /**
+     * \brief Versión vigente.  Sólo la modifica el hilo que tiene el mutex; las vistas usan su comparador y recorren
+     * sus nodos a partir de \P{raiz}.
+     */
+    snapshot_type vigente;
+    /** \brief Raíz de la versión vigente, publicada para las vistas (nullptr si es vacía) */
+    std::atomic<Nodo*> raiz{nullptr};
+    /** \brief Mutex que serializa las escrituras; protege todos los miembros que siguen salvo \P{contadores} */
+    std::mutex escritura;
+    /** \brief Fase en la que se cuentan las vistas nuevas: 0 o 1 */
+    std::atomic<unsigned> fase{0};
+    /** \brief Versiones reemplazadas durante la fase vigente */
+    std::vector<snapshot_type, allocator_versiones> pendientes;
+    /** \brief Versiones reemplazadas durante la fase anterior */
+    std::vector<snapshot_type, allocator_versiones> anteriores;
+    /** \brief Cantidad de vistas existentes, por fase y franja */
+    mutable Contador contadores[2][franjas];
+    //@}
+
+    /////////////////////////////////
+    /** \name Funciones auxiliares */
+    /////////////////////////////////
+    //@{
+        /**
+         * \brief franjaDelHilo
+         *
+         * \Descripcion Devuelve el contador de cada fase que usa el hilo actual.  Los hilos se reparten los
+         * contadores en orden de llegada, así que hasta \P{franjas} hilos no comparten ninguno.
+         *
+         * \complexity{\O(1)}
+         */
+    static unsigned franjaDelHilo() {
+        static std::atomic<unsigned> siguiente{0};
+        thread_local unsigned franja = siguiente.fetch_add(1, std::memory_order_relaxed) % franjas;
+        return franja;
+    }
+
+        /**
+         * \brief entrar
+         *
+         * \Descripcion Cuenta una vista nueva en la fase vigente y la devuelve.  Si la fase cambia mientras se
+         * cuenta, se descuenta y se vuelve a intentar, para que toda vista contada en una fase haya leído la raíz
+         * después de que la fase empezara.
+         *
+         * \complexity{\O(1) salvo que la fase cambie entre las dos lecturas}
+         */
+    unsigned entrar(unsigned franja) const {
+        for(;;){
+            unsigned f = fase.load();
+            contadores[f][franja].lectores.fetch_add(1);
+            if(fase.load() == f){
+                return f;
+            }
+            contadores[f][franja].lectores.fetch_sub(1);
+        }
+    }
+
+    /** \brief Descuenta una vista contada en la fase \P{f} */
+    void salir(unsigned f, unsigned franja) const {
+        contadores[f][franja].lectores.fetch_sub(1);
+    }
+
+    /** \brief Indica si no hay vistas contadas en la fase \P{f} */
+    bool sinLectores(unsigned f) const {
+        for(const Contador& c : contadores[f]){
+            if(c.lectores.load() != 0) return false;
+        }
+        return true;
+    }
+
+    /** \brief Reserva lugar en \P{pendientes} para la versión que va a reemplazar la próxima escritura, antes de construirla */
+    void prepararPublicacion() {
+        pendientes.reserve(pendientes.size() + 1);
+    }
+
+        /**
+         * \brief publicar
+         *
+         * \Descripcion Publica la raíz de \P{vigente}, que reemplaza a la versión \P{anterior}, y recupera la memoria
+         * de las versiones que ya no puede estar viendo ninguna vista.
+         *
+         * Las versiones reemplazadas se guardan en \P{pendientes} hasta que cambia la fase; la fase cambia cuando no
+         * quedan vistas contadas en la fase anterior, y en ese momento se sueltan las versiones de \P{anteriores}:
+         * como fueron reemplazadas antes del cambio de fase previo, sólo las pueden estar viendo vistas contadas en
+         * la fase anterior, que ya no existen.  Soltar una versión destruye sólo los nodos que no comparte con otras.
+         * Ninguna escritura espera a las vistas: si quedan vistas viejas, las versiones se siguen acumulando hasta
+         * una escritura posterior.
+         *
+         * \pre Se llamó a prepararPublicacion y se tiene el mutex.
+         *
+         * \complexity{\O(\P{franjas} \PLUS \DEL(nodos que sólo pertenecían a las versiones liberadas))}
+         */
+    void publicar(snapshot_type&& anterior) noexcept {
+        raiz.store(vigente.raiz);
+        pendientes.push_back(std::move(anterior));
+        unsigned f = fase.load(std::memory_order_relaxed);
+        if(not sinLectores(1 - f)) return;
+        anteriores.clear();
+        anteriores.swap(pendientes);
+        fase.store(1 - f);
+    }
+    //@}
+};
+
+}
+
+#endif /* CONCURRENT_MAP_H_ */
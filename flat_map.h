@@ -0,0 +1,1011 @@
+/**
+ * @file flat_map.h
+ *
+ * Módulo C++ que implementa un diccionario ordenado sobre dos arreglos contiguos (claves y significados), con la
+ * misma interfaz que aed2::map, para diccionarios que se consultan mucho más de lo que se modifican.
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef FLAT_MAP_H_
+#define FLAT_MAP_H_
+
+#include "map.h"
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace aed2{
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado sobre arreglos contiguos.
+ *
+ * Muchos diccionarios se arman una vez y después sólo se consultan.  En ese caso los tres punteros de cada nodo
+ * de aed2::map son memoria desperdiciada, y cada paso de una búsqueda o de un recorrido es un acceso a una
+ * dirección que depende del paso anterior.  aed2::flat_map guarda las claves, ordenadas, en un arreglo contiguo, y
+ * los significados en otro arreglo paralelo: una búsqueda es una búsqueda binaria sobre las claves (sin saltos
+ * condicionales que dependan de las comparaciones, ver lower_bound), y un recorrido avanza dos punteros sobre
+ * memoria contigua, al ritmo al que la memoria entrega los datos.
+ *
+ * La interfaz es la de aed2::map, así que se puede pasar de uno a otro con un renombre de tipos, y
+ * aed2::freeze convierte un aed2::map ya armado en un aed2::flat_map en \O(\a n), sin comparar claves.  A cambio,
+ * insertar o borrar un valor mueve todos los valores que le siguen: \O(\a n) en peor caso.  Ver \ref Plano.
+ *
+ * Como las claves y los significados están separados, no hay ningún value_type guardado al que se pueda referir:
+ * los iteradores devuelven un std::pair de referencias a la clave y al significado, que se usa igual que un
+ * value_type (`it->first`, `it->second`, `auto [k, v] = *it`).
+ *
+ * @tparam Key tipo de la clave.  Tiene que tener constructor por movimiento y asignación por movimiento.
+ * @tparam Meaning tipo del significado.  Tiene que tener constructor por movimiento y asignación por movimiento.
+ * @tparam Compare tipo del comparador.
+ * @tparam Alloc allocator estándar de C++, del que se obtienen (con rebind) los allocators de los arreglos.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map; además, llamamos \a n al tamaño del diccionario.
+ *
+ * \par Aspectos generales de aliasing
+ * A diferencia de aed2::map, las inserciones y los borrados mueven valores dentro de los arreglos (y pueden
+ * reubicarlos), por lo que <b>invalidan todos los iteradores, referencias y punteros a los valores</b>.  Las
+ * operaciones que no modifican la estructura (búsquedas, acceso a los significados, recorridos) no invalidan nada.
+ *
+ * \attention Si mover una clave o un significado puede lanzar una excepción, una inserción o un borrado que falla
+ * deja al diccionario en un estado válido pero no especificado.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>,
+  class Alloc = std::allocator<std::pair<const Key, Meaning>>
+>
+class flat_map {
+    using AllocClaves = typename std::allocator_traits<Alloc>::template rebind_alloc<Key>;
+    using AllocSignificados = typename std::allocator_traits<Alloc>::template rebind_alloc<Meaning>;
+
+	struct Lugar;
+public:
+    //forward declarations
+    class iterator;
+    class const_iterator;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Renombre para poder acceder al tipo del allocator.  Compatible con estándar C++. */
+    using allocator_type = Alloc;
+    /** \brief Par de referencias a la clave y al significado de un valor guardado. */
+    using reference = std::pair<const Key&, Meaning&>;
+    /** \brief Par de referencias a la clave y al significado constante de un valor guardado. */
+    using const_reference = std::pair<const Key&, const Meaning&>;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+    /** \brief Iterador para recorrer un diccionario en orden inverso.  Compatible con estándar C++. */
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    /** \brief Iterador para recorrer un diccionario constante en orden inverso.  Compatible con estándar C++. */
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción, asignación y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Constructor por defecto del diccionario.  Ver aed2::map::map().
+     *
+     * \complexity{\O(1)}
+     */
+    explicit flat_map(Compare c = Compare(), const Alloc& a = Alloc())
+        : lt(c), claves(AllocClaves(a)), significados(AllocSignificados(a)) {}
+
+    /**
+     * @brief Constructor a partir de un rango de valores.  Ver aed2::map::map(iterator, iterator, Compare, const Alloc&).
+     *
+     * Si el rango está ordenado de forma estrictamente creciente, los valores se agregan al final en el orden en que
+     * vienen.  Si no, se ordenan (de forma estable) y de cada clave repetida se queda el primer valor, como si se
+     * insertaran de a uno.
+     *
+     * \complexity{\O(\a n \CDOT \LOG(\a n) \CDOT \CMP(\P{*this})), donde \a n es la longitud del rango; \O(\a n) si el
+     * rango está ordenado.}
+     */
+    template<class iterator>
+    flat_map(iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc())
+        : flat_map(c, a) {
+        for(; first != last; ++first){
+            if(not empty() and not lt(claves.back(), first->first)){
+                insertarDesordenados(first, last);
+                return;
+            }
+            agregar(first->first, first->second);
+        }
+    }
+
+    /**
+     * @brief Constructor a partir de un rango ordenado sin claves repetidas.  Ver aed2::map::map(sorted_unique_t,
+     * iterator, iterator, Compare, const Alloc&).
+     *
+     * \pre \aedpre{El rango está ordenado de forma estrictamente creciente según \P{c}.}
+     *
+     * \complexity{\O(\a n), donde \a n es la longitud del rango}
+     */
+    template<class iterator>
+    flat_map(sorted_unique_t, iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc())
+        : flat_map(c, a) {
+        if constexpr(std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<iterator>::iterator_category>){
+            reserve(static_cast<size_t>(std::distance(first, last)));
+        }
+        for(; first != last; ++first) agregar(first->first, first->second);
+        assert(verificarOrden());
+    }
+
+    /**
+     * @brief Constructor por copia.  Copia los dos arreglos, sin comparar claves.
+     *
+     * \complexity{\O(\COPY(\P{other}))}
+     */
+    flat_map(const flat_map& other) = default;
+
+    /**
+     * @brief Constructor por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    flat_map(flat_map&& other) noexcept(std::is_nothrow_copy_constructible<Compare>::value)
+        : lt(other.lt), claves(std::move(other.claves)), significados(std::move(other.significados)) {
+        other.clear();
+    }
+
+    /**
+     * @brief Operador de asignación por copia.  Ver aed2::map::operator=(const map&).
+     *
+     * \complexity{\O(\DEL(\P{*this}) \PLUS \COPY(\P{other}))}
+     */
+    flat_map& operator=(const flat_map& other) = default;
+
+    /**
+     * @brief Operador de asignación por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    flat_map& operator=(flat_map&& other) noexcept(std::is_nothrow_swappable<Compare>::value) {
+        if(this != &other){
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Devuelve una copia del allocator del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    allocator_type get_allocator() const {
+        return allocator_type(claves.get_allocator());
+    }
+
+    /**
+     * @brief Devuelve una copia del comparador de claves.
+     *
+     * \complexity{\O(1)}
+     */
+    key_compare key_comp() const {
+        return lt;
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Busqueda y acceso a los valores */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+     *
+     * Si \T{Compare} es transparente, \P{key} puede ser de cualquier tipo comparable con \T{Key}; ver \ref Busqueda.
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    const Meaning& at(const Key& key) const {
+        return significados[buscar(key)];
+    }
+
+    /** \overload */
+    Meaning& at(const Key& key) {
+        return significados[buscar(key)];
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const Meaning& at(const K& key) const {
+        return significados[buscar(key)];
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    Meaning& at(const K& key) {
+        return significados[buscar(key)];
+    }
+
+    /**
+     * @brief Devuelve el significado de \P{key}, definiéndolo con \T{Meaning}() si no existe.  Ver aed2::map::operator[].
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \a x), donde \a x es 1 si def?(\P{key}, \P{*this})
+     * y \SIZE(\P{*this}) si no.}
+     */
+    Meaning& operator[](const Key& key) {
+        return significados[posicion(try_emplace(key))];
+    }
+
+    /** \overload */
+    Meaning& operator[](Key&& key) {
+        return significados[posicion(try_emplace(std::move(key)))];
+    }
+
+    /**
+     * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+     *
+     * Si \T{Compare} es transparente, \P{key} puede ser de cualquier tipo comparable con \T{Key}; ver \ref Busqueda.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    iterator find(const Key& key) {
+        return iterador(buscar(key));
+    }
+
+    /** \overload */
+    const_iterator find(const Key& key) const {
+        return iterador(buscar(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator find(const K& key) {
+        return iterador(buscar(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K& key) const {
+        return iterador(buscar(key));
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+     *
+     * Si \T{Compare} es transparente, \P{key} puede ser de cualquier tipo comparable con \T{Key}; ver \ref Busqueda.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     *
+     * \note La búsqueda binaria hace siempre ⌈\LOG(\SIZE(\P{*this}) + 1)⌉ comparaciones, y el resultado de cada una
+     * sólo decide cuánto avanzar (con un move condicional, no con un salto), así que no hay predicciones fallidas.
+     */
+    const_iterator lower_bound(const Key& key) const {
+        return iterador(cotaInferior(key));
+    }
+
+    /** \overload */
+    iterator lower_bound(const Key& key) {
+        return iterador(cotaInferior(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K& key) const {
+        return iterador(cotaInferior(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator lower_bound(const K& key) {
+        return iterador(cotaInferior(key));
+    }
+    //@}
+
+    ///////////////////////////////////
+    /** \name Tamaño del diccionario */
+    ///////////////////////////////////
+    //@{
+    /**
+     * @brief Indica si el diccionario está vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    bool empty() const {
+        return claves.empty();
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    size_t size() const {
+        return claves.size();
+    }
+
+    /**
+     * @brief Reserva lugar para \P{n} valores, de modo que las inserciones no reubiquen los arreglos mientras el
+     * tamaño no supere \P{n}.
+     *
+     * \complexity{\O(\SIZE(\P{*this})) si hay que reubicar los arreglos; \O(1) si no.}
+     */
+    void reserve(size_t n) {
+        claves.reserve(n);
+        significados.reserve(n);
+    }
+    //@}
+
+    //////////////////////////////////////////////
+    /** \name Inserción, borrado y modificación */
+    //////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Inserta \P{value} si su clave no está definida, usando \P{hint} como sugerencia.  Ver aed2::map::insert.
+     *
+     * Si \P{hint} apunta al sucesor de la posición de \P{value}, la posición se verifica con a lo sumo dos
+     * comparaciones y no se busca.
+     *
+     * \complexity{\O(\CMP(\P{*this}) \PLUS \SIZE(\P{*this})) si \P{hint} es correcto;
+     * \O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \SIZE(\P{*this})) si no.}
+     */
+    iterator insert(const_iterator hint, const value_type& value) {
+        return construirEn(lugarConHint(hint, value.first), value.first, value.second);
+    }
+
+    /** \overload */
+    iterator insert(const value_type& value) {
+        return construirEn(lugar(value.first), value.first, value.second);
+    }
+
+    /** \overload */
+    iterator insert(const_iterator hint, value_type&& value) {
+        return construirEn(lugarConHint(hint, value.first), value.first, std::move(value.second));
+    }
+
+    /** \overload */
+    iterator insert(value_type&& value) {
+        return construirEn(lugar(value.first), value.first, std::move(value.second));
+    }
+
+    /**
+     * @brief Construye un valor con \P{args} y lo inserta si su clave no está definida.  Ver aed2::map::emplace.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \SIZE(\P{*this}))}
+     */
+    template<class... Args>
+    iterator emplace(Args&&... args) {
+        std::pair<Key, Meaning> value(std::forward<Args>(args)...);
+        return construirEn(lugar(value.first), std::move(value.first), std::move(value.second));
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        std::pair<Key, Meaning> value(std::forward<Args>(args)...);
+        return construirEn(lugarConHint(hint, value.first), std::move(value.first), std::move(value.second));
+    }
+
+    /**
+     * @brief Si \P{key} no está definida, la define con el significado construido con \P{args}.  Ver
+     * aed2::map::try_emplace.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \SIZE(\P{*this}))}
+     */
+    template<class... Args>
+    iterator try_emplace(const Key& key, Args&&... args) {
+        return construirEn(lugar(key), key, std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(Key&& key, Args&&... args) {
+        return construirEn(lugar(key), std::move(key), std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(const_iterator hint, const Key& key, Args&&... args) {
+        return construirEn(lugarConHint(hint, key), key, std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(const_iterator hint, Key&& key, Args&&... args) {
+        return construirEn(lugarConHint(hint, key), std::move(key), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Define (o redefine) la clave de \P{value} con su significado.  Ver aed2::map::insert_or_assign.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \SIZE(\P{*this}))}
+     */
+    iterator insert_or_assign(const_iterator hint, const value_type& value) {
+        return asignarOConstruir(lugarConHint(hint, value.first), value.first, value.second);
+    }
+
+    /** \overload */
+    iterator insert_or_assign(const value_type& value) {
+        return asignarOConstruir(lugar(value.first), value.first, value.second);
+    }
+
+    /** \overload */
+    iterator insert_or_assign(const_iterator hint, value_type&& value) {
+        return asignarOConstruir(lugarConHint(hint, value.first), value.first, std::move(value.second));
+    }
+
+    /** \overload */
+    iterator insert_or_assign(value_type&& value) {
+        return asignarOConstruir(lugar(value.first), value.first, std::move(value.second));
+    }
+
+    /** \overload */
+    template<class M>
+    iterator insert_or_assign(const Key& key, M&& obj) {
+        return asignarOConstruir(lugar(key), key, std::forward<M>(obj));
+    }
+
+    /**
+     * @brief Elimina el valor apuntado por \P{pos}.  Ver aed2::map::erase(const_iterator).
+     *
+     * @retval res iterador al valor siguiente al eliminado.
+     *
+     * \complexity{\O(\SIZE(\P{*this}))}
+     */
+    iterator erase(const_iterator pos) {
+        size_t i = posicion(pos);
+        claves.erase(claves.begin() + i);
+        significados.erase(significados.begin() + i);
+        return iterador(i);
+    }
+
+    /**
+     * @brief Elimina los valores del rango [\P{first}, \P{last}).  Ver aed2::map::erase(const_iterator, const_iterator).
+     *
+     * @retval res iterador al valor siguiente al último eliminado.
+     *
+     * \complexity{\O(\SIZE(\P{*this}))}
+     */
+    iterator erase(const_iterator first, const_iterator last) {
+        size_t i = posicion(first), j = posicion(last);
+        claves.erase(claves.begin() + i, claves.begin() + j);
+        significados.erase(significados.begin() + i, significados.begin() + j);
+        return iterador(i);
+    }
+
+    /**
+     * @brief Elimina el valor cuya clave es \P{key}.  Ver aed2::map::erase(const Key&).
+     *
+     * Si \T{Compare} es transparente, \P{key} puede ser de cualquier tipo comparable con \T{Key}; ver \ref Busqueda.
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \SIZE(\P{*this}))}
+     */
+    void erase(const Key& key) {
+        erase(find(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent,
+            class = std::enable_if_t<not std::is_convertible_v<K, const_iterator>>>
+    void erase(const K& key) {
+        erase(find(key));
+    }
+
+    /**
+     * @brief Elimina todos los valores.  Conserva la memoria reservada por los arreglos.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    void clear() {
+        claves.clear();
+        significados.clear();
+    }
+
+    /**
+     * @brief Intercambia los valores de \P{*this} y \P{other}.  Ver aed2::map::swap.
+     *
+     * \complexity{\O(1)}
+     */
+    void swap(flat_map& other) noexcept(std::is_nothrow_swappable<Compare>::value) {
+        using std::swap;
+        swap(lt, other.lt);
+        claves.swap(other.claves);
+        significados.swap(other.significados);
+    }
+    //@}
+
+    ///////////////////////////////////////////////
+    /** \name Recorridos e iteradores */
+    ///////////////////////////////////////////////
+    //@{
+    /** @brief Iterador al primer valor.  \complexity{\O(1)} */
+    iterator begin() {
+        return iterador(0);
+    }
+
+    /** \overload */
+    const_iterator begin() const {
+        return iterador(0);
+    }
+
+    /** \overload */
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+    iterator end() {
+        return iterador(size());
+    }
+
+    /** \overload */
+    const_iterator end() const {
+        return iterador(size());
+    }
+
+    /** \overload */
+    const_iterator cend() const {
+        return end();
+    }
+
+    /** @brief Iterador inverso al último valor.  \complexity{\O(1)} */
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    /** \overload */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    /** \overload */
+    const_reverse_iterator crbegin() const {
+        return rbegin();
+    }
+
+    /** @brief Iterador inverso a la posición anterior al primer valor.  \complexity{\O(1)} */
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    /** \overload */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    /** \overload */
+    const_reverse_iterator crend() const {
+        return rend();
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación.
+     *
+     * \complexity{\O(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        return claves.size() == significados.size() and verificarOrden();
+    }
+#endif
+
+    /**
+     * @brief Puntero que devuelve el operator-> de los iteradores: guarda el par de referencias y lo expone.
+     */
+    template<class Referencia>
+    class flecha {
+    public:
+        /** @brief Par de referencias apuntado.  \complexity{\O(1)} */
+        const Referencia* operator->() const {
+            return &valor;
+        }
+
+    private:
+        explicit flecha(Referencia r) : valor(r) {}
+
+        Referencia valor;
+        friend class flat_map;
+    };
+
+    /**
+     * @brief Iterador que permite modificar los significados.  Ver aed2::map::iterator.
+     *
+     * Un iterador es un par de punteros, uno al arreglo de claves y otro al de significados, que avanzan juntos.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = flat_map::value_type;
+        using reference = flat_map::reference;
+        using pointer = flecha<reference>;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor del iterador nulo.  \complexity{\O(1)} */
+        iterator() {}
+
+        /** @brief Valor apuntado.  \pre el iterador no es nulo ni pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return reference(*clave, *significado);
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return pointer(**this);
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1)} */
+        iterator& operator++() {
+            ++clave;
+            ++significado;
+            return *this;
+        }
+
+        /** \overload */
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{\O(1)} */
+        iterator& operator--() {
+            --clave;
+            --significado;
+            return *this;
+        }
+
+        /** \overload */
+        iterator operator--(int) {
+            iterator ret = *this;
+            --*this;
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(iterator other) const {
+            return clave == other.clave;
+        }
+
+        /** \overload */
+        bool operator!=(iterator other) const {
+            return not (*this == other);
+        }
+
+    private:
+        iterator(const Key* k, Meaning* s) : clave(k), significado(s) {}
+
+        /** \brief Clave apuntada */
+        const Key* clave{nullptr};
+        /** \brief Significado apuntado */
+        Meaning* significado{nullptr};
+        friend class flat_map;
+    };
+
+    /**
+     * @brief Iterador que no permite modificar los significados.  Ver aed2::map::const_iterator.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = flat_map::value_type;
+        using reference = flat_map::const_reference;
+        using pointer = flecha<reference>;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor del iterador nulo.  \complexity{\O(1)} */
+        const_iterator() {}
+
+        /** @brief Conversión desde iterator.  \complexity{\O(1)} */
+        const_iterator(iterator it) : clave(it.clave), significado(it.significado) {}
+
+        /** @brief Valor apuntado.  \pre el iterador no es nulo ni pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return reference(*clave, *significado);
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return pointer(**this);
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1)} */
+        const_iterator& operator++() {
+            ++clave;
+            ++significado;
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator++(int) {
+            const_iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{\O(1)} */
+        const_iterator& operator--() {
+            --clave;
+            --significado;
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator--(int) {
+            const_iterator ret = *this;
+            --*this;
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(const_iterator other) const {
+            return clave == other.clave;
+        }
+
+        /** \overload */
+        bool operator!=(const_iterator other) const {
+            return not (*this == other);
+        }
+
+    private:
+        const_iterator(const Key* k, const Meaning* s) : clave(k), significado(s) {}
+
+        /** \brief Clave apuntada */
+        const Key* clave{nullptr};
+        /** \brief Significado apuntado */
+        const Meaning* significado{nullptr};
+        friend class flat_map;
+    };
+
+private:
+    template<class K, class V, class C, class A> friend bool operator==(const flat_map<K, V, C, A>&, const flat_map<K, V, C, A>&);
+
+    /** \brief Posición de una clave en los arreglos: la de su valor si existe, o en la que habría que insertarlo */
+    struct Lugar {
+        size_t pos;
+        bool existe;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - \P{claves} y \P{significados} tienen la misma longitud.
+     * - \P{claves} está ordenado de forma estrictamente creciente según \P{lt}.
+     * - El significado de \P{claves}[i] es \P{significados}[i].
+     * \endparblock
+     *
+     * \par Función de abstracción
+     * Un diccionario en el que cada \P{claves}[i] está definida con significado \P{significados}[i].
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /** \brief Orden total para comparar claves. */
+    Compare lt;
+    /** \brief Claves, ordenadas */
+    std::vector<Key, AllocClaves> claves;
+    /** \brief Significados, en el orden de sus claves */
+    std::vector<Meaning, AllocSignificados> significados;
+    //@}
+
+    /////////////////////////////////
+    /** \name Funciones auxiliares */
+    /////////////////////////////////
+    //@{
+    /** \brief Iterador a la posición \P{i} */
+    iterator iterador(size_t i) {
+        return iterator(claves.data() + i, significados.data() + i);
+    }
+
+    /** \overload */
+    const_iterator iterador(size_t i) const {
+        return const_iterator(claves.data() + i, significados.data() + i);
+    }
+
+    /** \brief Posición en los arreglos del valor apuntado por \P{it} */
+    size_t posicion(const_iterator it) const {
+        return static_cast<size_t>(it.clave - claves.data());
+    }
+
+        /**
+         * \brief cotaInferior
+         *
+         * \Descripcion Devuelve la posición de la primera clave no menor a \P{key}, o el tamaño si no existe.  La
+         * búsqueda binaria mantiene un segmento [base, base + largo] que contiene la respuesta y en cada paso lo
+         * parte por la mitad; el resultado de la comparación sólo decide el valor de base, que el compilador asigna
+         * con un move condicional.  La cantidad de pasos depende sólo del tamaño.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+    template<class K>
+    size_t cotaInferior(const K& key) const {
+        size_t largo = claves.size();
+        if(largo == 0) return 0;
+        const Key* base = claves.data();
+        while(largo > 1){
+            size_t mitad = largo / 2;
+            base = lt(base[mitad], key) ? base + mitad : base;
+            largo -= mitad;
+        }
+        return static_cast<size_t>(base - claves.data()) + (lt(*base, key) ? 1 : 0);
+    }
+
+    /** \brief Posición del valor con clave \P{key}, o el tamaño si no existe */
+    template<class K>
+    size_t buscar(const K& key) const {
+        size_t i = cotaInferior(key);
+        return i < claves.size() and not lt(key, claves[i]) ? i : claves.size();
+    }
+
+    /** \brief Lugar de la clave \P{key} */
+    Lugar lugar(const Key& key) const {
+        size_t i = cotaInferior(key);
+        return {i, i < claves.size() and not lt(key, claves[i])};
+    }
+
+    /** \brief Lugar de la clave \P{key}, verificando primero si es el que sugiere \P{hint} */
+    Lugar lugarConHint(const_iterator hint, const Key& key) const {
+        size_t i = posicion(hint);
+        if(i == claves.size() or lt(key, claves[i])){
+            if(i == 0 or lt(claves[i - 1], key)) return {i, false};
+            if(not lt(claves[i - 1], key) and not lt(key, claves[i - 1])) return {i - 1, true};
+        }else if(not lt(claves[i], key)){
+            return {i, true};
+        }
+        return lugar(key);
+    }
+
+    /** \brief Si el lugar \P{l} no tiene un valor, inserta allí la clave \P{key} con el significado construido con \P{args} */
+    template<class K, class... Args>
+    iterator construirEn(Lugar l, K&& key, Args&&... args) {
+        if(not l.existe){
+            claves.insert(claves.begin() + l.pos, std::forward<K>(key));
+            try {
+                significados.emplace(significados.begin() + l.pos, std::forward<Args>(args)...);
+            } catch(...) {
+                claves.erase(claves.begin() + l.pos);
+                throw;
+            }
+        }
+        return iterador(l.pos);
+    }
+
+    /** \brief Asigna \P{obj} al significado del lugar \P{l}, o inserta allí la clave \P{key} con \P{obj} si no existe */
+    template<class K, class M>
+    iterator asignarOConstruir(Lugar l, K&& key, M&& obj) {
+        if(l.existe){
+            significados[l.pos] = std::forward<M>(obj);
+            return iterador(l.pos);
+        }
+        return construirEn(l, std::forward<K>(key), std::forward<M>(obj));
+    }
+
+    /** \brief Agrega \P{key} con significado \P{obj} al final de los arreglos.  \pre \P{key} es mayor a todas las claves */
+    template<class K, class M>
+    void agregar(K&& key, M&& obj) {
+        claves.emplace_back(std::forward<K>(key));
+        try {
+            significados.emplace_back(std::forward<M>(obj));
+        } catch(...) {
+            claves.pop_back();
+            throw;
+        }
+    }
+
+    /**
+     * \brief Agrega los valores de [\P{first}, \P{last}), que no están ordenados, a los que ya están en los arreglos.
+     * Se ordenan todos de forma estable y de cada clave repetida queda el primero.
+     */
+    template<class iterator>
+    void insertarDesordenados(iterator first, iterator last) {
+        std::vector<std::pair<Key, Meaning>> valores;
+        for(size_t i = 0; i < claves.size(); ++i) valores.emplace_back(std::move(claves[i]), std::move(significados[i]));
+        for(; first != last; ++first) valores.emplace_back(first->first, first->second);
+        std::stable_sort(valores.begin(), valores.end(),
+                [this](const auto& a, const auto& b) { return lt(a.first, b.first); });
+        clear();
+        reserve(valores.size());
+        for(auto& v : valores){
+            if(empty() or lt(claves.back(), v.first)) agregar(std::move(v.first), std::move(v.second));
+        }
+    }
+
+    /** \brief Indica si las claves están ordenadas de forma estrictamente creciente */
+    bool verificarOrden() const {
+        for(size_t i = 1; i < claves.size(); ++i){
+            if(not lt(claves[i - 1], claves[i])) return false;
+        }
+        return true;
+    }
+    //@}
+
+    template<class K, class V, class C, class A, class G>
+    friend flat_map<K, V, C, A> freeze(const map<K, V, C, A, G>&);
+    template<class K, class V, class C, class A, class G>
+    friend flat_map<K, V, C, A> freeze(map<K, V, C, A, G>&&);
+};
+
+//////////////////////////////////////
+/** \name Operadores de comparación */
+//////////////////////////////////////
+//@{
+/**
+ * \relates aed2::flat_map
+ * @brief Operador de igualdad entre dos diccionarios.  Ver aed2::operator==(const map&, const map&).
+ *
+ * \complexity{ \O((\SIZE(m1) + \SIZE(m2)) \CDOT (\CMP(m1) + \CMP(m2)))}
+ */
+template<class K, class V, class C, class A>
+bool operator==(const flat_map<K, V, C, A>& m1, const flat_map<K, V, C, A>& m2) {
+	return m1.claves == m2.claves and m1.significados == m2.significados;
+}
+
+/**
+ * \relates aed2::flat_map
+ * @brief Renombre de not(\P{m1} == \P{m2})
+ */
+template<class K, class V, class C, class A>
+bool operator!=(const flat_map<K, V, C, A>& m1, const flat_map<K, V, C, A>& m2) {
+	return not(m1 == m2);
+}
+//@}
+
+/**
+ * \relates aed2::flat_map
+ * @brief Implementa la función swap para cumplir con el concepto swappable
+ *
+ * \complexity{\O(1)}
+ */
+template<class K, class V, class C, class A>
+void swap(flat_map<K, V, C, A>& m1, flat_map<K, V, C, A>& m2) noexcept(noexcept(m1.swap(m2))) {
+	m1.swap(m2);
+}
+
+/**
+ * \relates aed2::flat_map
+ * @brief Devuelve un aed2::flat_map con los valores de \P{dicc}.
+ *
+ * Los valores se recorren en orden, así que se agregan al final de los arreglos sin comparar claves.  La versión
+ * que recibe una referencia a un rvalue mueve los significados y deja a \P{dicc} vacío.  Ver \ref Plano.
+ *
+ * \complexity{\O(\COPY(\P{dicc})) o, si \P{dicc} es un rvalue, \O(\SIZE(\P{dicc}) \CDOT \COPY(\T{K}) \PLUS \DEL(\P{dicc}))}
+ */
+template<class K, class V, class C, class A, class G>
+flat_map<K, V, C, A> freeze(const map<K, V, C, A, G>& dicc) {
+	flat_map<K, V, C, A> res(dicc.key_comp(), dicc.get_allocator());
+	res.reserve(dicc.size());
+	for(const auto& v : dicc) res.agregar(v.first, v.second);
+	return res;
+}
+
+/** \overload */
+template<class K, class V, class C, class A, class G>
+flat_map<K, V, C, A> freeze(map<K, V, C, A, G>&& dicc) {
+	flat_map<K, V, C, A> res(dicc.key_comp(), dicc.get_allocator());
+	res.reserve(dicc.size());
+	for(auto& v : dicc) res.agregar(v.first, std::move(v.second));
+	dicc.clear();
+	return res;
+}
+
+}
+
+#endif /* FLAT_MAP_H_ */
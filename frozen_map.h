@@ -0,0 +1,578 @@
+/**
+ * @file frozen_map.h
+ *
+ * Módulo C++ que implementa un índice ordenado de sólo lectura con las claves en orden de Eytzinger (el orden de un
+ * recorrido BFS del árbol binario completo), armado en tiempo lineal a partir de un aed2::map o un aed2::flat_map.
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef FROZEN_MAP_H_
+#define FROZEN_MAP_H_
+
+#include "map.h"
+#include "flat_map.h"
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <memory>
+#include <new>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace aed2{
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado de sólo lectura con las claves en orden de Eytzinger.
+ *
+ * La búsqueda binaria sobre un arreglo ordenado (como la de aed2::flat_map) tiene mala localidad en los primeros
+ * pasos: cada comparación lee una clave en una línea de cache distinta y lejana de la anterior, y la próxima
+ * dirección no se conoce hasta que llega la clave.  En un diccionario de cientos de millones de claves, casi
+ * todos los pasos son un cache miss que el procesador espera entero.
+ *
+ * aed2::frozen_map guarda las claves en orden de Eytzinger \cite KhuongMorin2017: la posición 1 es la raíz de un
+ * árbol binario de búsqueda completo y los hijos de la posición \a k son las posiciones 2\a k y 2\a k + 1, como en
+ * un heap.  Los primeros niveles, que visitan todas las búsquedas, quedan juntos al principio del arreglo y viven
+ * en cache.  Además, los 2^\a d descendientes de \a k a \a d niveles de distancia son las posiciones contiguas
+ * [2^\a d \CDOT \a k, 2^\a d \CDOT \a k + 2^\a d): eligiendo \a d de modo que ocupen una línea de cache (16 claves
+ * de 4 bytes, 8 de 8 bytes), cada paso de la búsqueda pide por adelantado (prefetch) la línea que va a necesitar
+ * \a d pasos después, y así se superponen hasta \a d cache misses.  Ver \ref Congelado.
+ *
+ * Los significados se guardan en otro arreglo, en el mismo orden que sus claves, de modo que la posición que
+ * devuelve una búsqueda sirve para llegar al significado sin otra indirección.  Los iteradores recorren las
+ * posiciones en inorder, que es el orden creciente de las claves, en \O(1) amortizado por paso.
+ *
+ * @tparam Key tipo de la clave.  Tiene que tener constructor por copia.
+ * @tparam Meaning tipo del significado.  Tiene que tener constructor por copia.
+ * @tparam Compare tipo del comparador.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map; además, llamamos \a n al tamaño del diccionario.
+ *
+ * \par Aspectos generales de aliasing
+ * Los valores se ven sólo como referencias constantes, y se mantienen válidas mientras exista el diccionario.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>
+>
+class frozen_map {
+public:
+    //forward declarations
+    class const_iterator;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Par de referencias constantes a la clave y al significado de un valor guardado. */
+    using const_reference = std::pair<const Key&, const Meaning&>;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+    /** \brief Los valores no se pueden modificar: iterator es const_iterator. */
+    using iterator = const_iterator;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Constructor por defecto.  Genera un diccionario vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    explicit frozen_map(Compare c = Compare()) : lt(c) {}
+
+    /**
+     * @brief Constructor a partir de los \P{n} valores del rango que empieza en \P{first}, que tiene que estar
+     * ordenado de forma estrictamente creciente según \P{c}.
+     *
+     * Los valores se consumen en orden, con un recorrido inorder de las posiciones, y cada uno se copia
+     * directamente a su posición final.
+     *
+     * \pre \aedpre{El rango tiene al menos \P{n} valores, ordenados y sin claves repetidas.}
+     *
+     * \complexity{\O(\P{n} \CDOT (\COPY(\T{Key}) + \COPY(\T{Meaning})))}
+     */
+    template<class ForwardIt>
+    frozen_map(sorted_unique_t, ForwardIt first, size_t n, Compare c = Compare()) : lt(c) {
+        construir(first, n);
+    }
+
+    /**
+     * @brief Constructor a partir de un aed2::map.  Ver frozen_map(sorted_unique_t, ForwardIt, size_t, Compare).
+     *
+     * \complexity{\O(\COPY(\P{dicc}))}
+     */
+    template<class Alloc, class Augment>
+    explicit frozen_map(const map<Key, Meaning, Compare, Alloc, Augment>& dicc) : lt(dicc.key_comp()) {
+        construir(dicc.begin(), dicc.size());
+    }
+
+    /**
+     * @brief Constructor a partir de un aed2::flat_map.  Ver frozen_map(sorted_unique_t, ForwardIt, size_t, Compare).
+     *
+     * \complexity{\O(\COPY(\P{dicc}))}
+     */
+    template<class Alloc>
+    explicit frozen_map(const flat_map<Key, Meaning, Compare, Alloc>& dicc) : lt(dicc.key_comp()) {
+        construir(dicc.begin(), dicc.size());
+    }
+
+    /**
+     * @brief Constructor por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    frozen_map(frozen_map&& other) noexcept
+        : lt(other.lt), claves(std::exchange(other.claves, nullptr)),
+          significados(std::exchange(other.significados, nullptr)), n(std::exchange(other.n, 0)) {}
+
+    /** \overload */
+    frozen_map& operator=(frozen_map&& other) noexcept {
+        frozen_map copia(std::move(other));
+        swap(copia);
+        return *this;
+    }
+
+    /** @brief El índice no se copia: se vuelve a armar a partir del diccionario original */
+    frozen_map(const frozen_map&) = delete;
+    frozen_map& operator=(const frozen_map&) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    ~frozen_map() {
+        destruir(n);
+    }
+
+    /**
+     * @brief Intercambia los valores de \P{*this} y \P{other}.
+     *
+     * \complexity{\O(1)}
+     */
+    void swap(frozen_map& other) noexcept {
+        using std::swap;
+        swap(lt, other.lt);
+        swap(claves, other.claves);
+        swap(significados, other.significados);
+        swap(n, other.n);
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Observadores */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    const Meaning& at(const Key& key) const {
+        const_iterator it = find(key);
+        assert(it != end());
+        return it->second;
+    }
+
+    /**
+     * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+     *
+     * Si \T{Compare} es transparente, \P{key} puede ser de cualquier tipo comparable con \T{Key}; ver \ref Busqueda.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator find(const Key& key) const {
+        return iterador(buscar(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K& key) const {
+        return iterador(buscar(key));
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+     *
+     * Si \T{Compare} es transparente, \P{key} puede ser de cualquier tipo comparable con \T{Key}; ver \ref Busqueda.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     *
+     * \note Hace siempre ⌊\LOG(\a n)⌋ o ⌊\LOG(\a n)⌋ + 1 comparaciones, y cada una sólo decide a cuál de los dos hijos
+     * bajar, sin saltos condicionales.
+     */
+    const_iterator lower_bound(const Key& key) const {
+        return iterador(cotaInferior(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K& key) const {
+        return iterador(cotaInferior(key));
+    }
+
+    /**
+     * @brief Indica si la clave \P{key} está definida.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    bool contains(const Key& key) const {
+        return buscar(key) != 0;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    size_t size() const {
+        return n;
+    }
+
+    /**
+     * @brief Indica si el diccionario es vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    bool empty() const {
+        return n == 0;
+    }
+
+    /**
+     * @brief Devuelve una copia del comparador de claves.
+     *
+     * \complexity{\O(1)}
+     */
+    key_compare key_comp() const {
+        return lt;
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Iteradores */
+    ////////////////////////////////////////////////////
+    //@{
+    /** @brief Iterador al primer valor.  \complexity{\O(\LOG(\a n))} */
+    const_iterator begin() const {
+        return iterador(n == 0 ? 0 : extremo(1, 0));
+    }
+
+    /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+    const_iterator end() const {
+        return iterador(0);
+    }
+
+    /** \overload */
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    /** \overload */
+    const_iterator cend() const {
+        return end();
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación.
+     *
+     * Función de debugging que chequea que el recorrido inorder de las posiciones tenga las claves en orden
+     * estrictamente creciente.
+     *
+     * \complexity{\O(\a n \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        if((claves == nullptr) != (n == 0) or (significados == nullptr) != (n == 0)) return false;
+        size_t cantidad = 0;
+        for(size_t k = begin().k, anterior = 0; k != 0; anterior = k, k = siguiente(k)){
+            if(anterior != 0 and not lt(claves[anterior], claves[k])) return false;
+            ++cantidad;
+        }
+        return cantidad == n;
+    }
+#endif
+
+    /**
+     * @brief Puntero que devuelve el operator-> de los iteradores: guarda el par de referencias y lo expone.
+     */
+    class flecha {
+    public:
+        /** @brief Par de referencias apuntado.  \complexity{\O(1)} */
+        const const_reference* operator->() const {
+            return &valor;
+        }
+
+    private:
+        explicit flecha(const_reference r) : valor(r) {}
+
+        const_reference valor;
+        friend class frozen_map;
+    };
+
+    /**
+     * @brief Iterador del diccionario.  Es una posición en orden de Eytzinger; avanzar y retroceder se mueven al
+     * sucesor y al predecesor inorder.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = frozen_map::value_type;
+        using reference = frozen_map::const_reference;
+        using pointer = flecha;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor de un iterador inválido.  \complexity{\O(1)} */
+        const_iterator() = default;
+
+        /** @brief Valor apuntado.  \pre el iterador no es pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return reference(dicc->claves[k], dicc->significados[k - 1]);
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return pointer(**this);
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1) amortizado; \O(\LOG(\a n)) en peor caso} */
+        const_iterator& operator++() {
+            k = dicc->siguiente(k);
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator++(int) {
+            const_iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{\O(1) amortizado; \O(\LOG(\a n)) en peor caso} */
+        const_iterator& operator--() {
+            k = dicc->anterior(k);
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator--(int) {
+            const_iterator ret = *this;
+            --*this;
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(const const_iterator& other) const {
+            return k == other.k;
+        }
+
+        /** \overload */
+        bool operator!=(const const_iterator& other) const {
+            return k != other.k;
+        }
+
+    private:
+        const_iterator(const frozen_map* d, size_t pos) : dicc(d), k(pos) {}
+
+        /** \brief Diccionario recorrido */
+        const frozen_map* dicc{nullptr};
+        /** \brief Posición en orden de Eytzinger, o 0 para la posición pasando-el-último */
+        size_t k{0};
+        friend class frozen_map;
+    };
+
+private:
+    /** \brief Tamaño de una línea de cache, en bytes; el arreglo de claves se alinea a este tamaño */
+    static constexpr size_t lineaDeCache = 64;
+
+    /**
+     * \brief Cantidad de claves por línea de cache, redondeada hacia abajo a una potencia de 2 (y al menos 1).  Los
+     * descendientes a log2(porLinea) niveles de la posición \a k empiezan en la posición porLinea \CDOT \a k.
+     */
+    static constexpr size_t porLinea = [] {
+        size_t res = 1;
+        while(2 * res * sizeof(Key) <= lineaDeCache) res *= 2;
+        return res;
+    }();
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - \P{claves} es nullptr si \P{n} es 0; si no, apunta a un arreglo alineado a \P{lineaDeCache} con lugar para
+     *   \P{n} + 1 claves, de las cuales están construidas las de las posiciones 1 a \P{n}.
+     * - \P{significados} es nullptr si \P{n} es 0; si no, apunta a un arreglo de \P{n} significados construidos; el
+     *   de \P{claves}[\a k] es \P{significados}[\a k - 1].
+     * - Las posiciones 1 a \P{n} forman un ABB según \P{lt}, en el que los hijos de \a k son 2\a k y 2\a k + 1.
+     * \endparblock
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /** \brief Orden total para comparar claves. */
+    Compare lt;
+    /** \brief Claves en orden de Eytzinger, desde la posición 1 */
+    Key* claves{nullptr};
+    /** \brief Significados, en el orden de sus claves */
+    Meaning* significados{nullptr};
+    /** \brief Cantidad de valores */
+    size_t n{0};
+    //@}
+
+    /////////////////////////////////
+    /** \name Funciones auxiliares */
+    /////////////////////////////////
+    //@{
+    /** \brief Iterador a la posición \P{k} */
+    const_iterator iterador(size_t k) const {
+        return const_iterator(this, k);
+    }
+
+    /** \brief Cantidad de unos consecutivos en los bits menos significativos de \P{k} */
+    static unsigned unosFinales(size_t k) {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctzll(~static_cast<unsigned long long>(k)));
+#else
+        unsigned res = 0;
+        for(; k & 1; k >>= 1) ++res;
+        return res;
+#endif
+    }
+
+    /** \brief Pide por adelantado la línea de cache de \P{p}, si el compilador lo permite */
+    static void anticipar(const void* p) {
+#if defined(__GNUC__)
+        __builtin_prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+
+    /** \brief Descendiente de \P{k} que se alcanza bajando siempre hacia el hijo \P{lado} (0 izquierdo, 1 derecho) */
+    size_t extremo(size_t k, size_t lado) const {
+        while(2 * k + lado <= n) k = 2 * k + lado;
+        return k;
+    }
+
+    /** \brief Sucesor inorder de la posición \P{k}, o 0 si \P{k} es la última */
+    size_t siguiente(size_t k) const {
+        if(2 * k + 1 <= n) return extremo(2 * k + 1, 0);
+        return k >> (unosFinales(k) + 1);
+    }
+
+    /** \brief Predecesor inorder de la posición \P{k} (la última si \P{k} es 0), o 0 si \P{k} es la primera */
+    size_t anterior(size_t k) const {
+        if(k == 0) return extremo(1, 1);
+        if(2 * k <= n) return extremo(2 * k, 1);
+        return k >> (unosFinales(~k) + 1);
+    }
+
+        /**
+         * \brief cotaInferior
+         *
+         * \Descripcion Devuelve la posición de la primera clave no menor a \P{key}, o 0 si no existe.  Baja desde la
+         * raíz eligiendo el hijo 2\a k + (\P{claves}[\a k] < \P{key}) sin saltos condicionales, y en cada paso pide
+         * por adelantado la línea de los descendientes de \a k a log2(\P{porLinea}) niveles.  Al salir del arreglo,
+         * los bits de \a k codifican el camino: la respuesta es el último ancestro al que se bajó por la izquierda,
+         * que se obtiene descartando los unos finales y uno más.
+         *
+         * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+         */
+    template<class K>
+    size_t cotaInferior(const K& key) const {
+        size_t k = 1;
+        while(k <= n){
+            if(porLinea * k <= n) anticipar(claves + porLinea * k);
+            k = 2 * k + (lt(claves[k], key) ? 1 : 0);
+        }
+        return k >> (unosFinales(k) + 1);
+    }
+
+    /** \brief Posición del valor con clave \P{key}, o 0 si no existe */
+    template<class K>
+    size_t buscar(const K& key) const {
+        size_t k = cotaInferior(key);
+        return k != 0 and not lt(key, claves[k]) ? k : 0;
+    }
+
+    /**
+     * \brief Construye el índice con los \P{cantidad} valores desde \P{first}, recorriendo las posiciones en inorder
+     * y copiando cada clave y cada significado directamente a su posición.  Si una copia o el pedido de memoria
+     * lanzan una excepción, destruye y libera lo construido y la relanza.
+     */
+    template<class ForwardIt>
+    void construir(ForwardIt first, size_t cantidad) {
+        if(cantidad == 0) return;
+        claves = static_cast<Key*>(::operator new((cantidad + 1) * sizeof(Key), std::align_val_t(lineaDeCache)));
+        try {
+            significados = std::allocator<Meaning>().allocate(cantidad);
+        } catch(...) {
+            ::operator delete(claves, std::align_val_t(lineaDeCache));
+            claves = nullptr;
+            throw;
+        }
+        n = cantidad;
+        size_t construidos = 0;
+        try {
+            for(size_t k = extremo(1, 0); k != 0; k = siguiente(k), ++first){
+                ::new(static_cast<void*>(claves + k)) Key(first->first);
+                try {
+                    ::new(static_cast<void*>(significados + k - 1)) Meaning(first->second);
+                } catch(...) {
+                    claves[k].~Key();
+                    throw;
+                }
+                ++construidos;
+            }
+        } catch(...) {
+            destruir(construidos);
+            throw;
+        }
+    }
+
+    /** \brief Destruye los primeros \P{cantidad} valores en inorder y libera los arreglos */
+    void destruir(size_t cantidad) {
+        if(claves == nullptr) return;
+        for(size_t k = extremo(1, 0); cantidad > 0; k = siguiente(k), --cantidad){
+            claves[k].~Key();
+            significados[k - 1].~Meaning();
+        }
+        ::operator delete(claves, std::align_val_t(lineaDeCache));
+        std::allocator<Meaning>().deallocate(significados, n);
+        claves = nullptr;
+        significados = nullptr;
+        n = 0;
+    }
+    //@}
+};
+
+/**
+ * \relates aed2::frozen_map
+ * @brief Implementa la función swap para cumplir con el concepto swappable
+ *
+ * \complexity{\O(1)}
+ */
+template<class K, class V, class C>
+void swap(frozen_map<K, V, C>& m1, frozen_map<K, V, C>& m2) noexcept {
+	m1.swap(m2);
+}
+
+}
+
+#endif /* FROZEN_MAP_H_ */
@@ -294,8 +294,8 @@
  * distinguirla del nodo raíz.  Sin embargo, con ciertas rotaciones puede ocurrir que
  * temporalmente tanto la cabecera como la raíz tengan el mismo color.  Para evitar bugs
  * innecesarios, se propone un nuevo color (digamos azul) para la cabecera.
- * (Esto requiere un bit mas por nodo, pero igualmente el color usa al menos 8 bits en
- * cualquier implementación real).
+ * (Esto requiere un bit mas por nodo, que igualmente entra en los bits libres del puntero
+ * al padre; ver \ref Memoria).
  *
  * El problema del valor del nodo cabecera es más complejo ya que, aun así pudiéramos asignarle un valor
  * arbitrario al nodo, no sabemos de dónde obtener dicho valor (notar que los tipos `Key` y
@@ -314,10 +314,9 @@
  * struct Node {
  *   //punteros a los hijos izquierdo (child[0]) y derecho (child[1])
  *   Node* child[2]{nullptr,nullptr};
- *   //puntero al padre: garantiza insercion con puntero en O(1) amortizado e iteracion en O(1) memoria
- *   Node* parent{nullptr};
- *   //color del nodo
- *   Color color{Color::Red};
+ *   //puntero al padre: garantiza insercion con puntero en O(1) amortizado e iteracion en O(1) memoria.
+ *   //En los dos bits menos significativos se guarda el color del nodo (ver \ref Memoria)
+ *   std::uintptr_t padreYColor;
  * }
  *
  * struct InnerNode : public Node {
@@ -346,6 +345,288 @@
  * El algoritmo es exactamente el mismo que se muestra en \cite CormenLeisersonRivestStein2009
  * y la razón de este costo puede consultarse, por ejemplo, en \cite MehlhornSanders2008.
  *
+ * \section Pool Pool de nodos
+ *
+ * Los nodos internos no se piden con `new` ni se liberan con `delete`.  Cada diccionario tiene un pool
+ * (aed2::map::NodePool) que obtiene la memoria del allocator \T{Alloc} en bloques (\e slabs) de varios
+ * nodos contiguos.  Cada slab duplica la capacidad del anterior, hasta un máximo fijo, con lo cual la
+ * cantidad de pedidos al allocator es logarítmica mientras el diccionario es chico y lineal, con una
+ * constante muy baja, cuando crece.  Los nodos eliminados no se devuelven al allocator: se destruye su
+ * valor y la memoria se encadena en una lista de libres que se usa antes de tomar memoria nueva.  De
+ * esta forma, un diccionario con muchas inserciones y borrados no vuelve a pedir memoria una vez que
+ * alcanza su tamaño máximo, y los nodos de un mismo diccionario quedan agrupados en pocas regiones de
+ * memoria.  Los slabs se devuelven al allocator recién cuando se destruye el diccionario.
+ *
+ * Vaciar el diccionario (`clear` y el destructor) no borra los elementos uno por uno, ya que eso
+ * rebalancearía un árbol que está por desaparecer.  En cambio, se recorre el árbol en postorden
+ * destruyendo los valores (paso que se omite si el valor, y el resumen si lo hay, son trivialmente
+ * destructibles) y luego se marca todo el pool como libre de una sola vez.  El costo total es \O(\DEL(\a d)) sin comparaciones
+ * ni rotaciones.
+ *
+ * El pool pertenece al diccionario, por lo que `swap` intercambia los pools junto con los árboles.  La única
+ * excepción son los diccionarios que intercambian nodos (ver \ref Particion), que pueden compartir los slabs.
+ *
+ * \section Memoria Memoria por nodo
+ *
+ * Cada valor del diccionario ocupa un nodo interno de aed2::map::node_size() bytes, que es todo lo que se
+ * le pide al allocator por valor (los slabs no agregan encabezados por nodo, a diferencia de un `new` por
+ * nodo, que en las implementaciones habituales de malloc suma 8 a 16 bytes).  En una arquitectura de 64 bits
+ * el presupuesto es:
+ *  - 16 bytes para los punteros a los hijos,
+ *  - 8 bytes para el puntero al padre, cuyos dos bits menos significativos guardan el color,
+ *  - sizeof(value_type) bytes para el valor, más el relleno necesario para respetar su alineación.
+ *
+ * Los nodos no tienen vtable (Node no tiene funciones virtuales) y el color no ocupa un campo propio.  Así,
+ * un nodo de aed2::map<int, int> ocupa 32 bytes: 24 de estructura y 8 de valor.  Con un puntero a la vtable
+ * y el color en un campo aparte el mismo nodo ocuparía 48 bytes, i.e., en la misma memoria entra un 50% más
+ * de valores.
+ *
+ * \section Busqueda Comparaciones en las búsquedas
+ *
+ * Todas las búsquedas (find, lower_bound, operator[], las inserciones sin hint, etc.) descienden una única
+ * vez desde la raíz y comparan a lo sumo una vez por nodo.  Con un comparador que sólo responde "menor",
+ * en cada nivel se pregunta si la clave del nodo es menor a la buscada, recordando el último nodo que no lo
+ * es; al llegar a una hoja, ese nodo es el lower_bound, y una última comparación decide si su clave es la
+ * buscada.  Así, una búsqueda hace altura + 1 comparaciones, contra las tres por nivel que haría
+ * preguntar primero por la igualdad (que con "menor" cuesta dos comparaciones).
+ *
+ * Si las claves se pueden comparar de a tres vías (ver aed2::three_way_compare; e.g., std::string con
+ * std::less), cada comparación dice además si las claves son iguales, por lo que el descenso termina al
+ * encontrar la clave y no hace falta la comparación final.  Para claves como std::string, donde cada
+ * comparación recorre los caracteres comunes, esto ahorra la mayor parte del trabajo de la búsqueda.
+ *
+ * Si \T{Compare} es \e transparente (i.e., define el tipo `is_transparent`, como std::less<>), entonces find,
+ * lower_bound, at y erase aceptan como clave cualquier valor comparable con \T{Key}, sin construir un \T{Key}
+ * temporal.  Así, en un aed2::map<std::string, int, std::less<>> se puede buscar con un std::string_view o un
+ * `const char*` sin pedir memoria.  Con std::less<> y claves con método `compare` (como std::string), la
+ * búsqueda heterogénea también compara de a tres vías.
+ *
+ * \section Lotes Búsquedas en lotes
+ *
+ * En un diccionario que no entra en cache, cada nivel de una búsqueda es un cache miss que depende del anterior:
+ * el procesador no puede pedir el hijo sin haber leído la clave del padre.  Buscar muchas claves con un ciclo
+ * de find espera esos misses uno detrás de otro, aunque la memoria podría atender varios pedidos a la vez.
+ * find_batch y lower_bound_batch avanzan en ronda los descensos de hasta descensos_en_lote claves: en cada
+ * vuelta, cada descenso baja un nivel y pide por adelantado su próximo nodo, que recién lee en la vuelta
+ * siguiente, después de que los demás descensos pidieron los suyos.  Así los misses de un mismo nivel se
+ * superponen.  Las comparaciones son las mismas que las de find y lower_bound; lo único que cambia es el
+ * orden en que se hacen.  Con pocas claves, o con diccionarios que entran en cache, no hay misses que
+ * superponer y conviene el ciclo de find.
+ *
+ * Para insertar un lote de valores ordenados, insert_sorted_batch aprovecha el orden en otro sentido: la clave
+ * siguiente está cerca de la anterior, así que su lugar se busca desde el nodo recién insertado (\e finger
+ * \e search).  Se sube sólo hasta el primer ancestro con clave no menor a la nueva, comparando nada más con los
+ * ancestros de clave mayor, y se desciende desde ahí.  Si las \a m claves caen repartidas en un diccionario de
+ * \a n valores, cada búsqueda recorre un subárbol de unos \a n / \a m valores, y el lote cuesta
+ * \O(\a m \CDOT \LOG(\a n / \a m)) comparaciones en lugar de \O(\a m \CDOT \LOG(\a n)); si las claves van al final,
+ * cada una cuesta \O(1) amortizado.
+ *
+ * \section CargaOrdenada Carga de rangos ordenados
+ *
+ * Construir un diccionario insertando de a un valor cuesta, además de las comparaciones, un insertFixUp por
+ * valor.  Cuando el rango de entrada está ordenado en forma estricta (y se conoce su longitud \a n), el
+ * árbol red-black se puede armar directamente: la mediana del rango es la raíz y cada mitad se arma
+ * recursivamente de la misma forma.  El árbol resultante tiene altura mínima \a h = ⌈\LOG(\a n + 1)⌉ - 1 y todos
+ * sus nodos están a profundidad \a h - 1 o \a h, por lo que pintando de rojo los nodos de profundidad \a h (si
+ * \a h > 0) y de negro el resto, todo camino desde la raíz tiene \a h nodos negros y ningún rojo tiene hijos.
+ * Los valores se consumen en inorder, así que alcanza con una pasada por un \e ForwardIterator, y los \a n nodos
+ * se piden al pool como un único slab antes de empezar.  El costo es \O(\a n) más las copias, sin rotaciones.
+ *
+ * El constructor por rango verifica primero si la entrada está ordenada (\a n - 1 comparaciones) y, en tal
+ * caso, usa este algoritmo.  Con la etiqueta aed2::sorted_unique se omite incluso la verificación.
+ *
+ * \section Aumentos Aumentos: resúmenes de subárboles
+ *
+ * El último parámetro del template, \T{Augment}, es una \e política que indica qué guarda cada nodo además de
+ * su valor: un resumen de todos los valores de su subárbol, como propone \cite CormenLeisersonRivestStein2009
+ * para los árboles aumentados.  La política por defecto, aed2::no_augmentation, no guarda nada; en ese caso
+ * los nodos no ocupan ni un byte más y el código de mantenimiento desaparece en tiempo de compilación.
+ *
+ * Una política define un tipo `summary_type` y tres funciones estáticas que forman un monoide: `identity()`
+ * (el resumen de un subárbol vacío), `lift(v)` (el resumen de un único valor) y `combine(s1, s2)` (asociativa,
+ * el resumen de la concatenación).  El resumen de un nodo es `combine(combine(izq, lift(valor)), der)`.
+ * Para mantenerlo correcto alcanza con:
+ *  - recalcular los ancestros de un nodo recién enganchado (en aed2::map::enganchar) o del lugar donde se
+ *    desenganchó un nodo (en erase), de abajo hacia arriba, antes de rebalancear;
+ *  - recalcular, en cada rotación, los dos nodos rotados (primero el que baja);
+ *  - en la copia estructural y en la carga ordenada, calcular el resumen de cada nodo luego de sus hijos.
+ *
+ * Los cambios de color no alteran los resúmenes.  Con un aumento, insertar y borrar cuestan \O(\LOG(\a n))
+ * aun con un buen hint, ya que hay que recorrer el camino hasta la raíz; las búsquedas no cambian.
+ *
+ * Con cualquier política, aed2::map::reduce(lo, hi) devuelve el resumen de las claves en [lo, hi) en
+ * \O(\LOG(\a n)) combinaciones: se desciende hasta el primer nodo \a s con clave en el rango (donde se separan los
+ * caminos hacia lo y hi), y el resultado es el resumen de las claves mayores o iguales a lo del subárbol
+ * izquierdo de \a s, seguido del valor de \a s y del resumen de las claves menores a hi de su subárbol derecho.
+ * Cada uno de estos dos se obtiene en un descenso, tomando enteros los resúmenes de los subárboles que quedan
+ * dentro del rango.  No se asume que combine sea conmutativa ni que tenga inversa.  Por ejemplo, para sumar los
+ * significados en un rango de claves:
+ * \code{.cpp}
+ * struct suma_de_bytes {
+ *     using summary_type = long;
+ *     static long identity() { return 0; }
+ *     static long lift(const std::pair<const Timestamp, long>& v) { return v.second; }
+ *     static long combine(long s1, long s2) { return s1 + s2; }
+ * };
+ * aed2::map<Timestamp, long, std::less<Timestamp>, std::allocator<std::pair<const Timestamp, long>>, suma_de_bytes> d;
+ * long total = d.reduce(desde, hasta);
+ * \endcode
+ * Si el resumen depende del significado, modificar un significado a través de una referencia lo deja
+ * desactualizado; para eso está aed2::map::update_summary (insert_or_assign lo actualiza solo).  Para
+ * combinar un resumen propio con los estadísticos de orden, alcanza con que summary_type incluya la cantidad
+ * de valores y la política defina `size(s)`.
+ *
+ * La política aed2::subtree_size guarda la cantidad de valores del subárbol.  Con ella (o con cualquier política
+ * que defina `size(s)`) se calculan los estadísticos de orden en \O(\LOG(\a n)): aed2::map::nth desciende
+ * comparando \a k con el tamaño del subárbol izquierdo, aed2::map::rank suma los tamaños a la izquierda del
+ * camino de búsqueda y aed2::map::index sube desde un nodo hasta la raíz.  Como std::distance no puede
+ * aprovechar esta información en un iterador bidireccional, aed2::map::distance la ofrece como método.
+ *
+ * \section Particion Partición y unión de diccionarios
+ *
+ * Borrar o mover un rango contiguo de \a k valores de a uno cuesta \a k rebalanceos y \a k búsquedas.  En cambio,
+ * aed2::map implementa sobre los árboles red-black las operaciones \e split y \e join de \cite Tarjan1983.  Unir
+ * dos árboles \a L y \a R con un nodo \a x en el medio (aed2::map::unir) cuesta \O(1 \PLUS la diferencia entre
+ * las alturas negras de \a L y \a R): se baja por el borde del árbol más alto hasta la altura negra del más bajo,
+ * se engancha \a x como nodo rojo y se rebalancea con el mismo insertFixUp de la inserción.  Partir un árbol
+ * por una clave (aed2::map::partir) desciende por el camino de búsqueda y une, al volver, cada nodo del
+ * camino con el subárbol que no se visitó; las diferencias de altura de esas uniones forman una suma
+ * telescópica, con lo cual partir cuesta lo mismo que una búsqueda.  Sobre estas dos operaciones se
+ * construyen aed2::map::split, aed2::map::join, el borrado de rangos aed2::map::erase(const_iterator, const_iterator),
+ * aed2::map::extract_range y aed2::map::splice, con un rebalanceo de \O(\LOG(\a n)) sin importar \a k.
+ * Destruir los valores borrados sigue costando \O(\a k), y contar los valores que pasan a otro diccionario también,
+ * salvo que la política de aumento informe tamaños (ver \ref Aumentos).
+ *
+ * Para pasar nodos de un diccionario a otro sin copiarlos, ambos tienen que poder devolverlos a la misma memoria.
+ * Por eso el pool (ver \ref Pool) guarda los slabs y la lista de libres en un \e almacén con un contador de
+ * referencias.  El diccionario que devuelven split y extract_range comparte el almacén del original: los nodos
+ * borrados en uno se reutilizan en el otro y la memoria vuelve al allocator cuando se destruyen ambos.  Como
+ * los dos diccionarios son independientes para el usuario, que puede modificar cada uno desde un hilo distinto,
+ * el contador de referencias es atómico y, mientras el almacén esté compartido, cada pedido o devolución de un
+ * nodo toma el mutex del almacén; un almacén que usa un único pool no se bloquea nunca.  Cuando
+ * los almacenes son distintos, join y splice absorben el almacén de origen si nadie más lo usa (se concatenan las
+ * listas de slabs y de libres en \O(1)) y, si no, arman un árbol balanceado nuevo con los valores movidos (ver
+ * \ref CargaOrdenada), que se une en \O(\LOG(\a n)) como antes.  Si las claves del rango se intercalan con las
+ * del destino, splice inserta los valores de a uno.
+ *
+ * \section Conjuntos Operaciones de conjuntos
+ *
+ * aed2::map::merge, aed2::map::union_with, aed2::map::intersect_with y aed2::map::difference siguen el esquema
+ * de \cite BlellochFerizovicSun2016, que sólo usa partir y unir: para unir \a T1 con \a T2 se parte \a T1 por
+ * la clave de la raíz de \a T2, se unen recursivamente las mitades menores con el subárbol izquierdo de \a T2 y
+ * las mayores con el derecho, y los dos resultados se juntan con la raíz de \a T2 en el medio.  La intersección y
+ * la diferencia son iguales, salvo que la raíz se descarta cuando no debe quedar.  Si \a T2 es el árbol más chico,
+ * con \a m valores, las operaciones cuestan \O(\a m \CDOT \LOG(\a n / \a m \PLUS 1)), que es \O(\LOG(\a n)) para
+ * \a m constante y \O(\a n) para \a m \IGOBS \a n, mejor que insertar o buscar los \a m valores de a uno.  merge
+ * recibe el otro diccionario por movimiento y, como join, se queda con sus nodos sin copiar valores.
+ *
+ * Las dos llamadas recursivas trabajan sobre árboles disjuntos, con lo cual se pueden ejecutar en paralelo.
+ * Las versiones que reciben aed2::parallel lanzan la llamada izquierda en otro hilo mientras los subárboles
+ * tengan una altura negra de al menos aed2::map::altura_paralela y queden hilos libres, repartiendo los de
+ * std::thread::hardware_concurrency (o los que indique la etiqueta, ver aed2::parallel_t) a la mitad en cada nivel.  Como el pool no se puede usar desde varios hilos,
+ * los nodos que sobran no se destruyen durante la recursión: se encadenan en una lista y se destruyen al final.
+ *
+ * \section BTree Motor alternativo: árbol B+
+ *
+ * En diccionarios de millones de valores el árbol no entra en cache y cada nivel descendido es, en el peor
+ * caso, un cache miss.  El archivo `btree_map.h` define aed2::btree_map, con la misma interfaz que aed2::map,
+ * sobre un árbol B+ cuyos nodos ocupan unas pocas líneas de cache y guardan muchas claves contiguas.  La
+ * altura pasa de \O(\LOG(\a n)) a \O(\LOG_B(\a n)), con lo cual una búsqueda visita varias veces menos nodos.
+ * A cambio, las inserciones y los borrados mueven valores dentro de las hojas e invalidan los iteradores
+ * (ver aed2::btree_map).  Como la interfaz es la misma, se puede pasar de uno a otro con un renombre de tipos.
+ *
+ * Con claves enteras de 4 u 8 bytes y std::less, aed2::btree_map no hace búsquedas binarias dentro de los nodos:
+ * compara la clave buscada contra todas las del nodo con instrucciones vectoriales y cuenta las menores (ver
+ * aed2::simd_key_search).  Son más comparaciones, pero sin los saltos mal predichos de la búsqueda binaria.  Con
+ * SSE2 (el default en x86-64) se vectorizan las claves de 4 bytes; con `-msse4.2` también las de 8, y con `-mavx2`
+ * o `-march=native` se comparan el doble de claves por instrucción.
+ *
+ * \section Concurrencia Diccionario concurrente
+ *
+ * aed2::map no es seguro para usar desde varios hilos si alguno lo modifica, y protegerlo con un mutex serializa
+ * también las búsquedas.  El archivo `concurrent_map.h` define aed2::concurrent_map, en el que las búsquedas y
+ * los recorridos no toman locks.  Sus nodos no se modifican una vez publicados: cada escritura, serializada con
+ * un mutex, copia el camino de la raíz al nodo que cambia (\O(\LOG(\a n)) nodos, balanceados por peso como en
+ * \cite HiraiYamamoto2011) y publica la raíz nueva con una escritura atómica.  Un lector toma la raíz vigente y
+ * la recorre sin sincronizarse con nadie más.
+ *
+ * El problema es saber cuándo liberar los nodos reemplazados, que un lector puede estar recorriendo.  Para eso
+ * se usa un esquema de períodos de gracia, como en RCU: cada lector se cuenta, mientras dura su lectura, en
+ * uno de dos grupos de contadores (la \e fase vigente al empezar), y dentro del grupo en el contador de su hilo,
+ * que está en su propia línea de cache para que los hilos no compitan.  Las raíces reemplazadas se acumulan
+ * por fase; cuando en una escritura los contadores de la fase anterior están todos en cero, ningún lector
+ * puede estar viendo las raíces reemplazadas antes del último cambio de fase, que se sueltan, y la fase
+ * cambia.  Soltar una raíz destruye sólo los nodos que no comparte con versiones más nuevas, gracias al contador
+ * de referencias de cada nodo.  Las escrituras nunca esperan a los lectores: si alguno tarda, la memoria se
+ * libera en una escritura posterior.
+ *
+ * Cuando lo que abunda son las escrituras, serializarlas es el cuello de botella.  El archivo `sharded_map.h`
+ * define aed2::sharded_map, que parte el rango de claves en fragmentos, cada uno un aed2::map con su propio
+ * `std::shared_mutex`.  Las operaciones sobre claves de fragmentos distintos no compiten entre sí; los recorridos
+ * toman los locks compartidos de todos los fragmentos mientras dura la lectura, por lo que ven una instantánea
+ * consistente.  Los límites entre fragmentos se pueden dar explícitamente o tomar como cuantiles de una muestra de
+ * claves, para que la carga se reparta en partes parecidas.
+ *
+ * \section Persistencia Diccionario persistente
+ *
+ * Copiar un aed2::map cuesta \O(\a n \CDOT \COPY(value_type)), lo que descarta usar copias como fotos de un
+ * diccionario grande.  El archivo `persistent_map.h` define aed2::persistent_map, cuyas versiones son inmutables:
+ * insert, insert_or_assign y erase copian los \O(\LOG(\a n)) nodos del camino que modifican y comparten el resto
+ * con la versión anterior, de modo que una copia (o snapshot) cuesta \O(1) y se puede guardar indefinidamente.  Es
+ * el mismo árbol que usa aed2::concurrent_map para sus versiones; su snapshot devuelve la versión vigente como un
+ * aed2::persistent_map sin tomar locks.  Los nodos compartidos se liberan con contadores de referencias atómicos,
+ * así que las versiones se pueden pasar a otros hilos.  El costo es que cada modificación reserva memoria para un
+ * camino entero, en lugar de para un único nodo.
+ *
+ * \section Archivos Diccionarios en archivos mapeados
+ *
+ * Si las claves y los significados son trivialmente copiables, un diccionario se puede guardar con
+ * aed2::mapped_map::write (archivo `mapped_map.h`) en un archivo que tiene la misma forma que la estructura en
+ * memoria: una cabecera y un arreglo de nodos en orden creciente de claves, sin punteros.  Los hijos no se guardan:
+ * el árbol de búsqueda es el implícito de la búsqueda binaria, así que un archivo dañado no puede llevar a una
+ * búsqueda fuera del arreglo.  Como no hay direcciones absolutas, el archivo se puede mapear con `mmap`
+ * en cualquier dirección, y aed2::mapped_map busca directamente sobre el mapeo: abrirlo cuesta \O(1), y las
+ * páginas que no toca ninguna búsqueda ni siquiera se leen del disco.  El diccionario abierto es de sólo lectura;
+ * para modificarlo se lo carga en un aed2::map con el constructor de rangos ordenados, en \O(\a n).
+ *
+ * \section Serializacion Serialización
+ *
+ * aed2::map::serialize escribe en un std::ostream una cabecera (formato, versión, tamaños de los tipos y cantidad
+ * de valores) y los valores en orden creciente de claves.  Con aed2::serial_encoding::varint, las claves enteras
+ * se guardan como diferencias con la anterior y todos los enteros en zigzag con 7 bits por byte, de modo que
+ * claves densas ocupan uno o dos bytes; los std::string se guardan con su longitud, y el resto de los tipos
+ * (trivialmente copiables) con su representación en memoria.  Los bytes se escriben en bloques precedidos por su
+ * longitud, lo que le permite a aed2::map::deserialize leer de a bloques grandes sin consumir nada del stream
+ * más allá de la serialización.
+ *
+ * Como los valores vienen ordenados y se conoce su cantidad, deserialize arma el árbol con el algoritmo de
+ * \ref CargaOrdenada, decodificando cada valor en el momento en que se crea su nodo: la carga es lineal, sin
+ * búsquedas ni rotaciones, y sin guardar los valores en un buffer intermedio.  Sólo se compara cada clave con la
+ * anterior, para que datos corruptos lancen una excepción en lugar de romper el invariante.
+ *
+ * \section Plano Diccionarios planos
+ *
+ * Un diccionario que se arma una vez y después sólo se consulta no aprovecha los punteros de los nodos, que
+ * ocupan más memoria que un valor de aed2::map<int, int> y hacen que cada paso de una búsqueda o de un recorrido
+ * dependa del anterior.  El archivo `flat_map.h` define aed2::flat_map, con la misma interfaz que aed2::map, que
+ * guarda las claves ordenadas en un arreglo contiguo y los significados en otro arreglo paralelo.  Buscar es una
+ * búsqueda binaria sobre las claves, con una cantidad fija de pasos en la que cada comparación sólo elige entre dos
+ * posiciones (un move condicional en lugar de un salto), y recorrer es avanzar dos punteros.  aed2::freeze arma un
+ * aed2::flat_map a partir de un aed2::map recorriéndolo en orden, en \O(\a n) y sin comparar claves.  Insertar o
+ * borrar en un aed2::flat_map mueve los valores siguientes, así que sirve cuando las modificaciones son raras o
+ * vienen en orden (con hint al final).
+ *
+ * \section Congelado Índices congelados en orden de Eytzinger
+ *
+ * En un aed2::flat_map de cientos de millones de claves, la búsqueda binaria paga un cache miss por casi cada
+ * comparación, porque las claves que compara están lejos entre sí y la siguiente no se conoce hasta que llega la
+ * actual.  El archivo `frozen_map.h` define aed2::frozen_map, un diccionario de sólo lectura que se arma en
+ * \O(\a n) a partir de un aed2::map o un aed2::flat_map y guarda las claves en el orden de Eytzinger (por niveles,
+ * como un heap) que estudian \cite KhuongMorin2017.  Los niveles altos quedan juntos al principio del arreglo y
+ * en cache, y como los descendientes de una posición a cuatro niveles (para claves de 4 bytes) ocupan una única
+ * línea de cache, cada paso de la búsqueda la pide por adelantado: los cache misses de los niveles bajos se
+ * superponen en lugar de esperarse de a uno.  Se eligió este orden en lugar del de van Emde Boas porque la
+ * búsqueda es más simple (un índice que se duplica) y con el prefetch logra la misma cantidad de misses.
  */
 /**
  * \page Aliasing Aspectos de aliasing y uso de punteros
@@ -824,7 +1105,27 @@
 #include <iterator>
 #include <utility>
 #include <cassert>
+#include <cstdint>
 #include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <future>
+#include <system_error>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#if __cplusplus >= 202002L
+#include <compare>
+#include <concepts>
+#endif
 
 #ifdef DEBUG
 //Aca se puede incluir cualquier cosa que consideren que necesitan para debug
@@ -841,6 +1142,183 @@
  */
 namespace aed2{
 
+/**
+ * @brief Comparación de a tres vías (three-way) entre claves.
+ *
+ * Indica si las claves de tipo \T{Key} se pueden comparar de a tres vías con un comparador de tipo \T{Compare};
+ * i.e., si con una única invocación se puede saber si una clave es menor, igual o mayor a otra.  Cuando
+ * \P{value} es true, comparar(lt, k1, k2) devuelve un valor \a c tal que \a c < 0, \a c == 0 o \a c > 0 según
+ * \P{k1} sea menor, igual o mayor a \P{k2} con respecto a \P{lt}.  Los diccionarios usan esta comparación
+ * para que cada búsqueda compare a lo sumo una vez por nodo y termine ni bien encuentra la clave.
+ *
+ * La comparación de a tres vías está disponible cuando:
+ *  - \T{Compare} tiene un método `compare(k1, k2)`, que se usa directamente.
+ *  - \T{Compare} es std::less<Key> o std::less<> y \T{Key} tiene un método `k1.compare(k2)`, como std::string.
+ *  - (Desde C++20) \T{Compare} es std::less<Key> o std::less<> y \T{Key} tiene operator<=> con orden al menos débil.
+ *
+ * En cualquier otro caso \P{value} es false y las búsquedas usan sólo \T{Compare}.  Se puede especializar
+ * este template para otros comparadores.
+ *
+ * \attention La comparación de a tres vías tiene que ser consistente con \T{Compare}.
+ */
+template<class Compare, class Key, class = void>
+struct three_way_compare {
+    static constexpr bool value = false;
+};
+
+/** \overload */
+template<class Compare, class Key>
+struct three_way_compare<Compare, Key, std::void_t<
+        decltype(std::declval<const Compare&>().compare(std::declval<const Key&>(), std::declval<const Key&>()))>> {
+    static constexpr bool value = true;
+    static auto comparar(const Compare& lt, const Key& k1, const Key& k2) { return lt.compare(k1, k2); }
+};
+
+/** \overload */
+template<class Key>
+struct three_way_compare<std::less<Key>, Key, std::void_t<
+        decltype(std::declval<const Key&>().compare(std::declval<const Key&>()) < 0)>> {
+    static constexpr bool value = true;
+    static auto comparar(const std::less<Key>&, const Key& k1, const Key& k2) { return k1.compare(k2); }
+};
+
+/** \overload */
+template<class Key>
+struct three_way_compare<std::less<>, Key, std::void_t<
+        decltype(std::declval<const Key&>().compare(std::declval<const Key&>()) < 0)>> {
+    static constexpr bool value = true;
+    static auto comparar(const std::less<>&, const Key& k1, const Key& k2) { return k1.compare(k2); }
+};
+
+#if __cplusplus >= 202002L
+/** \overload */
+template<class Key> requires (std::three_way_comparable<Key, std::weak_ordering>
+        and not requires(const Key& k) { k.compare(k) < 0; })
+struct three_way_compare<std::less<Key>, Key, void> {
+    static constexpr bool value = true;
+    static auto comparar(const std::less<Key>&, const Key& k1, const Key& k2) { return k1 <=> k2; }
+};
+
+/** \overload */
+template<class Key> requires (std::three_way_comparable<Key, std::weak_ordering>
+        and not requires(const Key& k) { k.compare(k) < 0; })
+struct three_way_compare<std::less<>, Key, void> {
+    static constexpr bool value = true;
+    static auto comparar(const std::less<>&, const Key& k1, const Key& k2) { return k1 <=> k2; }
+};
+#endif
+
+/**
+ * @brief Política de aumento que no guarda nada en los nodos.  Ver \ref Aumentos.
+ *
+ * Es la política por defecto de aed2::map: los nodos no ocupan memoria adicional y ninguna operación paga el
+ * costo de mantener resúmenes.
+ */
+struct no_augmentation {};
+
+/**
+ * @brief Política de aumento que guarda en cada nodo la cantidad de valores de su subárbol.  Ver \ref Aumentos.
+ *
+ * Con esta política aed2::map ofrece las operaciones de estadísticos de orden: aed2::map::nth, aed2::map::rank,
+ * aed2::map::index y aed2::map::distance, todas en \O(\LOG(\SIZE(\a d))).
+ *
+ * Como toda política de aumento, define un monoide sobre summary_type: identity() es el neutro, combine es
+ * asociativa y lift(v) es el resumen de un único valor.  Además define size(s), que indica la cantidad de valores
+ * resumidos en \P{s}; las operaciones de estadísticos de orden están disponibles para cualquier política que la defina.
+ */
+struct subtree_size {
+    /** \brief Tipo de los resúmenes */
+    using summary_type = std::size_t;
+    /** \brief Resumen de un subárbol vacío */
+    static summary_type identity() { return 0; }
+    /** \brief Resumen de un único valor */
+    template<class V>
+    static summary_type lift(const V&) { return 1; }
+    /** \brief Resumen de la concatenación de dos secuencias de valores */
+    static summary_type combine(summary_type s1, summary_type s2) { return s1 + s2; }
+    /** \brief Cantidad de valores resumidos en \P{s} */
+    static std::size_t size(summary_type s) { return s; }
+};
+
+/**
+ * @brief Indica si la política de aumento \T{Augment} informa la cantidad de valores de cada resumen (i.e., si
+ * tiene una función `size(summary_type)`), con lo cual se pueden calcular estadísticos de orden.
+ */
+template<class Augment, class = void>
+struct augment_has_size : std::false_type {};
+
+/** \overload */
+template<class Augment>
+struct augment_has_size<Augment, std::void_t<
+        decltype(Augment::size(std::declval<const typename Augment::summary_type&>()))>> : std::true_type {};
+
+/**
+ * @brief Tipo de la etiqueta aed2::sorted_unique.
+ *
+ * Se usa para elegir los constructores que reciben un rango ordenado en forma estricta (i.e., ordenado y sin
+ * claves repetidas) con respecto al comparador del diccionario.  Ver aed2::map::map(sorted_unique_t, iterator, iterator, Compare, const Alloc&).
+ */
+struct sorted_unique_t {
+    explicit sorted_unique_t() = default;
+};
+
+/**
+ * @brief Etiqueta que indica que un rango de valores está ordenado en forma estricta por clave.
+ *
+ * \code{.cpp}
+ * std::vector<std::pair<int, int>> v = ...; //ordenado y sin claves repetidas
+ * aed2::map<int, int> d(aed2::sorted_unique, v.begin(), v.end());
+ * \endcode
+ */
+inline constexpr sorted_unique_t sorted_unique{};
+
+/**
+ * @brief Tipo de la etiqueta aed2::parallel.
+ *
+ * Se usa para elegir las versiones paralelas de las operaciones de conjuntos de aed2::map (ver aed2::map::merge).
+ * Construida con una cantidad de hilos, limita (o fuerza, por ejemplo en los tests) los hilos que se usan; si no,
+ * se usan los de std::thread::hardware_concurrency.
+ *
+ * \code{.cpp}
+ * a.merge(aed2::parallel_t(2), std::move(b));  // a lo sumo dos hilos
+ * \endcode
+ */
+struct parallel_t {
+    explicit parallel_t() = default;
+    explicit constexpr parallel_t(int threads) : threads(threads) {}
+
+    /** @brief Máximo de hilos a usar; si es menor a 1, los de std::thread::hardware_concurrency */
+    int threads = 0;
+};
+
+/**
+ * @brief Etiqueta que pide resolver una operación repartiendo el trabajo entre varios hilos.
+ *
+ * Sólo se usan varios hilos para entradas grandes.  Como el comparador (y la política de aumento) se llaman desde
+ * varios hilos a la vez, tienen que poder hacerlo sin sincronización.
+ *
+ * \code{.cpp}
+ * aed2::map<int, int> a = ..., b = ...;
+ * a.merge(aed2::parallel, std::move(b));
+ * \endcode
+ */
+inline constexpr parallel_t parallel{};
+
+/**
+ * @brief Codificación de las claves y significados enteros en aed2::map::serialize (ver \ref Serializacion).
+ *
+ * - \c fixed: todos los campos se guardan con su representación en memoria, de tamaño fijo.
+ * - \c varint: las claves enteras se guardan como la diferencia con la clave anterior, y los significados
+ *   enteros como su valor, en ambos casos en zigzag y con una cantidad variable de bytes (7 bits por byte).
+ *   Los campos que no son enteros se guardan como con \c fixed.
+ *
+ * En ambos casos, los std::string se guardan con su longitud y sus caracteres.
+ */
+enum class serial_encoding {
+    fixed,
+    varint
+};
+
 /**
  * @brief Modulo que implementa un diccionario.
  *
@@ -864,6 +1342,9 @@ namespace aed2{
  * @tparam Key tipo de la clave. Ver \ref Interfaz.
  * @tparam Meaning tipo del significado. Ver \ref Interfaz.
  * @tparam Compare tipo del comparador.  Ver \ref Interfaz.
+ * @tparam Alloc allocator estándar de C++ del que se obtiene la memoria de los nodos.  Ver \ref Pool.
+ * @tparam Augment política de aumento: qué resumen de su subárbol guarda cada nodo (e.g., aed2::subtree_size).
+ * Por defecto, ninguno.  Ver \ref Aumentos.
  *
  * \par Terminología para describir las complejidades temporales
  * \parblock
@@ -912,12 +1393,15 @@ namespace aed2{
 template<
   class Key,
   class Meaning,
-  class Compare = std::less<Key>
+  class Compare = std::less<Key>,
+  class Alloc = std::allocator<std::pair<const Key, Meaning>>,
+  class Augment = no_augmentation
 >
 class map {
 	//forward declarations (innecesario, pero ayuda al analizador semantico de Eclipse)
 	class Node;
 	class InnerNode;
+	class NodePool;
 public:
     //forward declarations
     class iterator;
@@ -939,6 +1423,10 @@ public:
      * \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++.
      */
     using key_compare = Compare;
+    /**
+     * \brief Renombre para poder acceder al tipo del allocator.  Compatible con estándar C++.
+     */
+    using allocator_type = Alloc;
     /**
      * \brief Renombre para poder acceder al tipo de referencia de los valores guardados.  Compatible con estándar C++.
      */
@@ -995,6 +1483,7 @@ public:
      * @brief Crea un diccionario vacio.
      *
      * @param c comparador (functor de orden) a utilizar
+     * @param a allocator del que el pool obtiene la memoria de los nodos
      * @retval res diccionario recién construido
      *
      * \pre \aedpre{true}
@@ -1005,8 +1494,7 @@ public:
      * \attention El parámetro formal \LT del TAD diccionario se establece en esta función.
      * \LT = \P{c}.operator()
      */
-    explicit map(Compare c = Compare()) {
-        lt = c;
+    explicit map(Compare c = Compare(), const Alloc& a = Alloc()) : lt(c), pool(a) {
         count = 0;
     }
 
@@ -1021,23 +1509,49 @@ public:
      *
      * \complexity{\O(\COPY(\P{other}))}
      *
-     * \deprecated el hint debería estar en el mismo árbol
-     *
      * \attention El parámetro formal \LT del TAD diccionario se establece en esta función.
      * \LT es igual al operator() del comparador de \P{other}
      *
+     * \note El diccionario nuevo tiene su propio pool de nodos; el allocator se obtiene con
+     * `select_on_container_copy_construction`, como en los contenedores estándar.
+     *
+     * \note Es importante remarcar que no se realiza ninguna comparación entre los elementos: se copia el
+     * árbol red-black nodo por nodo, colores incluidos.
      */
-    map(const map& other) {
-        const_iterator it = const_iterator(other.header.child[1]);
-        count = 0;
-        lt = other.lt;
-        const_iterator hint = end();
-        while(it != other.end()){
-            hint = insert(hint, *it);
-            it.retroceder();
+    map(const map& other)
+        : lt(other.lt),
+          pool(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.get_allocator())) {
+        try {
+            copiarArbol(other);
+        } catch(...) {
+            destruirValores(header.parent());
+            throw;
         }
     }
 
+    /**
+     * @brief Constructor por movimiento
+     *
+     * @param other diccionario cuyos valores pasan a \P{res}
+     * @retval res diccionario recien construido
+     *
+     * \aliasing{Los iteradores de \P{other}, salvo los que apuntan a la posición pasando-el-último, pasan a ser
+     * iteradores de \P{res}.  \P{other} queda vacío.}
+     *
+     * \pre \aedpre{other \IGOBS oth}
+     * \post \aedpost{*this \IGOBS oth \LAND vacio?(other)}
+     *
+     * \complexity{\O(1)}
+     *
+     * \note Ningún valor se copia ni se mueve: \P{res} se queda con los nodos y el pool de \P{other}.  Por eso no
+     * lanza excepciones, salvo que las lance la copia o el swap de \T{Compare}; así std::vector mueve (en lugar de
+     * copiar) los diccionarios al crecer.
+     */
+    map(map&& other) noexcept(std::is_nothrow_copy_constructible<Compare>::value and std::is_nothrow_swappable<Compare>::value)
+        : lt(other.lt), pool(other.get_allocator()) {
+        swap(other);
+    }
+
     /**
      * @brief Crea un diccionario con los elementos del rango [\P{first}, \P{last})
      *
@@ -1051,6 +1565,7 @@ public:
      * @param first iterador al primer elemento del rango
      * @param last iterador pasando el ultimo elemento del rango
      * @param c comparador a utilizar
+     * @param a allocator del que el pool obtiene la memoria de los nodos
      * @retval res diccionario recien construido
      *
      * \aliasing{\P{first} y \P{last} son iteradores que recorren la misma secuencia definida por una colección.}
@@ -1079,37 +1594,122 @@ public:
      * \attention El parámetro formal \LT del TAD diccionario se establece en esta función.
      * \LT = \P{c}.operator()
      *
+     * \note Si \T{iterator} es un \e ForwardIterator, primero se recorre el rango verificando si está ordenado en
+     * forma estricta; en ese caso el árbol se arma directamente, balanceado, sin rebalanceos (ver \ref CargaOrdenada).
+     * Si no, los valores se insertan de a uno usando end() como hint, que es un buen hint mientras el rango
+     * venga ordenado.
+     *
      * \sa [Documentación de InputIterator](http://en.cppreference.com/w/cpp/concept/InputIterator)
      */
     template<class iterator>
-    map(iterator first, iterator last, Compare c = Compare()) : lt(c) {
-    	auto it = end();
+    map(iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc()) : lt(c), pool(a) {
+        if constexpr(std::is_base_of<std::forward_iterator_tag,
+                typename std::iterator_traits<iterator>::iterator_category>::value) {
+            auto desordenado = [this](const auto& v1, const auto& v2) {
+                return not lt(v1.first, v2.first);
+            };
+            if(std::adjacent_find(first, last, desordenado) == last) {
+                construirOrdenado(first, static_cast<size_t>(std::distance(first, last)));
+                return;
+            }
+        }
     	while(first != last) {
-    		insert(it, *first);
+    		insert(end(), *first);
     		++first;
     	}
     }
 
+    /**
+     * @brief Crea un diccionario con los elementos del rango [\P{first}, \P{last}), que está ordenado en forma estricta
+     *
+     * Idem map(iterator, iterator, Compare, const Alloc&), pero sin verificar que el rango esté ordenado.  Si \T{iterator}
+     * es un \e ForwardIterator, el árbol se arma balanceado en una única pasada, sin comparaciones (ver \ref CargaOrdenada).
+     *
+     * @tparam iterator clase del iterador a recorrer
+     *
+     * @param first iterador al primer elemento del rango
+     * @param last iterador pasando el ultimo elemento del rango
+     * @param c comparador a utilizar
+     * @param a allocator del que el pool obtiene la memoria de los nodos
+     * @retval res diccionario recien construido
+     *
+     * \pre \parblock
+     * \P{last} debe ser alcanzable desde \P{first} y las claves del rango [\P{first}, \P{last}) deben ser
+     * estrictamente crecientes con respecto a \P{c}.
+     * \endparblock
+     *
+     * \complexity{
+     * - Si \T{iterator} es un \e ForwardIterator: \O(\COPY(\P{res}))
+     * - Si no: \O(\SIZE(\P{res}) \CDOT \CMP(\P{res}) \PLUS \COPY(\P{res})) amortizado
+     * }
+     */
+    template<class iterator>
+    map(sorted_unique_t, iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc())
+        : lt(c), pool(a) {
+        if constexpr(std::is_base_of<std::forward_iterator_tag,
+                typename std::iterator_traits<iterator>::iterator_category>::value) {
+            construirOrdenado(first, static_cast<size_t>(std::distance(first, last)));
+        } else {
+            while(first != last) {
+                insert(end(), *first);
+                ++first;
+            }
+        }
+    }
+
     /**
      * @brief Operador de asignación
      *
      * @param other diccionario a copiar
      * @retval res referencia a *this
      *
-     * \aliasing{Si res se modifica se va a modificar *this}
+     * \aliasing{Si res se modifica se va a modificar *this.  Se invalidan todos los iteradores de \P{*this},
+     * salvo los que apuntan a la posición pasando-el-último.}
      *
      * \pre \aedpre{true}
      * \post \aedpost{*this \IGOBS *other \LAND alias(res \IGOBS this)}
      *
      * \complexity{\O(\DEL(\P{*this}) \PLUS \COPY(\P{other}))}
      *
-     * \deprecated Esta función se llama a sí mismo sin reducir el tamaño de entrada
-     * Recuerden copy and swap, no copy and assign
+     * \note Es importante remarcar que no se realiza ninguna comparación entre los elementos.  Los nodos de
+     * \P{*this} se destruyen y su memoria se reutiliza para la copia, con lo cual sólo se pide memoria al
+     * allocator si \P{other} tiene más elementos que \P{*this}.
      *
-     * \note Es importante remarcar que no se realiza ninguna comparación entre los elementos.
+     * \attention Si la copia de algún valor lanza una excepción, \P{*this} queda vacío.
      */
-    map& operator=(map other) {
-        swap(other);
+    map& operator=(const map& other) {
+        if(this != &other) {
+            clear();
+            lt = other.lt;
+            try {
+                copiarArbol(other);
+            } catch(...) {
+                clear();
+                throw;
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Operador de asignación por movimiento
+     *
+     * @param other diccionario cuyos valores pasan a \P{*this}
+     * @retval res referencia a *this
+     *
+     * \aliasing{Se invalidan los iteradores de \P{*this}.  Los iteradores de \P{other}, salvo los que apuntan a la
+     * posición pasando-el-último, pasan a ser iteradores de \P{*this}.  \P{other} queda vacío.}
+     *
+     * \pre \aedpre{other \IGOBS oth}
+     * \post \aedpost{*this \IGOBS oth \LAND vacio?(other) \LAND alias(res \IGOBS this)}
+     *
+     * \complexity{\O(\DEL(\P{*this}))}
+     */
+    map& operator=(map&& other) noexcept(std::is_nothrow_swappable<Compare>::value) {
+        if(this != &other) {
+            clear();
+            swap(other);
+        }
         return *this;
     }
 
@@ -1139,6 +1739,31 @@ public:
     ~map() {
         clear();
     }
+
+    /**
+     * @brief Devuelve una copia del allocator usado por el pool de nodos
+     *
+     * @retval res allocator de \P{*this}
+     *
+     * \pre \aedpre{true}
+     * \post \aedpost{true}
+     *
+     * \complexity{\O(1)}
+     */
+    allocator_type get_allocator() const {
+        return pool.get_allocator();
+    }
+
+    /**
+     * @brief Devuelve una copia del comparador de claves
+     *
+     * @retval res comparador de \P{*this}
+     *
+     * \complexity{\O(1)}
+     */
+    key_compare key_comp() const {
+        return lt;
+    }
     ///@}
 
     ////////////////////////////////////////////
@@ -1177,6 +1802,28 @@ public:
     	return it->second;
     }
 
+    /**
+     * @brief Devuelve el significado asociado a la clave equivalente a \P{key}
+     *
+     * Idéntica a at(const Key&), pero \P{key} puede ser de cualquier tipo \T{K} comparable con \T{Key} por
+     * \T{Compare}; no se construye ningún \T{Key} temporal.  Sólo está disponible si \T{Compare} es transparente;
+     * ver \ref Busqueda.
+     *
+     * \pre \aedpre{def?(key,*this)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}))}
+     */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const Meaning& at(const K& key) const {
+        return const_iterator(buscar(key))->second;
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    Meaning& at(const K& key) {
+        return iterator(buscar(key))->second;
+    }
+
     /**
      * @brief Devuelve el significado asociado a \P{key}, asegurando su existencia
      *
@@ -1209,24 +1856,27 @@ public:
      *                  #claves(self) + 1 \IGOBS #claves(this) \LAND  alias(res \IGOBS obtener(key,*this)))
      *  \LAND def?(key,*this)}
 	   *
-     * \deprecated Idem antes,  "it.n->color == Color::Header", es mejor usar funciones:
-     * son más declarativas y ayuda a que cambios futuros de estructura no afecten a todo el código
-     *
      * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) + \a x) donde
      * - \a x = 1 si def?(\a self, \P{key}), y
      * - \a x = \a c en caso contrario.}
      *
+     * \note Se desciende una única vez desde la raíz (a lo sumo \a h + 1 comparaciones, siendo \a h la altura del
+     * árbol), recordando dónde engancharía el nodo nuevo.  El significado por defecto se construye sólo si \P{key}
+     * no está definida, y directamente dentro del nodo nuevo.
      */
     Meaning& operator[](const Key& key) {
-        iterator it = find(key);
-        value_type v = value_type(key, Meaning());
-        if(it == end()){
-            insert(v);
-            iterator it = find(key);
-            return it->second;
-        }else{
-            return it->second;
-        }
+        Lugar l = lugar(key);
+        if(l.existe) return l.padre->value().second;
+        return enganchar(pool.crear(l.padre, Color::Red, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple()), l)->second;
+    }
+
+    /** \overload */
+    Meaning& operator[](Key&& key) {
+        Lugar l = lugar(key);
+        if(l.existe) return l.padre->value().second;
+        return enganchar(pool.crear(l.padre, Color::Red, std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)), std::forward_as_tuple()), l)->second;
     }
 
     /**
@@ -1251,7 +1901,8 @@ public:
      * \deprecated En la post deben decir algo más sobre el iterator res, en particular algun otro de los observadores del
      * iterador
      *
-     * \deprecated Este código se puede mejorar, pero está bien
+     * \note Se compara a lo sumo una vez por nivel del árbol, más una comparación final cuando las claves no se pueden
+     * comparar de a tres vías; ver \ref Busqueda.
      *
      * \attention Si el objetivo es insertar un valor con clave \P{key} de acuerdo a alguna condición,
      * entonces conviene usar aed2::map::lower_bound para la búsqueda, dado que el
@@ -1259,27 +1910,32 @@ public:
      *
      */
     iterator find(const Key& key) {
-        iterator it = lower_bound(key);
-        if(it == end() or not eq(it->first, key)){
-           return iterator(&header);
-        }
-        return it;
+        return iterator(buscar(key));
     }
 
-    /** \overload
-    *
-    * \deprecated No pueden llamar a funciones const desde funciones no const,
-    * no lo vuelvo a mencionar pero se repite mucho este error
-    */
+    /** \overload */
     const_iterator find(const Key& key) const {
-        const_iterator it = lower_bound(key);
-        if(it == end()){
-            return it;
-        }
-        if(not eq(it->first, key)){
-            it = const_iterator(&header);
-        }
-        return it;
+        return const_iterator(buscar(key));
+    }
+
+    /**
+     * @brief Devuelve un iterador a la posicion del valor con clave equivalente a \P{key}
+     *
+     * Idéntica a find(const Key&), pero \P{key} puede ser de cualquier tipo \T{K} comparable con \T{Key} por
+     * \T{Compare}; no se construye ningún \T{Key} temporal.  Sólo está disponible si \T{Compare} es transparente;
+     * ver \ref Busqueda.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator find(const K& key) {
+        return iterator(buscar(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K& key) const {
+        return const_iterator(buscar(key));
     }
 
     /**
@@ -1300,61 +1956,89 @@ public:
 	 *						\LAND (((\LNOT def?(key, *this) \LAND \PI1 ult(secuSuby(res)) < key) \IMPLIES_L (vacia?(siguientes(res)))
 	 *						\LAND ((\LNOT def?(key, *this) \IMPLIES_L (\PI1 siguiente(res) > key \LAND \PI1 anterior(res) < key))}
      *
-     * \deprecated not lt(it.n->key(), key) and not lt(key, it.n->key()) usen funciones
-     *
      * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
      *
+     * \note Se compara una única vez por nivel del árbol; ver \ref Busqueda.
      */
     const_iterator lower_bound(const Key& key) const {
-        const_iterator it = iterator(header.parent);
-        while(it.n != nullptr){
-            if(eq(it.n->key(), key)){
-                return it;
-            }else{
-                if(lt(it.n->key(), key)){
-                    if(it.n->child[1] == nullptr) {
-                        return it.avanzar();
-                    }else{
-                        it.n = it.n->child[1];
-                    }
-                }else{
-                    if(it.n->child[0] == nullptr){
-                        return it;
-                    }else {
-                        it.n = it.n->child[0];
-                    }
-                }
-            }
-        }
-        it = const_iterator(&header);
-        return it;
+        return const_iterator(cotaInferior(key));
     }
 
     /** \overload */
     iterator lower_bound(const Key& key)  {
-        iterator it = iterator(header.parent);
-        while(it.n != nullptr){
-            if(eq(it.n->key(), key)){
-                return it;
-            }else{
-                if(lt(it.n->key(), key)){
-                    if(it.n->child[1] == nullptr) {
-                        return it.avanzar();
-                    }else{
-                        it.n = it.n->child[1];
-                    }
-                }else{
-                    if(it.n->child[0] == nullptr){
-                        return it;
-                    }else {
-                        it.n = it.n->child[0];
-                    }
-                }
-            }
-        }
-        it = iterator(&header);
-        return it;
+        return iterator(cotaInferior(key));
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave no menor a \P{key}
+     *
+     * Idéntica a lower_bound(const Key&), pero \P{key} puede ser de cualquier tipo \T{K} comparable con \T{Key}
+     * por \T{Compare}; no se construye ningún \T{Key} temporal.  Sólo está disponible si \T{Compare} es
+     * transparente; ver \ref Busqueda.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K& key) const {
+        return const_iterator(cotaInferior(key));
+    }
+
+    /** \overload */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator lower_bound(const K& key) {
+        return iterator(cotaInferior(key));
+    }
+
+    /**
+     * @brief Busca cada una de las claves de [\P{first}, \P{last}) y escribe los resultados en \P{out}
+     *
+     * Equivale a `for(; first != last; ++first) *out++ = find(*first);`, pero las búsquedas no se hacen de a una:
+     * se avanzan en simultáneo los descensos de hasta descensos_en_lote claves, un nivel por vez, pidiendo por
+     * adelantado (prefetch) el próximo nodo de cada una.  Así los cache misses de los distintos descensos se
+     * superponen en lugar de esperarse uno detrás de otro; ver \ref Lotes.  Las claves pueden estar en cualquier
+     * orden y repetirse.  Si \T{Compare} es transparente, las claves pueden ser de cualquier tipo comparable con
+     * \T{Key}; si no, cada clave debe ser convertible a \T{Key}.
+     *
+     * @param first, last rango de claves a buscar
+     * @param out destino de los resultados: un iterator (o const_iterator) por clave, en el orden de las claves
+     * @returns \P{out} avanzado tantas posiciones como claves hay en el rango
+     *
+     * \pre \aedpre{[\P{first}, \P{last}) es un rango válido y \P{out} admite distance(\P{first}, \P{last}) escrituras}
+     * \post \aedpost{el i-ésimo valor escrito en \P{out} es find(\P{first}[i])}
+     *
+     * \complexity{\O(\a m \CDOT \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this})), donde \a m es la cantidad de claves}
+     */
+    template<class ForwardIt, class OutputIt>
+    OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) {
+        return enLotes<true>(first, last, out, [](Node* n) { return iterator(n); });
+    }
+
+    /** \overload */
+    template<class ForwardIt, class OutputIt>
+    OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) const {
+        return enLotes<true>(first, last, out, [](Node* n) { return const_iterator(n); });
+    }
+
+    /**
+     * @brief Calcula lower_bound de cada una de las claves de [\P{first}, \P{last}) y escribe los resultados en \P{out}
+     *
+     * Idéntica a find_batch, pero el i-ésimo valor escrito en \P{out} es lower_bound(\P{first}[i]).
+     *
+     * \complexity{\O(\a m \CDOT \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this})), donde \a m es la cantidad de claves}
+     */
+    template<class ForwardIt, class OutputIt>
+    OutputIt lower_bound_batch(ForwardIt first, ForwardIt last, OutputIt out) {
+        return enLotes<false>(first, last, out, [](Node* n) { return iterator(n); });
     }
+
+    /** \overload */
+    template<class ForwardIt, class OutputIt>
+    OutputIt lower_bound_batch(ForwardIt first, ForwardIt last, OutputIt out) const {
+        return enLotes<false>(first, last, out, [](Node* n) { return const_iterator(n); });
+    }
+
+    /** \brief Cantidad máxima de descensos que find_batch y lower_bound_batch avanzan en simultáneo */
+    static constexpr size_t descensos_en_lote = 16;
     ///@}
 
     ///////////////////////////////////
@@ -1372,7 +2056,7 @@ public:
      * \complexity{\O(1)}
      */
     bool empty() const {
-        return header.parent == nullptr;
+        return header.parent() == nullptr;
     }
 
     /**
@@ -1388,29 +2072,198 @@ public:
     size_t size() const {
         return count;
     }
+
+    /**
+     * @brief Devuelve la cantidad de bytes que ocupa cada valor guardado en el diccionario, incluyendo la
+     * estructura del nodo que lo contiene.  Ver \ref Memoria.
+     *
+     * @retval res sizeof del nodo interno del árbol
+     *
+     * \complexity{\O(1)}
+     */
+    static constexpr size_t node_size() {
+        return sizeof(InnerNode);
+    }
     //@}
 
-	//////////////////////////////////////////////
-    /** \name Inserción, borrado y modificación */
-    //////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////
+    /** \name Estadísticos de orden (requieren una política con tamaño, e.g., aed2::subtree_size) */
+    /////////////////////////////////////////////////////////////////////////////
     //@{
     /**
-     * @brief Inserta \P{value} en el diccionario
+     * @brief Devuelve un iterador al \P{k}-ésimo valor (contando desde 0) en el orden de las claves
      *
-     * Inserta un \b nuevo valor en el diccionario.  Si \P{*this} ya tiene un valor con clave
-     * \P{value}.first, entonces la función no tiene efectos.  El iterador de retorno apunta al elemento
-     * recien insertado (o aquel que previno la insercion).
+     * @param k posición del valor buscado
+     * @retval res iterador al valor con exactamente \P{k} claves menores, o end() si \P{k} \GEQ \SIZE(\P{*this})
      *
-     * @param value valor a insertar
-     * @param hint iterador apuntando al diccionario.  Se espera que apunte al minimo valor
-     * mayor o igual a \P{value}.first (i.e., a lower_bound(\P{value}.first)).
-     * Igualmente, la función es robusta y funciona correctamente aunque esto no ocurra.
-     * @retval res iterador apuntando al elemento insertado o que previno la inserción
+     * \pre \aedpre{augment_has_size<Augment>}
      *
-     * \aliasing{Si modificas a lo que apunta res se modifica *this y hint no se modifica}
+     * \complexity{\O(\LOG(\SIZE(\P{*this})))}
      *
+     * \note Desciende desde la raíz usando el tamaño del subárbol izquierdo de cada nodo; no compara claves.
+     */
+    iterator nth(size_t k) {
+        return iterator(enesimo(k));
+    }
+
+    /** \overload */
+    const_iterator nth(size_t k) const {
+        return const_iterator(enesimo(k));
+    }
+
+    /**
+     * @brief Devuelve la cantidad de claves de \P{*this} menores a \P{key}
      *
-     * \pre \aedpre{*this \IGOBS self \LAND coleccion(hint) \IGOBS *this}
+     * Si \P{key} está definida, es su posición en el orden (contando desde 0); si no, es la posición en la que
+     * quedaría al insertarla.
+     *
+     * \pre \aedpre{augment_has_size<Augment>}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    size_t rank(const Key& key) const {
+        static_assert(augment_has_size<Augment>::value, "rank requiere una política de aumento con tamaño");
+        size_t res = 0;
+        const Node* n = header.parent();
+        while(n != nullptr){
+            if(lt(n->key(), key)){
+                res += tamanio(n->child[0]) + 1;
+                n = n->child[1];
+            }else{
+                n = n->child[0];
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Devuelve la posición (contando desde 0) del valor apuntado por \P{pos}, o \SIZE(\P{*this}) si es end()
+     *
+     * \pre \aedpre{augment_has_size<Augment>} y \P{pos} es un iterador de \P{*this}.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+     *
+     * \note Sube desde el nodo de \P{pos} hasta la raíz sumando los tamaños de los subárboles que quedan a izquierda.
+     */
+    size_t index(const_iterator pos) const {
+        static_assert(augment_has_size<Augment>::value, "index requiere una política de aumento con tamaño");
+        const Node* n = pos.n;
+        if(n == &header){
+            return count;
+        }
+        size_t res = tamanio(n->child[0]);
+        while(n->parent() != &header){
+            const Node* padre = n->parent();
+            if(n == padre->child[1]){
+                res += tamanio(padre->child[0]) + 1;
+            }
+            n = padre;
+        }
+        return res;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de incrementos necesarios para llegar de \P{first} a \P{last}
+     *
+     * Es el equivalente a std::distance(\P{first}, \P{last}), pero en tiempo logarítmico.  A diferencia de
+     * std::distance, el resultado es negativo si \P{last} está antes que \P{first}.
+     *
+     * \pre \aedpre{augment_has_size<Augment>} y \P{first} y \P{last} son iteradores de \P{*this}.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+     */
+    difference_type distance(const_iterator first, const_iterator last) const {
+        return static_cast<difference_type>(index(last)) - static_cast<difference_type>(index(first));
+    }
+    //@}
+
+    //////////////////////////////////////////////////////////////////////
+    /** \name Resúmenes de rangos (requieren una política de aumento) */
+    //////////////////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve el resumen, según la política \T{Augment}, de los valores con clave en [\P{lo}, \P{hi})
+     *
+     * Es el resultado de combinar, en el orden de las claves, los resúmenes (lift) de los valores cuya clave
+     * \a k cumple \P{lo} \LEQ \a k \LT \P{hi}; si no hay ninguno, es identity().  Por ejemplo, con una política
+     * que suma los significados, es la suma de los significados del rango.
+     *
+     * @param lo cota inferior (incluida) de las claves del rango
+     * @param hi cota superior (excluida) de las claves del rango
+     *
+     * \pre \aedpre{\T{Augment} no es aed2::no_augmentation}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS costo de combinar dos resúmenes))}
+     *
+     * \note Se busca el primer nodo cuya clave cae en el rango (donde se separan los caminos hacia \P{lo} y
+     * \P{hi}); el resultado combina el sufijo de su subárbol izquierdo, su valor y el prefijo de su subárbol
+     * derecho, cada uno calculado en un descenso que usa los resúmenes guardados.  Ver \ref Aumentos.
+     */
+    auto reduce(const Key& lo, const Key& hi) const {
+        static_assert(aumentado, "reduce requiere una política de aumento");
+        const Node* n = header.parent();
+        while(n != nullptr){
+            if(lt(n->key(), lo)){
+                n = n->child[1];
+            }else if(not lt(n->key(), hi)){
+                n = n->child[0];
+            }else{
+                return Augment::combine(Augment::combine(sufijo(n->child[0], lo), Augment::lift(n->value())),
+                                        prefijo(n->child[1], hi));
+            }
+        }
+        return Augment::identity();
+    }
+
+    /**
+     * @brief Devuelve el resumen de todos los valores del diccionario
+     *
+     * \pre \aedpre{\T{Augment} no es aed2::no_augmentation}
+     *
+     * \complexity{\O(1)}
+     */
+    auto summary() const {
+        static_assert(aumentado, "summary requiere una política de aumento");
+        return resumen(header.parent());
+    }
+
+    /**
+     * @brief Recalcula los resúmenes afectados por un cambio en el significado apuntado por \P{pos}
+     *
+     * Las operaciones del diccionario mantienen los resúmenes, pero si el resumen de un valor depende de su
+     * significado y éste se modifica a través de una referencia (e.g., obtenida con operator[], at o un
+     * iterador), hay que llamar a esta función antes de la próxima consulta de resúmenes.
+     *
+     * \pre \P{pos} apunta a un valor de \P{*this}.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this}))) si \T{Augment} guarda resúmenes; \O(1) si no}
+     */
+    void update_summary(const_iterator pos) {
+        actualizarHastaLaRaiz(const_cast<Node*>(pos.n));
+    }
+    //@}
+
+	//////////////////////////////////////////////
+    /** \name Inserción, borrado y modificación */
+    //////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Inserta \P{value} en el diccionario
+     *
+     * Inserta un \b nuevo valor en el diccionario.  Si \P{*this} ya tiene un valor con clave
+     * \P{value}.first, entonces la función no tiene efectos.  El iterador de retorno apunta al elemento
+     * recien insertado (o aquel que previno la insercion).
+     *
+     * @param value valor a insertar
+     * @param hint iterador apuntando al diccionario.  Se espera que apunte al minimo valor
+     * mayor o igual a \P{value}.first (i.e., a lower_bound(\P{value}.first)).
+     * Igualmente, la función es robusta y funciona correctamente aunque esto no ocurra.
+     * @retval res iterador apuntando al elemento insertado o que previno la inserción
+     *
+     * \aliasing{Si modificas a lo que apunta res se modifica *this y hint no se modifica}
+     *
+     *
+     * \pre \aedpre{*this \IGOBS self \LAND coleccion(hint) \IGOBS *this}
      * \post  \aedpost{ (def?(value.first, self) \IMPLIES_L this \IGOBS self) \LAND
      *                      (not(def?(value.first, self)) \IMPLIES_L this \IGOBS definir(value.first, value.second, self) \LAND #claves(self) + 1 \IGOBS #claves(this))
      *                      \LAND this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key)
@@ -1425,51 +2278,181 @@ public:
      * \deprecated Digan algo en la PRE (y aliasing) sobre el iterador hint, que debe cumplir
      * \deprecated \f$  #claves(self) + 1 \IGOBS #claves(this))\f$ tiene sentido eso??
      *
-     * \deprecated  hint++; Esto esta dentro del if donde hint es el header
-     * \deprecated Qué pasa si te pasan el aed2::map::end() como hint, pero no es un hint válido
-     * \deprecated Intenten no repetir tanto código, tal vez pueden hacer que todas las inserciones se hagan a través
-     * de una sola función
-     * \deprecated Tantos ifs anidados complican la comprensión de código, intenten reescribir
+     * \note Todas las inserciones se resuelven con dos funciones privadas: una que busca el lugar del nodo
+     * nuevo (usando \P{hint} si es bueno) y otra que lo engancha y rebalancea.  De esta forma, el nodo se
+     * construye directamente con su valor definitivo (ver aed2::map::emplace y aed2::map::try_emplace).
      *
      * \attention Para garantizar que el nuevo elemento se inserte sí o sí, usar aed2::map::insert_or_assign.
      */
 	 iterator insert(const_iterator hint, const value_type& value) {
-         if(empty()){
-             iterator nuevo = iterator(new InnerNode(&header, value, Color::Black));
-             header.child[0] = nuevo.n;
-             header.child[1] = nuevo.n;
-             header.parent = nuevo.n;
-             count++;
-             return nuevo;
-         }
-         if(esBuenHint(hint,value)){
-             if( lt(header.child[1]->key(), value.first) or lt(value.first, header.child[0]->key())){
-                 iterator it = insertMinOMax(value);
-                 insertFixUp(it.n);
-                 count++;
-                 return it;
-             }
-             if(eq(hint.n->value().first , value.first)){
-                 iterator it = iterator(const_cast<Node*>(hint.n));
-                 return it;
-             }else{
-                 iterator it = insertConLB(hint,value);
-                 insertFixUp(it.n);
-                 count++;
-                 return it;
-             }
-         }else{
-			 iterator it = insert(value);
-             return it;
-         }
+         Lugar l = lugarConHint(hint, value.first);
+         if(l.existe) return iterator(l.padre);
+         return enganchar(pool.crear(l.padre, Color::Red, value), l);
      }
 
      /** \overload */
      iterator insert(const value_type& value) {
-         const_iterator it = lower_bound(value.first);
-         return insert(it, value);
+         Lugar l = lugar(value.first);
+         if(l.existe) return iterator(l.padre);
+         return enganchar(pool.crear(l.padre, Color::Red, value), l);
      }
 
+     /**
+      * \overload
+      *
+      * El valor se mueve dentro del nodo nuevo; si la clave ya estaba definida, \P{value} no se modifica.
+      *
+      * \complexity{Idem insert(const_iterator, const value_type&), reemplazando \COPY(\P{value}) por el costo de moverlo.}
+      */
+     iterator insert(const_iterator hint, value_type&& value) {
+         Lugar l = lugarConHint(hint, value.first);
+         if(l.existe) return iterator(l.padre);
+         return enganchar(pool.crear(l.padre, Color::Red, std::move(value)), l);
+     }
+
+     /** \overload */
+     iterator insert(value_type&& value) {
+         Lugar l = lugar(value.first);
+         if(l.existe) return iterator(l.padre);
+         return enganchar(pool.crear(l.padre, Color::Red, std::move(value)), l);
+     }
+
+    /**
+     * @brief Inserta los valores del rango ordenado [\P{first}, \P{last})
+     *
+     * Equivale a insertar los valores de a uno con insert(const value_type&): los valores cuya clave ya está definida
+     * (en \P{*this} o antes en el rango) no tienen efecto.  Como el rango está ordenado, el lugar de cada valor no se
+     * busca desde la raíz sino desde el nodo del valor anterior (\e finger \e search): se sube sólo hasta el primer
+     * ancestro cuya clave no es menor a la nueva y se desciende desde ahí; ver \ref Lotes.
+     *
+     * @param first, last rango de valores a insertar, ordenado por clave
+     *
+     * \pre \aedpre{[\P{first}, \P{last}) es un rango válido}
+     * \post \aedpost{Idem insertar, en orden, cada valor del rango}
+     *
+     * \complexity{
+     * - Si el rango está ordenado: \O(\a m \CDOT (\LOG(\SIZE(\P{*this}) / \a m) \CDOT \CMP(\P{*this}) \PLUS \COPY(\P{value}))) amortizado, con
+     *   \a m la cantidad de valores del rango
+     * - Peor caso: \O(\a m \CDOT (\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \COPY(\P{value})))
+     * }
+     *
+     * \note La función es robusta: si una clave no es mayor a la anterior del rango, su lugar se busca desde la raíz.
+     * Si el lote es muy disperso (\a m mucho menor a \SIZE(\P{*this})), subir y volver a bajar puede costar hasta el
+     * doble de comparaciones que descender desde la raíz.  Con claves baratas de comparar (e.g., enteros) el costo lo
+     * domina el recorrido de los nodos, y la subida suele ser más lenta que la parte del descenso desde la raíz que
+     * ya está en cache; en ese caso conviene insertar de a uno.
+     */
+    template<class InputIt>
+    void insert_sorted_batch(InputIt first, InputIt last) {
+        Node* dedo = nullptr;
+        for(; first != last; ++first) {
+            const auto& value = *first;
+            const Key& key = value.first;
+            Lugar l = dedo != nullptr and lt(dedo->key(), key) ? lugarDesde(dedo, key) : lugar(key);
+            dedo = l.existe ? l.padre : enganchar(pool.crear(l.padre, Color::Red, value), l).n;
+        }
+    }
+
+    /**
+     * @brief Inserta un valor construido en el lugar a partir de \P{args}
+     *
+     * Construye un valor con `value_type(std::forward<Args>(args)...)` directamente dentro de un nodo nuevo y
+     * lo inserta en el diccionario.  Si la clave del valor construido ya estaba definida, el valor se destruye y
+     * la función no tiene efectos sobre el diccionario.
+     *
+     * @param args parámetros del constructor de \T{value_type}
+     * @retval res iterador apuntando al elemento insertado o que previno la inserción
+     *
+     * \aliasing{Si modificas a lo que apunta res se modifica *this}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{Idem aed2::map::insert, con value = value_type(args)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \a c) donde \a c es el costo de construir el valor.}
+     *
+     * \attention El valor se construye antes de buscar la clave, porque la clave se obtiene del valor.  Si la
+     * clave está disponible por separado, aed2::map::try_emplace evita construir el valor cuando la clave existe.
+     */
+    template<class... Args>
+    iterator emplace(Args&&... args) {
+        return emplace_hint(end(), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Idem aed2::map::emplace, usando \P{hint} para buscar el lugar de inserción
+     *
+     * @param hint iterador apuntando al diccionario.  Se espera que apunte al mínimo valor con clave mayor o igual
+     * a la del valor construido.  Igualmente, la función es robusta y funciona correctamente aunque esto no ocurra.
+     * @param args parámetros del constructor de \T{value_type}
+     * @retval res iterador apuntando al elemento insertado o que previno la inserción
+     *
+     * \complexity{Idem aed2::map::insert(const_iterator, const value_type&), reemplazando \COPY(\P{value}) por el costo de construir el valor.}
+     */
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        InnerNode* nuevo = pool.crear(nullptr, Color::Red, std::forward<Args>(args)...);
+        Lugar l = lugarConHint(hint, nuevo->key());
+        if(l.existe) {
+            pool.destruir(nuevo);
+            return iterator(l.padre);
+        }
+        nuevo->set_parent(l.padre);
+        return enganchar(nuevo, l);
+    }
+
+    /**
+     * @brief Inserta el valor (\P{key}, \T{Meaning}(\P{args}...)) si \P{key} no está definida
+     *
+     * A diferencia de aed2::map::emplace, la búsqueda se hace antes de construir el valor: si \P{key} ya está
+     * definida, no se construye nada ni se mueven \P{key} ni \P{args}.  En caso contrario, el significado se
+     * construye directamente dentro del nodo nuevo.
+     *
+     * @param key clave a insertar
+     * @param args parámetros del constructor de \T{Meaning}
+     * @retval res iterador apuntando al elemento insertado o que previno la inserción
+     *
+     * \aliasing{Si modificas a lo que apunta res se modifica *this}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{Idem aed2::map::insert, con value = (key, Meaning(args))}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \a c) donde \a c es 0 si \P{key} está definida,
+     * o el costo de construir el valor en caso contrario.}
+     */
+    template<class... Args>
+    iterator try_emplace(const Key& key, Args&&... args) {
+        return try_emplace(end(), key, std::forward<Args>(args)...);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(Key&& key, Args&&... args) {
+        return try_emplace(end(), std::move(key), std::forward<Args>(args)...);
+    }
+
+    /**
+     * \overload
+     *
+     * @param hint iterador apuntando al diccionario.  Se espera que apunte al mínimo valor con clave mayor o igual
+     * a \P{key}.  Igualmente, la función es robusta y funciona correctamente aunque esto no ocurra.
+     */
+    template<class... Args>
+    iterator try_emplace(const_iterator hint, const Key& key, Args&&... args) {
+        Lugar l = lugarConHint(hint, key);
+        if(l.existe) return iterator(l.padre);
+        return enganchar(pool.crear(l.padre, Color::Red, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)), l);
+    }
+
+    /** \overload */
+    template<class... Args>
+    iterator try_emplace(const_iterator hint, Key&& key, Args&&... args) {
+        Lugar l = lugarConHint(hint, key);
+        if(l.existe) return iterator(l.padre);
+        return enganchar(pool.crear(l.padre, Color::Red, std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)), l);
+    }
+
     /**
      * @brief Inserta o redefine \P{value} en el diccionario
      *
@@ -1491,9 +2474,6 @@ public:
      *
      * \deprecated \f$ definir(\PI1 value, \PI2 value), self) \f$ las "variables" de los TADS no se modifican
      *
-     * \deprecated El find del principio les arruina la complejidad ante un buen hint
-     *
-     *
      * \complexity{
      *  - Peor caso: \O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \COPY(\P{value}))
      *  - Si \P{hint} apunta al primer valor con clave al menos \P{value}.first (o \P{this}->end() en caso de no existir):
@@ -1506,17 +2486,40 @@ public:
      * \T{Meaning} tenga constructor sin parámetros.  La desventaja es que la notación no es tan bonita.
      */
     iterator insert_or_assign(const_iterator hint, const value_type& value) {
-        iterator encontrado = insert(hint, value);
-    	if(encontrado->second != value.second){
-    		encontrado->second = value.second;
-    	}
-    	return encontrado;
+        return asignarOEnganchar(lugarConHint(hint, value.first), value);
     }
 
     /** \overload */
     iterator insert_or_assign(const value_type& value) {
-        const_iterator hint = lower_bound(value.first);
-        return insert_or_assign(hint, value);
+        return asignarOEnganchar(lugar(value.first), value);
+    }
+
+    /** \overload */
+    iterator insert_or_assign(const_iterator hint, value_type&& value) {
+        return asignarOEnganchar(lugarConHint(hint, value.first), std::move(value));
+    }
+
+    /** \overload */
+    iterator insert_or_assign(value_type&& value) {
+        return asignarOEnganchar(lugar(value.first), std::move(value));
+    }
+
+    /**
+     * \overload
+     *
+     * Versión del estándar C++17, que recibe la clave y el significado por separado.  El significado se asigna
+     * (si \P{key} está definida) o se usa para construir el valor nuevo a partir de \P{obj}, sin construir
+     * un par temporal.
+     */
+    template<class M>
+    iterator insert_or_assign(const Key& key, M&& obj) {
+        Lugar l = lugar(key);
+        if(l.existe) {
+            l.padre->value().second = std::forward<M>(obj);
+            actualizarHastaLaRaiz(l.padre);
+            return iterator(l.padre);
+        }
+        return enganchar(pool.crear(l.padre, Color::Red, key, std::forward<M>(obj)), l);
     }
 
     /**
@@ -1548,41 +2551,18 @@ public:
      *
      */
     iterator erase(const_iterator pos) {
-        iterator y = iterator(const_cast<Node*>(pos.n));
-        Color original = y.n->color;
         iterator proximo = iterator(const_cast<Node*>(pos.n));
         proximo.avanzar();
-		iterator cambiado;
-        iterator padre_cambiado;
-        if(pos.n->child[0] == nullptr){
-            cambiado = iterator(pos.n->child[1]);
-            padre_cambiado = y.n->parent;
-            transplant(const_cast<Node*>(pos.n), pos.n->child[1]);
-        } else{
-            if(pos.n->child[1] == nullptr){
-                cambiado = iterator(pos.n->child[0]);
-                padre_cambiado = y.n->parent;
-                transplant(const_cast<Node*>(pos.n), pos.n->child[0]);
-        	}else{
-				y.avanzar();
-				original = y.n->color;
-				padre_cambiado = y;
-				cambiado = iterator(y.n->child[1]);
-				if(y.n->parent != pos) {
-					transplant(y.n, y.n->child[1]);
-					y.n->child[1] = pos.n->child[1];
-					y.n->child[1]->parent = y;
-				}
-				transplant(const_cast<Node*>(pos.n), y.n);
-                y.n->child[0] = pos.n->child[0];
-                y.n->child[0]->parent = y;
-                y.n->color = pos.n->color;
-			}
-		}
-		if(original == Color::Black){
-			deleteFixUp(padre_cambiado.n, cambiado.n);
-		}
-        delete pos.n;
+        if(count == 1){
+            header.child[0] = header.child[1] = &header;
+        }else if(pos.n == header.child[0]){
+            header.child[0] = proximo.n;
+        }else if(pos.n == header.child[1]){
+            iterator anterior = iterator(const_cast<Node*>(pos.n));
+            header.child[1] = anterior.retroceder().n;
+        }
+        desenganchar(const_cast<Node*>(pos.n));
+        pool.destruir(static_cast<InnerNode*>(const_cast<Node*>(pos.n)));
         count--;
 		return proximo;
     }
@@ -1609,6 +2589,52 @@ public:
         erase(pos);
     }
 
+    /**
+     * @brief Elimina el valor cuya clave es equivalente a \P{key}
+     *
+     * Idéntica a erase(const Key&), pero \P{key} puede ser de cualquier tipo \T{K} comparable con \T{Key} por
+     * \T{Compare} (salvo los iteradores); no se construye ningún \T{Key} temporal.  Sólo está disponible si
+     * \T{Compare} es transparente; ver \ref Busqueda.
+     *
+     * \pre \aedpre{definido?(key, *this) \LAND self \IGOBS *this}
+     * \post \aedpost{*this\IGOBS borrar(key, self)}
+     *
+     * \complexity{\O(\DEL(\P{*pos}) + \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    template<class K, class C = Compare, class = typename C::is_transparent,
+            class = std::enable_if_t<not std::is_convertible_v<K, const_iterator>>>
+    void erase(const K& key) {
+        erase(const_iterator(buscar(key)));
+    }
+
+    /**
+     * @brief Elimina los valores del rango [\P{first}, \P{last})
+     *
+     * @param first iterador al primer valor a eliminar
+     * @param last iterador pasando el último valor a eliminar
+     * @retval res iterador a \P{last}
+     *
+     * \aliasing{Se invalidan los iteradores a los valores eliminados; los demás se mantienen válidos.}
+     *
+     * \pre \aedpre{coleccion(\P{first}) \IGOBS *this \LAND coleccion(\P{last}) \IGOBS *this \LAND \P{last} es alcanzable desde \P{first}}
+     * \post \aedpost{*this no tiene los valores de [\P{first}, \P{last}) \LAND el resto no cambia \LAND res \IGOBS \P{last}}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \DEL([\P{first}, \P{last})))}
+     *
+     * \note El rango no se borra de a un valor: se separa del árbol partiéndolo en las claves de \P{first} y
+     * \P{last}, se destruye en postorden y los extremos se vuelven a unir, con lo cual el rebalanceo cuesta
+     * \O(\LOG(\SIZE(\P{*this}))) sin importar el largo del rango.  Ver \ref Particion.
+     */
+    iterator erase(const_iterator first, const_iterator last) {
+        if(first == cbegin() and last == cend()) {
+            clear();
+        } else {
+            size_t k;
+            destruirNodos(recortar(first, last, k).raiz);
+        }
+        return iterator(const_cast<Node*>(last.n));
+    }
+
     /**
      * @brief Vacia el diccionario
      *
@@ -1618,18 +2644,24 @@ public:
      * \pre \aedpre{true}
      * \post \aedpost{\P{*this} \IGOBS vacio}
      *
-     * \deprecated Es verdaderamente necesario el primer if??
-     *
      * \complexity{\O(\DEL(\P{*this}))}
+     *
+     * \note Los nodos no se borran con aed2::map::erase sino que se destruyen en postorden y vuelven al
+     * pool en bloque.  Ver \ref Pool.  Si el pool se comparte con otro diccionario (ver \ref Particion), cada
+     * nodo vuelve a la lista de libres.
      */
     void clear() {
-        iterator it = begin();
-        int i = 0;
-        size_t j = count;
-        while(it != end()){
-            it = erase(it);
-            i++;
+        if(pool.compartido()) {
+            destruirNodos(header.parent());
+        } else {
+            if(not std::is_trivially_destructible<InnerNode>::value) {
+                destruirValores(header.parent());
+            }
+            pool.vaciar();
         }
+        header.set_parent(nullptr);
+        header.child[0] = header.child[1] = &header;
+        count = 0;
     }
 
     /**
@@ -1655,16 +2687,19 @@ public:
      * representar al valor inválido, en lugar de usar los iteradores pasando-el-ultimo.
      *
      */
-    void swap(map& other) {
+    void swap(map& other) noexcept(std::is_nothrow_swappable<Compare>::value) {
     	using std::swap;
         swap(lt, other.lt);
         swap(count, other.count);
+        pool.swap(other.pool);
 
-        swap(header.parent, other.header.parent);
+        Node* raiz = header.parent();
+        header.set_parent(other.header.parent());
+        other.header.set_parent(raiz);
         swap(header.child[0], other.header.child[0]);
         swap(header.child[1], other.header.child[1]);
-        if(root() != nullptr) root()->parent = &header;
-        if(other.root() != nullptr) other.root()->parent = &other.header;
+        if(root() != nullptr) root()->set_parent(&header);
+        if(other.root() != nullptr) other.root()->set_parent(&other.header);
 
         //nota: cuando el arbol es vacio, los child de header apuntan a header.  Notar que quedan apuntando mal despues del swap
         if(root() == nullptr) header.child[0] = header.child[1] = &header;
@@ -1672,84 +2707,429 @@ public:
     }
     //@}
 
-    ////////////////////////////////////
-    /** \name Recorridos e iteradores */
-    ////////////////////////////////////
+    ///////////////////////////////////////////////////////
+    /** \name Partición y unión de diccionarios (ver \ref Particion) */
+    ///////////////////////////////////////////////////////
     //@{
     /**
-     * @brief Devuelve un iterador al primer valor del diccionario
+     * @brief Saca de \P{*this} los valores con clave mayor o igual a \P{key} y los devuelve en un diccionario nuevo
      *
-     * \aliasing{Si el iterador me permite modificar, si modificas a lo que apunta res se modifica *this}
+     * @param key clave por la que se parte el diccionario
+     * @retval res diccionario con los valores de clave mayor o igual a \P{key}
      *
-     * @retval res iterador al primer valor
+     * \aliasing{Los iteradores a los valores que pasan a \P{res} pasan a ser iteradores de \P{res}.  \P{res} comparte
+     * el pool de nodos con \P{*this}, pero ambos se pueden modificar desde hilos distintos (ver \ref Particion).}
      *
-     * \pre \aedpre{true}
-     * \post \aedpost{this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key) \LAND
-	 * 					colleccion(pos)=this \LAND res \IGOBS prim(secuSbuy(res))}
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS \elementosMenoresA(self, claves(self), key) \LAND res \IGOBS el resto de self}
      *
-     * \complexity{\O(1)}
+     * \complexity{
+     * - Si la política de aumento tiene tamaño: \O(\LOG(\SIZE(\P{self})) \CDOT \CMP(\P{self}))
+     * - Si no: \O(\LOG(\SIZE(\P{self})) \CDOT \CMP(\P{self}) \PLUS \SIZE(\P{res})), para contar los valores de \P{res}
+     * }
      */
-    iterator begin() {
-        iterator it = iterator(header.child[0]);
-        return it;
-    }
-
-    /** \overload */
-    const_iterator begin() const {
-        const_iterator it = const_iterator(header.child[0]);
-        return it;
-    }
-
-    /** \overload */
-    const_iterator cbegin() {
-        const_iterator it = const_iterator(header.child[0]);
-        return it;
+    map split(const Key& key) {
+        return extract_range(lower_bound(key), cend());
     }
 
     /**
-     * @brief Devuelve un iterador apuntando a la posición pasando-el-ultimo del diccionario
+     * @brief Agrega al final de \P{*this} los valores de \P{right}
      *
-     * \aliasing{si el iterador me permite modificar, si modificas a lo que apunta res se modifica *this}
+     * @param right diccionario cuyas claves son todas mayores a las de \P{*this}
      *
-     * @retval res iterador a la posicion pasando-al-ultimo
+     * \aliasing{\P{right} queda vacío.  Si sus nodos pasan a \P{*this}, sus iteradores pasan a ser iteradores de \P{*this}.}
      *
-     * \pre \aedpre{true}
-     * \post \aedpost{this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key) \LAND
-	 * 					colleccion(pos)=this \LAND res \IGOBS avanzar(ult(secuSbuy(res)))}
+     * \pre \aedpre{*this \IGOBS self \LAND right \IGOBS r \LAND toda clave de r es mayor a toda clave de self}
+     * \post \aedpost{claves(*this) \IGOBS claves(self) \UNION claves(r) \LAND vacio?(right)}
      *
-     * \complexity{\O(1)}
+     * \complexity{
+     * - Si los nodos de \P{right} pasan a \P{*this} (ver \ref Particion): \O(\LOG(\SIZE(\P{self}) \PLUS \SIZE(\P{r})))
+     * - Si no: \O(\LOG(\SIZE(\P{self})) \PLUS \COPY(\P{r}) \PLUS \DEL(\P{r}))
+     * }
      */
-    iterator end() {
-        iterator it = iterator(&header);
-        return it;
+    void join(map&& right) {
+        size_t n = count + right.count;
+        Arbol der = traerArbol(right);
+        plantar(unirSinMedio(soltarArbol(), der), n);
     }
 
-    /** \overload */
-    const_iterator end() const {
-        const_iterator it = const_iterator(&header);
-        return it;
+    /**
+     * @brief Agrega al final de \P{*this} el valor \P{value} y, luego, los valores de \P{right}
+     *
+     * Idem join(map&&), con un valor intermedio: es el \e join(izq, clave, der) de los árboles balanceados.
+     *
+     * @param value valor cuya clave es mayor a las de \P{*this} y menor a las de \P{right}
+     * @param right diccionario cuyas claves son todas mayores a la de \P{value}
+     *
+     * \pre \aedpre{*this \IGOBS self \LAND right \IGOBS r \LAND toda clave de self < value.first < toda clave de r}
+     * \post \aedpost{*this \IGOBS definir(value.first, value.second, self \UNION r) \LAND vacio?(right)}
+     *
+     * \complexity{idem join(map&&) \PLUS \COPY(\P{value})}
+     */
+    void join(const value_type& value, map&& right) {
+        unirConMedio(value, right);
     }
 
     /** \overload */
-    const_iterator cend() {
-        const_iterator it = const_iterator(&header);
-        return it;
+    void join(value_type&& value, map&& right) {
+        unirConMedio(std::move(value), right);
     }
 
     /**
-     * @brief Devuelve un iterador al primer valor del diccionario, en un recorrido al revés
+     * @brief Saca de \P{*this} los valores de [\P{first}, \P{last}) y los devuelve en un diccionario nuevo
      *
-     * \aliasing{si el iterador me permite modificar, si modificas a lo que apunta res se modifica *this}
+     * @param first iterador al primer valor a sacar
+     * @param last iterador pasando el último valor a sacar
+     * @retval res diccionario con los valores de [\P{first}, \P{last})
      *
-     * @retval res iterador a la primer posicion en un recorrido al revés
+     * \aliasing{Los iteradores a los valores del rango pasan a ser iteradores de \P{res}; el resto no cambia.  Salvo
+     * que el rango sea todo \P{*this}, \P{res} comparte el pool de nodos con \P{*this}, pero ambos se pueden modificar
+     * desde hilos distintos (ver \ref Particion).}
      *
-     * \pre \aedpre{true}
-     * \post \aedpost{this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key) \LAND
-	 * 					colleccion(pos)=this \LAND res \IGOBS avanzar(ult(secuSbuy(res)))}
+     * \pre \aedpre{*this \IGOBS self \LAND coleccion(\P{first}) \IGOBS *this \LAND coleccion(\P{last}) \IGOBS *this \LAND \P{last} es alcanzable desde \P{first}}
+     * \post \aedpost{res tiene los valores de [\P{first}, \P{last}) \LAND *this tiene el resto de los valores de self}
      *
-     * \complexity{\O(1)}
-     */
-    reverse_iterator rbegin() {
+     * \complexity{
+     * - Si la política de aumento tiene tamaño: \O(\LOG(\SIZE(\P{self})) \CDOT \CMP(\P{self}))
+     * - Si no: \O(\LOG(\SIZE(\P{self})) \CDOT \CMP(\P{self}) \PLUS \SIZE(\P{res})), para contar los valores de \P{res}
+     * }
+     *
+     * \note Ningún valor se copia ni se mueve: los nodos del rango pasan a \P{res} tal cual.
+     */
+    map extract_range(const_iterator first, const_iterator last) {
+        if(first == cbegin() and last == cend()) {
+            return map(std::move(*this));
+        }
+        map res(lt, get_allocator());
+        if(first != last) {
+            res.pool.compartir(pool);
+            size_t k;
+            Arbol rango = recortar(first, last, k);
+            res.plantar(rango, k);
+        }
+        return res;
+    }
+
+    /**
+     * @brief Pasa a \P{*this} los valores de [\P{first}, \P{last}), que pertenecen a \P{other}
+     *
+     * Los valores cuya clave ya está definida en \P{*this} quedan en \P{other}, como en std::map::merge.
+     *
+     * @param other diccionario del que se sacan los valores
+     * @param first iterador de \P{other} al primer valor a pasar
+     * @param last iterador de \P{other} pasando el último valor a pasar
+     *
+     * \aliasing{Si los nodos pasan a \P{*this}, los iteradores a los valores del rango pasan a ser iteradores de
+     * \P{*this}; si no, se invalidan.  Los demás iteradores se mantienen válidos.}
+     *
+     * \pre \aedpre{*this \IGOBS self \LAND other \IGOBS o \LAND coleccion(\P{first}) \IGOBS other \LAND coleccion(\P{last}) \IGOBS other \LAND \P{last} es alcanzable desde \P{first}}
+     * \post \aedpost{*this tiene los valores de self y los de [\P{first}, \P{last}) cuyas claves no están en self \LAND
+     * other tiene los demás valores de o}
+     *
+     * \complexity{
+     * - Si las claves del rango caen entre dos claves consecutivas de \P{self}: idem extract_range \PLUS
+     *   \O(\LOG(\SIZE(\P{self})) \CDOT \CMP(\P{self})) si los nodos pasan a \P{*this} (ver \ref Particion), o
+     *   \PLUS \COPY(rango) \PLUS \DEL(rango) si no
+     * - Si no: \O(\SIZE(rango) \CDOT \LOG(\SIZE(\P{self}) \PLUS \SIZE(\P{o})) \CDOT \CMP(\P{self}) \PLUS \COPY(rango))
+     * }
+     */
+    void splice(map& other, const_iterator first, const_iterator last) {
+        if(this == &other or first == last) return;
+        map rango = other.extract_range(first, last);
+        try {
+            incorporar(rango);
+        } catch(...) {
+            other.incorporar(rango);
+            throw;
+        }
+        other.incorporar(rango);
+    }
+
+    /** \overload Pasa a \P{*this} todos los valores de \P{other} */
+    void splice(map& other) {
+        splice(other, other.cbegin(), other.cend());
+    }
+    //@}
+
+    ///////////////////////////////////////////////////////////
+    /** \name Operaciones de conjuntos (ver \ref Conjuntos) */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Agrega a \P{*this} los valores de \P{other} cuyas claves no están en \P{*this}, sacándolos de \P{other}
+     *
+     * A diferencia de std::map::merge, \P{other} queda vacío: los valores cuyas claves ya están en \P{*this} se
+     * destruyen.
+     *
+     * @param other diccionario cuyos valores pasan a \P{*this}
+     *
+     * \aliasing{\P{other} queda vacío.  Si sus nodos pasan a \P{*this} (ver \ref Particion), los iteradores a los valores
+     * que no se destruyen pasan a ser iteradores de \P{*this}; si no, se invalidan.}
+     *
+     * \pre \aedpre{*this \IGOBS self \LAND other \IGOBS o}
+     * \post \aedpost{claves(*this) \IGOBS claves(self) \UNION claves(o) \LAND (\FORALL k \IN claves(self)) obtener(k, *this) \IGOBS obtener(k, self)
+     * \LAND (\FORALL k \IN claves(o) \MINUS claves(self)) obtener(k, *this) \IGOBS obtener(k, o) \LAND vacio?(other)}
+     *
+     * \complexity{\O(\a m \CDOT \LOG(\a n / \a m \PLUS 1) \CDOT \CMP(\P{*this}) \PLUS \DEL(repetidos)), con \a m y \a n el menor y el
+     * mayor de \SIZE(\P{self}) y \SIZE(\P{o}), si los nodos de \P{other} pasan a \P{*this}; si no, \PLUS \COPY(\P{o})}
+     *
+     * \note Ningún valor se copia ni se compara dos veces: los árboles se unen partiendo uno por las claves del otro
+     * (ver \ref Conjuntos).  El comparador no puede lanzar excepciones.
+     */
+    void merge(map&& other) {
+        fusionar(other, 1);
+    }
+
+    /**
+     * @brief Idem merge(map&&), repartiendo el trabajo entre varios hilos si los diccionarios son grandes
+     *
+     * \pre El comparador y la política de aumento se pueden llamar desde varios hilos a la vez.
+     */
+    void merge(parallel_t p, map&& other) {
+        fusionar(other, hilosDisponibles(p));
+    }
+
+    /**
+     * @brief Agrega a \P{*this} una copia de los valores de \P{other} cuyas claves no están en \P{*this}
+     *
+     * @param other diccionario con los valores a agregar
+     *
+     * \aliasing{Los iteradores de \P{*this} se mantienen válidos.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{claves(*this) \IGOBS claves(self) \UNION claves(other) \LAND los significados de self no cambian}
+     *
+     * \complexity{\O(\COPY(\P{other}) \PLUS \a m \CDOT \LOG(\a n / \a m \PLUS 1) \CDOT \CMP(\P{*this}) \PLUS \DEL(repetidos)), con \a m
+     * y \a n el menor y el mayor de \SIZE(\P{self}) y \SIZE(\P{other})}
+     *
+     * \note Se copia \P{other} entero (con la copia estructural, sin comparar) y la copia se une con merge; así,
+     * si una copia lanza una excepción, \P{*this} no cambia.
+     */
+    void union_with(const map& other) {
+        if(this != &other) merge(map(other));
+    }
+
+    /**
+     * @brief Idem union_with(const map&), repartiendo el trabajo entre varios hilos si los diccionarios son grandes
+     *
+     * \pre El comparador y la política de aumento se pueden llamar desde varios hilos a la vez.
+     */
+    void union_with(parallel_t p, const map& other) {
+        if(this != &other) merge(p, map(other));
+    }
+
+    /**
+     * @brief Elimina de \P{*this} los valores cuyas claves no están en \P{other}
+     *
+     * @param other diccionario con las claves que se conservan
+     *
+     * \aliasing{Se invalidan los iteradores a los valores eliminados; los demás se mantienen válidos.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{claves(*this) \IGOBS claves(self) \INTERSECCION claves(other) \LAND los significados de self no cambian}
+     *
+     * \complexity{
+     * - Si \SIZE(\P{other}) \LEQ \SIZE(\P{self}): \O(\a m \CDOT \LOG(\a n / \a m \PLUS 1) \CDOT \CMP(\P{*this}) \PLUS \DEL(eliminados)),
+     *   con \a m = \SIZE(\P{other}) y \a n = \SIZE(\P{self})
+     * - Si no: \O(\SIZE(\P{self}) \CDOT \LOG(\SIZE(\P{other})) \CDOT \CMP(\P{*this}) \PLUS \DEL(eliminados))
+     * }
+     */
+    void intersect_with(const map& other) {
+        if(this != &other) intersecar(other, true, 1);
+    }
+
+    /**
+     * @brief Idem intersect_with(const map&), repartiendo el trabajo entre varios hilos si los diccionarios son grandes
+     *
+     * \pre El comparador y la política de aumento se pueden llamar desde varios hilos a la vez.
+     */
+    void intersect_with(parallel_t p, const map& other) {
+        if(this != &other) intersecar(other, true, hilosDisponibles(p));
+    }
+
+    /**
+     * @brief Elimina de \P{*this} los valores cuyas claves están en \P{other}
+     *
+     * @param other diccionario con las claves a eliminar
+     *
+     * \aliasing{Se invalidan los iteradores a los valores eliminados; los demás se mantienen válidos.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{claves(*this) \IGOBS claves(self) \MINUS claves(other) \LAND los significados de self no cambian}
+     *
+     * \complexity{idem intersect_with}
+     */
+    void difference(const map& other) {
+        if(this == &other) {
+            clear();
+        } else {
+            intersecar(other, false, 1);
+        }
+    }
+
+    /**
+     * @brief Idem difference(const map&), repartiendo el trabajo entre varios hilos si los diccionarios son grandes
+     *
+     * \pre El comparador y la política de aumento se pueden llamar desde varios hilos a la vez.
+     */
+    void difference(parallel_t p, const map& other) {
+        if(this == &other) {
+            clear();
+        } else {
+            intersecar(other, false, hilosDisponibles(p));
+        }
+    }
+    //@}
+
+    ///////////////////////////////////////////////////////////
+    /** \name Serialización (ver \ref Serializacion) */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Escribe en \P{os} una representación binaria del diccionario, que se puede volver a cargar con
+     * deserialize.
+     *
+     * Las claves y los significados tienen que ser enteros, std::string o tipos trivialmente copiables; estos
+     * últimos se guardan con su representación en memoria, por lo que el resultado sólo se puede leer en una
+     * arquitectura con la misma representación.
+     *
+     * @param os stream en el que se escribe
+     * @param cod codificación de los enteros
+     *
+     * \post \aedpost{Si no falla la escritura, \P{os} tiene una representación de \P{*this} agregada al final.}
+     *
+     * \complexity{\O(\SIZE(\P{*this})) más el costo de escribir en \P{os}}
+     *
+     * \note Los errores de \P{os} no lanzan excepciones, salvo que \P{os} esté configurado para lanzarlas: hay que
+     * consultar el estado de \P{os} después de llamar a serialize.
+     */
+    void serialize(std::ostream& os, serial_encoding cod = serial_encoding::varint) const {
+        CabeceraSerial cabecera;
+        cabecera.clave = codificacionDe<Key>(cod);
+        cabecera.significado = codificacionDe<Meaning>(cod);
+        cabecera.cantidad = count;
+        EscritorBinario escritor(os);
+        escritor.bytes(&cabecera, sizeof(cabecera));
+        uint64_t anterior = 0;
+        for(const value_type& v : *this){
+            escribirCampo(escritor, cabecera.clave, v.first, &anterior);
+            escribirCampo(escritor, cabecera.significado, v.second, nullptr);
+        }
+        escritor.vaciar();
+    }
+
+    /**
+     * @brief Reemplaza los valores de \P{*this} por los que serialize escribió en \P{is}.
+     *
+     * Se leen exactamente los bytes que escribió serialize, así que \P{is} puede seguir con otros datos.  Los
+     * valores se leen de a bloques y se cargan con el algoritmo de \ref CargaOrdenada, sin insertar de a uno; sólo se
+     * compara cada clave con la anterior, para detectar datos corruptos.
+     *
+     * @param is stream del que se lee
+     *
+     * @throws std::runtime_error si \P{is} termina antes de tiempo o sus datos no son una serialización de un
+     * diccionario con los tipos de \P{*this}.  En ese caso, \P{*this} no cambia.
+     *
+     * \aliasing{Se invalidan todos los iteradores de \P{*this}.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{\P{*this} es el diccionario serializado en \P{is}.}
+     *
+     * \complexity{\O(\a n \CDOT \CMP(\P{*this}) \PLUS \DEL(\P{self})) más el costo de leer \P{is}, con \a n la
+     * cantidad de valores leídos}
+     */
+    void deserialize(std::istream& is) {
+        LectorBinario lector(is);
+        CabeceraSerial cabecera;
+        lector.bytes(&cabecera, sizeof(cabecera));
+        if(not cabecera.compatible<Key, Meaning>()) LectorBinario::fallar("el formato no corresponde a este diccionario");
+        map res(lt, get_allocator());
+        // la cantidad puede estar corrupta: se reservan a lo sumo tantos nodos como bytes tiene un bloque, y si el
+        // stream termina antes de tiempo la lectura falla con los nodos pedidos hasta ese momento
+        res.construirOrdenado(ValoresLeidos(lector, cabecera, lt), cabecera.cantidad, EscritorBinario::capacidad);
+        if(not lector.terminado()) LectorBinario::fallar("sobran datos");
+        swap(res);
+    }
+    //@}
+
+    ////////////////////////////////////
+    /** \name Recorridos e iteradores */
+    ////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve un iterador al primer valor del diccionario
+     *
+     * \aliasing{Si el iterador me permite modificar, si modificas a lo que apunta res se modifica *this}
+     *
+     * @retval res iterador al primer valor
+     *
+     * \pre \aedpre{true}
+     * \post \aedpost{this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key) \LAND
+	 * 					colleccion(pos)=this \LAND res \IGOBS prim(secuSbuy(res))}
+     *
+     * \complexity{\O(1)}
+     */
+    iterator begin() {
+        iterator it = iterator(header.child[0]);
+        return it;
+    }
+
+    /** \overload */
+    const_iterator begin() const {
+        const_iterator it = const_iterator(header.child[0]);
+        return it;
+    }
+
+    /** \overload */
+    const_iterator cbegin() {
+        const_iterator it = const_iterator(header.child[0]);
+        return it;
+    }
+
+    /**
+     * @brief Devuelve un iterador apuntando a la posición pasando-el-ultimo del diccionario
+     *
+     * \aliasing{si el iterador me permite modificar, si modificas a lo que apunta res se modifica *this}
+     *
+     * @retval res iterador a la posicion pasando-al-ultimo
+     *
+     * \pre \aedpre{true}
+     * \post \aedpost{this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key) \LAND
+	 * 					colleccion(pos)=this \LAND res \IGOBS avanzar(ult(secuSbuy(res)))}
+     *
+     * \complexity{\O(1)}
+     */
+    iterator end() {
+        iterator it = iterator(&header);
+        return it;
+    }
+
+    /** \overload */
+    const_iterator end() const {
+        const_iterator it = const_iterator(&header);
+        return it;
+    }
+
+    /** \overload */
+    const_iterator cend() {
+        const_iterator it = const_iterator(&header);
+        return it;
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor del diccionario, en un recorrido al revés
+     *
+     * \aliasing{si el iterador me permite modificar, si modificas a lo que apunta res se modifica *this}
+     *
+     * @retval res iterador a la primer posicion en un recorrido al revés
+     *
+     * \pre \aedpre{true}
+     * \post \aedpost{this \IGOBS coleccion(res) \LAND anteriores(res) \IGOBS \elementosMenoresA(*this, claves(*this), key) \LAND siguientes(res) \IGOBS \elementosMayoresA(*this, claves(*this), key) \LAND
+	 * 					colleccion(pos)=this \LAND res \IGOBS avanzar(ult(secuSbuy(res)))}
+     *
+     * \complexity{\O(1)}
+     */
+    reverse_iterator rbegin() {
         reverse_iterator it = reverse_iterator(&header);
         return it;
     }
@@ -1797,6 +3177,36 @@ public:
     }
     //@}
 
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación (ver \ref Implementacion).
+     *
+     * Función de debugging que chequea que la cabecera apunte a la raíz, al mínimo y al máximo, que los
+     * punteros a los padres sean consistentes, que las claves estén ordenadas con respecto a \P{lt},
+     * que se cumplan las condiciones de color de un árbol red-black y que la cantidad de nodos sea \P{count}.
+     *
+     * @returns true si \P{*this} satisface el invariante de representación.
+     *
+     * \complexity{\O(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        if(not header.is_header()){
+            return false;
+        }
+        if(header.parent() == nullptr){
+            return count == 0 and header.child[0] == &header and header.child[1] == &header;
+        }
+        if(header.parent()->parent() != &header or not is_black(header.parent())){
+            return false;
+        }
+        if(header.child[0] != iterator::min(header.parent()) or header.child[1] != iterator::max(header.parent())){
+            return false;
+        }
+        size_t nodos = 0;
+        return alturaNegra(header.parent(), nullptr, nullptr, nodos) >= 0 and nodos == count;
+    }
+#endif
+
     /**
      * @brief Parte del módulo que implementa los iteradores que permiten la modificación de los significados.
      *
@@ -2088,7 +3498,7 @@ public:
          *
          * \complexity{\O(\LOG(\SIZE(\P{*this})))}
          */
-		Node* max(Node* n){
+		static Node* max(Node* n){
             Node* ret = n;
             while (ret->child[1] != nullptr){
                 ret = ret->child[1];
@@ -2103,7 +3513,7 @@ public:
          *
          * \complexity{\O(\LOG(\SIZE(\P{*this})))}
          */
-       Node* min(Node* n){
+       static Node* min(Node* n){
            Node* ret = n;
            while (ret->child[0] != nullptr){
                 ret = ret->child[0];
@@ -2112,15 +3522,15 @@ public:
         }
 
 		iterator avanzar(){
-            if(n->color == Color::Header) {
+            if(n->color() == Color::Header) {
                 n = n->child[0];
             }else if(n->child[1] != nullptr){
                 n = min(n->child[1]);
             }else{
-                Node* y = n->parent;
-                while(y->color != Color::Header and n == y->child[1]){
+                Node* y = n->parent();
+                while(y->color() != Color::Header and n == y->child[1]){
                     n = y;
-                    y = y->parent;
+                    y = y->parent();
                 }
                 n = y;
             }
@@ -2128,15 +3538,15 @@ public:
 		}
 
 		iterator retroceder(){
-            if(n->color == Color::Header){
+            if(n->color() == Color::Header){
                 n = n->child[1];
             }else if(n->child[0] != nullptr){
                 n = max(n->child[0]);
             }else{
-                Node* y = n->parent;
-                while(y->color != Color::Header and n == y->child[0]){
+                Node* y = n->parent();
+                while(y->color() != Color::Header and n == y->child[0]){
                     n = y;
-                    y = y->parent;
+                    y = y->parent();
                 }
                 n = y;
             }
@@ -2265,15 +3675,15 @@ public:
         }
 
         const_iterator avanzar(){
-            if(n->color == Color::Header) {
+            if(n->color() == Color::Header) {
                 n = n->child[0];
             }else if(n->child[1] != nullptr){
                 n = min(n->child[1]);
             }else{
-                Node* y = n->parent;
-                while(y->color != Color::Header and n == y->child[1]){
+                Node* y = n->parent();
+                while(y->color() != Color::Header and n == y->child[1]){
                     n = y;
-                    y = y->parent;
+                    y = y->parent();
                 }
                 n = y;
             }
@@ -2281,15 +3691,15 @@ public:
         }
 
         const_iterator retroceder(){
-            if(n->color == Color::Header){
+            if(n->color() == Color::Header){
                 n = n->child[1];
             }else if(n->child[0] != nullptr){
                 n = max(n->child[0]);
             }else{
-                Node* y = n->parent;
-                while(y->color != Color::Header and n == y->child[0]){
+                Node* y = n->parent();
+                while(y->color() != Color::Header and n == y->child[0]){
                     n = y;
-                    y = y->parent;
+                    y = y->parent();
                 }
                 n = y;
             }
@@ -2327,14 +3737,23 @@ private:
      * de que el árbol red-black tiene un único nodo sentinela que sirve de cabecera. (Ver ejemplos)
      *
      * \remark Como \T{Node} es una estructura privada, no tiene ventajas imporantes implementarla en forma modular.
+     *
+     * \remark \T{Node} no tiene funciones virtuales, para no pagar un puntero a la vtable en cada nodo.  Por eso
+     * nunca se destruye un \T{InnerNode} a través de un Node*: el pool siempre recibe un InnerNode*.
      */
     struct Node {
         /** \brief Punteros a los hijos izquierdo (child[0]) y derecho (child[1]) */
         Node* child[2]{nullptr,nullptr};
-        /** \brief Puntero al padre: garantiza insercion con puntero en O(1) amortizado e iteracion en O(1) memoria */
-        Node* parent{nullptr};
-        /** \brief Color del nodo */
-        Color color{Color::Red};
+        /**
+         * \brief Puntero al padre y color del nodo, en una misma palabra.
+         *
+         * El puntero al padre garantiza insercion con puntero en O(1) amortizado e iteracion en O(1) memoria.
+         * Como los nodos están alineados al menos a 4 bytes, los dos bits menos significativos de la
+         * dirección del padre son siempre 0, y ahí se guarda el color.  Ver \ref Memoria.
+         */
+        std::uintptr_t padreYColor{static_cast<std::uintptr_t>(Color::Red)};
+        /** \brief Máscara de los bits de padreYColor que guardan el color */
+        static constexpr std::uintptr_t mascaraColor = 3;
 
 		//////////////////////////////////////////////
         /** \name Creación de nodos (constructores) */
@@ -2348,7 +3767,8 @@ private:
          *
          * \complexity{\O(1)}
          */
-        Node() : color(Color::Header) {
+        Node() : padreYColor(static_cast<std::uintptr_t>(Color::Header)) {
+        	static_assert(alignof(Node) > mascaraColor, "el color no entra en los bits libres del puntero al padre");
         	child[0] = child[1] = this;
         }
 
@@ -2362,30 +3782,52 @@ private:
          *
          * \complexity{\O(1)}
          */
-        Node(Node* p, Color c = Color::Red) : parent(p), color(c) {}
+        Node(Node* p, Color c = Color::Red)
+            : padreYColor(reinterpret_cast<std::uintptr_t>(p) | static_cast<std::uintptr_t>(c)) {}
         //@}
 
-        /**
-         * @brief Destructor de Node
-         *
-         * Como Node funciona de clase base, el destructor es virtual, asi se puede
-         * invocar delete de un Node* que apunta a un InnerNode, destruyendo el valor contenido
-         * en el InnerNode.
-         *
-         * \remark En rigor, nunca deberíamos invocar new Node, asi que no tiene sentido hacer
-         * delete de un Node*.  Podemos evitar esta invocación poniendo el destructor como protegido
-         * y no virtual.  De esa forma, nos obliga a tener un InnerNode* para el delete, lo cual
-         * efectivamente llama al destructor del valor.  Sin embargo, por simplicidad, vamos a permitir
-         * que el destructor sea virtual.  Además, así no es necesario que hagan el `static_cast` y evitamos
-         * errores de memoria difíciles de debugguear.
-         */
-        virtual ~Node() {}
 
 
 		/////////////////////////////////////////////////
         /** \name Acceso a la información en los nodos */
         /////////////////////////////////////////////////
         //@{
+        /**
+         * @brief Devuelve el padre del nodo (la cabecera, si el nodo es la raíz; la raíz, si el nodo es la cabecera).
+         *
+         * \complexity{\O(1)}
+         */
+        Node* parent() const {
+        	return reinterpret_cast<Node*>(padreYColor & ~mascaraColor);
+        }
+
+        /**
+         * @brief Cambia el padre del nodo por \P{p}, sin modificar el color.
+         *
+         * \complexity{\O(1)}
+         */
+        void set_parent(Node* p) {
+        	padreYColor = reinterpret_cast<std::uintptr_t>(p) | (padreYColor & mascaraColor);
+        }
+
+        /**
+         * @brief Devuelve el color del nodo.
+         *
+         * \complexity{\O(1)}
+         */
+        Color color() const {
+        	return static_cast<Color>(padreYColor & mascaraColor);
+        }
+
+        /**
+         * @brief Cambia el color del nodo por \P{c}, sin modificar el padre.
+         *
+         * \complexity{\O(1)}
+         */
+        void set_color(Color c) {
+        	padreYColor = (padreYColor & ~mascaraColor) | static_cast<std::uintptr_t>(c);
+        }
+
         /**
          * @brief Devuelve true si el nodo actual es el header de la estructura.
          *
@@ -2395,8 +3837,8 @@ private:
          * con verificar que `color == Color::Red and (parent == nullptr or parent->parent = this)`.  Sin embargo,
          * esta condicion también podría ser satisfecha por la raíz algún `fixup`.  Por simplicidad, y para evitar bugs,
          * acá tomamos como solucion que el header
-         * tiene un color particular, llamado Color::Header.  Si bien se necesita mas de un bit para el color, lo cierto
-         * es que ningun procesador admite direccionamiento a bit, asi que no se pierde nada en la practica.
+         * tiene un color particular, llamado Color::Header.  Si bien se necesita mas de un bit para el color, los
+         * tres colores entran en los dos bits libres del puntero al padre, asi que no se pierde nada en la practica.
          * El objetivo de esta función es poder reemplazar el chequeo de la condición para determinar si el nodo es
          * la cabecera, en caso en que queramos evitar el nuevo color.
          *
@@ -2405,7 +3847,7 @@ private:
          * \complexity{\O(1)}
          */
         bool is_header() const {
-        	return color == Color::Header;
+        	return color() == Color::Header;
         }
 
         /**
@@ -2456,7 +3898,7 @@ private:
          * Esta en una funcion de debugging que se incluye de ejemplo para mostrar cómo usar la técnica.
 
         void print(int tab = 0) const {
-        	std::cout << std::string(tab, ' ') << value().first << "->" << value().second << "   (" << (color == Color::Red ? "Red)" : "Black)") << std::endl;
+        	std::cout << std::string(tab, ' ') << value().first << "->" << value().second << "   (" << (color() == Color::Red ? "Red)" : "Black)") << std::endl;
         	if(child[0]) child[0]->print(tab + 2);
         	if(child[1]) child[1]->print(tab + 2);
         }*/
@@ -2464,6 +3906,22 @@ private:
 #endif
     };
 
+    /** \brief true si los nodos guardan un resumen de su subárbol; ver \ref Aumentos */
+    static constexpr bool aumentado = not std::is_same<Augment, no_augmentation>::value;
+
+    /** \brief Base de InnerNode cuando la política de aumento no guarda nada: no ocupa memoria */
+    struct SinResumen {};
+
+    /** \brief Base de InnerNode con el resumen del subárbol, según la política \T{A} */
+    template<class A>
+    struct ConResumen {
+        /** \brief Resumen de los valores del subárbol del nodo */
+        typename A::summary_type resumen;
+    };
+
+    /** \brief Base de InnerNode que guarda (o no) el resumen del subárbol */
+    using BaseResumen = typename std::conditional<aumentado, ConResumen<Augment>, SinResumen>::type;
+
     /**
      * @brief Estructura (privada) de un nodo no cabecera del árbol red-black
      *
@@ -2480,26 +3938,426 @@ private:
      *
      * \remark Como \T{InnerNode} es una estructura privada, no tiene ventajas imporantes implementarla en forma modular.
      */
-    struct InnerNode : public Node {
-       InnerNode( Node* p, value_type v ,Color c = Color::Red ):_value(v), Node(p,c){}
+    struct InnerNode : public Node, public BaseResumen {
+        /**
+         * @brief Construye un nodo con padre \P{p}, color \P{c} y valor value_type(\P{args}...), sin hijos.
+         *
+         * El resumen (si la política de aumento tiene) queda sin calcular; ver aed2::map::actualizar.
+         *
+         * \complexity{\O(costo de construir el valor)}
+         */
+        template<class... Args>
+        InnerNode(Node* p, Color c, Args&&... args) : Node(p, c), _value(std::forward<Args>(args)...) {}
 
         value_type _value;
     };
 
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-    /** \name Estructura de representación
+    /**
+     * @brief Estructura (privada) que administra la memoria de los nodos internos.  Ver \ref Pool
      *
-     * Nota: vamos a omitir la discusión del functor de comparación, ya que no entra dentro del contexto de los TADs de la materia.
-     * Para poder definirlos, habría que 1. especificar el tipo functor y 2. extender el TAD Diccionario para que pueda crearse con una
-     * instancia del TAD functor.
+     * El pool obtiene la memoria de \T{Alloc} en slabs de nodos contiguos y recicla los nodos borrados
+     * mediante una lista de libres.  Los slabs, junto con la lista de libres, forman un \e almacén que se pide
+     * recién cuando hace falta el primer nodo y que varios pools pueden compartir para intercambiar nodos (ver
+     * \ref Particion).  La memoria del almacén se devuelve al allocator únicamente cuando se destruye el último
+     * pool que lo usa.
      *
-     * \par Representación
-     * Diccionario se representa con map: tupla(header: Node, count: Nat).  Ver \ref axiomas
+     * \par Estructura de representación
+     * \parblock
+     * - \P{alloc}: allocator (reencuadrado a \T{InnerNode}) del que se obtienen los slabs.
+     * - \P{almacen}: nulo si el pool todavía no necesitó memoria.  Si no:
+     *   - \P{referencias}: cantidad de pools que usan el almacén (atómico, porque cada pool puede estar en un
+     *     hilo distinto).
+     *   - \P{cerrojo}: mutex que serializa el acceso al resto de los campos mientras \P{referencias} > 1.
+     *   - \P{primero}, \P{ultimo}: lista simplemente encadenada de slabs pedidos a \P{alloc}.  El encabezado de
+     *     cada slab (su capacidad y el siguiente slab) ocupa el lugar de un nodo extra al comienzo del bloque.
+     *   - \P{actual}: slab del que se toman los nodos nunca usados (nulo antes de usar el primero); los slabs
+     *     posteriores están completamente libres (ocurre luego de aed2::map::NodePool::vaciar).
+     *   - \P{proximo}, \P{limite}: rango aún no utilizado de \P{actual}.
+     *   - \P{libres}, \P{ultimoLibre}: lista simplemente encadenada de nodos destruidos cuya memoria se puede
+     *     reutilizar, y su último elemento (para concatenar listas en \O(1)).
+     * \endparblock
      *
-     * \par Invariante de representacion
-	 * \parblock
-	 * rep: map \TO bool\n
-	 * rep(m) \EQUIV nothing?(Header.value)\LAND \esRBTree(Header) \LAND \cantidadDeElementos(m.header.parent) = count
+     * \remark Los nodos de la lista de libres no tienen un \T{InnerNode} construido; sólo se usa su memoria
+     * para guardar el puntero al siguiente libre.
+     *
+     * \remark Un almacén con \P{referencias} = 1 sólo es accesible desde su pool, que pertenece a un único
+     * diccionario; por eso se bloquea únicamente cuando está compartido (ver aed2::map::NodePool::bloquear).
+     */
+    class NodePool {
+        using node_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<InnerNode>;
+        using node_traits = std::allocator_traits<node_allocator>;
+
+        /** \brief Nodo de la lista de libres, ubicado en la memoria de un nodo destruido */
+        struct Libre {
+            Libre* siguiente;
+        };
+
+        /** \brief Encabezado de un bloque de nodos contiguos pedido al allocator, ubicado antes del primer nodo */
+        struct Slab {
+            Slab* siguiente;
+            std::size_t capacidad;
+
+            /** \brief Devuelve el primer nodo del slab */
+            InnerNode* nodos() {
+                return reinterpret_cast<InnerNode*>(this) + 1;
+            }
+        };
+
+        /** \brief Slabs y lista de libres de uno o más pools */
+        struct Almacen {
+            std::atomic<std::size_t> referencias{1};
+            std::mutex cerrojo;
+            Slab* primero{nullptr};
+            Slab* ultimo{nullptr};
+            Slab* actual{nullptr};
+            InnerNode* proximo{nullptr};
+            InnerNode* limite{nullptr};
+            Libre* libres{nullptr};
+            Libre* ultimoLibre{nullptr};
+        };
+
+        using almacen_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<Almacen>;
+        using almacen_traits = std::allocator_traits<almacen_allocator>;
+
+        static_assert(sizeof(Slab) <= sizeof(InnerNode) and alignof(Slab) <= alignof(InnerNode),
+                      "el encabezado de un slab tiene que entrar en un nodo");
+
+        /** \brief Capacidad del primer slab */
+        static constexpr std::size_t slab_inicial = 4;
+        /** \brief Capacidad máxima de un slab; a partir de acá los slabs no crecen más */
+        static constexpr std::size_t slab_maximo = 1024;
+
+    public:
+        /**
+         * @brief Crea un pool vacío que pide memoria a \P{a}
+         *
+         * \complexity{\O(1)}
+         */
+        explicit NodePool(const Alloc& a) : alloc(a) {}
+
+        NodePool(const NodePool&) = delete;
+        NodePool& operator=(const NodePool&) = delete;
+
+        /**
+         * @brief Deja de usar el almacén, devolviendo su memoria al allocator si ningún otro pool lo usa
+         *
+         * \pre Todos los nodos creados por los pools que usan el almacén fueron destruidos, o lo serán por otro pool.
+         *
+         * \complexity{\O(cantidad de slabs)}
+         */
+        ~NodePool() {
+            soltar();
+        }
+
+        /**
+         * @brief Construye un nodo nuevo con los parámetros \P{args}
+         *
+         * Usa la memoria de un nodo libre si lo hay; si no, toma el siguiente nodo sin usar del slab actual
+         * (pasando al siguiente slab, o pidiendo uno nuevo, cuando éste se llena).  Si el constructor de
+         * \T{InnerNode} lanza una excepción, la memoria vuelve a la lista de libres.
+         *
+         * @returns puntero al nodo recién construido
+         *
+         * \complexity{\O(1) amortizado \PLUS costo de construir el valor}
+         */
+        template<class... Args>
+        InnerNode* crear(Args&&... args) {
+            InnerNode* res = reservar();
+            try {
+                node_traits::construct(alloc, res, std::forward<Args>(args)...);
+            } catch(...) {
+                liberar(res);
+                throw;
+            }
+            return res;
+        }
+
+        /**
+         * @brief Destruye el nodo \P{n} y deja su memoria disponible para un próximo crear
+         *
+         * \pre \P{n} fue creado por un pool que usa el almacén de \P{*this} y no fue destruido.
+         *
+         * \complexity{\O(\DEL(\P{n}))}
+         */
+        void destruir(InnerNode* n) {
+            node_traits::destroy(alloc, n);
+            liberar(n);
+        }
+
+        /**
+         * @brief Destruye el valor de \P{n} sin devolver su memoria al pool
+         *
+         * Se usa cuando se van a destruir todos los nodos, para devolverlos luego en bloque con
+         * aed2::map::NodePool::vaciar.
+         *
+         * \pre \P{n} fue creado por \P{*this} y no fue destruido.
+         *
+         * \complexity{\O(\DEL(\P{n}))}
+         */
+        void destruirValor(InnerNode* n) {
+            node_traits::destroy(alloc, n);
+        }
+
+        /**
+         * @brief Asegura que los próximos \P{n} nodos que se creen no necesiten pedir memoria al allocator
+         *
+         * Si la memoria disponible (sin contar la lista de libres) no alcanza, pide un único slab con los nodos que
+         * faltan, sin respetar el máximo de los slabs.  Se usa para armar un árbol completo de una vez.
+         *
+         * \complexity{\O(cantidad de slabs)}
+         */
+        void reservarNodos(std::size_t n) {
+            Almacen& a = propio();
+            auto cerrado = bloquear(a);
+            std::size_t disponibles = static_cast<std::size_t>(a.limite - a.proximo);
+            for(Slab* s = a.actual == nullptr ? a.primero : a.actual->siguiente; s != nullptr; s = s->siguiente) {
+                disponibles += s->capacidad;
+            }
+            if(disponibles < n) {
+                agregarSlab(std::max(n - disponibles, slab_inicial));
+            }
+        }
+
+        /**
+         * @brief Marca como libre la memoria de todos los nodos, sin devolverla al allocator
+         *
+         * Descarta la lista de libres y vuelve a tomar los nodos desde el comienzo del primer slab.
+         *
+         * \pre Todos los nodos creados por el pool fueron destruidos y ningún otro pool usa su almacén.
+         *
+         * \complexity{\O(1)}
+         */
+        void vaciar() {
+            if(almacen == nullptr) return;
+            almacen->libres = almacen->ultimoLibre = nullptr;
+            almacen->actual = nullptr;
+            almacen->proximo = almacen->limite = nullptr;
+        }
+
+        /**
+         * @brief Intercambia los nodos (y el allocator) de \P{*this} con los de \P{other}
+         *
+         * \complexity{\O(1)}
+         */
+        void swap(NodePool& other) {
+            using std::swap;
+            swap(alloc, other.alloc);
+            swap(almacen, other.almacen);
+        }
+
+        /** @brief Devuelve el allocator del pool, reencuadrado a \T{Alloc} */
+        Alloc get_allocator() const {
+            return Alloc(alloc);
+        }
+
+        /**
+         * @brief Devuelve true si otro pool usa el mismo almacén que \P{*this}
+         *
+         * \complexity{\O(1)}
+         */
+        bool compartido() const {
+            return almacen != nullptr and almacen->referencias.load(std::memory_order_acquire) > 1;
+        }
+
+        /**
+         * @brief Devuelve true si los nodos de \P{other} se pueden destruir con \P{*this}
+         *
+         * \complexity{\O(1)}
+         */
+        bool comparteNodosCon(const NodePool& other) const {
+            return other.almacen == nullptr or other.almacen == almacen;
+        }
+
+        /**
+         * @brief Pasa a usar el almacén de \P{other} (creándolo si hace falta), dejando de usar el propio
+         *
+         * \pre Los nodos creados por \P{*this} fueron destruidos y los allocators de ambos pools son iguales.
+         *
+         * \complexity{\O(cantidad de slabs de \P{*this})}
+         */
+        void compartir(NodePool& other) {
+            if(other.almacen == almacen and almacen != nullptr) return;
+            other.propio();
+            soltar();
+            almacen = other.almacen;
+            almacen->referencias.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Intenta quedarse con todos los slabs y nodos libres de \P{other}, que queda sin almacén
+         *
+         * Se puede cuando \P{other} no tiene almacén, cuando comparte el de \P{*this} (en cuyo caso no se hace nada)
+         * o cuando ningún otro pool usa el almacén de \P{other} y los allocators son iguales.  Los slabs usados de
+         * \P{other} se ubican antes que los de \P{*this} y los que están completamente libres después, de modo que
+         * se mantenga el invariante de \P{actual}.  Las listas de libres se concatenan.  Los nodos nunca usados del
+         * slab actual de \P{other} quedan inaccesibles hasta que se vacíe el pool.
+         *
+         * @returns true si, a partir de ahora, los nodos de \P{other} se pueden destruir con \P{*this}
+         *
+         * \complexity{\O(1)}
+         */
+        bool absorber(NodePool& other) {
+            if(comparteNodosCon(other)) return true;
+            if(other.compartido() or not (alloc == other.alloc)) return false;
+            if(almacen == nullptr) {
+                swap(other);
+                return true;
+            }
+            Almacen& a = *almacen;
+            Almacen& d = *other.almacen;
+            auto cerrado = bloquear(a);
+            Slab* libresDeOther = d.actual == nullptr ? d.primero : d.actual->siguiente;
+            if(d.actual != nullptr) {
+                d.actual->siguiente = a.primero;
+                a.primero = d.primero;
+                if(a.ultimo == nullptr) a.ultimo = d.actual;
+                if(a.actual == nullptr) {
+                    a.actual = d.actual;
+                    a.proximo = a.limite = nullptr;
+                }
+            }
+            if(libresDeOther != nullptr) {
+                if(a.ultimo == nullptr) {
+                    a.primero = libresDeOther;
+                } else {
+                    a.ultimo->siguiente = libresDeOther;
+                }
+                a.ultimo = d.ultimo;
+            }
+            if(d.libres != nullptr) {
+                d.ultimoLibre->siguiente = a.libres;
+                if(a.libres == nullptr) a.ultimoLibre = d.ultimoLibre;
+                a.libres = d.libres;
+            }
+            almacen_allocator aa(alloc);
+            other.almacen->~Almacen();
+            almacen_traits::deallocate(aa, other.almacen, 1);
+            other.almacen = nullptr;
+            return true;
+        }
+
+    private:
+        /**
+         * @brief Devuelve el almacén del pool, creándolo vacío si todavía no existe
+         *
+         * \complexity{\O(1)}
+         */
+        Almacen& propio() {
+            if(almacen == nullptr) {
+                almacen_allocator aa(alloc);
+                almacen = almacen_traits::allocate(aa, 1);
+                ::new (static_cast<void*>(almacen)) Almacen();
+            }
+            return *almacen;
+        }
+
+        /**
+         * @brief Toma el mutex de \P{a} si otro pool lo usa; si no, devuelve un lock sin tomar
+         *
+         * Que \P{referencias} valga 1 alcanza para no bloquear: el único pool que usa \P{a} es \P{*this}, y
+         * otro pool sólo puede empezar a usarlo mediante compartir, que requiere acceder a \P{*this}.
+         *
+         * \complexity{\O(1)}
+         */
+        static std::unique_lock<std::mutex> bloquear(Almacen& a) {
+            if(a.referencias.load(std::memory_order_acquire) > 1) {
+                return std::unique_lock<std::mutex>(a.cerrojo);
+            }
+            return std::unique_lock<std::mutex>(a.cerrojo, std::defer_lock);
+        }
+
+        /**
+         * @brief Deja de usar el almacén; si era el último pool que lo usaba, devuelve toda su memoria al allocator
+         *
+         * \complexity{\O(cantidad de slabs)}
+         */
+        void soltar() {
+            if(almacen != nullptr and almacen->referencias.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Slab* s = almacen->primero;
+                while(s != nullptr) {
+                    Slab* siguiente = s->siguiente;
+                    node_traits::deallocate(alloc, reinterpret_cast<InnerNode*>(s), s->capacidad + 1);
+                    s = siguiente;
+                }
+                almacen_allocator aa(alloc);
+                almacen->~Almacen();
+                almacen_traits::deallocate(aa, almacen, 1);
+            }
+            almacen = nullptr;
+        }
+
+        /**
+         * @brief Pide al allocator un slab con lugar para \P{capacidad} nodos y lo agrega al final de la lista
+         *
+         * \complexity{\O(1) \PLUS costo de pedir memoria}
+         */
+        Slab* agregarSlab(std::size_t capacidad) {
+            Almacen& a = *almacen;
+            Slab* s = ::new (static_cast<void*>(node_traits::allocate(alloc, capacidad + 1))) Slab{nullptr, capacidad};
+            if(a.ultimo == nullptr) {
+                a.primero = s;
+            } else {
+                a.ultimo->siguiente = s;
+            }
+            a.ultimo = s;
+            return s;
+        }
+
+        /**
+         * @brief Devuelve memoria sin inicializar para un nodo
+         *
+         * \complexity{\O(1) amortizado}
+         */
+        InnerNode* reservar() {
+            Almacen& a = propio();
+            auto cerrado = bloquear(a);
+            if(a.libres != nullptr) {
+                Libre* res = a.libres;
+                a.libres = a.libres->siguiente;
+                return reinterpret_cast<InnerNode*>(res);
+            }
+            if(a.proximo == a.limite) {
+                Slab* s = a.actual == nullptr ? a.primero : a.actual->siguiente;
+                if(s == nullptr) {
+                    s = agregarSlab(a.ultimo == nullptr ? slab_inicial : std::min(2 * a.ultimo->capacidad, slab_maximo));
+                }
+                a.actual = s;
+                a.proximo = s->nodos();
+                a.limite = a.proximo + s->capacidad;
+            }
+            return a.proximo++;
+        }
+
+        /**
+         * @brief Agrega la memoria (ya destruida) de \P{n} a la lista de libres
+         *
+         * \complexity{\O(1)}
+         */
+        void liberar(InnerNode* n) {
+            Almacen& a = *almacen;
+            auto cerrado = bloquear(a);
+            a.libres = ::new (static_cast<void*>(n)) Libre{a.libres};
+            if(a.libres->siguiente == nullptr) a.ultimoLibre = a.libres;
+        }
+
+        node_allocator alloc;
+        Almacen* almacen{nullptr};
+    };
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * Nota: vamos a omitir la discusión del functor de comparación, ya que no entra dentro del contexto de los TADs de la materia.
+     * Para poder definirlos, habría que 1. especificar el tipo functor y 2. extender el TAD Diccionario para que pueda crearse con una
+     * instancia del TAD functor.
+     *
+     * \par Representación
+     * Diccionario se representa con map: tupla(header: Node, count: Nat).  Ver \ref axiomas
+     *
+     * \par Invariante de representacion
+	 * \parblock
+	 * rep: map \TO bool\n
+	 * rep(m) \EQUIV nothing?(Header.value)\LAND \esRBTree(Header) \LAND \cantidadDeElementos(m.header.parent) = count
 	 * \endparblock
      *
      * \deprecated Este REP es ilegible, intenten formatearlo mejor o subdividir en más suboperaciones
@@ -2524,6 +4382,8 @@ private:
     size_t count{0};
     /** \brief Cabeceera del arbol; ver \ref Implementacion */
     Node header;
+    /** \brief Pool del que se obtienen (y al que vuelven) los nodos internos; ver \ref Pool */
+    NodePool pool;
     //@}
 
     ////////////////////////////////////////
@@ -2535,10 +4395,10 @@ private:
      *
      * @returns Nodo a la raiz del arbol.
      */
-    inline InnerNode* root() { return static_cast<InnerNode*>(header.parent); }
+    inline InnerNode* root() { return static_cast<InnerNode*>(header.parent()); }
 
     /** \overload */
-    inline const InnerNode* root() const { return static_cast<const InnerNode*>(header.parent); }
+    inline const InnerNode* root() const { return static_cast<const InnerNode*>(header.parent()); }
 	//@}
 
 	/////////////////////////////////
@@ -2555,134 +4415,535 @@ private:
         return lt(k1, k2) == lt(k2, k1);
     }
 
+    /** \brief true si las claves se pueden comparar de a tres vías con lt; ver aed2::three_way_compare */
+    static constexpr bool tripartito = three_way_compare<Compare, Key>::value;
+
+    /**
+     * \brief true si una clave se puede comparar de a tres vías con un valor de tipo \T{K}.  Para \T{K} distinto
+     * de \T{Key} hace falta que \T{Compare} sea std::less<> y que \T{Key} tenga un método `compare(K)`, como
+     * std::string con std::string_view o `const char*`; ver \ref Busqueda.
+     */
+    template<class K>
+    static constexpr bool tripartitoCon() {
+        if constexpr(std::is_same_v<K, Key>){
+            return tripartito;
+        }else if constexpr(std::is_same_v<Compare, std::less<>>){
+            return tieneCompare<K>(0);
+        }else{
+            return false;
+        }
+    }
+
+    /** \brief true si `k1.compare(k2)` está definido para \P{k1} de tipo \T{Key} y \P{k2} de tipo \T{K} */
+    template<class K, class Q = Key>
+    static constexpr auto tieneCompare(int) -> decltype(std::declval<const Q&>().compare(std::declval<const K&>()) < 0) {
+        return true;
+    }
+
+    /** \overload */
+    template<class K>
+    static constexpr bool tieneCompare(...) {
+        return false;
+    }
+
+    /** \brief true si \T{Compare} es transparente, i.e., define el tipo `is_transparent`; ver \ref Busqueda */
+    template<class C = Compare, class = typename C::is_transparent>
+    static constexpr bool esTransparente(int) {
+        return true;
+    }
+
+    /** \overload */
+    template<class C = Compare>
+    static constexpr bool esTransparente(...) {
+        return false;
+    }
+
+    /**
+     * @brief Compara de a tres vías la clave \P{k1} y el valor \P{k2} con respecto a \P{this}->lt.
+     *
+     * @returns un valor menor, igual o mayor a 0 según \P{k1} sea menor, igual o mayor a \P{k2}.
+     * \pre \aedpre{tripartitoCon<K>()}
+     */
+    template<class K>
+    inline auto comparar(const Key& k1, const K& k2) const {
+        if constexpr(std::is_same_v<K, Key>){
+            return three_way_compare<Compare, Key>::comparar(lt, k1, k2);
+        }else{
+            return k1.compare(k2);
+        }
+    }
+
         /**
-         * \brief deleteFixUp
-         *
-         * \Descripcion En esta funcion se recibe un parametro:'nodo' de tipo puntero a nodo, la cual viene derivada del erase. Se trata de implementar el FixUp del cormen, donde 'nodo' modifica su lugar y este puede llegar a romper el invariante RB-Tree, tanto como que la raiz no sea negra, que cada nodo rojo tenga hijo rojo, o que todos los caminos tengan distinta cantidad de nodos negros. El primer problema lo arregla si no entra en el ciclo ya que seria que la raiz es roja, entonces luego se le modifica el color. Si entra en el ciclo tiene dos casos particulares que dependen de si 'nodo' es hijo derecho o izquierdo de su padre, esto se ve en mas detalle en el deleteFixUpAux.
+         * \brief cotaInferior
          *
-         * \deprecated Suena a que les vendría bien una operación que te diga si un nodo es hijo derecho o izquierdo de su padre
-         * Donde la pondrían?? // En la parte privada de Node.
+         * \Descripcion Devuelve el primer nodo con clave mayor o igual a \P{key}, o la cabecera si no existe.  Desciende
+         * una única vez desde la raíz recordando el último nodo con clave mayor o igual a \P{key}, con una comparación
+         * por nivel.  Si las claves se comparan de a tres vías, el descenso termina al encontrar \P{key}.  \T{K} es
+         * \T{Key} o, si \T{Compare} es transparente, cualquier tipo comparable con \T{Key}.
          *
-         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
          */
-    void deleteFixUp(Node* padre_nodo, Node* hijo_nodo){
-		iterator hijo = iterator(hijo_nodo);
-		iterator padre = iterator(padre_nodo);
-		while((root() != hijo)and(is_black(hijo.n))){
-			if(hijo.n == padre.n->child[0]){
-				deleteFixUpAux(padre, hijo, 1);
-			}else{
-				deleteFixUpAux(padre, hijo, 0);
-			}
-		}
-		if(hijo.n != nullptr) {
-			hijo.n->color = Color::Black;
-		}
+    template<class K>
+    Node* cotaInferior(const K& key) const {
+        Node* candidato = const_cast<Node*>(&header);
+        Node* n = header.parent();
+        while(n != nullptr){
+            if constexpr(tripartitoCon<K>()){
+                auto c = comparar(n->key(), key);
+                if(c == 0){
+                    return n;
+                }
+                if(c < 0){
+                    n = n->child[1];
+                }else{
+                    candidato = n;
+                    n = n->child[0];
+                }
+            }else{
+                if(lt(n->key(), key)){
+                    n = n->child[1];
+                }else{
+                    candidato = n;
+                    n = n->child[0];
+                }
+            }
+        }
+        return candidato;
     }
 
         /**
-         * \brief deleteFixUpAux
+         * \brief buscar
          *
-         * \Descripcion Esta funcion recive dos parametros:puntero(nodo)'nodo' e int:'i'
-         * este ultimo solo avisa si 'nodo' es hijo derecho o izquierdo de su padre.
-         * Aqui se compara al nodo con su 'hermano': primer caso: Chequea si 'hermano' es rojo,
-         * si lo es le cambia el color a el y a su padre y luego los rota, cambiando asi al hermano
-         * de nodo por el que era hijo izquierdo de 'hermano', luego continua con los otros casos. segundo caso:
-         * Si 'hermano' es negro y sus hijos tambien lo cambia de color, luego 'nodo' pasa a ser su padre y vuelve a
-         * iniciar el ciclo. Si no se utiliza el segundo caso se sabe que 'hermano' es negro y que tiene al
-         * menos un hijo rojo tercer caso: Si nos encontramos aca se sabe que el hijo derecho de 'hermano' es negro,
-         * por lo tanto su hijo izquierdo sera negro. Para solucionarlo a 'hermano' se le cambia de color y
-         * se lo rota con su hijo izquierdo, el cual es negro y queda como nuevo 'hermano', luego pasa al cuarto caso.
-         * cuarto caso: Queda un ultimo caso posible, donde 'hermano' es negro y su hijo izquierdo es rojo,
-         * por lo tanto le modifica el color a 'hermano' y al padre, y luego los rota, quedando asi ya solucionado
-         * el invariante. Esta funcion modifica el arbol de tal forma que se siga cumpliendo el invariante.
+         * \Descripcion Devuelve el nodo con clave \P{key}, o la cabecera si no existe.  Si las claves se comparan de a
+         * tres vías, desciende desde la raíz con una comparación por nivel hasta encontrar \P{key}; si no, una comparación
+         * más decide si el nodo de cotaInferior tiene clave \P{key}.  \T{K} es como en cotaInferior.
          *
-         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
          */
-    void deleteFixUpAux(iterator& padre, iterator& hijo, int i){
-		iterator hermano = iterator(padre.n->child[i]);
-        if(not(is_black(hermano.n))){
-            hermano.n->color = Color::Black;
-            padre.n->color = Color::Red;
-            Rotate(padre.n, i);
-            hermano = padre.n->child[i];
-		}
-		if(hermano.n != nullptr){
-			if(is_black(hermano.n->child[0]) and is_black(hermano.n->child[1])){
-				hermano.n->color = Color::Red;
-				hijo.n = padre.n;
-				padre.n = padre.n->parent;
-			}else{
-				if(is_black(hermano.n->child[i])){
-					hermano.n->color = Color::Red;
-					hermano.n->child[(i+1)%2]->color = Color::Black;
-					Rotate(hermano.n, (i+1)%2);
-					hermano.n = padre.n->child[i];
-				}
-				hermano.n->color = padre.n->color;
-				padre.n->color = Color::Black;
-				hermano.n->child[i]->color = Color::Black;
-				Rotate(padre.n, i);
-				hijo = root();
-			}
-		}
+    template<class K>
+    Node* buscar(const K& key) const {
+        if constexpr(tripartitoCon<K>()){
+            Node* n = header.parent();
+            while(n != nullptr){
+                auto c = comparar(n->key(), key);
+                if(c == 0){
+                    return n;
+                }
+                n = c < 0 ? n->child[1] : n->child[0];
+            }
+            return const_cast<Node*>(&header);
+        }else{
+            Node* n = cotaInferior(key);
+            if(n != &header and lt(key, n->key())){
+                return const_cast<Node*>(&header);
+            }
+            return n;
+        }
     }
 
         /**
-         * \brief insertFixUp
+         * \brief enLotes
          *
-         * \Descripcion La función de inserción acude a este auxiliar para arreglar posibles violaciones del
-         * invariante de representación de la estructura del árbol Red-Black al insertar un nuevo nodo.
-         * El parámetro de entrada es un puntero al nodo insertado por la función insertar.
-         * La función tiene un ciclo que abarca tres casos. En el primer caso si el padre del nodo pasado como
-         * parámetro es rojo y su tío también entonces se invierten los colores del padre, el abuelo y el tío,
-         * y el nodo con el que se itera pasa a ser el abuelo.El segundo caso siempre lleva al caso tres.
-         * En el segundo caso si el nodo con el que se itera  es hijo derecho entonces el nodo pasa a ser su padre
+         * \Descripcion Implementa find_batch (si \P{exacta}) y lower_bound_batch.  Toma las claves de a lotes de
+         * descensos_en_lote y avanza los descensos del lote en ronda: en cada vuelta, cada descenso activo compara en su
+         * nodo actual, baja un nivel y pide por adelantado el nodo al que llegó, que recién se lee en la vuelta
+         * siguiente.  Cada descenso hace las mismas comparaciones que cotaInferior (o buscar, si \P{exacta}).  Al
+         * terminar el lote escribe en \P{out}, en orden, \P{convertir} aplicado al nodo resultante de cada clave.
+         * Si \P{first} no da referencias al tipo con el que se compara (por ejemplo, cuando el comparador no es
+         * transparente y hay que construir un \T{Key}), cada clave se convierte una única vez, al entrar al lote.
+         *
+         * \complexity{\O(\a m \CDOT \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this})), donde \a m es la cantidad de claves}
+         */
+    template<bool exacta, class ForwardIt, class OutputIt, class Convertir>
+    OutputIt enLotes(ForwardIt first, ForwardIt last, OutputIt out, Convertir convertir) const {
+        using K = std::conditional_t<std::is_same_v<std::decay_t<decltype(*first)>, Key> or not esTransparente(0),
+                                     Key, std::decay_t<decltype(*first)>>;
+        using Referencia = decltype(*first);
+        constexpr bool conIgualdad = tripartitoCon<K>();
+        constexpr bool copiarClaves = not (std::is_lvalue_reference_v<Referencia> and std::is_same_v<std::decay_t<Referencia>, K>);
+        struct Descenso {
+            const K* clave;
+            Node* n;
+            Node* candidato;
+        };
+        Node* cabecera = const_cast<Node*>(&header);
+        Descenso lote[descensos_en_lote];
+        std::optional<K> convertidas[copiarClaves ? descensos_en_lote : 1];
+        while(first != last){
+            size_t cantidad = 0;
+            for(; cantidad < descensos_en_lote and first != last; ++cantidad, ++first){
+                const K* clave;
+                if constexpr(copiarClaves){
+                    clave = &convertidas[cantidad].emplace(*first);
+                }else{
+                    clave = std::addressof(*first);
+                }
+                lote[cantidad] = Descenso{clave, header.parent(), cabecera};
+            }
+            size_t activos = header.parent() == nullptr ? 0 : cantidad;
+            while(activos > 0){
+                for(size_t i = 0; i < cantidad; ++i){
+                    Descenso& d = lote[i];
+                    if(d.n == nullptr) continue;
+                    const K& key = *d.clave;
+                    if constexpr(conIgualdad){
+                        auto c = comparar(d.n->key(), key);
+                        if(c == 0){
+                            d.candidato = d.n;
+                            d.n = nullptr;
+                        }else if(c < 0){
+                            d.n = d.n->child[1];
+                        }else{
+                            if(not exacta) d.candidato = d.n;
+                            d.n = d.n->child[0];
+                        }
+                    }else{
+                        if(lt(d.n->key(), key)){
+                            d.n = d.n->child[1];
+                        }else{
+                            d.candidato = d.n;
+                            d.n = d.n->child[0];
+                        }
+                    }
+                    if(d.n == nullptr){
+                        --activos;
+                    }else{
+                        anticipar(d.n);
+                    }
+                }
+            }
+            for(size_t i = 0; i < cantidad; ++i){
+                Node* res = lote[i].candidato;
+                if constexpr(exacta and not conIgualdad){
+                    if(res != cabecera and lt(*lote[i].clave, res->key())) res = cabecera;
+                }
+                *out = convertir(res);
+                ++out;
+            }
+        }
+        return out;
+    }
+
+        /**
+         * \brief anticipar
+         *
+         * \Descripcion Pide por adelantado la línea de cache de \P{p}, si el compilador lo permite.
+         *
+         * \complexity{\O(1)}
+         */
+    static void anticipar(const void* p) {
+#if defined(__GNUC__)
+        __builtin_prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+
+        /**
+         * \brief resumen
+         *
+         * \Descripcion Devuelve el resumen del subárbol de \P{n}, o el neutro de la política de aumento si \P{n} es nulo.
+         *
+         * \complexity{\O(1)}
+         */
+    static auto resumen(const Node* n) {
+        return n == nullptr ? Augment::identity() : static_cast<const InnerNode*>(n)->resumen;
+    }
+
+        /**
+         * \brief tamanio
+         *
+         * \Descripcion Devuelve la cantidad de valores del subárbol de \P{n} (0 si \P{n} es nulo), a partir de su resumen.
+         *
+         * \complexity{\O(1)}
+         */
+    static size_t tamanio(const Node* n) {
+        return n == nullptr ? 0 : Augment::size(static_cast<const InnerNode*>(n)->resumen);
+    }
+
+        /**
+         * \brief actualizar
+         *
+         * \Descripcion Recalcula el resumen de \P{n} a partir de su valor y de los resúmenes de sus hijos, que deben
+         * estar actualizados.  No hace nada si los nodos no guardan resúmenes.
+         *
+         * \complexity{\O(1) \PLUS costo de combinar dos resúmenes}
+         */
+    static void actualizar(Node* n) {
+        if constexpr(aumentado){
+            InnerNode* in = static_cast<InnerNode*>(n);
+            in->resumen = Augment::combine(Augment::combine(resumen(n->child[0]), Augment::lift(in->_value)),
+                                           resumen(n->child[1]));
+        }
+    }
+
+        /**
+         * \brief actualizarHastaLaRaiz
+         *
+         * \Descripcion Recalcula los resúmenes de \P{n} y de todos sus ancestros, de abajo hacia arriba.  Se usa luego de
+         * enganchar o desenganchar nodos, antes de rebalancear (las rotaciones mantienen los resúmenes por sí mismas).
+         * \P{n} puede ser la cabecera, en cuyo caso no hace nada.  Sube hasta cualquier cabecera, por lo que sirve
+         * también para árboles sueltos enganchados a una cabecera local.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this}))) si los nodos guardan resúmenes; \O(1) si no}
+         */
+    void actualizarHastaLaRaiz(Node* n) {
+        if constexpr(aumentado){
+            while(not n->is_header()){
+                actualizar(n);
+                n = n->parent();
+            }
+        }
+    }
+
+        /**
+         * \brief prefijo
+         *
+         * \Descripcion Devuelve el resumen de los valores del subárbol de \P{n} con clave menor a \P{hi}.  Desciende una
+         * vez desde \P{n}, agregando por derecha el subárbol izquierdo y el valor de cada nodo con clave menor a \P{hi}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS costo de combinar dos resúmenes))}
+         */
+    auto prefijo(const Node* n, const Key& hi) const {
+        auto res = Augment::identity();
+        while(n != nullptr){
+            if(lt(n->key(), hi)){
+                res = Augment::combine(res, Augment::combine(resumen(n->child[0]), Augment::lift(n->value())));
+                n = n->child[1];
+            }else{
+                n = n->child[0];
+            }
+        }
+        return res;
+    }
+
+        /**
+         * \brief sufijo
+         *
+         * \Descripcion Devuelve el resumen de los valores del subárbol de \P{n} con clave mayor o igual a \P{lo}.  Idem
+         * prefijo, agregando por izquierda el valor y el subárbol derecho de cada nodo con clave mayor o igual a \P{lo}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS costo de combinar dos resúmenes))}
+         */
+    auto sufijo(const Node* n, const Key& lo) const {
+        auto res = Augment::identity();
+        while(n != nullptr){
+            if(lt(n->key(), lo)){
+                n = n->child[1];
+            }else{
+                res = Augment::combine(Augment::combine(Augment::lift(n->value()), resumen(n->child[1])), res);
+                n = n->child[0];
+            }
+        }
+        return res;
+    }
+
+        /**
+         * \brief enesimo
+         *
+         * \Descripcion Devuelve el nodo con exactamente \P{k} claves menores, o la cabecera si \P{k} \GEQ \P{count}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         */
+    Node* enesimo(size_t k) const {
+        static_assert(augment_has_size<Augment>::value, "nth requiere una política de aumento con tamaño");
+        Node* n = header.parent();
+        while(n != nullptr){
+            size_t izquierdos = tamanio(n->child[0]);
+            if(k == izquierdos){
+                return n;
+            }
+            if(k < izquierdos){
+                n = n->child[0];
+            }else{
+                k -= izquierdos + 1;
+                n = n->child[1];
+            }
+        }
+        return const_cast<Node*>(&header);
+    }
+
+        /**
+         * \brief desenganchar
+         *
+         * \Descripcion Saca del árbol al nodo \P{z}, sin destruirlo, y restablece el invariante red-black con
+         * deleteFixUp.  No actualiza los extremos de la cabecera ni la cantidad de elementos; de eso se encargan
+         * erase y los demás llamadores.  Si \P{z} tiene dos hijos, su lugar lo ocupa su sucesor.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         */
+    void desenganchar(Node* z){
+        iterator y = iterator(z);
+        Color original = y.n->color();
+		iterator cambiado;
+        iterator padre_cambiado;
+        if(z->child[0] == nullptr){
+            cambiado = iterator(z->child[1]);
+            padre_cambiado = y.n->parent();
+            transplant(z, z->child[1]);
+        } else{
+            if(z->child[1] == nullptr){
+                cambiado = iterator(z->child[0]);
+                padre_cambiado = y.n->parent();
+                transplant(z, z->child[0]);
+        	}else{
+				y.avanzar();
+				original = y.n->color();
+				padre_cambiado = y.n->parent() == z ? y.n : y.n->parent();
+				cambiado = iterator(y.n->child[1]);
+				if(y.n->parent() != z) {
+					transplant(y.n, y.n->child[1]);
+					y.n->child[1] = z->child[1];
+					y.n->child[1]->set_parent(y);
+				}
+				transplant(z, y.n);
+                y.n->child[0] = z->child[0];
+                y.n->child[0]->set_parent(y);
+                y.n->set_color(z->color());
+			}
+		}
+		actualizarHastaLaRaiz(padre_cambiado.n);
+		if(original == Color::Black){
+			deleteFixUp(padre_cambiado.n, cambiado.n);
+		}
+    }
+
+        /**
+         * \brief deleteFixUp
+         *
+         * \Descripcion En esta funcion se recibe un parametro:'nodo' de tipo puntero a nodo, la cual viene derivada del erase. Se trata de implementar el FixUp del cormen, donde 'nodo' modifica su lugar y este puede llegar a romper el invariante RB-Tree, tanto como que la raiz no sea negra, que cada nodo rojo tenga hijo rojo, o que todos los caminos tengan distinta cantidad de nodos negros. El primer problema lo arregla si no entra en el ciclo ya que seria que la raiz es roja, entonces luego se le modifica el color. Si entra en el ciclo tiene dos casos particulares que dependen de si 'nodo' es hijo derecho o izquierdo de su padre, esto se ve en mas detalle en el deleteFixUpAux.
+         *
+         * \deprecated Suena a que les vendría bien una operación que te diga si un nodo es hijo derecho o izquierdo de su padre
+         * Donde la pondrían?? // En la parte privada de Node.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         */
+    void deleteFixUp(Node* padre_nodo, Node* hijo_nodo){
+		iterator hijo = iterator(hijo_nodo);
+		iterator padre = iterator(padre_nodo);
+		while((root() != hijo.n)and(is_black(hijo.n))){
+			if(hijo.n == padre.n->child[0]){
+				deleteFixUpAux(padre, hijo, 1);
+			}else{
+				deleteFixUpAux(padre, hijo, 0);
+			}
+		}
+		if(hijo.n != nullptr) {
+			hijo.n->set_color(Color::Black);
+		}
+    }
+
+        /**
+         * \brief deleteFixUpAux
+         *
+         * \Descripcion Esta funcion recive dos parametros:puntero(nodo)'nodo' e int:'i'
+         * este ultimo solo avisa si 'nodo' es hijo derecho o izquierdo de su padre.
+         * Aqui se compara al nodo con su 'hermano': primer caso: Chequea si 'hermano' es rojo,
+         * si lo es le cambia el color a el y a su padre y luego los rota, cambiando asi al hermano
+         * de nodo por el que era hijo izquierdo de 'hermano', luego continua con los otros casos. segundo caso:
+         * Si 'hermano' es negro y sus hijos tambien lo cambia de color, luego 'nodo' pasa a ser su padre y vuelve a
+         * iniciar el ciclo. Si no se utiliza el segundo caso se sabe que 'hermano' es negro y que tiene al
+         * menos un hijo rojo tercer caso: Si nos encontramos aca se sabe que el hijo derecho de 'hermano' es negro,
+         * por lo tanto su hijo izquierdo sera negro. Para solucionarlo a 'hermano' se le cambia de color y
+         * se lo rota con su hijo izquierdo, el cual es negro y queda como nuevo 'hermano', luego pasa al cuarto caso.
+         * cuarto caso: Queda un ultimo caso posible, donde 'hermano' es negro y su hijo izquierdo es rojo,
+         * por lo tanto le modifica el color a 'hermano' y al padre, y luego los rota, quedando asi ya solucionado
+         * el invariante. Esta funcion modifica el arbol de tal forma que se siga cumpliendo el invariante.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         */
+    void deleteFixUpAux(iterator& padre, iterator& hijo, int i){
+		iterator hermano = iterator(padre.n->child[i]);
+        if(not(is_black(hermano.n))){
+            hermano.n->set_color(Color::Black);
+            padre.n->set_color(Color::Red);
+            Rotate(padre.n, i);
+            hermano = padre.n->child[i];
+		}
+		if(hermano.n != nullptr){
+			if(is_black(hermano.n->child[0]) and is_black(hermano.n->child[1])){
+				hermano.n->set_color(Color::Red);
+				hijo.n = padre.n;
+				padre.n = padre.n->parent();
+			}else{
+				if(is_black(hermano.n->child[i])){
+					hermano.n->set_color(Color::Red);
+					hermano.n->child[(i+1)%2]->set_color(Color::Black);
+					Rotate(hermano.n, (i+1)%2);
+					hermano.n = padre.n->child[i];
+				}
+				hermano.n->set_color(padre.n->color());
+				padre.n->set_color(Color::Black);
+				hermano.n->child[i]->set_color(Color::Black);
+				Rotate(padre.n, i);
+				hijo = root();
+			}
+		}
+    }
+
+        /**
+         * \brief insertFixUp
+         *
+         * \Descripcion La función de inserción acude a este auxiliar para arreglar posibles violaciones del
+         * invariante de representación de la estructura del árbol Red-Black al insertar un nuevo nodo.
+         * El parámetro de entrada es un puntero al nodo insertado por la función insertar.
+         * La función tiene un ciclo que abarca tres casos. En el primer caso si el padre del nodo pasado como
+         * parámetro es rojo y su tío también entonces se invierten los colores del padre, el abuelo y el tío,
+         * y el nodo con el que se itera pasa a ser el abuelo.El segundo caso siempre lleva al caso tres.
+         * En el segundo caso si el nodo con el que se itera  es hijo derecho entonces el nodo pasa a ser su padre
          * y se hace una rotación. Si el nodo es hijo izquierdo entonces es una rotación derecha sino es
          * rotación izquierda(rotación es explica en Rotate). En el tercer caso se invierten los colores del padre
          * y el abuelo y si en el caso dos el padre es hijo derecho entonces se hace una rotación derecha sino una
          * rotación izquierda. Mientras que el padre de nodo sea rojo el ciclo sigue iterando.
+         * Devuelve true si al final la raíz era roja y se pintó de negro, es decir, si creció la altura negra
+         * del árbol (lo usa unir).  No usa la cabecera del diccionario: la raíz es el nodo cuyo padre es una cabecera,
+         * lo que permite rebalancear árboles sueltos enganchados a una cabecera local.
          *
          *
          * \complexity{\O(1)}
          */
-    void insertFixUp(Node* n){
-		while(n->parent->color == Color::Red){
-			if(n->parent == n->parent->parent->child[0]){
-				iterator y = iterator(n->parent->parent->child[1]);
+    bool insertFixUp(Node* n){
+		while(n->parent()->color() == Color::Red){
+			if(n->parent() == n->parent()->parent()->child[0]){
+				iterator y = iterator(n->parent()->parent()->child[1]);
 				if(not is_black(y)){
-					n->parent->color = Color::Black;
-					y.n->color = Color::Black;
-					n->parent->parent->color = Color::Red;
-					n = n->parent->parent;
+					n->parent()->set_color(Color::Black);
+					y.n->set_color(Color::Black);
+					n->parent()->parent()->set_color(Color::Red);
+					n = n->parent()->parent();
 				}else{
-					if(n == n->parent->child[1]){
-						n = n->parent;
+					if(n == n->parent()->child[1]){
+						n = n->parent();
 						Rotate(n,1);
 					}
-					n->parent->color = Color::Black;
-					n->parent->parent->color = Color::Red;
-					Rotate(n->parent->parent,0);
+					n->parent()->set_color(Color::Black);
+					n->parent()->parent()->set_color(Color::Red);
+					Rotate(n->parent()->parent(),0);
 				}
 			}else{
-				iterator y = iterator(n->parent->parent->child[0]);
+				iterator y = iterator(n->parent()->parent()->child[0]);
 				if(not is_black(y.n)){
-					n->parent->color = Color::Black;
-					y.n->color = Color::Black;
-					n->parent->parent->color = Color::Red;
-					n = n->parent->parent;
+					n->parent()->set_color(Color::Black);
+					y.n->set_color(Color::Black);
+					n->parent()->parent()->set_color(Color::Red);
+					n = n->parent()->parent();
 				}else{
-					if(n == n->parent->child[0]){
-						n = n->parent;
+					if(n == n->parent()->child[0]){
+						n = n->parent();
 						Rotate(n,0);
 					}
-					n->parent->color = Color::Black;
-					n->parent->parent->color = Color::Red;
-					Rotate(n->parent->parent,1);
+					n->parent()->set_color(Color::Black);
+					n->parent()->parent()->set_color(Color::Red);
+					Rotate(n->parent()->parent(),1);
 				}
 			}
 		}
-		root()->color = Color::Black;
+		// si la raíz quedó roja, es n: sólo el caso 1 pinta de rojo al abuelo, y en ese caso n pasa a ser el abuelo
+		if(n->parent()->is_header() and n->color() == Color::Red){
+			n->set_color(Color::Black);
+			return true;
+		}
+		return false;
     }
 
         /**
@@ -2699,21 +4960,63 @@ private:
         iterator it = iterator(n->child[i]);
         n->child[i] = it.n->child[(i+1)%2];
         if(it.n->child[(i+1)%2] != nullptr){
-            it.n->child[(i+1)%2]->parent = n;
+            it.n->child[(i+1)%2]->set_parent(n);
         }
-        it.n ->parent = n->parent;
-        if(n->parent == &header){
-            header.parent = it.n;
+        it.n ->set_parent(n->parent());
+        if(n->parent()->is_header()){
+            n->parent()->set_parent(it.n);
         }else{
-            if(n == n->parent->child[1]){
-                n->parent->child[1] = it.n;
+            if(n == n->parent()->child[1]){
+                n->parent()->child[1] = it.n;
             }else{
-                n->parent->child[0] = it.n;
+                n->parent()->child[0] = it.n;
             }
         }
         it.n -> child[(i+1)%2] = n;
-        n->parent = it.n;
+        n->set_parent(it.n);
+        actualizar(n);
+        actualizar(it.n);
+    }
+
+#ifdef DEBUG
+        /**
+         * \brief alturaNegra
+         *
+         * \Descripcion Auxiliar de verificarRep.  Devuelve la cantidad de nodos negros en cada camino desde \P{n} a sus
+         * hojas, o -1 si el subárbol de \P{n} no satisface el invariante, sabiendo que sus claves deben estar entre
+         * las de \P{menor} y \P{mayor} (cuando no son nulos).  Suma a \P{nodos} la cantidad de nodos del subárbol.
+         * Si la política de aumento informa tamaños, verifica además el tamaño guardado en cada nodo.
+         *
+         * \complexity{\O(\SIZE(\P{n}) \CDOT \CMP(\P{*this}))}
+         */
+    int alturaNegra(const Node* n, const Node* menor, const Node* mayor, size_t& nodos) const {
+        if(n == nullptr){
+            return 0;
+        }
+        size_t antes = nodos++;
+        if(n->is_header() or (menor != nullptr and not lt(menor->key(), n->key()))
+           or (mayor != nullptr and not lt(n->key(), mayor->key()))){
+            return -1;
+        }
+        for(int i = 0; i < 2; ++i){
+            if(n->child[i] != nullptr and (n->child[i]->parent() != n
+               or (n->color() == Color::Red and n->child[i]->color() == Color::Red))){
+                return -1;
+            }
+        }
+        int izq = alturaNegra(n->child[0], menor, n, nodos);
+        int der = alturaNegra(n->child[1], n, mayor, nodos);
+        if(izq < 0 or izq != der){
+            return -1;
+        }
+        if constexpr(augment_has_size<Augment>::value){
+            if(tamanio(n) != nodos - antes){
+                return -1;
+            }
+        }
+        return izq + (n->color() == Color::Black ? 1 : 0);
     }
+#endif
 
         /**
          * \brief transplant
@@ -2724,24 +5027,16 @@ private:
          */
     void transplant(Node* viejo, Node* nuevo){
         if(viejo == root()){
-            header.parent = nuevo;
+            header.set_parent(nuevo);
         } else{
-            if(viejo == viejo->parent->child[0]){
-                viejo->parent->child[0] = nuevo;
+            if(viejo == viejo->parent()->child[0]){
+                viejo->parent()->child[0] = nuevo;
             } else{
-                viejo->parent->child[1]= nuevo;
+                viejo->parent()->child[1]= nuevo;
             }
-        }
-        if(viejo == header.child[0]){
-            iterator max = iterator(viejo);
-            header.child[0] = max.avanzar();
-        }
-        if(viejo == header.child[1]){
-            iterator min = iterator(viejo);
-            header.child[1] = min.retroceder();
         }
 		if(nuevo != nullptr){
-            nuevo->parent = viejo->parent;
+            nuevo->set_parent(viejo->parent());
         }
     }
 
@@ -2752,60 +5047,1224 @@ private:
          *
          * \complexity{\O(1)}
          */
-    bool is_black(Node* n){
+    bool is_black(const Node* n) const {
         if(n == nullptr) {
             return true;
         }else{
-            return n->color == Color::Black;
+            return n->color() == Color::Black;
         }
     }
 
-	bool esBuenHint(const_iterator hint, const value_type& value){
-		if(hint == end()){
-			return not(empty()) & lt(header.child[1]->key(), value.first);
-		}
-		if(eq(hint->first , value.first)){
-			return true;
-		}
-		if(not lt(hint->first , value.first) ){
-			if(hint.n == header.child[0]){
-				return true;
-			}else{
-				hint.retroceder();
-				return lt(hint->first , value.first);
-			}
-		}
-	}
+        /**
+         * \brief destruirValores
+         *
+         * \Descripcion Destruye los valores de todos los nodos del subárbol con raíz \P{n}, recorriéndolo en
+         * postorden.  Los nodos no vuelven a la lista de libres del pool; se asume que a continuación se
+         * llama a NodePool::vaciar.  Para no usar memoria adicional, el recorrido desengancha cada hijo antes
+         * de descender a él, por lo que el subárbol queda inutilizable.
+         *
+         * \complexity{\O(\DEL(\P{n}))}
+         */
+    void destruirValores(Node* n){
+        if(n == nullptr) return;
+        Node* tope = n->parent();
+        while(n != tope){
+            if(n->child[0] != nullptr){
+                Node* hijo = n->child[0];
+                n->child[0] = nullptr;
+                n = hijo;
+            }else if(n->child[1] != nullptr){
+                Node* hijo = n->child[1];
+                n->child[1] = nullptr;
+                n = hijo;
+            }else{
+                Node* padre = n->parent();
+                pool.destruirValor(static_cast<InnerNode*>(n));
+                n = padre;
+            }
+        }
+    }
 
-	iterator insertMinOMax(const value_type& value){
-		if(lt(header.child[1]->key(), value.first)){
-			iterator nuevo = iterator(new InnerNode(header.child[1],value));
-			header.child[1]->child[1] = nuevo.n;
-			header.child[1] = nuevo.n;
-			return nuevo;
-		}
-		if(not lt(header.child[0]->key(), value.first)){
-			iterator nuevo = iterator(new InnerNode(header.child[0],value));
-			header.child[0]->child[0] = nuevo.n;
-			header.child[0] = nuevo.n;
-			return nuevo;
-		}
-	}
+        /**
+         * \brief destruirNodos
+         *
+         * \Descripcion Idem destruirValores, pero devolviendo cada nodo a la lista de libres del pool, por lo que no
+         * hace falta vaciarlo.  Se usa para destruir parte de los nodos, o todos cuando el pool se comparte.
+         * \P{n} deja de tener padre.
+         *
+         * @returns la cantidad de nodos destruidos
+         *
+         * \complexity{\O(\DEL(\P{n}))}
+         */
+    size_t destruirNodos(Node* n){
+        size_t res = 0;
+        if(n == nullptr) return res;
+        n->set_parent(nullptr);
+        while(n != nullptr){
+            if(n->child[0] != nullptr){
+                Node* hijo = n->child[0];
+                n->child[0] = nullptr;
+                n = hijo;
+            }else if(n->child[1] != nullptr){
+                Node* hijo = n->child[1];
+                n->child[1] = nullptr;
+                n = hijo;
+            }else{
+                Node* padre = n->parent();
+                pool.destruir(static_cast<InnerNode*>(n));
+                ++res;
+                n = padre;
+            }
+        }
+        return res;
+    }
 
-	iterator insertConLB(const_iterator hint, const value_type& value){
-		if(hint.n->child[0] == nullptr){
-			iterator nuevo = iterator(new InnerNode(const_cast<Node*>(hint.n), value));
-			const_cast<Node*>(hint.n)->child[0] = nuevo.n;
-			return nuevo;
-		}else{
-			iterator padre = iterator(hint.n->child[0]);
-			while(padre.n->child[1] != nullptr){
-				padre.n = padre.n->child[1];
-			}
-			iterator nuevo = iterator(new InnerNode(padre.n, value));
-			padre.n->child[1] = nuevo.n;
-			return nuevo;
+        /**
+         * \brief Arbol
+         *
+         * \Descripcion Árbol red-black suelto, i.e., que no está enganchado a la cabecera: su \P{raiz} (nula si es vacío)
+         * y su \P{altura} negra, i.e., la cantidad de nodos negros en cada camino desde la raíz (inclusive) a un hijo
+         * nulo.  La raíz puede ser roja y el puntero a su padre no tiene significado.  Ver \ref Particion.
+         */
+    struct Arbol {
+        Node* raiz;
+        int altura;
+    };
+
+        /**
+         * \brief alturaNegraDe
+         *
+         * \Descripcion Devuelve la altura negra del subárbol de \P{n}, recorriendo su borde izquierdo.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{n})))}
+         */
+    static int alturaNegraDe(const Node* n){
+        int res = 0;
+        for(; n != nullptr; n = n->child[0]){
+            if(n->color() == Color::Black) ++res;
+        }
+        return res;
+    }
+
+        /**
+         * \brief contar
+         *
+         * \Descripcion Devuelve la cantidad de valores del subárbol de \P{n}.  Si la política de aumento informa tamaños
+         * la lee del resumen; si no, recorre el subárbol.
+         *
+         * \complexity{\O(1) si la política de aumento tiene tamaño; \O(\SIZE(\P{n})) si no}
+         */
+    static size_t contar(const Node* n){
+        if constexpr(augment_has_size<Augment>::value){
+            return tamanio(n);
+        }else{
+            return n == nullptr ? 0 : 1 + contar(n->child[0]) + contar(n->child[1]);
+        }
+    }
+
+        /**
+         * \brief colgar
+         *
+         * \Descripcion Pone a \P{hijo}, que puede ser nulo, como hijo \P{lado} de \P{padre}.
+         *
+         * \complexity{\O(1)}
+         */
+    static void colgar(Node* padre, int lado, Node* hijo){
+        padre->child[lado] = hijo;
+        if(hijo != nullptr) hijo->set_parent(padre);
+    }
+
+        /**
+         * \brief soltarArbol
+         *
+         * \Descripcion Desengancha el árbol de la cabecera y lo devuelve suelto; \P{*this} queda vacío, aunque los nodos
+         * siguen perteneciendo a su pool.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})))}
+         */
+    Arbol soltarArbol(){
+        Arbol res{header.parent(), alturaNegraDe(header.parent())};
+        header.set_parent(nullptr);
+        header.child[0] = header.child[1] = &header;
+        count = 0;
+        return res;
+    }
+
+        /**
+         * \brief plantar
+         *
+         * \Descripcion Engancha a la cabecera el árbol suelto \P{t}, cuyos nodos pertenecen al pool y que tiene \P{n}
+         * valores, como árbol de \P{*this}.  Pinta la raíz de negro y actualiza los extremos de la cabecera.  El árbol
+         * que hubiera enganchado antes se pierde, por lo que \P{*this} tiene que estar vacío o haber sido soltado.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{t})))}
+         */
+    void plantar(Arbol t, size_t n){
+        header.set_parent(t.raiz);
+        count = n;
+        if(t.raiz == nullptr){
+            header.child[0] = header.child[1] = &header;
+            return;
+        }
+        t.raiz->set_parent(&header);
+        t.raiz->set_color(Color::Black);
+        header.child[0] = iterator::min(t.raiz);
+        header.child[1] = iterator::max(t.raiz);
+    }
+
+        /**
+         * \brief unir
+         *
+         * \Descripcion Devuelve el árbol con los valores de \P{izq}, el de \P{medio} y los de \P{der}, sabiendo que las
+         * claves de \P{izq} son menores a la de \P{medio} y ésta es menor a las de \P{der} (el \e join de
+         * \cite Tarjan1983).  Primero pinta de negro las raíces rojas.  Si las alturas negras coinciden, \P{medio}
+         * es la nueva raíz.  Si no, desciende por el borde derecho (resp. izquierdo) del árbol más alto hasta el
+         * primer nodo negro con la altura negra del más bajo, pone en su lugar a \P{medio} como nodo rojo, con ese
+         * nodo y el árbol más bajo como hijos, y rebalancea con insertFixUp.  Para poder rotar, el árbol más alto
+         * se engancha a una cabecera local, con lo cual no se toca la cabecera de \P{*this} y se pueden unir árboles
+         * disjuntos desde varios hilos a la vez.
+         *
+         * \complexity{\O(|\P{izq}.altura \MINUS \P{der}.altura| \PLUS 1), más el costo de combinar los resúmenes del
+         * borde recorrido}
+         */
+    Arbol unir(Arbol izq, InnerNode* medio, Arbol der){
+        for(Arbol* t : {&izq, &der}){
+            if(t->raiz != nullptr and t->raiz->color() == Color::Red){
+                t->raiz->set_color(Color::Black);
+                ++t->altura;
+            }
+        }
+        if(izq.altura == der.altura){
+            medio->set_color(Color::Black);
+            colgar(medio, 0, izq.raiz);
+            colgar(medio, 1, der.raiz);
+            actualizar(medio);
+            return Arbol{medio, izq.altura + 1};
+        }
+        // i es el lado por el que se desciende en el árbol más alto
+        int i = izq.altura > der.altura ? 1 : 0;
+        Arbol alto = i == 1 ? izq : der;
+        Arbol bajo = i == 1 ? der : izq;
+        Node cabecera;
+        alto.raiz->set_parent(&cabecera);
+        cabecera.set_parent(alto.raiz);
+        Node* padre = &cabecera;
+        Node* n = alto.raiz;
+        int altura = alto.altura;
+        while(not is_black(n) or altura != bajo.altura){
+            if(is_black(n)) --altura;
+            padre = n;
+            n = n->child[i];
+        }
+        medio->set_color(Color::Red);
+        colgar(medio, 1 - i, n);
+        colgar(medio, i, bajo.raiz);
+        colgar(padre, i, medio);
+        actualizarHastaLaRaiz(medio);
+        bool crecio = insertFixUp(medio);
+        return Arbol{cabecera.parent(), alto.altura + (crecio ? 1 : 0)};
+    }
+
+        /**
+         * \brief sacarUltimo
+         *
+         * \Descripcion Saca el nodo de clave máxima del árbol suelto no vacío \P{t}, lo guarda en \P{ultimo} (sin hijos) y
+         * devuelve el árbol que queda.  Baja por el borde derecho y, al volver, une cada nodo con su subárbol
+         * izquierdo y con lo que quedó del derecho; como en partir, el costo de las uniones es el de una sola rama.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{t}))), más el costo de combinar los resúmenes}
+         */
+    Arbol sacarUltimo(Arbol t, InnerNode*& ultimo){
+        InnerNode* n = static_cast<InnerNode*>(t.raiz);
+        int altura = t.altura - (n->color() == Color::Black ? 1 : 0);
+        Arbol izq{n->child[0], altura};
+        if(n->child[1] == nullptr){
+            ultimo = n;
+            n->child[0] = nullptr;
+            return izq;
+        }
+        Arbol der = sacarUltimo(Arbol{n->child[1], altura}, ultimo);
+        return unir(izq, n, der);
+    }
+
+        /**
+         * \brief unirSinMedio
+         *
+         * \Descripcion Idem unir, sin un valor intermedio: saca el máximo de \P{izq} con sacarUltimo y lo usa como medio.
+         * Si alguno de los árboles es vacío, devuelve el otro.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{izq}) \PLUS \SIZE(\P{der}))), más el costo de combinar los resúmenes}
+         */
+    Arbol unirSinMedio(Arbol izq, Arbol der){
+        if(der.raiz == nullptr) return izq;
+        if(izq.raiz == nullptr) return der;
+        InnerNode* ultimo;
+        Arbol resto = sacarUltimo(izq, ultimo);
+        return unir(resto, ultimo, der);
+    }
+
+        /**
+         * \brief partir
+         *
+         * \Descripcion Parte el árbol suelto \P{t} en \P{menores}, con los valores de clave menor a \P{key}, y \P{mayores},
+         * con el resto (el \e split de \cite Tarjan1983).  Desciende por el camino de búsqueda de \P{key} deduciendo
+         * la altura negra de cada subárbol a partir de la de \P{t} y, al volver, une cada nodo del camino con el
+         * subárbol que no visitó y con la parte que le corresponde del resultado recursivo.  Como las alturas de
+         * los árboles que se unen crecen a medida que se sube, el costo de todas las uniones es el de una sola
+         * rama.  Si \P{igual} no es nulo y \P{t} tiene un nodo con clave \P{key}, ese nodo no va a \P{mayores} sino a
+         * *\P{igual} (sin hijos); en ese caso se hace una comparación más por nivel.  *\P{igual} no se modifica si
+         * la clave no está.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{t})) \CDOT \CMP(\P{*this})), más el costo de combinar los resúmenes}
+         */
+    void partir(Arbol t, const Key& key, Arbol& menores, Arbol& mayores, InnerNode** igual = nullptr){
+        if(t.raiz == nullptr){
+            menores = mayores = Arbol{nullptr, 0};
+            return;
+        }
+        InnerNode* n = static_cast<InnerNode*>(t.raiz);
+        int altura = t.altura - (n->color() == Color::Black ? 1 : 0);
+        Arbol izq{n->child[0], altura};
+        Arbol der{n->child[1], altura};
+        if(lt(n->key(), key)){
+            partir(der, key, menores, mayores, igual);
+            menores = unir(izq, n, menores);
+        }else if(igual != nullptr and not lt(key, n->key())){
+            *igual = n;
+            n->child[0] = n->child[1] = nullptr;
+            menores = izq;
+            mayores = der;
+        }else{
+            partir(izq, key, menores, mayores, igual);
+            mayores = unir(mayores, n, der);
+        }
+    }
+
+        /**
+         * \brief recortar
+         *
+         * \Descripcion Saca de \P{*this} los valores de [\P{first}, \P{last}) y los devuelve como árbol suelto, cuyos nodos
+         * siguen perteneciendo al pool.  Parte el árbol en la clave de \P{first} y en la de \P{last} y une los dos
+         * extremos con unirSinMedio.  Guarda en \P{k} la cantidad de valores recortados.
+         *
+         * \pre \P{first} y \P{last} son iteradores de \P{*this}, \P{first} no está después de \P{last}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this})) \PLUS el costo de contar los valores recortados}
+         */
+    Arbol recortar(const_iterator first, const_iterator last, size_t& k){
+        if(first == last){
+            k = 0;
+            return Arbol{nullptr, 0};
+        }
+        size_t total = count;
+        if(first == cbegin() and last == cend()){
+            k = total;
+            return soltarArbol();
+        }
+        Arbol menores, medio, mayores{nullptr, 0};
+        partir(soltarArbol(), first.n->key(), menores, medio);
+        if(last != cend()){
+            partir(medio, last.n->key(), medio, mayores);
+        }
+        k = contar(medio.raiz);
+        plantar(unirSinMedio(menores, mayores), total - k);
+        return medio;
+    }
+
+        /**
+         * \brief traerArbol
+         *
+         * \Descripcion Saca todos los valores de \P{origen} y los devuelve como árbol suelto cuyos nodos se pueden destruir
+         * con el pool de \P{*this}.  Si los pools comparten el almacén o el de \P{origen} se puede absorber (ver
+         * NodePool::absorber), los nodos pasan tal cual.  Si no, se arma en el pool de \P{*this} un árbol balanceado
+         * con los valores de \P{origen}, que se mueven si moverlos no puede lanzar excepciones y se copian en caso
+         * contrario; si la copia lanza una excepción, \P{origen} no cambia.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{origen}))) si los nodos pasan tal cual; \O(\COPY(\P{origen}) \PLUS \DEL(\P{origen})) si no}
+         */
+    Arbol traerArbol(map& origen){
+        if(origen.empty() or pool.absorber(origen.pool)){
+            return origen.soltarArbol();
+        }
+        Node* raiz;
+        if constexpr(std::is_nothrow_move_constructible<value_type>::value){
+            auto it = std::make_move_iterator(origen.begin());
+            raiz = armarArbol(it, origen.count);
+        }else{
+            auto it = origen.cbegin();
+            raiz = armarArbol(it, origen.count);
+        }
+        origen.clear();
+        return Arbol{raiz, alturaNegraDe(raiz)};
+    }
+
+        /**
+         * \brief incorporar
+         *
+         * \Descripcion Pasa a \P{*this} los valores de \P{origen} cuyas claves no están definidas en \P{*this}; los demás
+         * quedan en \P{origen}.  Si las claves de \P{origen} caen entre dos claves consecutivas de \P{*this} (o antes de
+         * la primera o después de la última), parte \P{*this} en ese lugar y une las partes con el árbol de \P{origen}
+         * obtenido con traerArbol.  Si no, inserta los valores de a uno, moviéndolos; si una inserción lanza una
+         * excepción, los valores que no se insertaron siguen en \P{origen}.
+         *
+         * \complexity{
+         * - Si las claves no se intercalan: idem traerArbol \PLUS \O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))
+         * - Si no: \O(\SIZE(\P{origen}) \CDOT \LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}) \PLUS \COPY(\P{origen}))
+         * }
+         */
+    void incorporar(map& origen){
+        if(origen.empty()) return;
+        Node* siguiente = cotaInferior(origen.header.child[0]->key());
+        if(siguiente == &header or lt(origen.header.child[1]->key(), siguiente->key())){
+            size_t n = count + origen.count;
+            Arbol medio = traerArbol(origen);
+            Arbol menores, mayores;
+            partir(soltarArbol(), iterator::min(medio.raiz)->key(), menores, mayores);
+            plantar(unirSinMedio(unirSinMedio(menores, medio), mayores), n);
+            return;
+        }
+        for(iterator it = origen.begin(); it != origen.end();){
+            Lugar l = lugar(it->first);
+            if(l.existe){
+                ++it;
+            }else{
+                enganchar(pool.crear(l.padre, Color::Red, std::move(*it)), l);
+                it = origen.erase(it);
+            }
+        }
+    }
+
+        /**
+         * \brief unirConMedio
+         *
+         * \Descripcion Implementa join(value_type, map&&) para un valor copiado o movido: crea el nodo de \P{value} y une
+         * el árbol de \P{*this}, ese nodo y el árbol de \P{right} obtenido con traerArbol.
+         *
+         * \complexity{idem join(map&&) \PLUS \COPY(\P{value})}
+         */
+    template<class V>
+    void unirConMedio(V&& value, map& right){
+        size_t n = count + right.count + 1;
+        InnerNode* medio = pool.crear(nullptr, Color::Red, std::forward<V>(value));
+        Arbol der;
+        try {
+            der = traerArbol(right);
+        } catch(...) {
+            pool.destruir(medio);
+            throw;
+        }
+        plantar(unir(soltarArbol(), medio, der), n);
+    }
+
+        /**
+         * \brief Descartes
+         *
+         * \Descripcion Lista de árboles sueltos cuyos nodos hay que destruir, encadenados por el puntero al padre de sus
+         * raíces.  Las operaciones de conjuntos no destruyen nodos mientras recorren los árboles, porque el pool no
+         * se puede usar desde varios hilos; los acumulan acá y se destruyen todos al final con destruir.
+         */
+    struct Descartes {
+        Node* primero{nullptr};
+        Node* ultimo{nullptr};
+
+        /** \brief Agrega el árbol de raíz \P{raiz}, que puede ser nula */
+        void agregar(Node* raiz){
+            if(raiz == nullptr) return;
+            raiz->set_parent(nullptr);
+            if(ultimo == nullptr){
+                primero = raiz;
+            }else{
+                ultimo->set_parent(raiz);
+            }
+            ultimo = raiz;
+        }
+
+        /** \brief Agrega, en \O(1), los árboles de \P{otros} */
+        void agregar(const Descartes& otros){
+            if(otros.primero == nullptr) return;
+            if(ultimo == nullptr){
+                primero = otros.primero;
+            }else{
+                ultimo->set_parent(otros.primero);
+            }
+            ultimo = otros.ultimo;
+        }
+    };
+
+        /**
+         * \brief destruir
+         *
+         * \Descripcion Destruye con destruirNodos todos los árboles de \P{descartes}.
+         *
+         * @returns la cantidad de nodos destruidos
+         *
+         * \complexity{\O(\DEL(nodos descartados))}
+         */
+    size_t destruir(const Descartes& descartes){
+        size_t res = 0;
+        Node* n = descartes.primero;
+        while(n != nullptr){
+            Node* siguiente = n->parent();
+            res += destruirNodos(n);
+            n = siguiente;
+        }
+        return res;
+    }
+
+    /** \brief Altura negra a partir de la cual las operaciones de conjuntos reparten el trabajo entre hilos */
+    static constexpr int altura_paralela = 10;
+
+        /**
+         * \brief hilosDisponibles
+         *
+         * \Descripcion Devuelve la cantidad de hilos que se pueden usar en paralelo (al menos 1): los que pide \P{p} o,
+         * si no pide ninguno, los de std::thread::hardware_concurrency.
+         *
+         * \complexity{\O(1)}
+         */
+    static int hilosDisponibles(parallel_t p){
+        if(p.threads > 0) return p.threads;
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+        /**
+         * \brief enParalelo
+         *
+         * \Descripcion Ejecuta \P{izq}(hilos, descartes) y \P{der}(hilos, descartes), que trabajan sobre árboles disjuntos.
+         * Si hay más de un hilo disponible y el árbol que se está recorriendo tiene altura negra al menos
+         * altura_paralela, \P{izq} se ejecuta en un hilo nuevo con la mitad de los \P{hilos} y sus descartes
+         * propios, que al final se agregan a \P{descartes}.  Si no (o si no se puede crear el hilo), se ejecutan uno
+         * después del otro.  Así, nunca hay más de \P{hilos} hilos trabajando.
+         *
+         * \complexity{el de \P{izq} más el de \P{der}, o el máximo si se ejecutan en paralelo}
+         */
+    template<class Izq, class Der>
+    static void enParalelo(int hilos, int altura, Descartes& descartes, Izq izq, Der der){
+        if(hilos > 1 and altura >= altura_paralela){
+            Descartes descartesIzq;
+            std::future<void> tarea;
+            try {
+                tarea = std::async(std::launch::async, [&]{ izq(hilos / 2, descartesIzq); });
+            } catch(const std::system_error&) {
+                izq(1, descartesIzq);
+            }
+            der(hilos - hilos / 2, descartes);
+            if(tarea.valid()) tarea.get();
+            descartes.agregar(descartesIzq);
+        }else{
+            izq(hilos, descartes);
+            der(hilos, descartes);
+        }
+    }
+
+        /**
+         * \brief unirArboles
+         *
+         * \Descripcion Devuelve la unión de los árboles sueltos \P{t1} y \P{t2}, cuyos nodos pertenecen al pool, con el
+         * algoritmo de \cite BlellochFerizovicSun2016: parte \P{t1} por la clave de la raíz de \P{t2}, une
+         * recursivamente (y quizás en paralelo) las mitades menores y las mayores, y junta ambos resultados con unir
+         * usando la raíz de \P{t2} como medio.  Si una clave está en los dos árboles, se conserva el nodo de \P{t2} si
+         * \P{conservarT2} y el de \P{t1} si no; el otro va a \P{descartes}.
+         *
+         * \complexity{\O(\a m \CDOT \LOG(\a n / \a m \PLUS 1) \CDOT \CMP(\P{*this})), con \a m = \SIZE(\P{t2}) \LEQ \a n = \SIZE(\P{t1})}
+         */
+    Arbol unirArboles(Arbol t1, Arbol t2, bool conservarT2, Descartes& descartes, int hilos){
+        if(t1.raiz == nullptr) return t2;
+        if(t2.raiz == nullptr) return t1;
+        InnerNode* n = static_cast<InnerNode*>(t2.raiz);
+        int altura = t2.altura - (n->color() == Color::Black ? 1 : 0);
+        Arbol izq2{n->child[0], altura};
+        Arbol der2{n->child[1], altura};
+        n->child[0] = n->child[1] = nullptr;
+        Arbol izq1, der1, izq, der;
+        InnerNode* igual = nullptr;
+        partir(t1, n->key(), izq1, der1, &igual);
+        enParalelo(hilos, t2.altura, descartes,
+            [&](int h, Descartes& d){ izq = unirArboles(izq1, izq2, conservarT2, d, h); },
+            [&](int h, Descartes& d){ der = unirArboles(der1, der2, conservarT2, d, h); });
+        if(igual != nullptr){
+            if(conservarT2){
+                descartes.agregar(igual);
+            }else{
+                descartes.agregar(n);
+                n = igual;
+            }
+        }
+        return unir(izq, n, der);
+    }
+
+        /**
+         * \brief intersecarArboles
+         *
+         * \Descripcion Devuelve los nodos del árbol suelto \P{t} cuyas claves están en el subárbol \P{otro} (de otro
+         * diccionario, que no se modifica); el resto va a \P{descartes}.  Idem unirArboles: parte \P{t} por la clave de
+         * la raíz de \P{otro}, resuelve recursivamente ambas mitades y las junta con unir, si la clave estaba en \P{t},
+         * o con unirSinMedio, si no.
+         *
+         * \complexity{\O(\a m \CDOT \LOG(\a n / \a m \PLUS 1) \CDOT \CMP(\P{*this})), con \a m y \a n el menor y el mayor de
+         * \SIZE(\P{t}) y \SIZE(\P{otro}), si \SIZE(\P{otro}) \LEQ \SIZE(\P{t}); \O(\SIZE(\P{t}) \CDOT \LOG(\SIZE(\P{otro})) \CDOT \CMP(\P{*this})) si no}
+         */
+    Arbol intersecarArboles(Arbol t, const Node* otro, Descartes& descartes, int hilos){
+        if(t.raiz == nullptr) return t;
+        if(otro == nullptr){
+            descartes.agregar(t.raiz);
+            return Arbol{nullptr, 0};
+        }
+        Arbol izq1, der1, izq, der;
+        InnerNode* igual = nullptr;
+        partir(t, otro->key(), izq1, der1, &igual);
+        enParalelo(hilos, t.altura, descartes,
+            [&](int h, Descartes& d){ izq = intersecarArboles(izq1, otro->child[0], d, h); },
+            [&](int h, Descartes& d){ der = intersecarArboles(der1, otro->child[1], d, h); });
+        return igual != nullptr ? unir(izq, igual, der) : unirSinMedio(izq, der);
+    }
+
+        /**
+         * \brief restarArboles
+         *
+         * \Descripcion Devuelve los nodos del árbol suelto \P{t} cuyas claves no están en el subárbol \P{otro} (de otro
+         * diccionario, que no se modifica); el resto va a \P{descartes}.  Idem intersecarArboles, pero el nodo de
+         * \P{t} con la clave de la raíz de \P{otro}, si existe, se descarta y las mitades se juntan con unirSinMedio.
+         *
+         * \complexity{idem intersecarArboles}
+         */
+    Arbol restarArboles(Arbol t, const Node* otro, Descartes& descartes, int hilos){
+        if(t.raiz == nullptr or otro == nullptr) return t;
+        Arbol izq1, der1, izq, der;
+        InnerNode* igual = nullptr;
+        partir(t, otro->key(), izq1, der1, &igual);
+        enParalelo(hilos, t.altura, descartes,
+            [&](int h, Descartes& d){ izq = restarArboles(izq1, otro->child[0], d, h); },
+            [&](int h, Descartes& d){ der = restarArboles(der1, otro->child[1], d, h); });
+        descartes.agregar(igual);
+        return unirSinMedio(izq, der);
+    }
+
+        /**
+         * \brief fusionar
+         *
+         * \Descripcion Implementa merge: trae los nodos de \P{other} con traerArbol y une ambos árboles con unirArboles,
+         * recorriendo el más chico y conservando los valores de \P{*this} cuando las claves se repiten.
+         *
+         * \complexity{idem traerArbol \PLUS \O(\a m \CDOT \LOG(\a n / \a m \PLUS 1) \CDOT \CMP(\P{*this}) \PLUS \DEL(repetidos)),
+         * con \a m y \a n el menor y el mayor de \SIZE(\P{*this}) y \SIZE(\P{other})}
+         */
+    void fusionar(map& other, int hilos){
+        if(this == &other or other.empty()) return;
+        size_t n = count + other.count;
+        bool otroEsChico = other.count <= count;
+        Arbol t2 = traerArbol(other);
+        Arbol t1 = soltarArbol();
+        Descartes descartes;
+        Arbol res = otroEsChico ? unirArboles(t1, t2, false, descartes, hilos)
+                                : unirArboles(t2, t1, true, descartes, hilos);
+        plantar(res, n - destruir(descartes));
+    }
+
+        /**
+         * \brief intersecar
+         *
+         * \Descripcion Implementa intersect_with y difference: se queda con los nodos de \P{*this} cuyas claves están (si
+         * \P{interseccion}) o no están (si no) en \P{other}.
+         *
+         * \complexity{idem intersecarArboles \PLUS \DEL(valores eliminados)}
+         */
+    void intersecar(const map& other, bool interseccion, int hilos){
+        size_t n = count;
+        Descartes descartes;
+        Arbol res = interseccion ? intersecarArboles(soltarArbol(), other.header.parent(), descartes, hilos)
+                                 : restarArboles(soltarArbol(), other.header.parent(), descartes, hilos);
+        plantar(res, n - destruir(descartes));
+    }
+
+        /**
+         * \brief copiarArbol
+         *
+         * \Descripcion Copia en \P{*this}, que debe estar vacío, el árbol de \P{other} con la misma forma y los mismos
+         * colores, sin comparar claves.  Cada nodo se engancha a su padre apenas se crea, de forma que si la copia
+         * de un valor lanza una excepción, los nodos ya creados son alcanzables desde la cabecera y se pueden destruir.
+         * En ese caso \P{count} y los extremos de la cabecera quedan sin actualizar.
+         *
+         * \complexity{\O(\COPY(\P{other}))}
+         */
+    void copiarArbol(const map& other){
+        if(other.empty()) return;
+        header.set_parent(pool.crear(&header, other.header.parent()->color(), other.header.parent()->value()));
+        copiarHijos(other.header.parent(), header.parent());
+        actualizar(header.parent());
+        header.child[0] = iterator::min(header.parent());
+        header.child[1] = iterator::max(header.parent());
+        count = other.count;
+    }
+
+        /**
+         * \brief copiarHijos
+         *
+         * \Descripcion Copia recursivamente los subárboles de \P{origen} como hijos de \P{destino}, que es la copia
+         * de \P{origen}.  La profundidad de la recursión es la altura del árbol.
+         *
+         * \complexity{\O(\COPY(\P{origen}))}
+         */
+    void copiarHijos(const Node* origen, Node* destino){
+        for(int i = 0; i < 2; ++i){
+            if(origen->child[i] != nullptr){
+                destino->child[i] = pool.crear(destino, origen->child[i]->color(), origen->child[i]->value());
+                copiarHijos(origen->child[i], destino->child[i]);
+                actualizar(destino->child[i]);
+            }
+        }
+    }
+
+    /**
+     * \brief Cabecera de una serialización.  Los campos de tamaño fijo se guardan con la representación de la
+     * arquitectura; \P{orden} y los tamaños permiten rechazar datos escritos en otra.
+     */
+    struct CabeceraSerial {
+        /** \brief Identificador del formato */
+        char magia[8] = {'A', 'E', 'D', '2', 'S', 'E', 'R', '\0'};
+        /** \brief Marca para detectar el orden de los bytes */
+        uint32_t orden = 0x01020304;
+        /** \brief Versión del formato */
+        uint8_t version = 1;
+        /** \brief Codificación de las claves y de los significados (ver codificacionDe) */
+        uint8_t clave = 0, significado = 0;
+        /** \brief Sin uso; siempre 0 */
+        uint8_t reservado = 0;
+        /** \brief Tamaños en memoria de \T{Key} y \T{Meaning} */
+        uint32_t tamanioClave = sizeof(Key), tamanioSignificado = sizeof(Meaning);
+        /** \brief Cantidad de valores */
+        uint64_t cantidad = 0;
+
+        /** \brief Indica si la cabecera describe valores que se pueden leer como \T{K} y \T{M} */
+        template<class K, class M>
+        bool compatible() const {
+            CabeceraSerial esperada;
+            return std::memcmp(magia, esperada.magia, sizeof(magia)) == 0 and orden == esperada.orden
+                and version == esperada.version and reservado == 0 and tamanioClave == esperada.tamanioClave
+                and tamanioSignificado == esperada.tamanioSignificado and admite<K>(clave)
+                and admite<M>(significado);
+        }
+    };
+
+    /** \brief Codificación de un campo: representación en memoria */
+    static constexpr uint8_t codigoFijo = 0;
+    /** \brief Codificación de un campo: entero en zigzag y varint (las claves, como diferencia con la anterior) */
+    static constexpr uint8_t codigoVarint = 1;
+    /** \brief Codificación de un campo: std::string como longitud (varint) y caracteres */
+    static constexpr uint8_t codigoCadena = 2;
+
+    /** \brief Codificación con la que serialize guarda los campos de tipo \T{T}, pidiendo \P{cod} */
+    template<class T>
+    static constexpr uint8_t codificacionDe(serial_encoding cod) {
+        if constexpr(std::is_same<T, std::string>::value){
+            return codigoCadena;
+        }else if constexpr(std::is_integral<T>::value){
+            return cod == serial_encoding::varint ? codigoVarint : codigoFijo;
+        }else{
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "serialize requiere enteros, std::string o tipos trivialmente copiables");
+            return codigoFijo;
+        }
+    }
+
+    /** \brief Indica si un campo guardado con la codificación \P{cod} se puede leer como \T{T} */
+    template<class T>
+    static constexpr bool admite(uint8_t cod) {
+        if constexpr(std::is_same<T, std::string>::value){
+            return cod == codigoCadena;
+        }else{
+            return cod == codigoFijo or (cod == codigoVarint and std::is_integral<T>::value);
+        }
+    }
+
+    /**
+     * \brief Buffer con el que serialize escribe en un std::ostream.  Los bytes se escriben en bloques de a lo sumo
+     * \P{capacidad} bytes, precedidos por su longitud, para que deserialize sepa cuánto puede leer sin pasarse.
+     */
+    class EscritorBinario {
+    public:
+        explicit EscritorBinario(std::ostream& o) : os(o), buffer(capacidad) {}
+
+        /** \brief Escribe los \P{n} bytes que empiezan en \P{p} */
+        void bytes(const void* p, size_t n) {
+            const char* origen = static_cast<const char*>(p);
+            if(n <= capacidad - usados){
+                std::memcpy(buffer.data() + usados, origen, n);
+                usados += n;
+                return;
+            }
+            while(n > 0){
+                if(usados == capacidad) vaciar();
+                size_t k = std::min(n, capacidad - usados);
+                std::memcpy(buffer.data() + usados, origen, k);
+                usados += k;
+                origen += k;
+                n -= k;
+            }
+        }
+
+        /** \brief Escribe \P{v} con 7 bits por byte; el bit más alto indica si sigue otro byte */
+        void varint(uint64_t v) {
+            if(capacidad - usados < 10) vaciar();
+            while(v >= 0x80){
+                buffer[usados++] = static_cast<char>(v | 0x80);
+                v >>= 7;
+            }
+            buffer[usados++] = static_cast<char>(v);
+        }
+
+        /** \brief Escribe en el stream el bloque pendiente, si no es vacío */
+        void vaciar() {
+            if(usados == 0) return;
+            uint32_t longitud = static_cast<uint32_t>(usados);
+            os.write(reinterpret_cast<const char*>(&longitud), sizeof(longitud));
+            os.write(buffer.data(), static_cast<std::streamsize>(usados));
+            usados = 0;
+        }
+
+        /** \brief Longitud máxima de un bloque */
+        static constexpr size_t capacidad = 1 << 16;
+
+    private:
+        std::ostream& os;
+        std::vector<char> buffer;
+        size_t usados{0};
+    };
+
+    /** \brief Buffer con el que deserialize lee los bloques que escribió EscritorBinario */
+    class LectorBinario {
+    public:
+        explicit LectorBinario(std::istream& i) : is(i), buffer(EscritorBinario::capacidad) {}
+
+        /** \brief Lee \P{n} bytes en \P{p} */
+        void bytes(void* p, size_t n) {
+            char* destino = static_cast<char*>(p);
+            if(n <= fin - pos){
+                std::memcpy(destino, buffer.data() + pos, n);
+                pos += n;
+                return;
+            }
+            while(n > 0){
+                if(pos == fin) cargar();
+                size_t k = std::min(n, fin - pos);
+                std::memcpy(destino, buffer.data() + pos, k);
+                pos += k;
+                destino += k;
+                n -= k;
+            }
+        }
+
+        /** \brief Lee un entero escrito con EscritorBinario::varint */
+        uint64_t varint() {
+            uint64_t res = 0;
+            for(int desplazamiento = 0; desplazamiento < 64; desplazamiento += 7){
+                if(pos == fin) cargar();
+                unsigned char b = static_cast<unsigned char>(buffer[pos++]);
+                res |= static_cast<uint64_t>(b & 0x7f) << desplazamiento;
+                if((b & 0x80) == 0) return res;
+            }
+            fallar("varint demasiado largo");
+        }
+
+        /** \brief Indica si se consumió todo el último bloque leído */
+        bool terminado() const {
+            return pos == fin;
+        }
+
+        /** \brief Lanza std::runtime_error describiendo el problema */
+        [[noreturn]] static void fallar(const char* motivo) {
+            throw std::runtime_error(std::string("aed2::map::deserialize: ") + motivo);
+        }
+
+    private:
+        /** \brief Lee el próximo bloque */
+        void cargar() {
+            uint32_t longitud = 0;
+            if(not is.read(reinterpret_cast<char*>(&longitud), sizeof(longitud))) fallar("fin de los datos inesperado");
+            if(longitud == 0 or longitud > buffer.size()) fallar("bloque inválido");
+            if(not is.read(buffer.data(), longitud)) fallar("fin de los datos inesperado");
+            pos = 0;
+            fin = longitud;
+        }
+
+        std::istream& is;
+        std::vector<char> buffer;
+        size_t pos{0}, fin{0};
+    };
+
+        /**
+         * \brief escribirCampo
+         *
+         * \Descripcion Escribe \P{v} con la codificación \P{cod}.  Si \P{anterior} no es nulo, un entero en varint se
+         * escribe como la diferencia con *\P{anterior}, que pasa a ser \P{v}.
+         *
+         * \complexity{\O(1) salvo para std::string, \O(longitud)}
+         */
+    template<class T>
+    static void escribirCampo(EscritorBinario& escritor, uint8_t cod, const T& v, uint64_t* anterior) {
+        if constexpr(std::is_same<T, std::string>::value){
+            escritor.varint(v.size());
+            escritor.bytes(v.data(), v.size());
+        }else if constexpr(std::is_integral<T>::value){
+            if(cod == codigoFijo){
+                escritor.bytes(&v, sizeof(T));
+                return;
+            }
+            uint64_t u = static_cast<uint64_t>(v);
+            uint64_t d = anterior == nullptr ? u : u - std::exchange(*anterior, u);
+            escritor.varint((d << 1) ^ (0 - (d >> 63)));
+        }else{
+            escritor.bytes(&v, sizeof(T));
+        }
+    }
+
+    /** \brief Lee un campo que escribió escribirCampo(escritor, \P{cod}, v, \P{anterior}) */
+    template<class T>
+    static T leerCampo(LectorBinario& lector, uint8_t cod, uint64_t* anterior) {
+        if constexpr(std::is_same<T, std::string>::value){
+            uint64_t longitud = lector.varint();
+            T res;
+            // se agranda de a bloques, para no reservar una longitud corrupta de una vez
+            while(res.size() < longitud){
+                size_t antes = res.size();
+                res.resize(antes + std::min<uint64_t>(longitud - antes, EscritorBinario::capacidad));
+                lector.bytes(&res[antes], res.size() - antes);
+            }
+            return res;
+        }else if constexpr(std::is_integral<T>::value){
+            if(cod == codigoFijo){
+                T res;
+                lector.bytes(&res, sizeof(T));
+                return res;
+            }
+            uint64_t z = lector.varint();
+            uint64_t u = (z >> 1) ^ (0 - (z & 1));
+            if(anterior != nullptr) u = *anterior += u;
+            return static_cast<T>(u);
+        }else{
+            T res;
+            lector.bytes(&res, sizeof(T));
+            return res;
+        }
+    }
+
+    /**
+     * \brief Iterador de entrada sobre los valores de una serialización, con el que deserialize alimenta a
+     * construirOrdenado.  Cada valor se decodifica al avanzar, y se verifica que su clave sea mayor que la anterior.
+     * Desreferenciarlo devuelve el valor actual como rvalue, para que construirOrdenado lo mueva al nodo; por eso
+     * se puede desreferenciar una única vez por posición.
+     */
+    class ValoresLeidos {
+    public:
+        ValoresLeidos(LectorBinario& l, const CabeceraSerial& c, const Compare& o)
+            : lector(&l), cabecera(&c), lt(&o), restantes(c.cantidad) {
+            ++*this;
+        }
+
+        value_type&& operator*() {
+            return std::move(*actual);
+        }
+
+        ValoresLeidos& operator++() {
+            if(restantes == 0) return *this;
+            --restantes;
+            Key clave = leerCampo<Key>(*lector, cabecera->clave, &anterior);
+            if(actual.has_value() and not (*lt)(actual->first, clave)) LectorBinario::fallar("claves desordenadas");
+            Meaning significado = leerCampo<Meaning>(*lector, cabecera->significado, nullptr);
+            actual.reset();
+            actual.emplace(std::move(clave), std::move(significado));
+            return *this;
+        }
+
+    private:
+        LectorBinario* lector;
+        const CabeceraSerial* cabecera;
+        const Compare* lt;
+        uint64_t restantes;
+        uint64_t anterior{0};
+        std::optional<value_type> actual;
+    };
+
+        /**
+         * \brief construirOrdenado
+         *
+         * \Descripcion Arma en \P{*this}, que debe estar vacío, un árbol perfectamente balanceado con los \P{n} valores que
+         * empiezan en \P{first}, cuyas claves son estrictamente crecientes.  Se piden al pool de una vez hasta
+         * \P{reserva} nodos (ver armarArbol) y se crean en inorder, en una única pasada por el rango y sin comparar
+         * claves.  Son negros todos los nodos salvo
+         * los del último nivel cuando el árbol no es completo, que son rojos (ver \ref CargaOrdenada).  Si la copia
+         * de un valor lanza una excepción, se destruyen los valores ya copiados y \P{*this} queda vacío.
+         *
+         * \complexity{\O(\P{n} \PLUS \COPY(\P{*this}))}
+         */
+    template<class ForwardIt>
+    void construirOrdenado(ForwardIt first, size_t n, size_t reserva = size_t(-1)){
+        if(n == 0) return;
+        Node* raiz = armarArbol(first, n, reserva);
+        raiz->set_parent(&header);
+        header.set_parent(raiz);
+        header.child[0] = iterator::min(raiz);
+        header.child[1] = iterator::max(raiz);
+        count = n;
+    }
+
+        /**
+         * \brief armarArbol
+         *
+         * \Descripcion Devuelve la raíz, sin padre, de un árbol red-black perfectamente balanceado con los \P{n} \GEQ 1
+         * valores que empiezan en \P{first}, cuyas claves son estrictamente crecientes, y avanza \P{first} hasta pasar
+         * el último.  Los primeros \P{reserva} nodos (todos, por omisión) se piden al pool de una vez, y el resto a medida
+         * que se crean; limitar la reserva sirve cuando \P{n} viene de datos externos y podría estar corrupto.  Si la
+         * copia de un valor lanza una excepción, se destruyen los nodos ya creados.
+         *
+         * \complexity{\O(\P{n} \PLUS \COPY(valores copiados))}
+         */
+    template<class ForwardIt>
+    Node* armarArbol(ForwardIt& first, size_t n, size_t reserva = size_t(-1)){
+        int nivelRojo = 0;
+        while((size_t(2) << nivelRojo) - 1 < n) ++nivelRojo;
+        pool.reservarNodos(std::min(n, reserva));
+        return construirSubarbol(first, n, 0, nivelRojo);
+    }
+
+        /**
+         * \brief construirSubarbol
+         *
+         * \Descripcion Auxiliar de construirOrdenado.  Devuelve la raíz de un árbol balanceado con los próximos \P{n}
+         * valores de \P{first}, que avanza hasta pasar el último valor usado.  La raíz está a profundidad \P{nivel}
+         * y no tiene padre; los nodos a profundidad \P{nivelRojo} (si es mayor a 0) son rojos.  Si la copia de un
+         * valor lanza una excepción, se destruyen los nodos ya creados del subárbol.
+         *
+         * \complexity{\O(\P{n} \PLUS \COPY(valores copiados))}
+         */
+    template<class ForwardIt>
+    Node* construirSubarbol(ForwardIt& first, size_t n, int nivel, int nivelRojo){
+        if(n == 0) return nullptr;
+        size_t izquierdos = (n - 1) / 2;
+        Node* izq = construirSubarbol(first, izquierdos, nivel + 1, nivelRojo);
+        InnerNode* nodo;
+        try {
+            nodo = pool.crear(nullptr, nivel == nivelRojo and nivel > 0 ? Color::Red : Color::Black, *first);
+        } catch(...) {
+            destruirNodos(izq);
+            throw;
+        }
+        ++first;
+        nodo->child[0] = izq;
+        if(izq != nullptr) izq->set_parent(nodo);
+        try {
+            nodo->child[1] = construirSubarbol(first, n - 1 - izquierdos, nivel + 1, nivelRojo);
+        } catch(...) {
+            destruirNodos(nodo);
+            throw;
+        }
+        if(nodo->child[1] != nullptr) nodo->child[1]->set_parent(nodo);
+        actualizar(nodo);
+        return nodo;
+    }
+
+        /**
+         * \brief Lugar
+         *
+         * \Descripcion Resultado de buscar dónde insertar una clave.  Si \P{existe}, \P{padre} es el nodo que ya tiene la clave.
+         * Si no, el nodo nuevo se engancha como hijo \P{lado} de \P{padre}, que es la cabecera cuando el árbol está vacío.
+         */
+    struct Lugar {
+        Node* padre;
+        int lado;
+        bool existe;
+    };
+
+        /**
+         * \brief lugar
+         *
+         * \Descripcion Busca, descendiendo una única vez desde la raíz, el nodo con clave \P{key} o el lugar en el que
+         * habría que engancharlo.  En cada nivel se hace una sola comparación.  Si las claves se comparan de a tres vías,
+         * el descenso termina al encontrar \P{key}; si no, se recuerda el último nodo con clave mayor o igual a \P{key} y
+         * al final una comparación más decide si dicho nodo tiene clave \P{key}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+         */
+    Lugar lugar(const Key& key) const {
+        Node* padre = const_cast<Node*>(&header);
+        Node* candidato = nullptr;
+        Node* n = header.parent();
+        int lado = 0;
+        while(n != nullptr){
+            padre = n;
+            if constexpr(tripartito){
+                auto c = comparar(n->key(), key);
+                if(c == 0){
+                    return Lugar{n, 0, true};
+                }
+                lado = c < 0 ? 1 : 0;
+            }else{
+                lado = lt(n->key(), key) ? 1 : 0;
+                if(lado == 0){
+                    candidato = n;
+                }
+            }
+            n = n->child[lado];
+        }
+        if(not tripartito and candidato != nullptr and not lt(key, candidato->key())){
+            return Lugar{candidato, 0, true};
+        }
+        return Lugar{padre, lado, false};
+    }
+
+        /**
+         * \brief lugarDesde
+         *
+         * \Descripcion Idem lugar, pero buscando desde el nodo \P{dedo}, cuya clave es menor a \P{key}, en lugar de
+         * desde la raíz.  Sube desde \P{dedo} comparando sólo con los ancestros de los que se llega desde su hijo
+         * izquierdo (los de clave mayor), hasta encontrar uno con clave mayor o igual a \P{key}.  Entre los nodos
+         * salteados, el último con clave menor a \P{key} (o \P{dedo}) tiene a \P{key} entre su clave y la de su
+         * sucesor, por lo que el lugar está en su subárbol derecho, donde se desciende como en lugar.  Si \P{key}
+         * está cerca de \P{dedo} en el orden, ambos recorridos son cortos.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this})); ver insert_sorted_batch}
+         */
+    Lugar lugarDesde(Node* dedo, const Key& key) const {
+        Node* desde = dedo;
+        Node* candidato = nullptr;
+        for(Node* u = dedo; u->parent() != &header; u = u->parent()){
+            Node* p = u->parent();
+            if(u != p->child[0]){
+                continue;
+            }
+            if constexpr(tripartito){
+                auto c = comparar(p->key(), key);
+                if(c == 0){
+                    return Lugar{p, 0, true};
+                }
+                if(c > 0){
+                    break;
+                }
+            }else{
+                if(not lt(p->key(), key)){
+                    candidato = p;
+                    break;
+                }
+            }
+            desde = p;
+        }
+        Node* padre = desde;
+        Node* n = desde->child[1];
+        int lado = 1;
+        while(n != nullptr){
+            padre = n;
+            if constexpr(tripartito){
+                auto c = comparar(n->key(), key);
+                if(c == 0){
+                    return Lugar{n, 0, true};
+                }
+                lado = c < 0 ? 1 : 0;
+            }else{
+                lado = lt(n->key(), key) ? 1 : 0;
+                if(lado == 0){
+                    candidato = n;
+                }
+            }
+            n = n->child[lado];
+        }
+        if(not tripartito and candidato != nullptr and not lt(key, candidato->key())){
+            return Lugar{candidato, 0, true};
+        }
+        return Lugar{padre, lado, false};
+    }
+
+        /**
+         * \brief lugarConHint
+         *
+         * \Descripcion Idem lugar, pero si \P{hint} apunta al primer valor con clave mayor o igual a \P{key} (o a end() si
+         * no existe), el lugar se obtiene a partir de \P{hint} sin descender desde la raíz.  El nodo nuevo va como hijo
+         * izquierdo de \P{hint} si éste no tiene, o como hijo derecho del máximo del subárbol izquierdo de \P{hint}.
+         *
+         * \complexity{
+         * - Peor caso: \O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))
+         * - Si \P{hint} es bueno: \O(\CMP(\P{*this})) amortizado
+         * }
+         */
+    Lugar lugarConHint(const_iterator hint, const Key& key) const {
+        if(not esBuenHint(hint, key)){
+            return lugar(key);
+        }
+        if(hint == end()){
+            return Lugar{header.child[1], 1, false};
+        }
+        Node* n = const_cast<Node*>(hint.n);
+        if(not lt(key, n->key())){
+            return Lugar{n, 0, true};
+        }
+        if(n->child[0] == nullptr){
+            return Lugar{n, 0, false};
+        }
+        return Lugar{iterator::max(n->child[0]), 1, false};
+    }
+
+        /**
+         * \brief enganchar
+         *
+         * \Descripcion Engancha el nodo \P{nuevo}, cuyo padre ya es \P{l}.padre, en el lugar \P{l} obtenido con lugar o
+         * lugarConHint.  Actualiza los extremos de la cabecera y la cantidad de elementos, y restablece el invariante
+         * red-black con insertFixUp.
+         *
+         * \complexity{\O(1) amortizado}
+         */
+    iterator enganchar(InnerNode* nuevo, Lugar l){
+        if(l.padre == &header){
+            header.set_parent(nuevo);
+            header.child[0] = header.child[1] = nuevo;
+        }else{
+            l.padre->child[l.lado] = nuevo;
+            if(l.padre == header.child[l.lado]){
+                header.child[l.lado] = nuevo;
+            }
+        }
+        actualizarHastaLaRaiz(nuevo);
+        insertFixUp(nuevo);
+        count++;
+        return iterator(nuevo);
+    }
+
+        /**
+         * \brief asignarOEnganchar
+         *
+         * \Descripcion Si en el lugar \P{l} ya existe la clave, le asigna el significado de \P{value}; si no, crea un nodo con
+         * \P{value} y lo engancha en \P{l}.  \P{V} es `const value_type&` o `value_type&&`, en cuyo caso el valor se mueve.
+         *
+         * \complexity{\O(1) amortizado \PLUS costo de copiar (o mover) \P{value}}
+         */
+    template<class V>
+    iterator asignarOEnganchar(Lugar l, V&& value){
+        if(l.existe){
+            l.padre->value().second = std::forward<V>(value).second;
+            actualizarHastaLaRaiz(l.padre);
+            return iterator(l.padre);
+        }
+        return enganchar(pool.crear(l.padre, Color::Red, std::forward<V>(value)), l);
+    }
+
+        /**
+         * \brief esBuenHint
+         *
+         * \Descripcion Devuelve true si \P{hint} apunta al primer valor con clave mayor o igual a \P{key}, o a end() cuando
+         * \P{key} es mayor a todas las claves de un diccionario no vacío.
+         *
+         * \complexity{\O(\CMP(\P{*this})) amortizado}
+         */
+	bool esBuenHint(const_iterator hint, const Key& key) const {
+		if(hint == end()){
+			return not(empty()) and lt(header.child[1]->key(), key);
+		}
+		if(lt(hint->first, key)){
+			return false;
+		}
+		if(hint.n == header.child[0]){
+			return true;
 		}
+		hint.retroceder();
+		return lt(hint->first, key);
 	}
 
 };
@@ -2821,6 +6280,8 @@ private:
  * @tparam K clave del diccionario
  * @tparam V signficado del diccionario
  * @tparam C tipo del comparador
+ * @tparam A tipo del allocator
+ * @tparam G política de aumento (ver \ref Aumentos)
  *
  * \par Requerimientos sobre los tipos
  * \T{K} y \T{V} tienen operator==; vamos a usar \CMP para describir los costos de comparación.
@@ -2837,8 +6298,8 @@ private:
  * \attention  Para determinar la igualdad de las claves no se utiliza el functor de comparación (que podrian
  * ser distintos entre los diccionarios), sino si los valores son los mismos con respecto al operator== de \T{K} y T{V}.
  */
-template<class K, class V, class C>
-bool operator==(const map<K, V, C>& m1, const map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+bool operator==(const map<K, V, C, A, G>& m1, const map<K, V, C, A, G>& m2) {
 	return m1.size() == m2.size() and std::equal(m1.begin(), m1.end(), m2.begin());
 }
 
@@ -2848,8 +6309,8 @@ bool operator==(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  *
  * \sa aed2::operator==()
  */
-template<class K, class V, class C>
-bool operator!=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+bool operator!=(const map<K, V, C, A, G>& m1, const map<K, V, C, A, G>& m2) {
 	return not(m1 == m2);
 }
 
@@ -2862,6 +6323,8 @@ bool operator!=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  * @tparam K clave del diccionario
  * @tparam V signficado del diccionario
  * @tparam C tipo del comparador
+ * @tparam A tipo del allocator
+ * @tparam G política de aumento (ver \ref Aumentos)
  *
  * \par Requerimientos sobre los tipos
  * \T{K} y \T{V} tienen operator<; vamos a usar \CMP para describir los costos de comparación.
@@ -2878,8 +6341,8 @@ bool operator!=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  * \attention  Para determinar la comparación de las claves no se utiliza el functor de comparación (que podrian
  * ser distintos entre los diccionarios), sino si los valores son los mismos con respecto al operator< de \T{K} y T{V}.
  */
-template<class K, class V, class C>
-bool operator<(const map<K, V, C>& m1, const map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+bool operator<(const map<K, V, C, A, G>& m1, const map<K, V, C, A, G>& m2) {
         return std::lexicographical_compare(m1.begin(), m1.end(), m2.begin(), m2.end());
 }
 
@@ -2889,8 +6352,8 @@ bool operator<(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  *
  * \sa aed2::operator<()
  */
-template<class K, class V, class C>
-bool operator>(const map<K, V, C>& m1, const map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+bool operator>(const map<K, V, C, A, G>& m1, const map<K, V, C, A, G>& m2) {
 	return m2 < m1;
 }
 
@@ -2900,8 +6363,8 @@ bool operator>(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  *
  * \sa aed2::operator<()
  */
-template<class K, class V, class C>
-bool operator<=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+bool operator<=(const map<K, V, C, A, G>& m1, const map<K, V, C, A, G>& m2) {
 	return not(m2 < m1);
 }
 
@@ -2911,8 +6374,8 @@ bool operator<=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  *
  * \sa aed2::operator<()
  */
-template<class K, class V, class C>
-bool operator>=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+bool operator>=(const map<K, V, C, A, G>& m1, const map<K, V, C, A, G>& m2) {
 	return !(m1 < m2);
 }
 //@}
@@ -2927,6 +6390,8 @@ bool operator>=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  * @tparam K clave del diccionario
  * @tparam V signficado del diccionario
  * @tparam C tipo del comparador
+ * @tparam A tipo del allocator
+ * @tparam G política de aumento (ver \ref Aumentos)
  *
  * @param m1 diccionario a intercambiar
  * @param m2 diccionario a intercambiar
@@ -2935,8 +6400,8 @@ bool operator>=(const map<K, V, C>& m1, const map<K, V, C>& m2) {
  *
  * \sa [Swappable](http://en.cppreference.com/w/cpp/concept/Swappable)
  */
-template<class K, class V, class C>
-void swap(map<K, V, C>& m1, map<K, V, C>& m2) {
+template<class K, class V, class C, class A, class G>
+void swap(map<K, V, C, A, G>& m1, map<K, V, C, A, G>& m2) noexcept(noexcept(m1.swap(m2))) {
 	m1.swap(m2);
 }
 }
@@ -1090,9 +1090,7 @@ public:
      * \note Es importante remarcar que no se realiza ninguna comparación entre los elementos.
      */
     map& operator=(map other) {
-        map* m = new map(other);
-        swap(*m);
-        delete m;
+        swap(other);
         return *this;
     }
 
@@ -0,0 +1,550 @@
+/**
+ * @file mapped_map.h
+ *
+ * Módulo C++ que implementa un diccionario ordenado de sólo lectura guardado en un archivo, que se abre con mmap
+ * sin deserializar nada.
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef MAPPED_MAP_H_
+#define MAPPED_MAP_H_
+
+#include "map.h"
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <string>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aed2{
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado de sólo lectura que vive en un archivo mapeado en memoria.
+ *
+ * Reconstruir un aed2::map grande a partir de un volcado cuesta \O(\a n \CDOT \LOG(\a n)) inserciones cada vez que
+ * arranca el proceso.  Si las claves y los significados son trivialmente copiables, aed2::mapped_map::write guarda
+ * el diccionario en un archivo con el mismo formato que se usa en memoria, y el constructor lo abre con `mmap`: no
+ * se lee ni se construye nada, y find y lower_bound se pueden usar de inmediato.  Las páginas del archivo las trae
+ * el sistema operativo a medida que las búsquedas las tocan, y las comparten todos los procesos que abren el mismo
+ * archivo.
+ *
+ * Para que el archivo sea independiente de la dirección en la que se mapea, los nodos no guardan punteros ni
+ * posiciones de otros nodos.  Están en orden creciente de claves (así los iteradores sólo avanzan al nodo
+ * siguiente) y forman un ABB balanceado implícito: la raíz de las posiciones [\a desde, \a hasta) es la del medio,
+ * como en una búsqueda binaria, y buscar cuesta \O(\LOG(\a n)) comparaciones.  Como los hijos se calculan, un
+ * archivo corrupto puede dar respuestas equivocadas pero nunca hacer que una búsqueda se salga del arreglo o no
+ * termine.  Ver \ref Archivos.
+ *
+ * @tparam Key tipo de la clave.  Tiene que ser trivialmente copiable.
+ * @tparam Meaning tipo del significado.  Tiene que ser trivialmente copiable.
+ * @tparam Compare tipo del comparador.  Tiene que ser el mismo orden con el que se escribió el archivo.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map; además, llamamos \a n a la cantidad de valores del archivo.
+ *
+ * \par Aspectos generales de aliasing
+ * Los valores se ven sólo como referencias constantes a la memoria mapeada, y se mantienen válidas mientras
+ * exista el diccionario.  Modificar el archivo mientras está abierto es un error.
+ *
+ * \attention El archivo depende de la representación de \T{Key} y \T{Meaning} en la arquitectura que lo escribió
+ * (tamaños, alineación y orden de los bytes).  La cabecera guarda esos datos, y abrir un archivo incompatible
+ * lanza una excepción.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>
+>
+class mapped_map {
+    static_assert(std::is_trivially_copyable<Key>::value, "aed2::mapped_map requiere claves trivialmente copiables");
+    static_assert(std::is_trivially_copyable<Meaning>::value, "aed2::mapped_map requiere significados trivialmente copiables");
+
+	struct Nodo;
+	struct Cabecera;
+
+public:
+    //forward declarations
+    class const_iterator;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Renombre para poder acceder al tipo de referencia constante de los valores guardados.  Compatible con estándar C++. */
+    using const_reference = const value_type&;
+    /** \brief Renombre para poder acceder al tipo de los punteros de los valores constantes guardados.  Compatible con estándar C++. */
+    using const_pointer = const value_type*;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+    /** \brief Los valores no se pueden modificar: iterator es const_iterator. */
+    using iterator = const_iterator;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Escritura del archivo */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Guarda en el archivo \P{ruta} los valores del rango [\P{first}, \P{last}), que tiene que estar ordenado
+     * de forma estrictamente creciente según \T{Compare}.
+     *
+     * El archivo se escribe primero con otro nombre (\P{ruta} seguido de ".tmp") y después se renombra, así que
+     * quien abra \P{ruta} ve la versión anterior completa o la nueva completa.
+     *
+     * \pre \aedpre{El rango es válido, está ordenado y no tiene claves repetidas.}
+     * \post \aedpost{El archivo \P{ruta} representa el diccionario con los valores del rango.}
+     *
+     * @throws std::system_error si falla alguna operación sobre el archivo.
+     *
+     * \complexity{\O(\a n), donde \a n es la longitud del rango}
+     */
+    template<class ForwardIt>
+    static void write(const std::string& ruta, ForwardIt first, ForwardIt last) {
+        size_t n = static_cast<size_t>(std::distance(first, last));
+        size_t bytes = sizeof(Cabecera) + n * sizeof(Nodo);
+        std::string temporal = ruta + ".tmp";
+        try {
+            Archivo archivo(::open(temporal.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644), temporal);
+            if(::ftruncate(archivo.fd, static_cast<off_t>(bytes)) != 0) archivo.fallar("ftruncate");
+            Mapeo mapeo(archivo, bytes, PROT_READ | PROT_WRITE);
+            Cabecera* cabecera = ::new(mapeo.datos) Cabecera();
+            cabecera->cantidad = n;
+            Nodo* nodos = reinterpret_cast<Nodo*>(mapeo.datos + sizeof(Cabecera));
+            for(size_t i = 0; i < n; ++i, ++first){
+                ::new(static_cast<void*>(nodos + i)) Nodo{value_type(first->first, first->second)};
+            }
+            if(::msync(mapeo.datos, bytes, MS_SYNC) != 0) archivo.fallar("msync");
+            if(::rename(temporal.c_str(), ruta.c_str()) != 0) archivo.fallar("rename");
+        } catch(...) {
+            ::unlink(temporal.c_str());
+            throw;
+        }
+    }
+
+    /**
+     * @brief Guarda los valores de \P{dicc} en el archivo \P{ruta}.  Ver write(const std::string&, ForwardIt, ForwardIt).
+     *
+     * \complexity{\O(\SIZE(\P{dicc}))}
+     */
+    template<class Alloc, class Augment>
+    static void write(const std::string& ruta, const map<Key, Meaning, Compare, Alloc, Augment>& dicc) {
+        write(ruta, dicc.begin(), dicc.end());
+    }
+    //@}
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Abre el diccionario guardado en el archivo \P{ruta}.  No lee los valores: sólo mapea el archivo y
+     * verifica la cabecera.
+     *
+     * @throws std::system_error si no se puede abrir o mapear el archivo.
+     * @throws std::runtime_error si el archivo no fue escrito por aed2::mapped_map::write con los mismos \T{Key} y
+     * \T{Meaning}, o está truncado.
+     *
+     * \complexity{\O(1)}
+     */
+    explicit mapped_map(const std::string& ruta, Compare c = Compare()) : lt(c) {
+        Archivo archivo(::open(ruta.c_str(), O_RDONLY), ruta);
+        struct stat datos;
+        if(::fstat(archivo.fd, &datos) != 0) archivo.fallar("fstat");
+        size_t bytes = static_cast<size_t>(datos.st_size);
+        if(bytes < sizeof(Cabecera)) throw std::runtime_error("aed2::mapped_map: " + ruta + " no tiene cabecera");
+        Mapeo mapeo(archivo, bytes, PROT_READ);
+        const Cabecera* leida = reinterpret_cast<const Cabecera*>(mapeo.datos);
+        if(not (*leida == Cabecera()) or leida->cantidad > (bytes - sizeof(Cabecera)) / sizeof(Nodo)) {
+            throw std::runtime_error("aed2::mapped_map: " + ruta + " no tiene el formato esperado");
+        }
+        ::madvise(mapeo.datos, bytes, MADV_RANDOM);
+        cabecera = leida;
+        nodos = reinterpret_cast<const Nodo*>(mapeo.datos + sizeof(Cabecera)) - 1;
+        longitud = std::exchange(mapeo.bytes, 0);
+    }
+
+    /**
+     * @brief Constructor por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    mapped_map(mapped_map&& other) noexcept
+        : lt(other.lt), cabecera(std::exchange(other.cabecera, nullptr)), nodos(other.nodos),
+          longitud(std::exchange(other.longitud, 0)) {}
+
+    /** \overload */
+    mapped_map& operator=(mapped_map&& other) noexcept {
+        mapped_map copia(std::move(other));
+        std::swap(lt, copia.lt);
+        std::swap(cabecera, copia.cabecera);
+        std::swap(nodos, copia.nodos);
+        std::swap(longitud, copia.longitud);
+        return *this;
+    }
+
+    /** @brief El diccionario no se puede copiar: cada copia abriría el archivo otra vez */
+    mapped_map(const mapped_map&) = delete;
+    mapped_map& operator=(const mapped_map&) = delete;
+
+    /**
+     * @brief Destructor.  Desmapea el archivo.
+     *
+     * \complexity{\O(1)}
+     */
+    ~mapped_map() {
+        if(cabecera != nullptr) ::munmap(const_cast<Cabecera*>(cabecera), longitud);
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Observadores */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    const Meaning& at(const Key& key) const {
+        const_iterator it = find(key);
+        assert(it != end());
+        return it->second;
+    }
+
+    /**
+     * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator find(const Key& key) const {
+        const_iterator res = lower_bound(key);
+        return res != end() and not lt(key, res->first) ? res : end();
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator lower_bound(const Key& key) const {
+        uint64_t desde = 1, hasta = tamanio() + 1;
+        while(desde != hasta){
+            uint64_t medio = desde + (hasta - desde) / 2;
+            if(lt(nodos[medio].valor.first, key)){
+                desde = medio + 1;
+            }else{
+                hasta = medio;
+            }
+        }
+        return const_iterator(nodos + desde);
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor a \P{key}.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator upper_bound(const Key& key) const {
+        uint64_t desde = 1, hasta = tamanio() + 1;
+        while(desde != hasta){
+            uint64_t medio = desde + (hasta - desde) / 2;
+            if(lt(key, nodos[medio].valor.first)){
+                hasta = medio;
+            }else{
+                desde = medio + 1;
+            }
+        }
+        return const_iterator(nodos + desde);
+    }
+
+    /**
+     * @brief Indica si la clave \P{key} está definida.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    bool contains(const Key& key) const {
+        return find(key) != end();
+    }
+
+    /**
+     * @brief Devuelve 1 si la clave \P{key} está definida y 0 si no.
+     *
+     * \complexity{\O(\LOG(\a n) \CDOT \CMP(\P{*this}))}
+     */
+    size_t count(const Key& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    size_t size() const {
+        return static_cast<size_t>(tamanio());
+    }
+
+    /**
+     * @brief Indica si el diccionario es vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Devuelve una copia del comparador de claves.
+     *
+     * \complexity{\O(1)}
+     */
+    key_compare key_comp() const {
+        return lt;
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Iteradores */
+    ////////////////////////////////////////////////////
+    //@{
+    /** @brief Iterador al primer valor.  \complexity{\O(1)} */
+    const_iterator begin() const {
+        return const_iterator(nodos + 1);
+    }
+
+    /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+    const_iterator end() const {
+        return const_iterator(nodos + tamanio() + 1);
+    }
+
+    /** \overload */
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    /** \overload */
+    const_iterator cend() const {
+        return end();
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación.
+     *
+     * Función de debugging que chequea que los nodos estén ordenados.
+     *
+     * \complexity{\O(\a n \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        for(uint64_t i = 1; i < tamanio(); ++i){
+            if(not lt(nodos[i].valor.first, nodos[i + 1].valor.first)) return false;
+        }
+        return true;
+    }
+#endif
+
+    /**
+     * @brief Iterador del diccionario.  Como los nodos están en orden, avanzar y retroceder es moverse al nodo
+     * contiguo.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = mapped_map::value_type;
+        using reference = mapped_map::const_reference;
+        using pointer = mapped_map::const_pointer;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor de un iterador inválido.  \complexity{\O(1)} */
+        const_iterator() = default;
+
+        /** @brief Valor apuntado.  \pre el iterador no es pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return nodo->valor;
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return &nodo->valor;
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1)} */
+        const_iterator& operator++() {
+            ++nodo;
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator++(int) {
+            const_iterator ret = *this;
+            ++nodo;
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{\O(1)} */
+        const_iterator& operator--() {
+            --nodo;
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator--(int) {
+            const_iterator ret = *this;
+            --nodo;
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(const const_iterator& other) const {
+            return nodo == other.nodo;
+        }
+
+        /** \overload */
+        bool operator!=(const const_iterator& other) const {
+            return nodo != other.nodo;
+        }
+
+    private:
+        explicit const_iterator(const Nodo* n) : nodo(n) {}
+
+        /** \brief Nodo apuntado */
+        const Nodo* nodo{nullptr};
+        friend class mapped_map;
+    };
+
+private:
+    /**
+     * \brief Nodo guardado en el archivo.  No guarda a sus hijos: los del nodo del medio de las posiciones
+     * [\a desde, \a hasta) son los del medio de [\a desde, medio) y de [medio + 1, \a hasta).
+     */
+    struct Nodo {
+        /** \brief Valor guardado */
+        value_type valor;
+    };
+
+    /**
+     * \brief Cabecera del archivo.  Identifica el formato y la representación de los nodos, para rechazar archivos
+     * escritos con otros tipos o en otra arquitectura.
+     */
+    struct alignas(64) Cabecera {
+        /** \brief Identificador del formato */
+        char magia[8] = {'A', 'E', 'D', '2', 'M', 'A', 'P', '\0'};
+        /** \brief Versión del formato */
+        uint32_t version = 2;
+        /** \brief Marca para detectar el orden de los bytes */
+        uint32_t orden = 0x01020304;
+        /** \brief Representación de los nodos */
+        uint32_t tamanioClave = sizeof(Key), tamanioSignificado = sizeof(Meaning), tamanioNodo = sizeof(Nodo),
+                 alineacion = alignof(Nodo);
+        /** \brief Cantidad de nodos */
+        uint64_t cantidad = 0;
+
+        /** \brief Indica si \P{*this} y \P{other} describen el mismo formato, sin mirar la cantidad */
+        bool operator==(const Cabecera& other) const {
+            return std::memcmp(magia, other.magia, sizeof(magia)) == 0 and version == other.version
+                and orden == other.orden and tamanioClave == other.tamanioClave
+                and tamanioSignificado == other.tamanioSignificado and tamanioNodo == other.tamanioNodo
+                and alineacion == other.alineacion;
+        }
+    };
+
+    static_assert(alignof(Nodo) <= alignof(Cabecera), "los nodos tienen que quedar alineados después de la cabecera");
+
+    /** \brief Descriptor de archivo que se cierra al destruirse */
+    struct Archivo {
+        Archivo(int f, const std::string& r) : fd(f), ruta(r) {
+            if(fd < 0) fallar("open");
+        }
+        ~Archivo() {
+            ::close(fd);
+        }
+        Archivo(const Archivo&) = delete;
+        Archivo& operator=(const Archivo&) = delete;
+
+        /** \brief Lanza std::system_error con el errno actual */
+        [[noreturn]] void fallar(const char* operacion) const {
+            throw std::system_error(errno, std::generic_category(), "aed2::mapped_map: " + std::string(operacion) + " " + ruta);
+        }
+
+        int fd;
+        std::string ruta;
+    };
+
+    /** \brief Mapeo de un archivo que se desmapea al destruirse, salvo que se lo suelte poniendo \P{bytes} en 0 */
+    struct Mapeo {
+        Mapeo(const Archivo& archivo, size_t b, int proteccion) : bytes(b) {
+            void* p = ::mmap(nullptr, bytes, proteccion, MAP_SHARED, archivo.fd, 0);
+            if(p == MAP_FAILED) archivo.fallar("mmap");
+            datos = static_cast<char*>(p);
+        }
+        ~Mapeo() {
+            if(bytes != 0) ::munmap(datos, bytes);
+        }
+        Mapeo(const Mapeo&) = delete;
+        Mapeo& operator=(const Mapeo&) = delete;
+
+        char* datos;
+        size_t bytes;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - Si \P{cabecera} es nullptr, el diccionario fue movido y es vacío.  Si no, \P{cabecera} apunta al comienzo de
+     *   un mapeo de \P{longitud} bytes y los \P{cabecera}->cantidad nodos empiezan en \P{nodos} + 1.
+     * - Los nodos están ordenados de forma estrictamente creciente según \P{lt}.
+     * \endparblock
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /** \brief Orden total para comparar claves. */
+    Compare lt;
+    /** \brief Cabecera del archivo mapeado */
+    const Cabecera* cabecera{nullptr};
+    /** \brief Nodos del archivo, desplazados en uno para que las posiciones empiecen en 1 */
+    const Nodo* nodos{nullptr};
+    /** \brief Longitud del mapeo, en bytes */
+    size_t longitud{0};
+    //@}
+
+    /////////////////////////////////
+    /** \name Funciones auxiliares */
+    /////////////////////////////////
+    //@{
+    /** \brief Cantidad de nodos */
+    uint64_t tamanio() const {
+        return cabecera == nullptr ? 0 : cabecera->cantidad;
+    }
+    //@}
+};
+
+}
+
+#endif /* MAPPED_MAP_H_ */
@@ -0,0 +1,852 @@
+/**
+ * @file persistent_map.h
+ *
+ * Módulo C++ que implementa un diccionario ordenado persistente, cuyas copias cuestan \O(1).
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef PERSISTENT_MAP_H_
+#define PERSISTENT_MAP_H_
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <cassert>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+namespace aed2{
+
+template<class Key, class Meaning, class Compare, class Alloc>
+class concurrent_map;
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado persistente: cada modificación deja intactas las versiones
+ * anteriores, y tomar una versión (snapshot o el constructor por copia) cuesta \O(1).
+ *
+ * Copiar un aed2::map cuesta \O(\SIZE(d)), lo que es prohibitivo si se quiere, por ejemplo, una foto de un
+ * diccionario grande para un reporte consistente mientras se lo sigue modificando.  En aed2::persistent_map los
+ * nodos no se modifican nunca una vez creados:
+ * - insert, insert_or_assign y erase copian los \O(\LOG(\SIZE(d))) nodos del camino que modifican y comparten el
+ *   resto con la versión anterior.
+ * - Una copia del diccionario comparte todos los nodos con el original, así que cuesta \O(1), y las modificaciones
+ *   posteriores de cualquiera de los dos no afectan al otro.  Una copia se puede guardar todo el tiempo que haga
+ *   falta: retiene sólo los nodos que no comparte con las versiones más nuevas.
+ * - Cada nodo tiene un contador de referencias atómico, por lo que versiones que comparten nodos se pueden usar
+ *   y destruir desde hilos distintos, como un `std::shared_ptr`.
+ *
+ * El árbol es el de aed2::concurrent_map, que usa este módulo para representar sus versiones: no tiene punteros
+ * al padre y se balancea por peso (\cite HiraiYamamoto2011), para que las rotaciones sólo toquen nodos del camino o
+ * sus hijos.
+ *
+ * @tparam Key tipo de la clave.  Además de lo pedido por aed2::map, tiene que tener constructor por copia.
+ * @tparam Meaning tipo del significado.  Tiene que tener constructor por copia.
+ * @tparam Compare tipo del comparador.
+ * @tparam Alloc allocator estándar de C++ del que se obtiene la memoria de los nodos.  Como los nodos compartidos
+ * se liberan al destruir la última versión que los usa, el allocator se puede usar desde cualquier hilo que
+ * destruya o modifique una versión.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map.
+ *
+ * \par Aspectos generales de aliasing
+ * Los valores se ven sólo como referencias constantes, porque pueden pertenecer a varias versiones.  Las
+ * referencias e iteradores se mantienen válidos mientras exista alguna versión que contenga el valor sin
+ * modificar: modificar el diccionario los invalida, salvo que se haya tomado una copia antes.
+ *
+ * \par Concurrencia
+ * Se pueden hacer operaciones constantes (incluidas las copias) sobre un mismo diccionario desde varios hilos a la
+ * vez.  Modificar un diccionario requiere, como en la biblioteca estándar, que ningún otro hilo lo esté usando;
+ * las copias que tengan otros hilos no cuentan.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>,
+  class Alloc = std::allocator<std::pair<const Key, Meaning>>
+>
+class persistent_map {
+	struct Nodo;
+
+    /**
+     * \brief Cota para la altura del árbol.  En un árbol balanceado por peso con \a delta = 3, cada hijo pesa a lo
+     * sumo 3/4 de su padre, con lo cual la altura es a lo sumo log_{4/3}(2^64) < 155.
+     */
+    static constexpr int alturaMaxima = 160;
+    /** \brief Parámetro de balanceo: el peso de un hijo no supera \P{delta} veces el de su hermano */
+    static constexpr size_t delta = 3;
+    /** \brief Parámetro de balanceo: decide entre rotaciones simples y dobles */
+    static constexpr size_t gamma = 2;
+
+public:
+    //forward declarations
+    class const_iterator;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Renombre para poder acceder al tipo del allocator.  Compatible con estándar C++. */
+    using allocator_type = Alloc;
+    /** \brief Renombre para poder acceder al tipo de referencia constante de los valores guardados.  Compatible con estándar C++. */
+    using const_reference = const value_type&;
+    /** \brief Renombre para poder acceder al tipo de los punteros de los valores constantes guardados.  Compatible con estándar C++. */
+    using const_pointer = const value_type*;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+    /** \brief Los valores no se pueden modificar a través de los iteradores: iterator es const_iterator. */
+    using iterator = const_iterator;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Constructor por defecto del diccionario.  Ver aed2::map::map().
+     *
+     * \complexity{\O(1)}
+     */
+    explicit persistent_map(Compare c = Compare(), const Alloc& a = Alloc()) : lt(c), alloc(a) {}
+
+    /**
+     * @brief Constructor a partir de un rango de valores.  Si hay claves repetidas, se queda con la primera.
+     *
+     * \complexity{\O(\a n \CDOT \LOG(\a n) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type))), donde \a n es la longitud del rango}
+     */
+    template<class iterator>
+    persistent_map(iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc()) : lt(c), alloc(a) {
+        for(; first != last; ++first) insert(*first);
+    }
+
+    /**
+     * @brief Constructor por copia.  La copia comparte todos los nodos con \P{other}.
+     *
+     * \aliasing{Las modificaciones posteriores de \P{other} no afectan a la copia, ni viceversa.}
+     *
+     * \pre \aedpre{other \IGOBS d}
+     * \post \aedpost{*this \IGOBS d}
+     *
+     * \complexity{\O(1)}
+     */
+    persistent_map(const persistent_map& other) : lt(other.lt), alloc(other.alloc), raiz(ref(other.raiz)) {}
+
+    /**
+     * @brief Constructor por movimiento.  \P{other} queda vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    persistent_map(persistent_map&& other) noexcept
+        : lt(other.lt), alloc(other.alloc), raiz(std::exchange(other.raiz, nullptr)) {}
+
+    /**
+     * @brief Operador de asignación.  Ver el constructor por copia.
+     *
+     * \complexity{\O(1 \PLUS \DEL(nodos que sólo pertenecían a \P{*this}))}
+     */
+    persistent_map& operator=(const persistent_map& other) {
+        persistent_map copia(other);
+        swap(copia);
+        return *this;
+    }
+
+    /** \overload */
+    persistent_map& operator=(persistent_map&& other) noexcept {
+        persistent_map copia(std::move(other));
+        swap(copia);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor.  Libera los nodos que no comparte con otras versiones.
+     *
+     * \complexity{\O(\DEL(nodos que sólo pertenecían a \P{*this}))}
+     */
+    ~persistent_map(){
+        soltar(raiz);
+    }
+
+    /**
+     * @brief Devuelve una versión del diccionario que no cambia con las modificaciones posteriores de
+     * \P{*this}.  Equivale al constructor por copia; el nombre sólo hace explícita la intención.
+     *
+     * \complexity{\O(1)}
+     */
+    persistent_map snapshot() const {
+        return *this;
+    }
+
+    /**
+     * @brief Devuelve una copia del allocator del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    allocator_type get_allocator() const {
+        return allocator_type(alloc);
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Observadores */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+     *
+     * \pre \aedpre{def?(key, *this)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    const Meaning& at(const Key& key) const {
+        const Nodo* n = buscar(raiz, key);
+        assert(n != nullptr);
+        return n->valor.second;
+    }
+
+    /**
+     * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator find(const Key& key) const {
+        return buscarIterador(raiz, key);
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator lower_bound(const Key& key) const {
+        return primeroNoMenor(raiz, key);
+    }
+
+    /**
+     * @brief Devuelve un iterador al primer valor con clave mayor a \P{key}.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    const_iterator upper_bound(const Key& key) const {
+        return primeroMayor(raiz, key);
+    }
+
+    /**
+     * @brief Indica si la clave \P{key} está definida.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    bool contains(const Key& key) const {
+        return buscar(raiz, key) != nullptr;
+    }
+
+    /**
+     * @brief Devuelve 1 si la clave \P{key} está definida y 0 si no.
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT \CMP(\P{*this}))}
+     */
+    size_t count(const Key& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores del diccionario.
+     *
+     * \complexity{\O(1)}
+     */
+    size_t size() const {
+        return tamanio(raiz);
+    }
+
+    /**
+     * @brief Indica si el diccionario es vacío.
+     *
+     * \complexity{\O(1)}
+     */
+    bool empty() const {
+        return raiz == nullptr;
+    }
+
+    /**
+     * @brief Devuelve una copia del comparador de claves.
+     *
+     * \complexity{\O(1)}
+     */
+    key_compare key_comp() const {
+        return lt;
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Iteradores */
+    ////////////////////////////////////////////////////
+    //@{
+    /** @brief Iterador al primer valor.  \complexity{\O(\LOG(\SIZE(\P{*this})))} */
+    const_iterator begin() const {
+        return primero(raiz);
+    }
+
+    /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /** \overload */
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    /** \overload */
+    const_iterator cend() const {
+        return end();
+    }
+    //@}
+
+	//////////////////////////////////////////////
+    /** \name Modificadores */
+    //////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Inserta \P{value} si su clave no está definida.
+     *
+     * @returns true si se insertó \P{value}.
+     *
+     * \aliasing{Invalida los iteradores y referencias, salvo los de valores que pertenezcan a otra versión.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{res \IGOBS \LNOT def?(value.first, self) \LAND (res \IMPLIES_L *this \IGOBS definir(value.first, value.second, self))
+     * \LAND (\LNOT res \IMPLIES_L *this \IGOBS self)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type)))}
+     */
+    bool insert(const value_type& value) {
+        if(contains(value.first)) return false;
+        auto nuevo = [&](Nodo* izq, Nodo* der){ return crear(izq, der, value); };
+        reemplazarRaiz(insertar(raiz, value.first, nuevo));
+        return true;
+    }
+
+    /**
+     * @brief Define \P{key} con el significado \P{m}, reemplazando el anterior si la clave ya estaba definida.
+     * El valor anterior no se modifica: se crea un nodo nuevo.
+     *
+     * @returns true si la clave no estaba definida.
+     *
+     * \aliasing{Ver insert.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS definir(key, m, self) \LAND res \IGOBS \LNOT def?(key, self)}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type)))}
+     */
+    template<class M>
+    bool insert_or_assign(const Key& key, M&& m) {
+        bool nueva = not contains(key);
+        auto nuevo = [&](Nodo* izq, Nodo* der){ return crear(izq, der, key, std::forward<M>(m)); };
+        reemplazarRaiz(insertar(raiz, key, nuevo));
+        return nueva;
+    }
+
+    /**
+     * @brief Elimina el valor de clave \P{key}, si existe.
+     *
+     * @returns la cantidad de valores eliminados (0 o 1).
+     *
+     * \aliasing{Ver insert.}
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS borrar(key, self) \LAND res \IGOBS \IF def?(key, self) \THEN 1 \ELSE 0 \FI}
+     *
+     * \complexity{\O(\LOG(\SIZE(\P{*this})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type)))}
+     */
+    size_t erase(const Key& key) {
+        if(not contains(key)) return 0;
+        reemplazarRaiz(borrar(raiz, key));
+        return 1;
+    }
+
+    /**
+     * @brief Elimina todos los valores del diccionario.
+     *
+     * \aliasing{Las otras versiones no cambian.}
+     *
+     * \complexity{\O(1 \PLUS \DEL(nodos que sólo pertenecían a \P{*this}))}
+     */
+    void clear() {
+        reemplazarRaiz(nullptr);
+    }
+
+    /**
+     * @brief Intercambia los valores de \P{*this} con los de \P{other}.
+     *
+     * \complexity{\O(1)}
+     */
+    void swap(persistent_map& other) noexcept {
+        using std::swap;
+        swap(lt, other.lt);
+        swap(alloc, other.alloc);
+        swap(raiz, other.raiz);
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación.
+     *
+     * Función de debugging que chequea que las claves estén ordenadas, que los tamaños de los subárboles sean
+     * correctos y que los nodos estén balanceados por peso.
+     *
+     * \complexity{\O(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}))}
+     */
+    bool verificarRep() const {
+        return verificarNodo(raiz, nullptr, nullptr);
+    }
+#endif
+
+    /**
+     * @brief Iterador del diccionario.  Recorre los valores en orden creciente de claves.
+     *
+     * Como los nodos no tienen puntero al padre, el iterador guarda la pila de ancestros del valor apuntado cuyo
+     * valor es mayor, de modo que avanzar cuesta \O(1) amortizado.  Por eso un iterador ocupa
+     * alturaMaxima punteros: conviene no copiarlo más de lo necesario.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = persistent_map::value_type;
+        using reference = persistent_map::const_reference;
+        using pointer = persistent_map::const_pointer;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor del iterador pasando-el-último.  \complexity{\O(1)} */
+        const_iterator() {}
+
+        /** @brief Constructor por copia.  Sólo copia la parte ocupada de la pila.  \complexity{\O(\LOG(\SIZE(d)))} */
+        const_iterator(const const_iterator& other) : tope(other.tope) {
+            std::copy(other.pila, other.pila + tope, pila);
+        }
+
+        /** @brief Operador de asignación.  \complexity{\O(\LOG(\SIZE(d)))} */
+        const_iterator& operator=(const const_iterator& other) {
+            tope = other.tope;
+            std::copy(other.pila, other.pila + tope, pila);
+            return *this;
+        }
+
+        /** @brief Valor apuntado.  \pre el iterador no es pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return pila[tope - 1]->valor;
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return &**this;
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{\O(1) amortizado} */
+        const_iterator& operator++() {
+            const Nodo* n = pila[--tope]->hijo[1];
+            bajarIzquierda(n);
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator++(int) {
+            const_iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(const const_iterator& other) const {
+            return tope == other.tope and (tope == 0 or pila[tope - 1] == other.pila[tope - 1]);
+        }
+
+        /** \overload */
+        bool operator!=(const const_iterator& other) const {
+            return not (*this == other);
+        }
+
+    private:
+        /** \brief Ancestros pendientes del valor apuntado, que está en el tope */
+        const Nodo* pila[alturaMaxima];
+        /** \brief Cantidad de nodos en la pila; 0 para el iterador pasando-el-último */
+        int tope{0};
+        friend class persistent_map;
+
+        /** \brief Apila \P{n} y su camino hacia el mínimo de su subárbol */
+        void bajarIzquierda(const Nodo* n) {
+            for(; n != nullptr; n = n->hijo[0]){
+                pila[tope++] = n;
+            }
+        }
+    };
+
+private:
+    template<class, class, class, class>
+    friend class concurrent_map;
+
+    /**
+     * \brief Nodo del árbol.  Una vez creado, sólo cambia su contador de referencias.
+     */
+    struct Nodo {
+        template<class... Args>
+        Nodo(Nodo* izq, Nodo* der, Args&&... args)
+            : tamanio(persistent_map::tamanio(izq) + persistent_map::tamanio(der) + 1),
+              hijo{izq, der}, valor(std::forward<Args>(args)...) {}
+
+        /** \brief Cantidad de nodos (de cualquier versión) y de versiones que tienen a este nodo como hijo o raíz */
+        std::atomic<size_t> referencias{1};
+        /** \brief Cantidad de nodos del subárbol */
+        size_t tamanio;
+        /** \brief Hijos izquierdo y derecho */
+        Nodo* hijo[2];
+        /** \brief Valor guardado */
+        value_type valor;
+    };
+
+    using traits_nodo = typename std::allocator_traits<Alloc>::template rebind_traits<Nodo>;
+    using allocator_nodo = typename std::allocator_traits<Alloc>::template rebind_alloc<Nodo>;
+
+    /**
+     * \brief Constructor de la versión de raíz \P{r}, con el comparador y el allocator de \P{modelo}.  Agrega una
+     * referencia a \P{r}.
+     */
+    persistent_map(const persistent_map& modelo, Nodo* r) : lt(modelo.lt), alloc(modelo.alloc), raiz(ref(r)) {}
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - El árbol de raíz \P{raiz} es un ABB con respecto a \P{lt}, sin claves repetidas, y el tamaño de cada nodo es
+     *   la cantidad de nodos de su subárbol.
+     * - Cada nodo está balanceado por peso: llamando peso(t) = tamanio(t) + 1, el peso de cada hijo es a lo sumo
+     *   \P{delta} veces el peso de su hermano.
+     * - El contador de referencias de cada nodo es la cantidad de nodos vivos que lo tienen como hijo, más la cantidad
+     *   de versiones (aed2::persistent_map) que lo tienen como \P{raiz}.
+     * \endparblock
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /** \brief Orden total para comparar claves. */
+    Compare lt;
+    /** \brief Allocator del que se obtienen los nodos */
+    allocator_nodo alloc;
+    /** \brief Raíz del árbol (nullptr si es vacío) */
+    Nodo* raiz{nullptr};
+    //@}
+
+    /////////////////////////////////
+    /** \name Funciones auxiliares */
+    /////////////////////////////////
+    //@{
+    /** \brief Cantidad de nodos del subárbol de raíz \P{n} */
+    static size_t tamanio(const Nodo* n) {
+        return n == nullptr ? 0 : n->tamanio;
+    }
+
+    /** \brief Devuelve el nodo de clave \P{key} del subárbol de raíz \P{n}, o nullptr si no existe */
+    const Nodo* buscar(const Nodo* n, const Key& key) const {
+        while(n != nullptr){
+            if(lt(key, n->valor.first)){
+                n = n->hijo[0];
+            }else if(lt(n->valor.first, key)){
+                n = n->hijo[1];
+            }else{
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    /** \brief Iterador al valor de clave \P{key} del subárbol \P{n}, o pasando-el-último si no existe */
+    const_iterator buscarIterador(const Nodo* n, const Key& key) const {
+        const_iterator res = primeroNoMenor(n, key);
+        return res != end() and not lt(key, res->first) ? res : end();
+    }
+
+    /** \brief Iterador al primer valor del subárbol \P{n} con clave mayor o igual a \P{key} */
+    const_iterator primeroNoMenor(const Nodo* n, const Key& key) const {
+        const_iterator res;
+        while(n != nullptr){
+            if(lt(n->valor.first, key)){
+                n = n->hijo[1];
+            }else{
+                res.pila[res.tope++] = n;
+                n = n->hijo[0];
+            }
+        }
+        return res;
+    }
+
+    /** \brief Iterador al primer valor del subárbol \P{n} con clave mayor a \P{key} */
+    const_iterator primeroMayor(const Nodo* n, const Key& key) const {
+        const_iterator res;
+        while(n != nullptr){
+            if(lt(key, n->valor.first)){
+                res.pila[res.tope++] = n;
+                n = n->hijo[0];
+            }else{
+                n = n->hijo[1];
+            }
+        }
+        return res;
+    }
+
+    /** \brief Iterador al mínimo del subárbol \P{n} */
+    static const_iterator primero(const Nodo* n) {
+        const_iterator res;
+        res.bajarIzquierda(n);
+        return res;
+    }
+
+    /** \brief Reemplaza la raíz por \P{nueva}, cuya referencia pasa a ser de \P{*this}, y suelta la anterior */
+    void reemplazarRaiz(Nodo* nueva) {
+        soltar(std::exchange(raiz, nueva));
+    }
+
+    /**
+     * \brief Agrega una referencia a \P{n} y lo devuelve.  Alcanza con un incremento relajado: quien agrega la
+     * referencia ya tiene otra, que impide que el nodo se destruya mientras tanto.
+     */
+    static Nodo* ref(Nodo* n) {
+        if(n != nullptr) n->referencias.fetch_add(1, std::memory_order_relaxed);
+        return n;
+    }
+
+        /**
+         * \brief soltar
+         *
+         * \Descripcion Quita una referencia a \P{n}; si era la última, destruye el nodo y suelta sus hijos.  El
+         * decremento sincroniza con los de las otras referencias, para que el hilo que destruye el nodo vea
+         * todo lo que hicieron con él los hilos que lo soltaron antes.
+         *
+         * \complexity{\O(\DEL(nodos que sólo eran alcanzables desde \P{n}))}
+         */
+    void soltar(Nodo* n) {
+        while(n != nullptr and n->referencias.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            soltar(n->hijo[0]);
+            Nodo* der = n->hijo[1];
+            traits_nodo::destroy(alloc, n);
+            traits_nodo::deallocate(alloc, n, 1);
+            n = der;
+        }
+    }
+
+        /**
+         * \brief crear
+         *
+         * \Descripcion Crea un nodo con hijos \P{izq} y \P{der}, cuyo valor se construye con \P{args}.  El nodo
+         * nuevo se queda con las referencias a \P{izq} y \P{der}, que se sueltan si la construcción lanza una
+         * excepción.
+         *
+         * \complexity{\O(\COPY(value_type))}
+         */
+    template<class... Args>
+    Nodo* crear(Nodo* izq, Nodo* der, Args&&... args) {
+        Nodo* n = nullptr;
+        try {
+            n = traits_nodo::allocate(alloc, 1);
+            traits_nodo::construct(alloc, n, izq, der, std::forward<Args>(args)...);
+        } catch(...) {
+            if(n != nullptr) traits_nodo::deallocate(alloc, n, 1);
+            soltar(izq);
+            soltar(der);
+            throw;
+        }
+        return n;
+    }
+
+        /**
+         * \brief balancear
+         *
+         * \Descripcion Crea un nodo con valor \P{v} e hijos \P{izq} y \P{der}, y lo rebalancea con una rotación simple
+         * o doble si uno de los hijos pesa más de \P{delta} veces el otro.  Alcanza con una rotación si el
+         * desbalance viene de insertar o borrar un valor en un árbol balanceado (\cite HiraiYamamoto2011).  Se queda
+         * con las referencias a \P{izq} y \P{der}, aun si lanza una excepción.
+         *
+         * \complexity{\O(\COPY(value_type))}
+         */
+    Nodo* balancear(const value_type& v, Nodo* izq, Nodo* der) {
+        if(tamanio(der) + 1 > delta * (tamanio(izq) + 1)) return rotar(v, izq, der, 1);
+        if(tamanio(izq) + 1 > delta * (tamanio(der) + 1)) return rotar(v, izq, der, 0);
+        return crear(izq, der, v);
+    }
+
+        /**
+         * \brief rotar
+         *
+         * \Descripcion Idem balancear, cuando el hijo del lado \P{lado} es el pesado: si su nieto interior pesa
+         * menos de \P{gamma} veces el exterior, el hijo pesado pasa a ser la raíz; si no, el nieto interior.  El hijo
+         * pesado se reemplaza por nodos nuevos y se suelta.
+         *
+         * \complexity{\O(\COPY(value_type))}
+         */
+    Nodo* rotar(const value_type& v, Nodo* izq, Nodo* der, int lado) {
+        Nodo* pesado = lado == 1 ? der : izq;
+        Nodo* liviano = lado == 1 ? izq : der;
+        Nodo* interior = pesado->hijo[1 - lado];
+        Nodo* exterior = pesado->hijo[lado];
+        Nodo* bajo = nullptr;
+        Nodo* res;
+        try {
+            if(tamanio(interior) + 1 < gamma * (tamanio(exterior) + 1)){
+                bajo = crearOrientado(lado, liviano, ref(interior), v);
+                res = crearOrientado(lado, std::exchange(bajo, nullptr), ref(exterior), pesado->valor);
+            }else{
+                bajo = crearOrientado(lado, liviano, ref(interior->hijo[1 - lado]), v);
+                Nodo* alto = crearOrientado(lado, ref(interior->hijo[lado]), ref(exterior), pesado->valor);
+                res = crearOrientado(lado, std::exchange(bajo, nullptr), alto, interior->valor);
+            }
+        } catch(...) {
+            soltar(bajo);
+            soltar(pesado);
+            throw;
+        }
+        soltar(pesado);
+        return res;
+    }
+
+    /** \brief Crea un nodo con valor \P{v}, el hijo \P{opuesto} del lado 1 - \P{lado} y el hijo \P{mismo} del lado \P{lado}.  Ver crear. */
+    Nodo* crearOrientado(int lado, Nodo* opuesto, Nodo* mismo, const value_type& v) {
+        return lado == 1 ? crear(opuesto, mismo, v) : crear(mismo, opuesto, v);
+    }
+
+        /**
+         * \brief insertar
+         *
+         * \Descripcion Devuelve un árbol nuevo con los valores del subárbol \P{n} y el valor que construye
+         * \P{nuevo}(izq, der) en el lugar de la clave \P{key}, reemplazando al existente si lo hay.  Se copian los
+         * nodos del camino de búsqueda; el resto se comparte con \P{n}, que no se modifica.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{n})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type)))}
+         */
+    template<class Nuevo>
+    Nodo* insertar(Nodo* n, const Key& key, Nuevo& nuevo) {
+        if(n == nullptr) return nuevo(nullptr, nullptr);
+        int lado;
+        if(lt(key, n->valor.first)){
+            lado = 0;
+        }else if(lt(n->valor.first, key)){
+            lado = 1;
+        }else{
+            return nuevo(ref(n->hijo[0]), ref(n->hijo[1]));
+        }
+        Nodo* hijo = insertar(n->hijo[lado], key, nuevo);
+        Nodo* otro = ref(n->hijo[1 - lado]);
+        return lado == 0 ? balancear(n->valor, hijo, otro) : balancear(n->valor, otro, hijo);
+    }
+
+        /**
+         * \brief borrar
+         *
+         * \Descripcion Devuelve un árbol nuevo con los valores del subárbol \P{n} salvo el de clave \P{key}, copiando
+         * los nodos del camino de búsqueda.
+         *
+         * \pre La clave \P{key} está en el subárbol \P{n}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{n})) \CDOT (\CMP(\P{*this}) \PLUS \COPY(value_type)))}
+         */
+    Nodo* borrar(Nodo* n, const Key& key) {
+        int lado;
+        if(lt(key, n->valor.first)){
+            lado = 0;
+        }else if(lt(n->valor.first, key)){
+            lado = 1;
+        }else{
+            return pegar(ref(n->hijo[0]), ref(n->hijo[1]));
+        }
+        Nodo* hijo = borrar(n->hijo[lado], key);
+        Nodo* otro = ref(n->hijo[1 - lado]);
+        return lado == 0 ? balancear(n->valor, hijo, otro) : balancear(n->valor, otro, hijo);
+    }
+
+        /**
+         * \brief pegar
+         *
+         * \Descripcion Devuelve un árbol con los valores de \P{izq} y de \P{der}, cuyas claves son todas menores que
+         * las de \P{der} y cuyos pesos difieren a lo sumo en un factor \P{delta}: el valor extremo del más pesado
+         * pasa a ser la raíz.  Se queda con las referencias a \P{izq} y \P{der}.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{izq}) \PLUS \SIZE(\P{der})) \CDOT \COPY(value_type))}
+         */
+    Nodo* pegar(Nodo* izq, Nodo* der) {
+        if(izq == nullptr) return der;
+        if(der == nullptr) return izq;
+        int lado = tamanio(izq) > tamanio(der) ? 0 : 1;
+        Nodo* pesado = lado == 0 ? izq : der;
+        Nodo* liviano = lado == 0 ? der : izq;
+        const Nodo* extremo = pesado;
+        while(extremo->hijo[1 - lado] != nullptr) extremo = extremo->hijo[1 - lado];
+        Nodo* resto;
+        try {
+            resto = sacarExtremo(pesado, 1 - lado);
+        } catch(...) {
+            soltar(pesado);
+            soltar(liviano);
+            throw;
+        }
+        Nodo* res;
+        try {
+            res = lado == 0 ? balancear(extremo->valor, resto, liviano) : balancear(extremo->valor, liviano, resto);
+        } catch(...) {
+            soltar(pesado);
+            throw;
+        }
+        soltar(pesado);
+        return res;
+    }
+
+        /**
+         * \brief sacarExtremo
+         *
+         * \Descripcion Devuelve un árbol nuevo con los valores del subárbol \P{n} salvo el mínimo, si \P{lado} es 0,
+         * o el máximo, si \P{lado} es 1.
+         *
+         * \complexity{\O(\LOG(\SIZE(\P{n})) \CDOT \COPY(value_type))}
+         */
+    Nodo* sacarExtremo(Nodo* n, int lado) {
+        if(n->hijo[lado] == nullptr) return ref(n->hijo[1 - lado]);
+        Nodo* hijo = sacarExtremo(n->hijo[lado], lado);
+        Nodo* otro = ref(n->hijo[1 - lado]);
+        return lado == 0 ? balancear(n->valor, hijo, otro) : balancear(n->valor, otro, hijo);
+    }
+
+#ifdef DEBUG
+    /** \brief Verifica el invariante en el subárbol \P{n}, cuyas claves tienen que estar entre \P{min} y \P{max} (si no son nulos) */
+    bool verificarNodo(const Nodo* n, const Key* min, const Key* max) const {
+        if(n == nullptr) return true;
+        if((min != nullptr and not lt(*min, n->valor.first)) or (max != nullptr and not lt(n->valor.first, *max))){
+            return false;
+        }
+        size_t izq = tamanio(n->hijo[0]) + 1, der = tamanio(n->hijo[1]) + 1;
+        return n->referencias.load() > 0 and n->tamanio == izq + der - 1 and izq <= delta * der and der <= delta * izq
+            and verificarNodo(n->hijo[0], min, &n->valor.first) and verificarNodo(n->hijo[1], &n->valor.first, max);
+    }
+#endif
+    //@}
+};
+
+/**
+ * @brief Intercambia los valores de \P{a} y \P{b}.  Ver aed2::persistent_map::swap.
+ *
+ * \complexity{\O(1)}
+ */
+template<class K, class M, class C, class A>
+void swap(persistent_map<K, M, C, A>& a, persistent_map<K, M, C, A>& b) noexcept {
+    a.swap(b);
+}
+
+}
+
+#endif /* PERSISTENT_MAP_H_ */
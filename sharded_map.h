@@ -0,0 +1,551 @@
+/**
+ * @file sharded_map.h
+ *
+ * Módulo C++ que implementa un diccionario ordenado repartido en fragmentos por rangos de claves, cada uno con su
+ * propio lock, para que varios hilos puedan escribir a la vez.
+ *
+ * Algoritmos y Estructuras de Datos II -- FCEN -- UBA.
+ */
+#ifndef SHARDED_MAP_H_
+#define SHARDED_MAP_H_
+
+#include "map.h"
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <cstddef>
+
+namespace aed2{
+
+/**
+ * @brief Módulo que implementa un diccionario ordenado repartido en fragmentos, para escrituras concurrentes.
+ *
+ * En aed2::concurrent_map las lecturas no se bloquean, pero las escrituras se ejecutan de a una.  Cuando casi todo
+ * son escrituras, aed2::sharded_map reparte las claves en \a F fragmentos según rangos fijos: el fragmento i tiene
+ * las claves k con limites[i - 1] \LEQ k \LT limites[i].  Cada fragmento es un aed2::map con su propio pool de nodos
+ * y su propio lock (un std::shared_mutex), de modo que dos escrituras sobre fragmentos distintos no se esperan, y
+ * dos lecturas nunca se esperan entre sí.  Como los fragmentos son rangos consecutivos, recorrer el diccionario en
+ * orden es recorrer los fragmentos de a uno, y lower_bound sólo mira el fragmento de la clave y, si no encuentra
+ * nada ahí, los siguientes.
+ *
+ * Las escrituras escalan con la cantidad de hilos en la medida en que las claves se repartan entre los
+ * fragmentos: los límites se pueden dar explícitamente o elegir a partir de una muestra de las claves esperadas.
+ *
+ * @tparam Key tipo de la clave.  Además de lo pedido por aed2::map, tiene que tener constructor por copia (para los
+ * límites).
+ * @tparam Meaning tipo del significado.
+ * @tparam Compare tipo del comparador.  Se usa desde varios hilos a la vez, por lo que no puede tener estado
+ * mutable sin sincronizar.
+ * @tparam Alloc allocator estándar de C++ del que se obtiene la memoria de los nodos.  Cada fragmento tiene su
+ * propia copia.
+ *
+ * \par Terminología para describir las complejidades temporales
+ * Idem aed2::map; además, llamamos \a F a la cantidad de fragmentos.
+ *
+ * \par Aspectos generales de aliasing
+ * Las operaciones de aed2::sharded_map no devuelven referencias a los valores.  Para buscar y recorrer se usa una
+ * vista (aed2::sharded_map::reader), que mantiene tomados en modo compartido los locks de todos los fragmentos:
+ * sus iteradores y referencias son válidos mientras exista la vista, y las escrituras esperan a que se destruya.
+ *
+ * \par Se explica con
+ * Diccionario(\T{Key}, \T{Meaning}) con parámetro formal \LT = f.operator() para algún f de tipo \T{Compare}.
+ */
+template<
+  class Key,
+  class Meaning,
+  class Compare = std::less<Key>,
+  class Alloc = std::allocator<std::pair<const Key, Meaning>>
+>
+class sharded_map {
+public:
+    /** \brief Tipo de cada fragmento */
+    using shard_type = map<Key, Meaning, Compare, Alloc>;
+
+    //forward declarations
+    class const_iterator;
+    class reader;
+
+    /** \brief Renombre para poder acceder al tipo de las claves.  Compatible con estándar C++. */
+    using key_type = Key;
+    /** \brief Renombre para poder acceder al tipo de los significados.  Compatible con estándar C++. */
+    using mapped_type = Meaning;
+    /** \brief Renombre para poder acceder al tipo de las valores almacenados.  Compatible con estándar C++. */
+    using value_type = std::pair<const Key, Meaning>;
+    /** \brief Renombre para poder acceder al tipo del comparador.  Compatible con estándar C++. */
+    using key_compare = Compare;
+    /** \brief Renombre para poder acceder al tipo del allocator.  Compatible con estándar C++. */
+    using allocator_type = Alloc;
+    /** \brief Renombre para poder acceder al tipo de referencia constante de los valores guardados.  Compatible con estándar C++. */
+    using const_reference = const value_type&;
+    /** \brief Renombre para poder acceder al tipo de los punteros de los valores constantes guardados.  Compatible con estándar C++. */
+    using const_pointer = const value_type*;
+    /** \brief Renombre para poder acceder al tipo usado para describir tamaños.  Compatible con estándar C++. */
+    using size_type = std::size_t;
+    /** \brief Renombre para poder acceder al tipo usado para describir diferencias entre punteros.  Compatible con estándar C++. */
+    using difference_type = std::ptrdiff_t;
+
+    ///////////////////////////////////////////////////////////
+    /** \name Construcción y destrucción */
+    ///////////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Constructor con los límites entre fragmentos.
+     *
+     * Se crean \SIZE(\P{limites}) + 1 fragmentos: el fragmento i tiene las claves k tales que
+     * \P{limites}[i - 1] \LEQ k (si i > 0) y k \LT \P{limites}[i] (si i < \SIZE(\P{limites})).
+     *
+     * \pre Los límites están ordenados en forma estricta con respecto a \P{c}.
+     *
+     * \complexity{\O(\SIZE(\P{limites}))}
+     */
+    explicit sharded_map(std::vector<Key> limites, Compare c = Compare(), const Alloc& a = Alloc())
+        : lt(c), limites(std::move(limites)) {
+        crearFragmentos(a);
+    }
+
+    /**
+     * @brief Constructor que elige los límites a partir de una muestra de claves.
+     *
+     * Los límites son los cuantiles de la muestra, de modo que, si las claves que se inserten se distribuyen como
+     * la muestra, cada uno de los a lo sumo \P{fragmentos} fragmentos recibe aproximadamente la misma cantidad.
+     * Las claves repetidas de la muestra se descartan, con lo cual puede haber menos fragmentos.  La muestra no se
+     * inserta.
+     *
+     * \pre \P{fragmentos} > 0.
+     *
+     * \complexity{\O(\a m \CDOT \LOG(\a m) \CDOT \CMP(\P{*this}) \PLUS \a m \CDOT \COPY(key_type)), donde \a m es la longitud de la muestra}
+     */
+    template<class iterator>
+    sharded_map(size_t fragmentos, iterator first, iterator last, Compare c = Compare(), const Alloc& a = Alloc())
+        : lt(c) {
+        std::vector<Key> muestra(first, last);
+        std::sort(muestra.begin(), muestra.end(), lt);
+        for(size_t i = 1; i < fragmentos; ++i){
+            size_t j = i * muestra.size() / fragmentos;
+            if(j > 0 and (limites.empty() or lt(limites.back(), muestra[j]))){
+                limites.push_back(muestra[j]);
+            }
+        }
+        crearFragmentos(a);
+    }
+
+    sharded_map(const sharded_map&) = delete;
+    sharded_map& operator=(const sharded_map&) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * \pre Ningún otro hilo está usando el diccionario ni tiene vistas suyas.
+     *
+     * \complexity{\O(\DEL(\P{*this}) \PLUS \a F)}
+     */
+    ~sharded_map() = default;
+
+    /**
+     * @brief Devuelve la cantidad de fragmentos.
+     *
+     * \complexity{\O(1)}
+     */
+    size_t shard_count() const {
+        return limites.size() + 1;
+    }
+
+    /**
+     * @brief Devuelve el índice del fragmento al que pertenece la clave \P{key}.
+     *
+     * \complexity{\O(\LOG(\a F) \CDOT \CMP(\P{*this}))}
+     */
+    size_t shard_of(const Key& key) const {
+        return std::upper_bound(limites.begin(), limites.end(), key, lt) - limites.begin();
+    }
+    //@}
+
+    ////////////////////////////////////////////////////
+    /** \name Lectura */
+    ////////////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Devuelve una vista del diccionario, que toma en modo compartido los locks de todos los fragmentos.
+     *
+     * \aliasing{Mientras exista la vista, las escrituras esperan.}
+     *
+     * \complexity{\O(\a F) más la espera de las escrituras en curso}
+     */
+    reader read() const {
+        return reader(this);
+    }
+
+    /**
+     * @brief Indica si la clave \P{key} está definida.  Sólo toma el lock del fragmento de \P{key}.
+     *
+     * \complexity{\O(\LOG(\a F) \CDOT \CMP(\P{*this}) \PLUS \LOG(\SIZE(fragmento)) \CDOT \CMP(\P{*this})), más la espera del lock}
+     */
+    bool contains(const Key& key) const {
+        const Fragmento& f = *fragmentos[shard_of(key)];
+        std::shared_lock<std::shared_mutex> lock(f.mutex);
+        return f.dicc.find(key) != f.dicc.end();
+    }
+
+    /** @brief Devuelve 1 si la clave \P{key} está definida y 0 si no.  Idem contains. */
+    size_t count(const Key& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de valores.  Toma los locks de los fragmentos de a uno, con lo cual, si hay
+     * escrituras concurrentes, el resultado puede no corresponder a ningún instante; read().size() sí.
+     *
+     * \complexity{\O(\a F), más la espera de los locks}
+     */
+    size_t size() const {
+        size_t res = 0;
+        for(size_t i = 0; i < shard_count(); ++i){
+            std::shared_lock<std::shared_mutex> lock(fragmentos[i]->mutex);
+            res += fragmentos[i]->dicc.size();
+        }
+        return res;
+    }
+
+    /** @brief Indica si el diccionario es vacío.  Idem size. */
+    bool empty() const {
+        return size() == 0;
+    }
+    //@}
+
+	//////////////////////////////////////////////
+    /** \name Escritura */
+    //////////////////////////////////////////////
+    //@{
+    /**
+     * @brief Inserta \P{value} si su clave no está definida.  Sólo toma el lock del fragmento de la clave.
+     *
+     * @returns true si se insertó \P{value}.
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{res \IGOBS \LNOT def?(value.first, self) \LAND (res \IMPLIES_L *this \IGOBS definir(value.first, value.second, self))
+     * \LAND (\LNOT res \IMPLIES_L *this \IGOBS self)}
+     *
+     * \complexity{\O(\LOG(\a F) \CDOT \CMP(\P{*this})) más el costo de aed2::map::insert en el fragmento y la espera del lock}
+     */
+    bool insert(const value_type& value) {
+        Fragmento& f = *fragmentos[shard_of(value.first)];
+        std::unique_lock<std::shared_mutex> lock(f.mutex);
+        size_t antes = f.dicc.size();
+        f.dicc.insert(value);
+        return f.dicc.size() != antes;
+    }
+
+    /** \overload */
+    bool insert(value_type&& value) {
+        Fragmento& f = *fragmentos[shard_of(value.first)];
+        std::unique_lock<std::shared_mutex> lock(f.mutex);
+        size_t antes = f.dicc.size();
+        f.dicc.insert(std::move(value));
+        return f.dicc.size() != antes;
+    }
+
+    /**
+     * @brief Define \P{key} con el significado \P{m}, reemplazando el anterior si la clave ya estaba definida.
+     *
+     * @returns true si la clave no estaba definida.
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS definir(key, m, self) \LAND res \IGOBS \LNOT def?(key, self)}
+     *
+     * \complexity{\O(\LOG(\a F) \CDOT \CMP(\P{*this})) más el costo de aed2::map::insert_or_assign en el fragmento y la espera del lock}
+     */
+    template<class M>
+    bool insert_or_assign(const Key& key, M&& m) {
+        Fragmento& f = *fragmentos[shard_of(key)];
+        std::unique_lock<std::shared_mutex> lock(f.mutex);
+        size_t antes = f.dicc.size();
+        f.dicc.insert_or_assign(key, std::forward<M>(m));
+        return f.dicc.size() != antes;
+    }
+
+    /**
+     * @brief Elimina el valor de clave \P{key}, si existe.
+     *
+     * @returns la cantidad de valores eliminados (0 o 1).
+     *
+     * \pre \aedpre{*this \IGOBS self}
+     * \post \aedpost{*this \IGOBS borrar(key, self) \LAND res \IGOBS \IF def?(key, self) \THEN 1 \ELSE 0 \FI}
+     *
+     * \complexity{\O(\LOG(\a F) \CDOT \CMP(\P{*this})) más el costo de aed2::map::erase en el fragmento y la espera del lock}
+     */
+    size_t erase(const Key& key) {
+        Fragmento& f = *fragmentos[shard_of(key)];
+        std::unique_lock<std::shared_mutex> lock(f.mutex);
+        auto it = f.dicc.find(key);
+        if(it == f.dicc.end()) return 0;
+        f.dicc.erase(it);
+        return 1;
+    }
+
+    /**
+     * @brief Elimina todos los valores.  Vacía los fragmentos de a uno.
+     *
+     * \complexity{\O(\DEL(\P{*this}) \PLUS \a F), más la espera de los locks}
+     */
+    void clear() {
+        for(size_t i = 0; i < shard_count(); ++i){
+            std::unique_lock<std::shared_mutex> lock(fragmentos[i]->mutex);
+            fragmentos[i]->dicc.clear();
+        }
+    }
+    //@}
+
+#ifdef DEBUG
+    /**
+     * @brief Verifica el invariante de representación: cada fragmento cumple el de aed2::map y sus claves están
+     * en su rango.
+     *
+     * \pre No hay escrituras concurrentes.
+     *
+     * \complexity{\O(\SIZE(\P{*this}) \CDOT \CMP(\P{*this}) \PLUS \a F)}
+     */
+    bool verificarRep() const {
+        for(size_t i = 1; i < limites.size(); ++i){
+            if(not lt(limites[i - 1], limites[i])) return false;
+        }
+        for(size_t i = 0; i < shard_count(); ++i){
+            const shard_type& d = fragmentos[i]->dicc;
+            if(not d.verificarRep()) return false;
+            if(d.empty()) continue;
+            if(i > 0 and lt(d.begin()->first, limites[i - 1])) return false;
+            if(i < limites.size() and not lt(std::prev(d.end())->first, limites[i])) return false;
+        }
+        return true;
+    }
+#endif
+
+    /**
+     * @brief Iterador de una vista.  Recorre los fragmentos en orden, concatenando sus recorridos.
+     *
+     * \aliasing{El iterador es válido mientras exista la vista que lo devolvió.}
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = sharded_map::value_type;
+        using reference = sharded_map::const_reference;
+        using pointer = sharded_map::const_pointer;
+        using difference_type = std::ptrdiff_t;
+
+        /** @brief Constructor del iterador nulo.  \complexity{\O(1)} */
+        const_iterator() {}
+
+        /** @brief Valor apuntado.  \pre el iterador no es nulo ni pasando-el-último.  \complexity{\O(1)} */
+        reference operator*() const {
+            return *it;
+        }
+
+        /** \overload */
+        pointer operator->() const {
+            return &*it;
+        }
+
+        /** @brief Avanza al siguiente valor.  \complexity{idem aed2::map::const_iterator, más \O(\a F) si hay fragmentos vacíos} */
+        const_iterator& operator++() {
+            ++it;
+            normalizar();
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator++(int) {
+            const_iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        /** @brief Retrocede al valor anterior.  \complexity{idem operator++} */
+        const_iterator& operator--() {
+            while(it == dicc->fragmentos[i]->dicc.begin()){
+                --i;
+                it = dicc->fragmentos[i]->dicc.end();
+            }
+            --it;
+            return *this;
+        }
+
+        /** \overload */
+        const_iterator operator--(int) {
+            const_iterator ret = *this;
+            --*this;
+            return ret;
+        }
+
+        /** @brief Igualdad de iteradores.  \complexity{\O(1)} */
+        bool operator==(const const_iterator& other) const {
+            return i == other.i and it == other.it;
+        }
+
+        /** \overload */
+        bool operator!=(const const_iterator& other) const {
+            return not (*this == other);
+        }
+
+    private:
+        const_iterator(const sharded_map* d, size_t fragmento, typename shard_type::const_iterator pos)
+            : dicc(d), i(fragmento), it(pos) {
+            normalizar();
+        }
+
+        /**
+         * \brief Si el iterador está al final de un fragmento que no es el último, lo pasa al principio del
+         * siguiente fragmento no vacío, o al final del último.  Así, cada posición tiene un único representante.
+         */
+        void normalizar() {
+            while(i + 1 < dicc->shard_count() and it == dicc->fragmentos[i]->dicc.end()){
+                ++i;
+                it = dicc->fragmentos[i]->dicc.begin();
+            }
+        }
+
+        /** \brief Diccionario recorrido */
+        const sharded_map* dicc{nullptr};
+        /** \brief Fragmento de la posición apuntada */
+        size_t i{0};
+        /** \brief Posición dentro del fragmento */
+        typename shard_type::const_iterator it;
+        friend class sharded_map;
+    };
+
+    /**
+     * @brief Vista del diccionario.
+     *
+     * Una vista toma en modo compartido los locks de todos los fragmentos (en orden, para no trabarse con otras
+     * vistas) y ofrece la interfaz de búsqueda y recorrido de un aed2::map constante.  Varias vistas pueden existir
+     * a la vez; las escrituras esperan a que se destruyan todas.  Una vista no se puede copiar, pero se puede mover.
+     */
+    class reader {
+    public:
+        reader(reader&&) = default;
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+
+        /**
+         * @brief Devuelve el significado de la clave \P{key}.  Ver aed2::map::at.
+         *
+         * \pre \aedpre{def?(key, *this)}
+         *
+         * \complexity{\O(\LOG(\a F) \CDOT \CMP(\P{*this}) \PLUS \LOG(\SIZE(fragmento)) \CDOT \CMP(\P{*this}))}
+         */
+        const Meaning& at(const Key& key) const {
+            return find(key)->second;
+        }
+
+        /**
+         * @brief Devuelve un iterador al valor de clave \P{key}, o end() si no existe.  Ver aed2::map::find.
+         *
+         * \complexity{idem at}
+         */
+        const_iterator find(const Key& key) const {
+            size_t i = dicc->shard_of(key);
+            auto it = dicc->fragmentos[i]->dicc.find(key);
+            return it == dicc->fragmentos[i]->dicc.end() ? end() : const_iterator(dicc, i, it);
+        }
+
+        /**
+         * @brief Devuelve un iterador al primer valor con clave mayor o igual a \P{key}.  Ver aed2::map::lower_bound.
+         *
+         * \complexity{idem at, más \O(\a F) si los fragmentos siguientes están vacíos}
+         */
+        const_iterator lower_bound(const Key& key) const {
+            size_t i = dicc->shard_of(key);
+            return const_iterator(dicc, i, dicc->fragmentos[i]->dicc.lower_bound(key));
+        }
+
+        /** @brief Indica si la clave \P{key} está definida.  \complexity{idem at} */
+        bool contains(const Key& key) const {
+            size_t i = dicc->shard_of(key);
+            return dicc->fragmentos[i]->dicc.find(key) != dicc->fragmentos[i]->dicc.end();
+        }
+
+        /** @brief Devuelve 1 si la clave \P{key} está definida y 0 si no.  \complexity{idem at} */
+        size_t count(const Key& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        /** @brief Devuelve la cantidad de valores.  \complexity{\O(\a F)} */
+        size_t size() const {
+            size_t res = 0;
+            for(size_t i = 0; i < dicc->shard_count(); ++i) res += dicc->fragmentos[i]->dicc.size();
+            return res;
+        }
+
+        /** @brief Indica si el diccionario es vacío.  \complexity{\O(\a F)} */
+        bool empty() const {
+            return begin() == end();
+        }
+
+        /** @brief Iterador al primer valor.  \complexity{\O(\a F) en peor caso} */
+        const_iterator begin() const {
+            return const_iterator(dicc, 0, dicc->fragmentos[0]->dicc.begin());
+        }
+
+        /** @brief Iterador a la posición pasando-el-último.  \complexity{\O(1)} */
+        const_iterator end() const {
+            size_t ultimo = dicc->shard_count() - 1;
+            return const_iterator(dicc, ultimo, dicc->fragmentos[ultimo]->dicc.end());
+        }
+
+    private:
+        explicit reader(const sharded_map* d) : dicc(d) {
+            locks.reserve(dicc->shard_count());
+            for(size_t i = 0; i < dicc->shard_count(); ++i) locks.emplace_back(dicc->fragmentos[i]->mutex);
+        }
+
+        /** \brief Diccionario visto */
+        const sharded_map* dicc;
+        /** \brief Locks compartidos de todos los fragmentos, que se liberan al destruir la vista */
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        friend class sharded_map;
+    };
+
+private:
+    /** \brief Fragmento: un diccionario con su lock, en sus propias líneas de cache para que los hilos no compitan */
+    struct alignas(64) Fragmento {
+        explicit Fragmento(const Compare& c, const Alloc& a) : dicc(c, a) {}
+
+        mutable std::shared_mutex mutex;
+        shard_type dicc;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \name Estructura de representación
+     *
+     * \par Invariante de representación
+     * \parblock
+     * - \P{limites} está ordenado en forma estricta con respecto a \P{lt}, y hay \SIZE(\P{limites}) + 1 fragmentos.
+     * - Cada fragmento cumple el invariante de aed2::map, con comparador \P{lt}, y todas las claves k del fragmento i
+     *   cumplen \P{limites}[i - 1] \LEQ k (si i > 0) y k \LT \P{limites}[i] (si i < \SIZE(\P{limites})).
+     * \endparblock
+     */
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    //@{
+    /** \brief Orden total para comparar claves. */
+    Compare lt;
+    /** \brief Límites entre fragmentos consecutivos */
+    std::vector<Key> limites;
+    /** \brief Fragmentos, en orden de claves */
+    std::vector<std::unique_ptr<Fragmento>> fragmentos;
+    //@}
+
+    /** \brief Crea los \SIZE(\P{limites}) + 1 fragmentos, vacíos */
+    void crearFragmentos(const Alloc& a) {
+        fragmentos.reserve(shard_count());
+        for(size_t i = 0; i < shard_count(); ++i) fragmentos.push_back(std::make_unique<Fragmento>(lt, a));
+    }
+};
+
+}
+
+#endif /* SHARDED_MAP_H_ */
@@ -1,9 +1,27 @@
 #define DEBUG
 #include "map.h"
+#include "btree_map.h"
+#include "persistent_map.h"
+#include "concurrent_map.h"
+#include "sharded_map.h"
+#include "mapped_map.h"
+#include "flat_map.h"
+#include "frozen_map.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <iostream>
+#include <random>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <string_view>
+#include <functional>
 
 ////////////////////////////////////
 // Estructuras básicas de testing //
@@ -411,6 +429,2201 @@ TEST_F(BasicMapInstances, MapDeMap) {
 	EXPECT_EQ(it->first, cinco_elementos);
 }
 
+////////////////////
+// Pool de nodos  //
+////////////////////
+
+/**
+ * @brief Allocator que cuenta los pedidos de memoria, para verificar que el
+ * pool de aed2::map recicla los nodos borrados.
+ */
+template<class T>
+struct ContadorAllocator
+{
+	using value_type = T;
+
+	ContadorAllocator(size_t* pedidos) : pedidos_( pedidos ) {}
+
+	template<class U>
+	ContadorAllocator(const ContadorAllocator<U>& other) : pedidos_( other.pedidos_ ) {}
+
+	T* allocate(size_t n)
+	{
+		++*pedidos_;
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, size_t n)
+	{ std::allocator<T>().deallocate(p, n); }
+
+	size_t* pedidos_;
+};
+
+template<class T, class U>
+bool operator == (const ContadorAllocator<T>& a, const ContadorAllocator<U>& b)
+{ return a.pedidos_ == b.pedidos_; }
+
+template<class T, class U>
+bool operator != (const ContadorAllocator<T>& a, const ContadorAllocator<U>& b)
+{ return not (a == b); }
+
+TEST(PoolDeNodos, ReutilizaNodosBorrados) {
+	using Alloc = ContadorAllocator<std::pair<const int, int>>;
+	size_t pedidos = 0;
+	aed2::map<int, int, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&pedidos));
+
+	for(int i = 0; i < 1000; ++i) dicc.insert({i, i});
+	size_t pedidos_llenado = pedidos;
+	// los slabs crecen geometricamente: muchos menos pedidos que nodos
+	EXPECT_LT(pedidos_llenado, 50);
+
+	for(int ronda = 0; ronda < 10; ++ronda) {
+		for(int i = 0; i < 1000; i += 2) dicc.erase(i);
+		for(int i = 0; i < 1000; i += 2) dicc.insert({i, ronda});
+	}
+	EXPECT_EQ(pedidos, pedidos_llenado);
+	EXPECT_EQ(dicc.size(), 1000);
+	EXPECT_EQ(dicc.at(998), 9);
+	EXPECT_EQ(dicc.at(999), 999);
+}
+
+TEST(PoolDeNodos, ClearDevuelveLosNodosAlPool) {
+	using Alloc = ContadorAllocator<std::pair<const int, std::string>>;
+	size_t pedidos = 0;
+	aed2::map<int, std::string, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&pedidos));
+
+	for(int i = 0; i < 500; ++i) dicc.insert({i, std::to_string(i)});
+	size_t pedidos_llenado = pedidos;
+
+	dicc.clear();
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_EQ(dicc.begin(), dicc.end());
+
+	for(int i = 500; i > 0; --i) dicc.insert({i, std::to_string(i)});
+	EXPECT_EQ(pedidos, pedidos_llenado);
+	EXPECT_EQ(dicc.size(), 500);
+	EXPECT_EQ(dicc.begin()->second, "1");
+	EXPECT_EQ(dicc.rbegin()->second, "500");
+}
+
+TEST(PoolDeNodos, SwapIntercambiaPools) {
+	aed2::map<int, std::string> a, b;
+	for(int i = 0; i < 100; ++i) a.insert({i, "a"});
+	b.insert({1, "b"});
+	a.swap(b);
+	a.erase(1);
+	b.erase(50);
+	EXPECT_TRUE(a.empty());
+	EXPECT_EQ(b.size(), 99);
+}
+
+///////////////////////
+// Copia estructural //
+///////////////////////
+
+/**
+ * @brief Comparador de enteros que cuenta cuántas veces se lo invoca.
+ */
+struct ContadorCompare
+{
+	ContadorCompare(size_t* comparaciones = nullptr) : comparaciones_( comparaciones ) {}
+
+	bool operator () (int a, int b) const
+	{
+		if(comparaciones_ != nullptr) ++*comparaciones_;
+		return a < b;
+	}
+
+	size_t* comparaciones_;
+};
+
+TEST(CopiaEstructural, NoCompara) {
+	size_t comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> dicc(ContadorCompare{&comparaciones});
+	for(int i = 0; i < 1000; ++i) dicc.insert({(i * 7919) % 1000, i});
+
+	comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> copia(dicc);
+	EXPECT_EQ(comparaciones, 0);
+	EXPECT_EQ(copia, dicc);
+
+	aed2::map<int, int, ContadorCompare> asignada;
+	asignada = dicc;
+	EXPECT_EQ(comparaciones, 0);
+	EXPECT_EQ(asignada, dicc);
+
+	// las copias son independientes y siguen siendo árboles válidos
+	for(int i = 0; i < 1000; i += 3) copia.erase(i);
+	for(int i = 1000; i < 1100; ++i) asignada.insert({i, i});
+	EXPECT_EQ(copia.size(), 666);
+	EXPECT_EQ(asignada.size(), 1100);
+	EXPECT_EQ(dicc.size(), 1000);
+	EXPECT_TRUE(std::is_sorted(asignada.begin(), asignada.end()));
+}
+
+TEST(CopiaEstructural, AsignacionReutilizaNodos) {
+	using Alloc = ContadorAllocator<std::pair<const int, std::string>>;
+	size_t pedidos = 0;
+	aed2::map<int, std::string, std::less<int>, Alloc> grande(std::less<int>{}, Alloc(&pedidos));
+	aed2::map<int, std::string, std::less<int>, Alloc> chico(std::less<int>{}, Alloc(&pedidos));
+	for(int i = 0; i < 300; ++i) grande.insert({i, "grande"});
+	for(int i = 0; i < 100; ++i) chico.insert({i, "chico"});
+
+	size_t pedidos_antes = pedidos;
+	grande = chico;
+	EXPECT_EQ(pedidos, pedidos_antes);
+	EXPECT_EQ(grande, chico);
+
+	grande = grande;
+	EXPECT_EQ(grande, chico);
+}
+
+//////////////////////////////////////////
+// Movimiento y construcción en el lugar //
+//////////////////////////////////////////
+
+/**
+ * @brief Tipo que cuenta cuántas copias y construcciones se hicieron.
+ */
+struct Contado
+{
+	static int copias;
+	static int construcciones;
+
+	Contado(int v = 0) : v_( v ) { ++construcciones; }
+	Contado(const Contado& other) : v_( other.v_ ) { ++copias; }
+	Contado(Contado&& other) : v_( other.v_ ) {}
+	Contado& operator = (const Contado& other) { v_ = other.v_; ++copias; return *this; }
+	Contado& operator = (Contado&& other) { v_ = other.v_; return *this; }
+
+	int v_;
+};
+
+int Contado::copias = 0;
+int Contado::construcciones = 0;
+
+TEST(Movimiento, ConstructorYAsignacion) {
+	aed2::map<int, std::string> dicc;
+	llenarCincoElementos(dicc);
+	auto it = dicc.find(3);
+
+	aed2::map<int, std::string> movido(std::move(dicc));
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_EQ(movido.size(), 5);
+	EXPECT_EQ(it->second, "tres");
+	EXPECT_EQ(movido.erase(it)->first, 4);
+
+	aed2::map<int, std::string> asignado;
+	asignado.insert({10, "diez"});
+	asignado = std::move(movido);
+	EXPECT_TRUE(movido.empty());
+	EXPECT_EQ(asignado.size(), 4);
+	EXPECT_EQ(asignado.find(10), asignado.end());
+
+	// los diccionarios movidos se pueden seguir usando
+	movido.insert({1, "uno"});
+	EXPECT_EQ(movido.at(1), "uno");
+}
+
+/** @brief Comparador cuyo swap puede lanzar excepciones */
+struct MenorQueLanza {
+	MenorQueLanza() = default;
+	MenorQueLanza(const MenorQueLanza&) noexcept(false) {}
+	MenorQueLanza& operator=(const MenorQueLanza&) noexcept(false) { return *this; }
+	bool operator()(int a, int b) const { return a < b; }
+};
+
+TEST(Movimiento, SinExcepciones) {
+	static_assert(std::is_nothrow_move_constructible<aed2::map<int, int>>::value);
+	static_assert(std::is_nothrow_move_assignable<aed2::map<int, int>>::value);
+	static_assert(std::is_nothrow_swappable<aed2::map<int, int>>::value);
+	static_assert(std::is_nothrow_move_constructible<aed2::btree_map<int, int>>::value);
+	static_assert(std::is_nothrow_move_assignable<aed2::btree_map<int, int>>::value);
+	static_assert(std::is_nothrow_swappable<aed2::btree_map<int, int>>::value);
+	static_assert(std::is_nothrow_move_constructible<aed2::flat_map<int, int>>::value);
+	static_assert(std::is_nothrow_move_assignable<aed2::flat_map<int, int>>::value);
+	static_assert(std::is_nothrow_swappable<aed2::flat_map<int, int>>::value);
+	static_assert(not std::is_nothrow_move_constructible<aed2::map<int, int, MenorQueLanza>>::value);
+	static_assert(not std::is_nothrow_swappable<aed2::map<int, int, MenorQueLanza>>::value);
+	static_assert(not std::is_nothrow_move_constructible<aed2::btree_map<int, int, MenorQueLanza>>::value);
+	static_assert(not std::is_nothrow_move_constructible<aed2::flat_map<int, int, MenorQueLanza>>::value);
+
+	// al crecer, el vector mueve los diccionarios: los iteradores siguen siendo válidos
+	std::vector<aed2::map<int, std::string>> diccs(1);
+	llenarCincoElementos(diccs[0]);
+	auto it = diccs[0].find(3);
+	for(int i = 0; i < 100; ++i) diccs.emplace_back();
+	EXPECT_EQ(it, diccs[0].find(3));
+	EXPECT_EQ(it->second, "tres");
+}
+
+TEST(Movimiento, InsertMueveElValor) {
+	aed2::map<int, std::unique_ptr<int>> dicc;
+	dicc.insert({1, std::unique_ptr<int>(new int(1))});
+	std::pair<const int, std::unique_ptr<int>> valor(2, std::unique_ptr<int>(new int(2)));
+	dicc.insert(dicc.end(), std::move(valor));
+	EXPECT_EQ(valor.second, nullptr);
+	EXPECT_EQ(*dicc.at(2), 2);
+
+	// si la clave existe, el valor no se mueve
+	std::pair<const int, std::unique_ptr<int>> repetido(2, std::unique_ptr<int>(new int(20)));
+	dicc.insert(std::move(repetido));
+	EXPECT_NE(repetido.second, nullptr);
+	EXPECT_EQ(*dicc.at(2), 2);
+}
+
+TEST(Movimiento, Emplace) {
+	aed2::map<int, Contado> dicc;
+	Contado::copias = 0;
+
+	auto it = dicc.emplace(1, 10);
+	EXPECT_EQ(it->second.v_, 10);
+	dicc.emplace(std::piecewise_construct, std::forward_as_tuple(3), std::forward_as_tuple(30));
+	it = dicc.emplace_hint(dicc.find(3), 2, 20);
+	EXPECT_EQ(it->first, 2);
+	it = dicc.emplace(2, 200);
+	EXPECT_EQ(it->second.v_, 20);
+
+	EXPECT_EQ(Contado::copias, 0);
+	EXPECT_EQ(dicc.size(), 3);
+	EXPECT_TRUE(std::is_sorted(dicc.begin(), dicc.end(),
+		[](const std::pair<const int, Contado>& a, const std::pair<const int, Contado>& b) { return a.first < b.first; }));
+}
+
+TEST(Movimiento, TryEmplace) {
+	aed2::map<std::string, Contado> dicc;
+	Contado::copias = 0;
+
+	dicc.try_emplace("uno", 1);
+	Contado::construcciones = 0;
+	auto it = dicc.try_emplace("uno", 100);
+	EXPECT_EQ(Contado::construcciones, 0);
+	EXPECT_EQ(it->second.v_, 1);
+
+	std::string clave("dos");
+	it = dicc.try_emplace(dicc.end(), std::move(clave), 2);
+	EXPECT_EQ(it->first, "dos");
+	EXPECT_EQ(Contado::copias, 0);
+	EXPECT_EQ(dicc.size(), 2);
+}
+
+/////////////////////////////////////////
+// operator[] e insert_or_assign       //
+/////////////////////////////////////////
+
+TEST(UnaSolaBusqueda, OperadorCorchetesComparaUnaVezPorNivel) {
+	size_t comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> dicc(ContadorCompare{&comparaciones});
+	for(int i = 0; i < 1023; ++i) dicc[2 * i] = i;
+
+	// un árbol red-black de 1023 nodos tiene altura a lo sumo 2 * log2(1024) = 20
+	comparaciones = 0;
+	dicc[1] = 1;
+	EXPECT_LE(comparaciones, 21);
+
+	comparaciones = 0;
+	EXPECT_EQ(dicc[1000], 500);
+	EXPECT_LE(comparaciones, 22);
+	EXPECT_EQ(dicc.size(), 1024);
+}
+
+TEST(UnaSolaBusqueda, OperadorCorchetesConstruyeSoloSiFalta) {
+	aed2::map<int, Contado> dicc;
+	dicc[1].v_ = 10;
+	Contado::construcciones = 0;
+	Contado::copias = 0;
+	EXPECT_EQ(dicc[1].v_, 10);
+	EXPECT_EQ(Contado::construcciones, 0);
+	dicc[2];
+	EXPECT_EQ(Contado::construcciones, 1);
+	EXPECT_EQ(Contado::copias, 0);
+}
+
+TEST(UnaSolaBusqueda, InsertOrAssignConClaveYSignificado) {
+	aed2::map<std::string, std::unique_ptr<int>> dicc;
+	auto it = dicc.insert_or_assign("uno", std::unique_ptr<int>(new int(1)));
+	EXPECT_EQ(*it->second, 1);
+	it = dicc.insert_or_assign("uno", std::unique_ptr<int>(new int(10)));
+	EXPECT_EQ(*it->second, 10);
+	EXPECT_EQ(dicc.size(), 1);
+}
+
+////////////////////////////////
+// Comparación de a tres vías //
+////////////////////////////////
+
+/**
+ * Comparador de strings de a tres vías, que cuenta por separado las invocaciones a operator() y a compare().
+ */
+struct ContadorTresVias
+{
+	ContadorTresVias(size_t* menores = nullptr, size_t* tresVias = nullptr) : menores_(menores), tresVias_(tresVias) {}
+
+	bool operator () (const std::string& a, const std::string& b) const
+	{
+		++*menores_;
+		return a < b;
+	}
+
+	int compare(const std::string& a, const std::string& b) const
+	{
+		++*tresVias_;
+		return a.compare(b);
+	}
+
+	size_t* menores_;
+	size_t* tresVias_;
+};
+
+TEST(TresVias, DeteccionDelComparador) {
+	EXPECT_TRUE((aed2::three_way_compare<std::less<std::string>, std::string>::value));
+	EXPECT_TRUE((aed2::three_way_compare<ContadorTresVias, std::string>::value));
+	EXPECT_FALSE((aed2::three_way_compare<std::greater<std::string>, std::string>::value));
+	EXPECT_FALSE((aed2::three_way_compare<ContadorCompare, int>::value));
+}
+
+TEST(TresVias, UnaComparacionPorNivel) {
+	size_t menores = 0, tresVias = 0;
+	aed2::map<std::string, int, ContadorTresVias> dicc(ContadorTresVias{&menores, &tresVias});
+	for(int i = 0; i < 1023; ++i) dicc[std::to_string(1000 + 2 * i)] = i;
+
+	// un árbol red-black de 1023 nodos tiene altura a lo sumo 2 * log2(1024) = 20
+	menores = tresVias = 0;
+	EXPECT_EQ(dicc.find("1500")->second, 250);
+	EXPECT_EQ(dicc.find("1501"), dicc.end());
+	EXPECT_EQ(dicc.lower_bound("1501")->first, "1502");
+	EXPECT_EQ(dicc["1600"], 300);
+	EXPECT_EQ(dicc.insert({"1700", 0})->second, 350);
+	EXPECT_EQ(menores, 0);
+	EXPECT_LE(tresVias, 5 * 20);
+}
+
+TEST(TresVias, LowerBoundSinTresVias) {
+	size_t comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> dicc(ContadorCompare{&comparaciones});
+	for(int i = 0; i < 1023; ++i) dicc[2 * i] = i;
+
+	comparaciones = 0;
+	EXPECT_EQ(dicc.lower_bound(1001)->first, 1002);
+	EXPECT_LE(comparaciones, 20);
+
+	comparaciones = 0;
+	EXPECT_EQ(dicc.find(1002)->second, 501);
+	EXPECT_LE(comparaciones, 21);
+
+	EXPECT_EQ(dicc.lower_bound(-1), dicc.begin());
+	EXPECT_EQ(dicc.lower_bound(3000), dicc.end());
+	EXPECT_EQ(dicc.find(3000), dicc.end());
+}
+
+/////////////////////////
+// Búsqueda heterogénea //
+/////////////////////////
+
+TEST(BusquedaHeterogenea, StringViewYPunteros) {
+	aed2::map<std::string, int, std::less<>> dicc;
+	for(int i = 0; i < 100; ++i) dicc[std::to_string(1000 + 2 * i)] = i;
+
+	std::string_view vista = "1050";
+	EXPECT_EQ(dicc.find(vista)->second, 25);
+	EXPECT_EQ(dicc.find("1051"), dicc.end());
+	EXPECT_EQ(dicc.lower_bound(std::string_view("1051"))->first, "1052");
+	EXPECT_EQ(dicc.lower_bound("2000"), dicc.end());
+	EXPECT_EQ(dicc.at("1100"), 50);
+	dicc.at(vista) = -1;
+	EXPECT_EQ(std::as_const(dicc).at(vista), -1);
+	EXPECT_EQ(std::as_const(dicc).find("1050")->second, -1);
+
+	dicc.erase(vista);
+	dicc.erase("1100");
+	EXPECT_EQ(dicc.size(), 98);
+	EXPECT_EQ(dicc.find(vista), dicc.end());
+	EXPECT_EQ(dicc.find("1100"), dicc.end());
+}
+
+/**
+ * Comparador transparente entre Contado y enteros.
+ */
+struct ContadoMenor
+{
+	using is_transparent = void;
+
+	bool operator () (const Contado& a, const Contado& b) const { return a.v_ < b.v_; }
+	bool operator () (const Contado& a, int b) const { return a.v_ < b; }
+	bool operator () (int a, const Contado& b) const { return a < b.v_; }
+};
+
+TEST(BusquedaHeterogenea, NoConstruyeClaves) {
+	aed2::map<Contado, int, ContadoMenor> dicc;
+	for(int i = 0; i < 100; ++i) dicc.insert({Contado(2 * i), i});
+
+	Contado::construcciones = Contado::copias = 0;
+	EXPECT_EQ(dicc.find(50)->second, 25);
+	EXPECT_EQ(dicc.find(51), dicc.end());
+	EXPECT_EQ(dicc.lower_bound(51)->first.v_, 52);
+	EXPECT_EQ(dicc.at(100), 50);
+	dicc.erase(100);
+	EXPECT_EQ(dicc.find(100), dicc.end());
+	EXPECT_EQ(Contado::construcciones, 0);
+	EXPECT_EQ(Contado::copias, 0);
+	EXPECT_EQ(dicc.size(), 99);
+}
+
+template<class M, class K, class = void>
+struct BuscaCon : std::false_type {};
+
+template<class M, class K>
+struct BuscaCon<M, K, std::void_t<decltype(std::declval<M&>().find(std::declval<const K&>()))>> : std::true_type {};
+
+TEST(BusquedaHeterogenea, SoloConComparadorTransparente) {
+	EXPECT_TRUE((BuscaCon<aed2::map<std::string, int, std::less<>>, std::string_view>::value));
+	EXPECT_FALSE((BuscaCon<aed2::map<std::string, int>, std::string_view>::value));
+	EXPECT_TRUE((BuscaCon<aed2::map<Contado, int, ContadoMenor>, int>::value));
+}
+
+//////////////////////////
+// Búsquedas en lotes   //
+//////////////////////////
+
+TEST(Lotes, ContraFindYLowerBound) {
+	aed2::map<int, int> dicc;
+	std::vector<int> buscadas;
+	std::vector<aed2::map<int, int>::iterator> encontrados;
+	std::vector<aed2::map<int, int>::const_iterator> cotas;
+	EXPECT_EQ(dicc.find_batch(buscadas.begin(), buscadas.end(), encontrados.begin()), encontrados.begin());
+	buscadas = {3, 1, 3};
+	dicc.find_batch(buscadas.begin(), buscadas.end(), std::back_inserter(encontrados));
+	EXPECT_EQ(encontrados, (std::vector<aed2::map<int, int>::iterator>(3, dicc.end())));
+
+	std::mt19937 gen(5);
+	for(int i = 0; i < 2000; ++i) dicc[gen() % 4000] = i;
+	buscadas.clear();
+	for(int i = 0; i < 1000; ++i) buscadas.push_back(int(gen() % 4200) - 100);
+	encontrados.clear();
+	auto fin = dicc.find_batch(buscadas.begin(), buscadas.end(), std::back_inserter(encontrados));
+	*fin = dicc.begin();
+	std::as_const(dicc).lower_bound_batch(buscadas.begin(), buscadas.end(), std::back_inserter(cotas));
+	ASSERT_EQ(encontrados.size(), buscadas.size() + 1);
+	ASSERT_EQ(cotas.size(), buscadas.size());
+	for(size_t i = 0; i < buscadas.size(); ++i) {
+		ASSERT_EQ(encontrados[i], dicc.find(buscadas[i])) << buscadas[i];
+		ASSERT_EQ(cotas[i], dicc.lower_bound(buscadas[i])) << buscadas[i];
+	}
+}
+
+TEST(Lotes, MismasComparacionesSinTresVias) {
+	size_t comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> dicc(ContadorCompare{&comparaciones});
+	for(int i = 0; i < 1000; ++i) dicc[3 * i] = i;
+	std::vector<int> buscadas;
+	for(int i = 0; i < 100; ++i) buscadas.push_back(37 * i % 3100);
+
+	comparaciones = 0;
+	for(int k : buscadas) dicc.find(k);
+	size_t deAUna = comparaciones;
+	comparaciones = 0;
+	std::vector<aed2::map<int, int, ContadorCompare>::iterator> encontrados(buscadas.size());
+	dicc.find_batch(buscadas.begin(), buscadas.end(), encontrados.begin());
+	EXPECT_EQ(comparaciones, deAUna);
+	for(size_t i = 0; i < buscadas.size(); ++i) EXPECT_EQ(encontrados[i], dicc.find(buscadas[i]));
+}
+
+TEST(Lotes, BusquedaHeterogenea) {
+	aed2::map<std::string, int, std::less<>> dicc;
+	for(int i = 0; i < 100; ++i) dicc[std::to_string(1000 + 2 * i)] = i;
+	std::vector<std::string_view> buscadas = {"1050", "1051", "0", "1198", "2000"};
+	std::vector<aed2::map<std::string, int, std::less<>>::iterator> encontrados(buscadas.size());
+	std::vector<aed2::map<std::string, int, std::less<>>::iterator> cotas(buscadas.size());
+	dicc.find_batch(buscadas.begin(), buscadas.end(), encontrados.begin());
+	dicc.lower_bound_batch(buscadas.begin(), buscadas.end(), cotas.begin());
+	EXPECT_EQ(encontrados[0]->second, 25);
+	EXPECT_EQ(encontrados[1], dicc.end());
+	EXPECT_EQ(encontrados[2], dicc.end());
+	EXPECT_EQ(encontrados[3]->second, 99);
+	EXPECT_EQ(encontrados[4], dicc.end());
+	EXPECT_EQ(cotas[1]->first, "1052");
+	EXPECT_EQ(cotas[2], dicc.begin());
+	EXPECT_EQ(cotas[4], dicc.end());
+}
+
+/**
+ * Comparador de Contado que no es transparente.
+ */
+struct ContadoMenorOpaco
+{
+	bool operator () (const Contado& a, const Contado& b) const { return a.v_ < b.v_; }
+};
+
+TEST(Lotes, ConvierteCadaClaveUnaVez) {
+	aed2::map<Contado, int, ContadoMenorOpaco> dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({Contado(2 * i), i});
+	std::vector<int> buscadas;
+	for(int i = 0; i < 100; ++i) buscadas.push_back(37 * i % 2100);
+	std::vector<aed2::map<Contado, int, ContadoMenorOpaco>::iterator> encontrados(buscadas.size());
+
+	Contado::construcciones = Contado::copias = 0;
+	dicc.find_batch(buscadas.begin(), buscadas.end(), encontrados.begin());
+	EXPECT_EQ(Contado::construcciones, int(buscadas.size()));
+	EXPECT_EQ(Contado::copias, 0);
+	for(size_t i = 0; i < buscadas.size(); ++i) EXPECT_EQ(encontrados[i], dicc.find(buscadas[i])) << buscadas[i];
+}
+
+TEST(Lotes, InsercionOrdenadaContraStdMap) {
+	std::mt19937 gen(9);
+	for(int n : {0, 1, 50, 3000}) {
+		aed2::map<int, int> dicc;
+		std::map<int, int> esperado;
+		for(int i = 0; i < n; ++i) {
+			int k = gen() % 10000;
+			dicc.insert({k, i});
+			esperado.insert({k, i});
+		}
+		std::vector<std::pair<int, int>> lote;
+		for(int i = 0; i < 500; ++i) lote.push_back({int(gen() % 10200) - 100, -i});
+		std::sort(lote.begin(), lote.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		dicc.insert_sorted_batch(lote.begin(), lote.end());
+		esperado.insert(lote.begin(), lote.end());
+		ASSERT_TRUE(dicc.verificarRep()) << n;
+		ASSERT_EQ(dicc.size(), esperado.size());
+		ASSERT_TRUE(std::equal(dicc.begin(), dicc.end(), esperado.begin(), esperado.end(),
+		                       [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; })) << n;
+	}
+}
+
+TEST(Lotes, InsercionOrdenadaComparaPoco) {
+	size_t comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> dicc(ContadorCompare{&comparaciones});
+	for(int i = 0; i < (1 << 14); ++i) dicc.insert(dicc.end(), {64 * i, i});
+
+	// 2^12 claves repartidas en 2^14 valores: cada una está a 4 valores de la anterior
+	std::vector<std::pair<int, int>> lote;
+	for(int i = 0; i < (1 << 12); ++i) lote.push_back({256 * i + 1, i});
+	comparaciones = 0;
+	dicc.insert_sorted_batch(lote.begin(), lote.end());
+	EXPECT_LE(comparaciones, (1 << 12) * 10);
+	size_t conDedo = comparaciones;
+
+	for(auto& v : lote) ++v.first;
+	comparaciones = 0;
+	for(auto& v : lote) dicc.insert(v);
+	EXPECT_LT(conDedo, comparaciones);
+	EXPECT_TRUE(dicc.verificarRep());
+
+	// claves al final: cada una cuesta una cantidad constante de comparaciones
+	lote.clear();
+	for(int i = 0; i < 1000; ++i) lote.push_back({(1 << 30) + i, i});
+	comparaciones = 0;
+	dicc.insert_sorted_batch(lote.begin(), lote.end());
+	EXPECT_LE(comparaciones, 3 * 1000);
+	EXPECT_EQ(dicc.size(), (1 << 14) + 2 * (1 << 12) + 1000);
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+TEST(Lotes, InsercionConRangoDesordenadoORepetido) {
+	aed2::map<std::string, int> dicc;
+	dicc["b"] = 1;
+	dicc["d"] = 2;
+	std::vector<std::pair<std::string, int>> lote = {{"c", 3}, {"c", 4}, {"a", 5}, {"d", 6}, {"e", 7}, {"b", 8}};
+	dicc.insert_sorted_batch(lote.begin(), lote.end());
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_EQ(dicc.size(), 5);
+	EXPECT_EQ(dicc.at("a"), 5);
+	EXPECT_EQ(dicc.at("b"), 1);
+	EXPECT_EQ(dicc.at("c"), 3);
+	EXPECT_EQ(dicc.at("d"), 2);
+	EXPECT_EQ(dicc.at("e"), 7);
+}
+
+/////////////////////
+// Memoria por nodo //
+/////////////////////
+
+TEST(MemoriaPorNodo, SinVtableYConColorEnElPadre) {
+	// tres punteros (hijos y padre, con el color en los bits libres) más el valor, alineado
+	EXPECT_EQ((aed2::map<int, int>::node_size()), 3 * sizeof(void*) + 2 * sizeof(int));
+	EXPECT_EQ((aed2::map<char, char>::node_size()), 4 * sizeof(void*));
+	EXPECT_EQ((aed2::map<long, long>::node_size()), 3 * sizeof(void*) + 2 * sizeof(long));
+	EXPECT_EQ((aed2::map<std::string, int>::node_size()), 3 * sizeof(void*) + sizeof(std::pair<const std::string, int>));
+}
+
+TEST(MemoriaPorNodo, ColoresYPadresSobreviven) {
+	// inserciones y borrados en orden creciente rotan en cada paso; si el color pisara al
+	// padre (o viceversa) el recorrido inverso dejaría de coincidir
+	aed2::map<char, char> dicc;
+	for(int i = 0; i < 100; ++i) dicc.insert({static_cast<char>(i), static_cast<char>(i)});
+	for(int i = 0; i < 100; i += 3) dicc.erase(static_cast<char>(i));
+	char esperado = 98;
+	for(auto it = dicc.rbegin(); it != dicc.rend(); ++it) {
+		if(esperado % 3 == 0) --esperado;
+		EXPECT_EQ(it->first, esperado);
+		--esperado;
+	}
+	EXPECT_EQ(dicc.size(), 66);
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+TEST(MemoriaPorNodo, InvarianteLuegoDeInsertarYBorrar) {
+	aed2::map<int, int> dicc;
+	std::vector<int> claves;
+	for(int i = 0; i < 500; ++i) claves.push_back((i * 7919) % 500);
+	for(int k : claves) dicc.insert({k, k});
+	EXPECT_TRUE(dicc.verificarRep());
+	for(size_t i = 0; i < claves.size(); i += 2) {
+		dicc.erase(claves[i]);
+		ASSERT_TRUE(dicc.verificarRep()) << "luego de borrar " << claves[i];
+	}
+	EXPECT_EQ(dicc.size(), 250);
+	for(size_t i = 1; i < claves.size(); i += 2) dicc.erase(claves[i]);
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_EQ(dicc.begin(), dicc.end());
+}
+
+///////////////////////
+// Motor de árbol B+ //
+///////////////////////
+
+// Nodos chicos (4 valores por hoja, 3 claves por nodo interno) para que pocas
+// claves alcancen para partir, redistribuir y fusionar nodos en todos los niveles.
+using BTreeChico = aed2::btree_map<int, int, std::less<int>, 64>;
+
+TEST(BTreeMap, MismaInterfazQueMap) {
+	aed2::btree_map<int, std::string> dicc;
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_EQ(dicc.begin(), dicc.end());
+	dicc[3] = "tres";
+	EXPECT_EQ(dicc.insert({1, "uno"})->second, "uno");
+	EXPECT_EQ(dicc.insert({1, "otro"})->second, "uno");
+	EXPECT_EQ(dicc.try_emplace(2, "dos")->second, "dos");
+	EXPECT_EQ(dicc.insert_or_assign(3, "III")->first, 3);
+	EXPECT_EQ(dicc.at(3), "III");
+	EXPECT_EQ(dicc.size(), 3);
+	EXPECT_EQ(dicc.find(2)->second, "dos");
+	EXPECT_EQ(dicc.find(4), dicc.end());
+	EXPECT_EQ(dicc.lower_bound(0)->first, 1);
+	EXPECT_EQ(dicc.lower_bound(4), dicc.end());
+	dicc.erase(2);
+	EXPECT_EQ(dicc.find(2), dicc.end());
+	EXPECT_EQ(dicc.erase(dicc.begin())->first, 3);
+	EXPECT_EQ(dicc.size(), 1);
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+TEST(BTreeMap, InsertarConHint) {
+	BTreeChico dicc;
+	// hint en end() con claves crecientes: siempre es un buen hint
+	for(int i = 0; i < 200; ++i) dicc.insert(dicc.end(), {2 * i, i});
+	// hint en la posición exacta (el sucesor)
+	for(int i = 0; i < 200; ++i) {
+		auto it = dicc.insert(dicc.lower_bound(2 * i + 1), {2 * i + 1, i});
+		ASSERT_EQ(it->first, 2 * i + 1);
+	}
+	// hint malo: se ignora
+	EXPECT_EQ(dicc.insert(dicc.begin(), {1000, 0})->first, 1000);
+	EXPECT_EQ(dicc.insert(dicc.begin(), {5, 0})->second, 2);
+	EXPECT_EQ(dicc.size(), 401);
+	EXPECT_TRUE(dicc.verificarRep());
+	int esperado = 0;
+	for(auto& p : dicc) {
+		if(esperado == 400) esperado = 1000;
+		EXPECT_EQ(p.first, esperado++);
+	}
+}
+
+TEST(BTreeMap, RecorridosEnAmbosSentidos) {
+	BTreeChico dicc;
+	for(int i = 0; i < 100; ++i) dicc[(i * 37) % 100] = i;
+	int esperado = 99;
+	for(auto it = dicc.rbegin(); it != dicc.rend(); ++it) EXPECT_EQ(it->first, esperado--);
+	auto it = dicc.end();
+	for(int i = 99; i >= 0; --i) EXPECT_EQ((--it)->first, i);
+	EXPECT_EQ(it, dicc.begin());
+	EXPECT_EQ(std::distance(dicc.cbegin(), dicc.cend()), 100);
+}
+
+TEST(BTreeMap, ContraStdMap) {
+	BTreeChico dicc;
+	std::map<int, int> modelo;
+	std::mt19937 gen(7);
+	for(int paso = 0; paso < 5000; ++paso) {
+		int k = gen() % 300;
+		switch(gen() % 4) {
+		case 0:
+		case 1:
+			ASSERT_EQ(dicc.insert({k, paso})->second, modelo.insert({k, paso}).first->second);
+			break;
+		case 2: {
+			auto it = dicc.find(k);
+			ASSERT_EQ(it == dicc.end(), modelo.count(k) == 0);
+			if(it != dicc.end()) {
+				auto sig = dicc.erase(it);
+				auto sigModelo = modelo.erase(modelo.find(k));
+				ASSERT_EQ(sig == dicc.end(), sigModelo == modelo.end());
+				if(sig != dicc.end()) {
+					EXPECT_EQ(sig->first, sigModelo->first);
+				}
+			}
+			break;
+		}
+		default: {
+			auto it = dicc.lower_bound(k);
+			auto itModelo = modelo.lower_bound(k);
+			ASSERT_EQ(it == dicc.end(), itModelo == modelo.end());
+			if(it != dicc.end()) {
+				EXPECT_EQ(it->first, itModelo->first);
+			}
+		}
+		}
+		ASSERT_TRUE(dicc.verificarRep()) << "paso " << paso;
+		ASSERT_EQ(dicc.size(), modelo.size());
+	}
+	EXPECT_TRUE(std::equal(dicc.begin(), dicc.end(), modelo.begin(), modelo.end()));
+	while(not dicc.empty()) {
+		dicc.erase(dicc.begin());
+		ASSERT_TRUE(dicc.verificarRep());
+	}
+}
+
+TEST(BTreeMap, CopiaMovimientoYSwap) {
+	BTreeChico dicc;
+	for(int i = 0; i < 300; ++i) dicc[i] = -i;
+	BTreeChico copia(dicc);
+	EXPECT_TRUE(copia.verificarRep());
+	EXPECT_EQ(copia, dicc);
+	copia[300] = 0;
+	EXPECT_NE(copia, dicc);
+	EXPECT_LT(dicc, copia);
+
+	BTreeChico movido(std::move(copia));
+	EXPECT_TRUE(copia.empty());
+	EXPECT_EQ(movido.size(), 301);
+	EXPECT_TRUE(movido.verificarRep());
+
+	copia = dicc;
+	EXPECT_EQ(copia, dicc);
+	swap(copia, movido);
+	EXPECT_EQ(copia.size(), 301);
+	EXPECT_EQ(movido.size(), 300);
+	EXPECT_TRUE(copia.verificarRep());
+	EXPECT_TRUE(movido.verificarRep());
+	// end() sigue siendo el de cada diccionario luego del swap
+	EXPECT_EQ(std::prev(copia.end())->first, 300);
+	copia.clear();
+	EXPECT_TRUE(copia.empty());
+	EXPECT_EQ(copia.begin(), copia.end());
+}
+
+/**
+ * @brief Allocator que cuenta los bloques vivos y lanza std::bad_alloc cuando se
+ * agotan los pedidos permitidos (si *permitidos_ es negativo, nunca falla).
+ */
+template<class T>
+struct FallaAllocator
+{
+	using value_type = T;
+
+	FallaAllocator(long* vivos, long* permitidos) : vivos_( vivos ), permitidos_( permitidos ) {}
+
+	template<class U>
+	FallaAllocator(const FallaAllocator<U>& other) : vivos_( other.vivos_ ), permitidos_( other.permitidos_ ) {}
+
+	T* allocate(size_t n)
+	{
+		if(*permitidos_ == 0) throw std::bad_alloc();
+		if(*permitidos_ > 0) --*permitidos_;
+		T* res = std::allocator<T>().allocate(n);
+		++*vivos_;
+		return res;
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		--*vivos_;
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	long* vivos_;
+	long* permitidos_;
+};
+
+template<class T, class U>
+bool operator == (const FallaAllocator<T>& a, const FallaAllocator<U>& b)
+{ return a.vivos_ == b.vivos_; }
+
+template<class T, class U>
+bool operator != (const FallaAllocator<T>& a, const FallaAllocator<U>& b)
+{ return not (a == b); }
+
+TEST(BTreeMap, FallaDelAllocatorNoModifica) {
+	using Alloc = FallaAllocator<std::pair<const int, int>>;
+	long vivos = 0, permitidos = -1;
+	{
+		aed2::btree_map<int, int, std::less<int>, 64, Alloc> dicc(std::less<int>{}, Alloc(&vivos, &permitidos));
+		// cada inserción falla en cada uno de sus pedidos antes de lograrse: las divisiones
+		// pasan por la raíz (con pocas claves) y por varios niveles a la vez (con muchas)
+		for(int i = 0; i < 400; ++i) {
+			int k = (i * 37) % 400;
+			for(long intento = 0; ; ++intento) {
+				long vivosAntes = vivos;
+				permitidos = intento;
+				try {
+					dicc.insert({k, -k});
+					break;
+				} catch(const std::bad_alloc&) {
+					ASSERT_EQ(dicc.size(), size_t(i));
+					ASSERT_EQ(vivos, vivosAntes);
+					ASSERT_EQ(dicc.find(k), dicc.end());
+					ASSERT_TRUE(dicc.verificarRep());
+				}
+			}
+			permitidos = -1;
+		}
+		EXPECT_EQ(dicc.size(), 400);
+		for(int k = 0; k < 400; ++k) ASSERT_EQ(dicc.at(k), -k);
+	}
+	EXPECT_EQ(vivos, 0);
+}
+
+TEST(BTreeMap, NodosDelTamanioPedido) {
+	EXPECT_LE((aed2::btree_map<int, int>::node_size()), 256);
+	EXPECT_GE((aed2::btree_map<int, int>::leaf_capacity()), 16);
+	EXPECT_EQ(BTreeChico::leaf_capacity(), 4);
+}
+
+TEST(BTreeMap, DeteccionDeBusquedaVectorial) {
+	EXPECT_TRUE((aed2::simd_key_search<int, std::less<int>>::value));
+	EXPECT_TRUE((aed2::simd_key_search<std::uint64_t, std::less<>>::value));
+	EXPECT_FALSE((aed2::simd_key_search<int, std::greater<int>>::value));
+	EXPECT_FALSE((aed2::simd_key_search<short, std::less<short>>::value));
+	EXPECT_FALSE((aed2::simd_key_search<std::string, std::less<std::string>>::value));
+}
+
+TEST(BTreeMap, ConteoVectorialConPaso) {
+	using Busqueda = aed2::simd_key_search<std::uint32_t, std::less<std::uint32_t>>;
+	// claves en las posiciones pares, intercaladas con basura en las impares
+	std::vector<std::uint32_t> k;
+	for(std::uint32_t i = 0; i < 37; ++i) {
+		k.push_back(i * 0x07000000u);
+		k.push_back(~i);
+	}
+	for(size_t n = 0; n <= 37; ++n) {
+		for(std::uint32_t x : {0u, 1u, 0x07000000u, 0x80000000u, 0xFC000000u, 0xFFFFFFFFu}) {
+			size_t menores = 0, noMayores = 0;
+			for(size_t i = 0; i < n; ++i) {
+				menores += k[2 * i] < x;
+				noMayores += k[2 * i] <= x;
+			}
+			ASSERT_EQ(Busqueda::menores<2>(k.data(), n, x), menores) << n << " " << x;
+			ASSERT_EQ(Busqueda::noMayores<2>(k.data(), n, x), noMayores) << n << " " << x;
+		}
+	}
+}
+
+template <typename K>
+void contraStdMapConClavesExtremas() {
+	aed2::btree_map<K, int> dicc;
+	std::map<K, int> esperado;
+	std::mt19937_64 gen(11);
+	// las sumas se hacen sin signo: dan la vuelta en lugar de desbordar
+	using U = std::make_unsigned_t<K>;
+	std::vector<K> extremos = {std::numeric_limits<K>::min(), std::numeric_limits<K>::max(), K(0), K(1), K(-1),
+	                           K(K(1) << (8 * sizeof(K) - 1)), K(~(K(1) << (8 * sizeof(K) - 1)))};
+	for(int i = 0; i < 3000; ++i) {
+		K k = i % 10 == 0 ? K(U(extremos[i / 10 % extremos.size()]) + U(i / 70)) : K(gen());
+		dicc.insert({k, i});
+		esperado.insert({k, i});
+	}
+	ASSERT_TRUE(dicc.verificarRep());
+	for(int i = 0; i < 3000; ++i) {
+		K k = i < 100 ? K(U(extremos[i % extremos.size()]) - U(i / 7)) : K(gen());
+		if(i % 2 == 0 and i >= 100) k = std::next(esperado.begin(), i % esperado.size())->first;
+		auto it = dicc.lower_bound(k);
+		auto esp = esperado.lower_bound(k);
+		if(esp == esperado.end()) {
+			ASSERT_EQ(it, dicc.end());
+		} else {
+			ASSERT_NE(it, dicc.end());
+			ASSERT_EQ(it->first, esp->first);
+			ASSERT_EQ(it->second, esp->second);
+		}
+		ASSERT_EQ(dicc.find(k) == dicc.end(), esperado.find(k) == esperado.end());
+	}
+}
+
+TEST(BTreeMap, BusquedaVectorialContraStdMap) {
+	contraStdMapConClavesExtremas<std::int32_t>();
+	contraStdMapConClavesExtremas<std::uint32_t>();
+	contraStdMapConClavesExtremas<std::int64_t>();
+	contraStdMapConClavesExtremas<std::uint64_t>();
+}
+
+//////////////////////
+// Carga ordenada   //
+//////////////////////
+
+TEST(CargaOrdenada, ArbolValidoParaTodoTamanio) {
+	std::vector<std::pair<int, int>> valores;
+	for(int n = 0; n < 300; ++n) {
+		aed2::map<int, int> dicc(aed2::sorted_unique, valores.begin(), valores.end());
+		ASSERT_TRUE(dicc.verificarRep()) << "n = " << n;
+		ASSERT_EQ(dicc.size(), n);
+		ASSERT_TRUE(std::equal(dicc.begin(), dicc.end(), valores.begin(), valores.end(),
+		                       [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+		valores.push_back({3 * n, n});
+	}
+}
+
+TEST(CargaOrdenada, RangoOrdenadoNoInserta) {
+	size_t comparaciones = 0;
+	std::vector<std::pair<int, int>> valores;
+	for(int i = 0; i < 1000; ++i) valores.push_back({i, -i});
+
+	// la única pasada para verificar el orden hace n - 1 comparaciones
+	aed2::map<int, int, ContadorCompare> dicc(valores.begin(), valores.end(), ContadorCompare{&comparaciones});
+	EXPECT_EQ(comparaciones, 999);
+	EXPECT_TRUE(dicc.verificarRep());
+
+	comparaciones = 0;
+	aed2::map<int, int, ContadorCompare> etiquetado(aed2::sorted_unique, valores.begin(), valores.end(),
+	                                                ContadorCompare{&comparaciones});
+	EXPECT_EQ(comparaciones, 0);
+	EXPECT_TRUE(etiquetado.verificarRep());
+
+	// el árbol armado sigue funcionando como cualquier otro
+	for(int i = 0; i < 1000; i += 3) etiquetado.erase(i);
+	for(int i = 1000; i < 1100; ++i) etiquetado.insert({i, i});
+	EXPECT_TRUE(etiquetado.verificarRep());
+	EXPECT_EQ(etiquetado.size(), 666 + 100);
+}
+
+TEST(CargaOrdenada, RangoDesordenadoOConRepetidos) {
+	std::vector<std::pair<int, std::string>> valores = {{1, "uno"}, {3, "tres"}, {2, "dos"}, {3, "otro"}};
+	aed2::map<int, std::string> dicc(valores.begin(), valores.end());
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_EQ(dicc.size(), 3);
+	EXPECT_EQ(dicc.at(3), "tres");
+}
+
+TEST(CargaOrdenada, UnSoloPedidoDeMemoria) {
+	using Alloc = ContadorAllocator<std::pair<const int, int>>;
+	size_t pedidos = 0;
+	std::vector<std::pair<int, int>> valores;
+	for(int i = 0; i < 10000; ++i) valores.push_back({i, i});
+	aed2::map<int, int, std::less<int>, Alloc> dicc(aed2::sorted_unique, valores.begin(), valores.end(),
+	                                                std::less<int>{}, Alloc(&pedidos));
+	// un slab con todos los nodos (más el del vector de slabs del pool)
+	EXPECT_LE(pedidos, 2);
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+/**
+ * @brief Significado cuya copia lanza una excepción si su valor es el de \P{explosivo}.
+ */
+struct Explosivo
+{
+	static int explosivo;
+
+	Explosivo(int v) : v_( v ) {}
+
+	Explosivo(const Explosivo& other) : v_( other.v_ )
+	{ if(v_ == explosivo) throw std::runtime_error("copia"); }
+
+	int v_;
+};
+
+int Explosivo::explosivo = -1;
+
+TEST(CargaOrdenada, ExcepcionAlCopiar) {
+	std::vector<std::pair<int, Explosivo>> valores;
+	for(int i = 0; i < 100; ++i) valores.push_back({i, Explosivo(i)});
+	Explosivo::explosivo = 37;
+	EXPECT_THROW((aed2::map<int, Explosivo>(aed2::sorted_unique, valores.begin(), valores.end())), std::runtime_error);
+	Explosivo::explosivo = -1;
+}
+
+//////////////////
+// Serialización //
+//////////////////
+
+/**
+ * @brief Significado trivialmente copiable, que se serializa con su representación en memoria.
+ */
+struct Punto
+{
+	double x, y;
+
+	bool operator==(const Punto& other) const { return x == other.x and y == other.y; }
+};
+
+template<class M>
+M idaYVuelta(const M& dicc, aed2::serial_encoding cod)
+{
+	std::stringstream datos;
+	dicc.serialize(datos, cod);
+	M res;
+	res.insert({typename M::key_type(), typename M::mapped_type()});
+	res.deserialize(datos);
+	EXPECT_EQ(datos.peek(), std::char_traits<char>::eof());
+	return res;
+}
+
+TEST(Serializacion, IdaYVuelta) {
+	for(auto cod : {aed2::serial_encoding::fixed, aed2::serial_encoding::varint}) {
+		aed2::map<int, int> enteros;
+		aed2::map<std::string, std::string> cadenas;
+		aed2::map<long long, Punto> puntos;
+		EXPECT_TRUE(idaYVuelta(enteros, cod).empty());
+		std::mt19937 gen(61);
+		for(int i = 0; i < 20000; ++i) {
+			int k = static_cast<int>(gen());
+			enteros.insert({k, -k});
+			cadenas.insert({std::to_string(k), std::string(gen() % 100, 'a' + i % 26)});
+			puntos.insert({static_cast<long long>(k) * k * (k % 2 ? 1 : -1), Punto{k / 2.0, -1.0 * i}});
+		}
+		for(int k : {std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), 0}) enteros.insert({k, k});
+		auto e = idaYVuelta(enteros, cod);
+		EXPECT_TRUE(e.verificarRep());
+		EXPECT_EQ(e, enteros);
+		auto c = idaYVuelta(cadenas, cod);
+		EXPECT_TRUE(c.verificarRep());
+		EXPECT_EQ(c, cadenas);
+		auto p = idaYVuelta(puntos, cod);
+		EXPECT_TRUE(p.verificarRep());
+		EXPECT_TRUE(std::equal(p.begin(), p.end(), puntos.begin(), puntos.end()));
+	}
+}
+
+TEST(Serializacion, VariosDiccionariosEnUnStream) {
+	aed2::map<int, int, std::less<int>, std::allocator<std::pair<const int, int>>, aed2::subtree_size> a, b;
+	for(int i = 0; i < 100000; ++i) a.insert({i, i});
+	for(int i = 0; i < 10; ++i) b.insert({-i, i});
+	std::stringstream datos;
+	a.serialize(datos);
+	b.serialize(datos, aed2::serial_encoding::fixed);
+	datos << "fin";
+	decltype(a) a2, b2;
+	a2.deserialize(datos);
+	b2.deserialize(datos);
+	std::string resto;
+	datos >> resto;
+	EXPECT_EQ(a2, a);
+	EXPECT_EQ(b2, b);
+	EXPECT_EQ(resto, "fin");
+	EXPECT_TRUE(a2.verificarRep());
+	EXPECT_EQ(a2.nth(54321)->first, 54321);
+}
+
+TEST(Serializacion, VarintComprimeClavesConsecutivas) {
+	aed2::map<int, int> dicc;
+	for(int i = 0; i < 100000; ++i) dicc.insert({1000000 + 3 * i, i % 64 - 32});
+	std::stringstream fijo, varint;
+	dicc.serialize(fijo, aed2::serial_encoding::fixed);
+	dicc.serialize(varint, aed2::serial_encoding::varint);
+	// diferencias de 3 y significados entre -32 y 31: un byte cada uno
+	EXPECT_LT(varint.str().size(), 2 * dicc.size() + 1000);
+	EXPECT_GT(fijo.str().size(), 8 * dicc.size());
+}
+
+TEST(Serializacion, DatosInvalidos) {
+	aed2::map<int, int> dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({i, i});
+	std::stringstream datos;
+	dicc.serialize(datos, aed2::serial_encoding::fixed);
+	std::string bytes = datos.str();
+	aed2::map<int, int> destino;
+	destino.insert({-1, -1});
+	auto falla = [&](const std::string& entrada) {
+		std::stringstream is(entrada);
+		EXPECT_THROW(destino.deserialize(is), std::runtime_error);
+		// si falla, el diccionario no cambia
+		EXPECT_EQ(destino.size(), 1);
+		EXPECT_EQ(destino.at(-1), -1);
+	};
+	falla("");
+	falla(bytes.substr(0, bytes.size() / 2));
+	falla("AED2SER");
+	std::string desordenado = bytes;
+	// la clave 500 pasa a ser 0; la cabecera ocupa 32 bytes y el bloque empieza con 4 de longitud
+	std::memset(&desordenado[4 + 32 + 500 * 8], 0, sizeof(int));
+	falla(desordenado);
+	std::stringstream otroTipo;
+	aed2::map<int, long long> largos;
+	largos.insert({1, 1});
+	largos.serialize(otroTipo, aed2::serial_encoding::fixed);
+	falla(otroTipo.str());
+	std::stringstream cadenas;
+	aed2::map<std::string, int> conCadenas;
+	conCadenas.insert({"a", 1});
+	conCadenas.serialize(cadenas);
+	falla(cadenas.str());
+	// cantidades corruptas (bytes 28 a 35): no se reserva memoria para ellas antes de leer los valores
+	std::stringstream chico;
+	aed2::map<int, int> dos;
+	dos.insert({1, 1});
+	dos.insert({2, 2});
+	dos.serialize(chico);
+	for(size_t i = 31; i < 36; ++i) {
+		std::string corrupto = chico.str();
+		corrupto[i] = char(~corrupto[i]);
+		falla(corrupto);
+	}
+	std::string enorme = chico.str();
+	uint64_t cantidad = 100000000;
+	std::memcpy(&enorme[4 + 24], &cantidad, sizeof(cantidad));
+	falla(enorme);
+}
+
+///////////////////////////
+// Estadísticos de orden //
+///////////////////////////
+
+using MapConTamanio = aed2::map<int, int, std::less<int>, std::allocator<std::pair<const int, int>>, aed2::subtree_size>;
+
+TEST(EstadisticosDeOrden, SinAumentoNoOcupaMemoria) {
+	EXPECT_EQ((aed2::map<int, int>::node_size()), 32);
+	EXPECT_EQ(MapConTamanio::node_size(), 40);
+}
+
+TEST(EstadisticosDeOrden, NthRankEIndex) {
+	MapConTamanio dicc;
+	for(int i = 0; i < 100; ++i) dicc[(i * 37) % 100 * 2] = i;
+	ASSERT_TRUE(dicc.verificarRep());
+	int i = 0;
+	for(auto it = dicc.begin(); it != dicc.end(); ++it, ++i) {
+		EXPECT_EQ(dicc.nth(i), it);
+		EXPECT_EQ(dicc.index(it), i);
+		EXPECT_EQ(dicc.rank(it->first), i);
+		EXPECT_EQ(dicc.rank(it->first + 1), i + 1);
+	}
+	EXPECT_EQ(dicc.nth(100), dicc.end());
+	EXPECT_EQ(dicc.index(dicc.end()), 100);
+	EXPECT_EQ(dicc.rank(-1), 0);
+	EXPECT_EQ(dicc.distance(dicc.find(10), dicc.find(50)), 20);
+	EXPECT_EQ(dicc.distance(dicc.find(50), dicc.find(10)), -20);
+	EXPECT_EQ(dicc.distance(dicc.begin(), dicc.end()), 100);
+}
+
+TEST(EstadisticosDeOrden, SeMantienenContraStdMap) {
+	MapConTamanio dicc;
+	std::map<int, int> modelo;
+	std::mt19937 gen(11);
+	for(int paso = 0; paso < 3000; ++paso) {
+		int k = gen() % 500;
+		if(gen() % 3 == 0) {
+			if(modelo.erase(k) == 1) dicc.erase(k);
+		} else if(gen() % 2 == 0) {
+			dicc.insert({k, paso});
+			modelo.insert({k, paso});
+		} else {
+			dicc.insert(dicc.lower_bound(k), {k, paso});
+			modelo.insert({k, paso});
+		}
+		ASSERT_TRUE(dicc.verificarRep()) << "paso " << paso;
+		size_t rango = std::distance(modelo.begin(), modelo.lower_bound(k));
+		ASSERT_EQ(dicc.rank(k), rango);
+	}
+	MapConTamanio copia(dicc);
+	EXPECT_TRUE(copia.verificarRep());
+	std::vector<std::pair<int, int>> ordenados(modelo.begin(), modelo.end());
+	MapConTamanio cargado(aed2::sorted_unique, ordenados.begin(), ordenados.end());
+	EXPECT_TRUE(cargado.verificarRep());
+	EXPECT_EQ(cargado.nth(modelo.size() / 2)->first, std::next(modelo.begin(), modelo.size() / 2)->first);
+}
+
+/////////////////////////
+// Resúmenes de rangos //
+/////////////////////////
+
+/**
+ * @brief Política que concatena las claves (letras) en orden: un monoide no conmutativo.
+ */
+struct Concatenacion
+{
+	using summary_type = std::string;
+	static std::string identity() { return ""; }
+	static std::string lift(const std::pair<const char, int>& v) { return std::string(1, v.first); }
+	static std::string combine(const std::string& s1, const std::string& s2) { return s1 + s2; }
+};
+
+/**
+ * @brief Política que guarda la suma y el mínimo de los significados, junto con la cantidad de valores.
+ */
+struct SumaYMinimo
+{
+	struct summary_type { long suma; int minimo; size_t cantidad; };
+	static summary_type identity() { return {0, std::numeric_limits<int>::max(), 0}; }
+	static summary_type lift(const std::pair<const int, int>& v) { return {v.second, v.second, 1}; }
+	static summary_type combine(const summary_type& s1, const summary_type& s2)
+	{ return {s1.suma + s2.suma, std::min(s1.minimo, s2.minimo), s1.cantidad + s2.cantidad}; }
+	static size_t size(const summary_type& s) { return s.cantidad; }
+};
+
+using MapConSuma = aed2::map<int, int, std::less<int>, std::allocator<std::pair<const int, int>>, SumaYMinimo>;
+
+TEST(ResumenesDeRangos, RespetaElOrden) {
+	aed2::map<char, int, std::less<char>, std::allocator<std::pair<const char, int>>, Concatenacion> dicc;
+	std::string letras = "qwertyuiopasdfghjklzxcvbnm";
+	for(char c : letras) dicc.insert({c, 0});
+	EXPECT_EQ(dicc.summary(), "abcdefghijklmnopqrstuvwxyz");
+	EXPECT_EQ(dicc.reduce('c', 'h'), "cdefg");
+	EXPECT_EQ(dicc.reduce('a', 'b'), "a");
+	EXPECT_EQ(dicc.reduce('x', '~'), "xyz");
+	EXPECT_EQ(dicc.reduce('h', 'c'), "");
+	EXPECT_EQ(dicc.reduce('d', 'd'), "");
+	for(char c = 'a'; c <= 'z'; c += 2) dicc.erase(c);
+	EXPECT_EQ(dicc.reduce('a', 'k'), "bdfhj");
+}
+
+TEST(ResumenesDeRangos, ContraRecorrido) {
+	MapConSuma dicc;
+	std::mt19937 gen(3);
+	for(int paso = 0; paso < 2000; ++paso) {
+		int k = gen() % 400;
+		if(gen() % 4 == 0) {
+			auto it = dicc.find(k);
+			if(it != dicc.end()) dicc.erase(it);
+		} else {
+			dicc.insert_or_assign(k, static_cast<int>(gen() % 1000) - 500);
+		}
+	}
+	ASSERT_TRUE(dicc.verificarRep());
+	for(int i = 0; i < 200; ++i) {
+		int lo = gen() % 420, hi = gen() % 420;
+		long suma = 0;
+		int minimo = std::numeric_limits<int>::max();
+		for(auto it = dicc.lower_bound(lo); it != dicc.end() and it->first < hi; ++it) {
+			suma += it->second;
+			minimo = std::min(minimo, it->second);
+		}
+		auto r = dicc.reduce(lo, hi);
+		ASSERT_EQ(r.suma, suma);
+		ASSERT_EQ(r.minimo, minimo);
+		ASSERT_EQ(r.cantidad, lo < hi ? dicc.rank(hi) - dicc.rank(lo) : 0);
+	}
+}
+
+TEST(ResumenesDeRangos, ActualizarLuegoDeModificarUnSignificado) {
+	MapConSuma dicc;
+	for(int i = 0; i < 100; ++i) dicc[i] = 1;
+	// operator[] devuelve una referencia: el resumen queda viejo hasta update_summary
+	for(int i = 0; i < 100; ++i) dicc.update_summary(dicc.find(i));
+	EXPECT_EQ(dicc.summary().suma, 100);
+	dicc[50] = 1000;
+	dicc.update_summary(dicc.find(50));
+	EXPECT_EQ(dicc.reduce(40, 60).suma, 1019);
+	dicc.insert_or_assign(10, -5);
+	EXPECT_EQ(dicc.reduce(0, 20).suma, 14);
+	EXPECT_EQ(dicc.summary().minimo, -5);
+	EXPECT_EQ(dicc.nth(50)->second, 1000);
+}
+
+/////////////////////////////////////////
+// Partición y unión de diccionarios //
+/////////////////////////////////////////
+
+/**
+ * @brief Devuelve los valores de \P{dicc} en orden, como pares modificables.
+ */
+template<class M>
+std::vector<std::pair<int, int>> valoresDe(const M& dicc)
+{ return std::vector<std::pair<int, int>>(dicc.begin(), dicc.end()); }
+
+template<class M, class = void>
+struct InsertaConHint : std::false_type {};
+
+template<class M>
+struct InsertaConHint<M, std::void_t<decltype(std::declval<M&>().insert(std::declval<M&>().lower_bound(0),
+                                                                         std::pair<int, int>()))>> : std::true_type {};
+
+template<class V, class = void>
+struct TieneUpperBound : std::false_type {};
+
+template<class V>
+struct TieneUpperBound<V, std::void_t<decltype(std::declval<const V&>().upper_bound(0))>> : std::true_type {};
+
+/**
+ * @brief Aplica a \P{dicc} y a \P{modelo} la misma secuencia de 20000 insert, insert_or_assign y erase al azar,
+ * con las claves que devuelve \P{claveAlAzar}, y compara los resultados de cada operación.  Cada 1000 pasos
+ * verifica el invariante de \P{dicc} y llama a \P{cadaMil}, si no es nula.
+ *
+ * Los resultados se comparan cuando \P{dicc} los informa como bool (o cantidad de borrados); si insert devuelve
+ * un iterador, se verifica su clave, y si erase no devuelve nada sólo se borran claves definidas.  Si \P{dicc}
+ * tiene insert con hint, la mitad de los insert usan como hint el lower_bound de la clave.
+ */
+template<class M, class F>
+void modificarComoStdMap(M& dicc, std::map<int, int>& modelo, unsigned semilla, F claveAlAzar,
+                         std::function<void(int)> cadaMil = nullptr)
+{
+	std::mt19937 gen(semilla);
+	for(int paso = 0; paso < 20000; ++paso) {
+		int k = claveAlAzar(gen);
+		switch(gen() % 3) {
+			case 0: {
+				if constexpr(InsertaConHint<M>::value) {
+					if(gen() % 2 == 0) {
+						auto it = dicc.insert(dicc.lower_bound(k), {k, paso});
+						modelo.insert({k, paso});
+						ASSERT_EQ(it->first, k);
+						break;
+					}
+				}
+				auto res = dicc.insert({k, paso});
+				bool insertado = modelo.insert({k, paso}).second;
+				if constexpr(std::is_same_v<decltype(res), bool>) {
+					ASSERT_EQ(res, insertado);
+				} else {
+					ASSERT_EQ(res->first, k);
+				}
+				break;
+			}
+			case 1: {
+				auto res = dicc.insert_or_assign(k, paso);
+				bool insertado = modelo.insert_or_assign(k, paso).second;
+				if constexpr(std::is_same_v<decltype(res), bool>) {
+					ASSERT_EQ(res, insertado);
+				} else {
+					ASSERT_EQ(res->second, paso);
+				}
+				break;
+			}
+			default:
+				if constexpr(std::is_void_v<decltype(dicc.erase(k))>) {
+					if(modelo.erase(k) == 1) {
+						dicc.erase(k);
+					}
+				} else {
+					ASSERT_EQ(dicc.erase(k), modelo.erase(k));
+				}
+				break;
+		}
+		if(paso % 1000 == 0) {
+			ASSERT_TRUE(dicc.verificarRep()) << "paso " << paso;
+			if(cadaMil) cadaMil(paso);
+		}
+	}
+	ASSERT_TRUE(dicc.verificarRep());
+}
+
+/**
+ * @brief Compara \P{dicc} con \P{modelo}: sus valores en orden y, para cada clave de [\P{desde}, \P{hasta}],
+ * find, lower_bound y (si \P{dicc} lo tiene) upper_bound.
+ */
+template<class V, class S>
+void consultasComoStdMap(const V& dicc, const std::map<int, S>& modelo, int desde, int hasta)
+{
+	ASSERT_EQ(dicc.size(), modelo.size());
+	ASSERT_TRUE(std::equal(dicc.begin(), dicc.end(), modelo.begin(), modelo.end(),
+	                       [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+	for(int k = desde; k <= hasta; ++k) {
+		auto it = dicc.lower_bound(k);
+		auto esperado = modelo.lower_bound(k);
+		ASSERT_EQ(it == dicc.end(), esperado == modelo.end()) << k;
+		if(it != dicc.end()) {
+			ASSERT_EQ(it->first, esperado->first) << k;
+			ASSERT_EQ(it->second, esperado->second) << k;
+		}
+		if constexpr(TieneUpperBound<V>::value) {
+			auto sup = dicc.upper_bound(k);
+			auto supEsperado = modelo.upper_bound(k);
+			ASSERT_EQ(sup == dicc.end(), supEsperado == modelo.end()) << k;
+			if(sup != dicc.end()) {
+				ASSERT_EQ(sup->first, supEsperado->first) << k;
+			}
+		}
+		ASSERT_EQ(dicc.find(k) == dicc.end(), modelo.count(k) == 0) << k;
+	}
+}
+
+TEST(Particion, SplitYJoinParaTodoTamanio) {
+	for(int n = 0; n < 70; ++n) {
+		for(int k = -1; k <= 2 * n + 1; k += 3) {
+			MapConTamanio dicc;
+			for(int i = 0; i < n; ++i) dicc.insert({2 * i, i});
+			MapConTamanio mayores = dicc.split(k);
+			ASSERT_TRUE(dicc.verificarRep()) << n << " " << k;
+			ASSERT_TRUE(mayores.verificarRep()) << n << " " << k;
+			ASSERT_EQ(dicc.size() + mayores.size(), static_cast<size_t>(n));
+			ASSERT_TRUE(dicc.empty() or dicc.rbegin()->first < k);
+			ASSERT_TRUE(mayores.empty() or mayores.begin()->first >= k);
+			dicc.join(std::move(mayores));
+			ASSERT_TRUE(dicc.verificarRep());
+			ASSERT_TRUE(mayores.empty());
+			ASSERT_EQ(dicc.size(), static_cast<size_t>(n));
+			ASSERT_EQ(dicc.nth(n / 2), dicc.find(2 * (n / 2)));
+		}
+	}
+}
+
+TEST(Particion, JoinConValorIntermedioDeAlturasDistintas) {
+	std::mt19937 gen(5);
+	for(int paso = 0; paso < 200; ++paso) {
+		int a = gen() % 300, b = (paso % 4 == 0) ? gen() % 5 : gen() % 3000;
+		if(paso % 2 == 0) std::swap(a, b);
+		aed2::map<int, int> izq, der;
+		for(int i = 0; i < a; ++i) izq.insert({i, i});
+		for(int i = 0; i < b; ++i) der.insert({a + 1 + i, i});
+		izq.join({a, -1}, std::move(der));
+		ASSERT_TRUE(izq.verificarRep()) << a << " " << b;
+		ASSERT_EQ(izq.size(), static_cast<size_t>(a + b + 1));
+		ASSERT_EQ(izq.at(a), -1);
+	}
+}
+
+TEST(Particion, EraseDeRangosContraStdMap) {
+	aed2::map<int, int> dicc;
+	std::map<int, int> modelo;
+	std::mt19937 gen(17);
+	for(int paso = 0; paso < 300; ++paso) {
+		for(int i = 0; i < 20; ++i) {
+			int k = gen() % 1000;
+			dicc.insert({k, paso});
+			modelo.insert({k, paso});
+		}
+		int lo = gen() % 1000, hi = lo + gen() % 100;
+		auto res = dicc.erase(dicc.lower_bound(lo), dicc.lower_bound(hi));
+		modelo.erase(modelo.lower_bound(lo), modelo.lower_bound(hi));
+		ASSERT_TRUE(dicc.verificarRep()) << "paso " << paso;
+		ASSERT_EQ(res, dicc.lower_bound(hi));
+		ASSERT_EQ(valoresDe(dicc), valoresDe(modelo));
+	}
+	dicc.erase(dicc.begin(), dicc.end());
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+TEST(Particion, EraseDeRangoNoBorraDeAUno) {
+	size_t comparaciones = 0;
+	std::vector<std::pair<int, int>> valores;
+	for(int i = 0; i < 100000; ++i) valores.push_back({i, i});
+	aed2::map<int, int, ContadorCompare> dicc(aed2::sorted_unique, valores.begin(), valores.end(),
+	                                          ContadorCompare{&comparaciones});
+	auto first = dicc.find(10), last = dicc.find(99990);
+	comparaciones = 0;
+	dicc.erase(first, last);
+	// dos particiones de a un camino de búsqueda cada una
+	EXPECT_LT(comparaciones, 100);
+	EXPECT_EQ(dicc.size(), 20);
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+TEST(Particion, ExtractRangeCompartePool) {
+	using Alloc = ContadorAllocator<std::pair<const int, std::string>>;
+	size_t pedidos = 0;
+	aed2::map<int, std::string, std::less<int>, Alloc> rango(std::less<int>{}, Alloc(&pedidos));
+	{
+		aed2::map<int, std::string, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&pedidos));
+		for(int i = 0; i < 1000; ++i) dicc.insert({i, std::to_string(i)});
+		size_t pedidos_antes = pedidos;
+		rango = dicc.extract_range(dicc.find(100), dicc.find(900));
+		EXPECT_EQ(pedidos, pedidos_antes);
+		EXPECT_TRUE(dicc.verificarRep());
+		EXPECT_TRUE(rango.verificarRep());
+		EXPECT_EQ(dicc.size(), 200);
+		EXPECT_EQ(rango.size(), 800);
+		// los nodos borrados de uno se reutilizan en el otro
+		dicc.erase(dicc.begin(), dicc.find(50));
+		for(int i = 0; i < 50; ++i) rango.insert({2000 + i, "nuevo"});
+		EXPECT_EQ(pedidos, pedidos_antes);
+	}
+	// el pool sobrevive al diccionario original
+	EXPECT_EQ(rango.begin()->second, "100");
+	EXPECT_EQ(rango.rbegin()->second, "nuevo");
+	rango.clear();
+	for(int i = 0; i < 10; ++i) rango.insert({i, "otra vez"});
+	EXPECT_TRUE(rango.verificarRep());
+}
+
+TEST(Particion, PartesQueCompartenPoolEnHilosDistintos) {
+	aed2::map<int, std::string> dicc;
+	for(int i = 0; i < 2000; ++i) dicc.insert({i, std::to_string(i)});
+	aed2::map<int, std::string> mayores = dicc.split(1000);
+	// cada parte pide y devuelve nodos al almacén compartido desde su hilo
+	auto modificar = [](aed2::map<int, std::string>& parte, int base) {
+		for(int vuelta = 0; vuelta < 20; ++vuelta) {
+			for(int i = 0; i < 500; ++i) parte.erase(base + i);
+			for(int i = 0; i < 500; ++i) parte.insert({base + i, "otra vez"});
+			aed2::map<int, std::string> resto = parte.split(base + 900);
+			parte.join(std::move(resto));
+		}
+	};
+	std::thread hilo([&]{ modificar(mayores, 1000); });
+	modificar(dicc, 0);
+	hilo.join();
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_TRUE(mayores.verificarRep());
+	EXPECT_EQ(dicc.size(), 1000);
+	EXPECT_EQ(mayores.size(), 1000);
+	EXPECT_EQ(dicc.at(0), "otra vez");
+	EXPECT_EQ(mayores.at(1999), "1999");
+}
+
+TEST(Particion, JoinAbsorbeLosNodosSinPedirMemoria) {
+	using Alloc = ContadorAllocator<std::pair<const int, int>>;
+	size_t pedidos = 0;
+	aed2::map<int, int, std::less<int>, Alloc> izq(std::less<int>{}, Alloc(&pedidos));
+	aed2::map<int, int, std::less<int>, Alloc> der(std::less<int>{}, Alloc(&pedidos));
+	for(int i = 0; i < 500; ++i) izq.insert({i, i});
+	for(int i = 600; i < 2000; ++i) der.insert({i, i});
+	for(int i = 1500; i < 2000; ++i) der.erase(i);
+	auto it = der.find(700);
+	size_t pedidos_antes = pedidos;
+	izq.join({550, 0}, std::move(der));
+	EXPECT_EQ(pedidos, pedidos_antes);
+	EXPECT_TRUE(der.empty());
+	EXPECT_TRUE(izq.verificarRep());
+	EXPECT_EQ(it, izq.find(700));
+	// los libres de der pasan a izq
+	for(int i = 3000; i < 3500; ++i) izq.insert({i, i});
+	EXPECT_EQ(pedidos, pedidos_antes);
+	EXPECT_EQ(izq.size(), 1901);
+	der.insert({1, 1});
+	EXPECT_TRUE(der.verificarRep());
+}
+
+TEST(Particion, SpliceEntreDiccionariosIndependientes) {
+	aed2::map<int, std::string> dicc, otro;
+	for(int i = 0; i < 100; ++i) dicc.insert({i, "dicc"});
+	for(int i = 200; i < 300; ++i) otro.insert({i, "otro"});
+	// las claves caen después de todas las de dicc: los valores se mueven a un árbol nuevo
+	dicc.splice(otro, otro.find(250), otro.end());
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_TRUE(otro.verificarRep());
+	EXPECT_EQ(dicc.size(), 150);
+	EXPECT_EQ(otro.size(), 50);
+	EXPECT_EQ(dicc.at(260), "otro");
+	// claves intercaladas y repetidas: las repetidas quedan en otro
+	for(int i = 50; i < 150; i += 2) otro.insert({i, "otro"});
+	dicc.splice(otro);
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_TRUE(otro.verificarRep());
+	EXPECT_EQ(dicc.size(), 225);
+	EXPECT_EQ(otro.size(), 25);
+	EXPECT_EQ(otro.begin()->first, 50);
+	EXPECT_EQ(otro.rbegin()->first, 98);
+	EXPECT_EQ(dicc.at(100), "otro");
+	EXPECT_EQ(dicc.at(60), "dicc");
+}
+
+TEST(Particion, SpliceEntreParticionesMueveNodos) {
+	aed2::map<int, int> dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({i, i});
+	aed2::map<int, int> mayores = dicc.split(500);
+	auto it = mayores.find(800);
+	const int* significado = &it->second;
+	dicc.splice(mayores, mayores.find(700), mayores.find(900));
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_TRUE(mayores.verificarRep());
+	EXPECT_EQ(dicc.size(), 700);
+	EXPECT_EQ(mayores.size(), 300);
+	EXPECT_EQ(&dicc.at(800), significado);
+}
+
+TEST(Particion, ResumenesLuegoDePartirYUnir) {
+	MapConSuma dicc;
+	std::mt19937 gen(23);
+	for(int i = 0; i < 2000; ++i) dicc.insert_or_assign(static_cast<int>(gen() % 5000), static_cast<int>(gen() % 100));
+	for(int paso = 0; paso < 50; ++paso) {
+		int k = gen() % 5000;
+		MapConSuma mayores = dicc.split(k);
+		ASSERT_TRUE(mayores.verificarRep());
+		long suma = 0;
+		for(auto& v : mayores) suma += v.second;
+		ASSERT_EQ(mayores.summary().suma, suma);
+		ASSERT_EQ(mayores.summary().cantidad, mayores.size());
+		dicc.join(std::move(mayores));
+		ASSERT_TRUE(dicc.verificarRep());
+		ASSERT_EQ(dicc.summary().cantidad, dicc.size());
+	}
+}
+
+//////////////////////////////
+// Operaciones de conjuntos //
+//////////////////////////////
+
+/**
+ * @brief Devuelve un diccionario con \P{n} claves al azar entre 0 y \P{rango}, cuyo significado es \P{marca}.
+ */
+template<class M = aed2::map<int, int>>
+M clavesAlAzar(std::mt19937& gen, int n, int rango, int marca) {
+	M res;
+	for(int i = 0; i < n; ++i) res.insert({static_cast<int>(gen() % rango), marca});
+	return res;
+}
+
+TEST(Conjuntos, ContraAlgoritmosDeStd) {
+	std::mt19937 gen(31);
+	for(int paso = 0; paso < 300; ++paso) {
+		int n = gen() % 500, m = (paso % 3 == 0) ? gen() % 10 : gen() % 500, rango = 1 + gen() % 1000;
+		aed2::map<int, int> a = clavesAlAzar(gen, n, rango, 1), b = clavesAlAzar(gen, m, rango, 2);
+		auto va = valoresDe(a), vb = valoresDe(b);
+		auto menor = [](const std::pair<int, int>& x, const std::pair<int, int>& y) { return x.first < y.first; };
+		std::vector<std::pair<int, int>> unidos, comunes, restantes;
+		std::set_union(va.begin(), va.end(), vb.begin(), vb.end(), std::back_inserter(unidos), menor);
+		std::set_intersection(va.begin(), va.end(), vb.begin(), vb.end(), std::back_inserter(comunes), menor);
+		std::set_difference(va.begin(), va.end(), vb.begin(), vb.end(), std::back_inserter(restantes), menor);
+
+		aed2::map<int, int> u = a, i = a, d = a, f = a, otro = b;
+		u.union_with(b);
+		i.intersect_with(b);
+		d.difference(b);
+		f.merge(std::move(otro));
+		for(auto* res : {&u, &i, &d, &f}) ASSERT_TRUE(res->verificarRep()) << "paso " << paso;
+		ASSERT_EQ(valoresDe(u), unidos);
+		ASSERT_EQ(valoresDe(i), comunes);
+		ASSERT_EQ(valoresDe(d), restantes);
+		ASSERT_EQ(valoresDe(f), unidos);
+		ASSERT_TRUE(otro.empty());
+		ASSERT_EQ(valoresDe(b), vb);
+	}
+}
+
+TEST(Conjuntos, ConSiMismo) {
+	aed2::map<int, int> dicc;
+	for(int i = 0; i < 100; ++i) dicc.insert({i, i});
+	dicc.union_with(dicc);
+	dicc.intersect_with(dicc);
+	dicc.merge(std::move(dicc));
+	EXPECT_EQ(dicc.size(), 100);
+	EXPECT_TRUE(dicc.verificarRep());
+	dicc.difference(dicc);
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+/**
+ * Comparador que anota si se lo llamó desde un hilo distinto al principal.
+ */
+struct MenorQueAnotaHilos
+{
+	static std::thread::id principal;
+	static std::atomic<bool> enOtroHilo;
+
+	bool operator () (int a, int b) const {
+		if(std::this_thread::get_id() != principal) enOtroHilo.store(true, std::memory_order_relaxed);
+		return a < b;
+	}
+};
+
+std::thread::id MenorQueAnotaHilos::principal;
+std::atomic<bool> MenorQueAnotaHilos::enOtroHilo{false};
+
+TEST(Conjuntos, ParalelasIgualQueSecuenciales) {
+	using MapEnHilos = aed2::map<int, int, MenorQueAnotaHilos, std::allocator<std::pair<const int, int>>, aed2::subtree_size>;
+	MenorQueAnotaHilos::principal = std::this_thread::get_id();
+	std::mt19937 gen(37);
+	MapEnHilos a = clavesAlAzar<MapEnHilos>(gen, 200000, 1000000, 1);
+	MapEnHilos b = clavesAlAzar<MapEnHilos>(gen, 150000, 1000000, 2);
+	MapEnHilos u = a, i = a, d = a, f = a, otro = b;
+	MapEnHilos up = a, ip = a, dp = a, fp = a, otrop = b;
+	u.union_with(b);
+	i.intersect_with(b);
+	d.difference(b);
+	f.merge(std::move(otro));
+	// se fuerzan varios hilos aunque la máquina tenga uno solo
+	const aed2::parallel_t variosHilos(4);
+	auto usaOtroHilo = [](auto operacion) {
+		MenorQueAnotaHilos::enOtroHilo = false;
+		operacion();
+		return MenorQueAnotaHilos::enOtroHilo.load();
+	};
+	EXPECT_TRUE(usaOtroHilo([&]{ up.union_with(variosHilos, b); }));
+	EXPECT_TRUE(usaOtroHilo([&]{ ip.intersect_with(variosHilos, b); }));
+	EXPECT_TRUE(usaOtroHilo([&]{ dp.difference(variosHilos, b); }));
+	EXPECT_TRUE(usaOtroHilo([&]{ fp.merge(variosHilos, std::move(otrop)); }));
+	for(auto* res : {&up, &ip, &dp, &fp}) EXPECT_TRUE(res->verificarRep());
+	EXPECT_EQ(valoresDe(up), valoresDe(u));
+	EXPECT_EQ(valoresDe(ip), valoresDe(i));
+	EXPECT_EQ(valoresDe(dp), valoresDe(d));
+	EXPECT_EQ(valoresDe(fp), valoresDe(f));
+	EXPECT_EQ(u.size(), d.size() + b.size());
+	EXPECT_EQ(i.size() + d.size(), a.size());
+	EXPECT_EQ(up.nth(up.size() / 2), up.find(u.nth(u.size() / 2)->first));
+}
+
+TEST(Conjuntos, MergeNoPideMemoriaNiMueveValores) {
+	using Alloc = ContadorAllocator<std::pair<const int, int>>;
+	size_t pedidos = 0;
+	aed2::map<int, int, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&pedidos));
+	aed2::map<int, int, std::less<int>, Alloc> otro(std::less<int>{}, Alloc(&pedidos));
+	for(int i = 0; i < 3000; i += 2) dicc.insert({i, 0});
+	for(int i = 0; i < 3000; i += 3) otro.insert({i, 1});
+	const int* significado = &otro.at(9);
+	size_t pedidos_antes = pedidos;
+	dicc.merge(std::move(otro));
+	EXPECT_EQ(pedidos, pedidos_antes);
+	EXPECT_TRUE(otro.empty());
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_EQ(dicc.size(), 2000);
+	// se conservan los valores de dicc y los nodos de otro que no estaban
+	EXPECT_EQ(dicc.at(6), 0);
+	EXPECT_EQ(&dicc.at(9), significado);
+	// los repetidos de otro quedan libres para insertar
+	for(int i = 0; i < 500; ++i) dicc.insert({5000 + i, 2});
+	EXPECT_EQ(pedidos, pedidos_antes);
+}
+
+TEST(Conjuntos, RangosDisjuntosComparanPoco) {
+	size_t comparaciones = 0;
+	std::vector<std::pair<int, int>> menores, mayores;
+	for(int i = 0; i < 100000; ++i) {
+		menores.push_back({i, i});
+		mayores.push_back({100000 + i, i});
+	}
+	using Map = aed2::map<int, int, ContadorCompare>;
+	Map dicc(aed2::sorted_unique, menores.begin(), menores.end(), ContadorCompare{&comparaciones});
+	Map otro(aed2::sorted_unique, mayores.begin(), mayores.end(), ContadorCompare{&comparaciones});
+	Map copia = dicc;
+	comparaciones = 0;
+	dicc.merge(std::move(otro));
+	// un camino de búsqueda por cada nivel del árbol que se parte, en vez de una búsqueda por valor
+	EXPECT_LT(comparaciones, 1000);
+	EXPECT_EQ(dicc.size(), 200000);
+	EXPECT_TRUE(dicc.verificarRep());
+	comparaciones = 0;
+	dicc.difference(copia);
+	// borrar los valores de a uno compararía unas 17 veces por cada uno
+	EXPECT_LT(comparaciones, 3 * 100000);
+	EXPECT_EQ(dicc.begin()->first, 100000);
+	EXPECT_TRUE(dicc.verificarRep());
+}
+
+TEST(Conjuntos, ResumenesLuegoDeOperar) {
+	std::mt19937 gen(41);
+	for(int paso = 0; paso < 30; ++paso) {
+		MapConSuma a = clavesAlAzar<MapConSuma>(gen, gen() % 3000, 5000, 1);
+		MapConSuma b = clavesAlAzar<MapConSuma>(gen, gen() % 3000, 5000, 2);
+		MapConSuma otro = b;
+		switch(paso % 3) {
+			case 0: a.merge(std::move(otro)); break;
+			case 1: a.intersect_with(b); break;
+			default: a.difference(b); break;
+		}
+		ASSERT_TRUE(a.verificarRep());
+		long suma = 0;
+		for(auto& v : a) suma += v.second;
+		ASSERT_EQ(a.summary().suma, suma);
+		ASSERT_EQ(a.summary().cantidad, a.size());
+	}
+}
+
+/////////////////////////////
+// Diccionario concurrente //
+/////////////////////////////
+
+/**
+ * @brief Allocator que cuenta los objetos vivos, para verificar que aed2::concurrent_map libera las versiones viejas.
+ */
+template<class T>
+struct VivosAllocator
+{
+	using value_type = T;
+
+	VivosAllocator(long* vivos) : vivos_( vivos ) {}
+
+	template<class U>
+	VivosAllocator(const VivosAllocator<U>& other) : vivos_( other.vivos_ ) {}
+
+	T* allocate(size_t n)
+	{
+		*vivos_ += n;
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		*vivos_ -= n;
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	long* vivos_;
+};
+
+template<class T, class U>
+bool operator == (const VivosAllocator<T>& a, const VivosAllocator<U>& b)
+{ return a.vivos_ == b.vivos_; }
+
+template<class T, class U>
+bool operator != (const VivosAllocator<T>& a, const VivosAllocator<U>& b)
+{ return not (a == b); }
+
+TEST(Concurrente, ContraStdMap) {
+	aed2::concurrent_map<int, int> dicc;
+	std::map<int, int> modelo;
+	ASSERT_NO_FATAL_FAILURE(modificarComoStdMap(dicc, modelo, 43, [](std::mt19937& gen) { return int(gen() % 2000); }));
+	auto vista = dicc.read();
+	ASSERT_NO_FATAL_FAILURE(consultasComoStdMap(vista, modelo, -1, 2001));
+	for(int k = -1; k <= 2001; ++k) {
+		ASSERT_EQ(vista.contains(k), modelo.count(k) == 1);
+		if(vista.contains(k)) {
+			ASSERT_EQ(vista.at(k), modelo.at(k));
+		}
+	}
+}
+
+TEST(Concurrente, LaVistaVeUnaVersionFija) {
+	aed2::concurrent_map<int, std::string> dicc;
+	for(int i = 0; i < 100; ++i) dicc.insert({i, "viejo"});
+	auto vista = dicc.read();
+	auto it = vista.find(50);
+	for(int i = 0; i < 100; i += 2) dicc.erase(i);
+	dicc.insert_or_assign(51, "nuevo");
+	dicc.insert({1000, "nuevo"});
+	EXPECT_EQ(vista.size(), 100);
+	EXPECT_EQ(it->second, "viejo");
+	EXPECT_EQ(vista.at(51), "viejo");
+	EXPECT_FALSE(vista.contains(1000));
+	{
+		auto actual = dicc.read();
+		EXPECT_EQ(actual.size(), 51);
+		EXPECT_EQ(actual.at(51), "nuevo");
+		EXPECT_FALSE(actual.contains(50));
+	}
+	dicc.clear();
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_EQ(std::distance(vista.begin(), vista.end()), 100);
+}
+
+/**
+ * @brief Significado que cuenta las instancias vivas, para contar los nodos de aed2::concurrent_map.
+ */
+struct Vivo
+{
+	static long vivos;
+
+	Vivo(int v) : v_( v ) { ++vivos; }
+
+	Vivo(const Vivo& other) : v_( other.v_ ) { ++vivos; }
+
+	~Vivo() { --vivos; }
+
+	int v_;
+};
+
+long Vivo::vivos = 0;
+
+TEST(Concurrente, LiberaLasVersionesViejas) {
+	using Alloc = VivosAllocator<std::pair<const int, Vivo>>;
+	long vivos = 0;
+	{
+		aed2::concurrent_map<int, Vivo, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&vivos));
+		for(int i = 0; i < 1000; ++i) dicc.insert({i, Vivo(i)});
+		// sólo quedan los nodos de la versión vigente y los caminos de las dos anteriores
+		EXPECT_LT(Vivo::vivos, 1000 + 100);
+		{
+			auto vista = dicc.read();
+			for(int ronda = 0; ronda < 5; ++ronda) {
+				for(int i = 0; i < 1000; ++i) dicc.insert_or_assign(i, Vivo(ronda));
+			}
+			// la vista retiene su versión y todas las posteriores a ella
+			EXPECT_GT(Vivo::vivos, 5000);
+			EXPECT_EQ(vista.at(10).v_, 10);
+		}
+		dicc.erase(0);
+		dicc.erase(1);
+		EXPECT_LT(Vivo::vivos, 1000 + 100);
+		dicc.clear();
+		dicc.insert({1, Vivo(1)});
+		dicc.insert({2, Vivo(2)});
+		EXPECT_LT(Vivo::vivos, 100);
+	}
+	EXPECT_EQ(Vivo::vivos, 0);
+	EXPECT_EQ(vivos, 0);
+}
+
+TEST(Concurrente, ExcepcionAlCopiarNoModifica) {
+	using Alloc = VivosAllocator<std::pair<const int, Explosivo>>;
+	long vivos = 0;
+	{
+		aed2::concurrent_map<int, Explosivo, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&vivos));
+		for(int i = 0; i < 200; ++i) dicc.insert({2 * i, Explosivo(2 * i)});
+		for(int explosivo = 0; explosivo < 400; explosivo += 3) {
+			Explosivo::explosivo = explosivo;
+			for(int k : {-1, 133, 401, 0, 200, 398}) {
+				try { dicc.insert_or_assign(k, Explosivo(-2)); } catch(const std::runtime_error&) {}
+				try { dicc.erase(k); } catch(const std::runtime_error&) {}
+			}
+			Explosivo::explosivo = -1;
+			ASSERT_TRUE(dicc.verificarRep());
+		}
+		auto vista = dicc.read();
+		for(auto& v : vista) ASSERT_TRUE(v.second.v_ == v.first or v.second.v_ == -2);
+	}
+	EXPECT_EQ(vivos, 0);
+}
+
+TEST(Concurrente, LectoresYEscritoresEnParalelo) {
+	aed2::concurrent_map<int, int> dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({i, 2 * i});
+	std::atomic<bool> terminar{false};
+	std::atomic<bool> error{false};
+	std::vector<std::thread> hilos;
+	for(int h = 0; h < 4; ++h) {
+		hilos.emplace_back([&, h]{
+			std::mt19937 gen(h);
+			while(not terminar.load()) {
+				auto vista = dicc.read();
+				size_t cantidad = 0;
+				int anterior = -1;
+				for(auto& v : vista) {
+					if(v.first <= anterior or v.second != 2 * v.first) error = true;
+					anterior = v.first;
+					++cantidad;
+				}
+				if(cantidad != vista.size() or not vista.contains(0)) error = true;
+				int k = gen() % 4000;
+				auto it = vista.lower_bound(k);
+				if(it != vista.end() and it->first < k) error = true;
+			}
+		});
+	}
+	for(int h = 0; h < 2; ++h) {
+		hilos.emplace_back([&, h]{
+			std::mt19937 gen(100 + h);
+			for(int paso = 0; paso < 20000; ++paso) {
+				int k = 1 + gen() % 4000;
+				if(gen() % 2 == 0) {
+					dicc.insert_or_assign(k, 2 * k);
+				} else {
+					dicc.erase(k);
+				}
+			}
+		});
+	}
+	for(size_t h = 4; h < hilos.size(); ++h) hilos[h].join();
+	terminar = true;
+	for(size_t h = 0; h < 4; ++h) hilos[h].join();
+	EXPECT_FALSE(error.load());
+	EXPECT_TRUE(dicc.verificarRep());
+	EXPECT_TRUE(dicc.contains(0));
+}
+
+TEST(Concurrente, SnapshotSobreviveALasEscrituras) {
+	using Alloc = VivosAllocator<std::pair<const int, Vivo>>;
+	long vivos = 0;
+	{
+		aed2::concurrent_map<int, Vivo, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&vivos));
+		for(int i = 0; i < 1000; ++i) dicc.insert({i, Vivo(i)});
+		auto foto = dicc.snapshot();
+		for(int ronda = 0; ronda < 5; ++ronda) {
+			for(int i = 0; i < 1000; ++i) dicc.insert_or_assign(i, Vivo(ronda));
+		}
+		// a diferencia de una vista, la foto sólo retiene sus propios nodos
+		EXPECT_LT(Vivo::vivos, 2000 + 100);
+		EXPECT_EQ(foto.size(), 1000);
+		EXPECT_EQ(foto.at(10).v_, 10);
+		EXPECT_EQ(dicc.read().at(10).v_, 4);
+		foto.erase(10);
+		EXPECT_TRUE(dicc.contains(10));
+		EXPECT_TRUE(foto.verificarRep());
+		EXPECT_TRUE(dicc.verificarRep());
+	}
+	EXPECT_EQ(Vivo::vivos, 0);
+	EXPECT_EQ(vivos, 0);
+}
+
+TEST(Concurrente, SnapshotsEnOtrosHilos) {
+	aed2::concurrent_map<int, int> dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({i, 0});
+	std::atomic<bool> terminar{false};
+	std::atomic<bool> error{false};
+	std::thread lector([&]{
+		while(not terminar.load()) {
+			// cada ronda redefine las claves en orden creciente, así que una foto ve los significados
+			// de la ronda r en un prefijo y los de la ronda r - 1 en el resto, y no cambia con el tiempo
+			auto foto = dicc.snapshot();
+			int primero = foto.begin()->second;
+			long suma = 0;
+			for(auto& v : foto) {
+				if(v.second != primero and v.second != primero - 1) error = true;
+				primero = v.second;
+				suma += v.second;
+			}
+			std::this_thread::yield();
+			for(auto& v : foto) suma -= v.second;
+			if(suma != 0 or foto.size() != 1000) error = true;
+		}
+	});
+	for(int ronda = 1; ronda <= 20; ++ronda) {
+		auto foto = dicc.snapshot();
+		for(int i = 0; i < 1000; ++i) foto.insert_or_assign(i, ronda);
+		for(int i = 0; i < 1000; ++i) dicc.insert_or_assign(i, ronda);
+	}
+	terminar = true;
+	lector.join();
+	EXPECT_FALSE(error.load());
+}
+
+////////////////////////////
+// Diccionario persistente //
+////////////////////////////
+
+TEST(Persistente, ContraStdMap) {
+	aed2::persistent_map<int, int> dicc;
+	std::map<int, int> modelo;
+	std::vector<std::pair<aed2::persistent_map<int, int>, std::map<int, int>>> fotos;
+	ASSERT_NO_FATAL_FAILURE(modificarComoStdMap(dicc, modelo, 53, [](std::mt19937& gen) { return int(gen() % 2000); },
+	                                            [&](int) { fotos.emplace_back(dicc.snapshot(), modelo); }));
+	ASSERT_NO_FATAL_FAILURE(consultasComoStdMap(dicc, modelo, -1, 2001));
+	for(int k = -1; k <= 2001; ++k) {
+		ASSERT_EQ(dicc.count(k), modelo.count(k));
+	}
+	for(auto& foto : fotos) {
+		ASSERT_TRUE(foto.first.verificarRep());
+		ASSERT_EQ(valoresDe(foto.first), valoresDe(foto.second));
+	}
+}
+
+TEST(Persistente, CopiasIndependientes) {
+	aed2::persistent_map<int, std::string> a;
+	for(int i = 0; i < 100; ++i) a.insert({i, "a"});
+	aed2::persistent_map<int, std::string> b = a;
+	auto it = a.find(50);
+	b.insert_or_assign(50, "b");
+	b.erase(0);
+	b.insert({100, "b"});
+	EXPECT_EQ(it->second, "a");
+	EXPECT_EQ(a.size(), 100);
+	EXPECT_EQ(b.size(), 100);
+	EXPECT_EQ(a.at(50), "a");
+	EXPECT_EQ(b.at(50), "b");
+	EXPECT_FALSE(a.contains(100));
+	EXPECT_FALSE(b.contains(0));
+	a = b;
+	EXPECT_EQ(a.at(50), "b");
+	b.clear();
+	EXPECT_TRUE(b.empty());
+	EXPECT_EQ(a.size(), 100);
+	aed2::persistent_map<int, std::string> c = std::move(a);
+	EXPECT_TRUE(a.empty());
+	EXPECT_EQ(c.size(), 100);
+	swap(b, c);
+	EXPECT_EQ(b.size(), 100);
+	EXPECT_TRUE(c.empty());
+}
+
+TEST(Persistente, CopiaSoloElCamino) {
+	using Alloc = VivosAllocator<std::pair<const int, Vivo>>;
+	long vivos = 0;
+	{
+		aed2::persistent_map<int, Vivo, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&vivos));
+		for(int i = 0; i < 10000; ++i) dicc.insert({i, Vivo(i)});
+		EXPECT_EQ(Vivo::vivos, 10000);
+		std::vector<aed2::persistent_map<int, Vivo, std::less<int>, Alloc>> fotos;
+		for(int i = 0; i < 100; ++i) {
+			fotos.push_back(dicc.snapshot());
+			dicc.insert_or_assign(i * 100, Vivo(-1));
+		}
+		// cada versión agrega, como mucho, un camino (altura < 2 log2 n) más las rotaciones
+		EXPECT_LT(Vivo::vivos, 10000 + 100 * 40);
+		EXPECT_EQ(fotos[37].at(3700).v_, 3700);
+		EXPECT_EQ(fotos[38].at(3700).v_, -1);
+		fotos.clear();
+		EXPECT_EQ(Vivo::vivos, 10000);
+		for(int i = 0; i < 10000; i += 2) dicc.erase(i);
+		EXPECT_EQ(Vivo::vivos, 5000);
+	}
+	EXPECT_EQ(Vivo::vivos, 0);
+	EXPECT_EQ(vivos, 0);
+}
+
+TEST(Persistente, ExcepcionAlCopiarNoModifica) {
+	using Alloc = VivosAllocator<std::pair<const int, Explosivo>>;
+	long vivos = 0;
+	{
+		aed2::persistent_map<int, Explosivo, std::less<int>, Alloc> dicc(std::less<int>{}, Alloc(&vivos));
+		for(int i = 0; i < 200; ++i) dicc.insert({2 * i, Explosivo(2 * i)});
+		auto foto = dicc;
+		for(int explosivo = 0; explosivo < 400; explosivo += 3) {
+			Explosivo::explosivo = explosivo;
+			for(int k : {-1, 133, 401, 0, 200, 398}) {
+				size_t antes = dicc.size();
+				try { dicc.insert_or_assign(k, Explosivo(-2)); } catch(const std::runtime_error&) { ASSERT_EQ(dicc.size(), antes); }
+				try { dicc.erase(k); } catch(const std::runtime_error&) {}
+			}
+			Explosivo::explosivo = -1;
+			ASSERT_TRUE(dicc.verificarRep());
+		}
+		for(auto& v : dicc) ASSERT_TRUE(v.second.v_ == v.first or v.second.v_ == -2);
+		ASSERT_EQ(foto.size(), 200);
+		for(auto& v : foto) ASSERT_EQ(v.second.v_, v.first);
+	}
+	EXPECT_EQ(vivos, 0);
+}
+
+//////////////////////////////
+// Diccionario fragmentado //
+//////////////////////////////
+
+TEST(Fragmentado, ContraStdMap) {
+	aed2::sharded_map<int, int> dicc({100, 200, 300, 1000, 1500});
+	std::map<int, int> modelo;
+	EXPECT_EQ(dicc.shard_count(), 6);
+	// ninguna clave cae en el fragmento [300, 1000) ni en el último
+	auto claveAlAzar = [](std::mt19937& gen) {
+		int k = gen() % 300;
+		return gen() % 2 == 0 ? 1000 + k : k;
+	};
+	ASSERT_NO_FATAL_FAILURE(modificarComoStdMap(dicc, modelo, 47, claveAlAzar));
+	auto vista = dicc.read();
+	ASSERT_NO_FATAL_FAILURE(consultasComoStdMap(vista, modelo, -1, 1600));
+	std::vector<std::pair<int, int>> alReves(std::make_reverse_iterator(vista.end()), std::make_reverse_iterator(vista.begin()));
+	std::reverse(alReves.begin(), alReves.end());
+	EXPECT_EQ(alReves, valoresDe(modelo));
+	for(int k = -1; k <= 1600; ++k) {
+		ASSERT_EQ(vista.contains(k), modelo.count(k) == 1);
+	}
+}
+
+TEST(Fragmentado, LimitesDesdeUnaMuestra) {
+	std::vector<int> muestra;
+	for(int i = 0; i < 1000; ++i) muestra.push_back((i * 7919) % 1000);
+	aed2::sharded_map<int, int> dicc(8, muestra.begin(), muestra.end());
+	EXPECT_EQ(dicc.shard_count(), 8);
+	std::vector<size_t> porFragmento(dicc.shard_count());
+	for(int i = 0; i < 1000; ++i) ++porFragmento[dicc.shard_of(i)];
+	for(size_t cantidad : porFragmento) EXPECT_EQ(cantidad, 125);
+	// muestras chicas o con repetidos dan menos fragmentos
+	std::vector<int> repetidos(100, 5);
+	EXPECT_EQ((aed2::sharded_map<int, int>(8, repetidos.begin(), repetidos.end()).shard_count()), 2);
+	EXPECT_EQ((aed2::sharded_map<int, int>(8, repetidos.begin(), repetidos.begin()).shard_count()), 1);
+}
+
+TEST(Fragmentado, EscritoresEnParalelo) {
+	std::vector<int> limites;
+	for(int i = 1; i < 16; ++i) limites.push_back(i * 1000);
+	aed2::sharded_map<int, std::string> dicc(limites);
+	std::vector<std::thread> hilos;
+	for(int h = 0; h < 8; ++h) {
+		hilos.emplace_back([&, h]{
+			std::mt19937 gen(h);
+			for(int paso = 0; paso < 5000; ++paso) {
+				int k = gen() % 16000;
+				if(k % 8 != h) continue;
+				if(gen() % 4 == 0) {
+					dicc.erase(k);
+				} else {
+					dicc.insert_or_assign(k, std::to_string(k));
+				}
+			}
+		});
+	}
+	hilos.emplace_back([&]{
+		for(int i = 0; i < 50; ++i) {
+			auto vista = dicc.read();
+			int anterior = -1;
+			for(auto& v : vista) {
+				EXPECT_LT(anterior, v.first);
+				EXPECT_EQ(v.second, std::to_string(v.first));
+				anterior = v.first;
+			}
+		}
+	});
+	for(auto& hilo : hilos) hilo.join();
+	EXPECT_TRUE(dicc.verificarRep());
+	auto vista = dicc.read();
+	EXPECT_EQ(static_cast<size_t>(std::distance(vista.begin(), vista.end())), vista.size());
+}
+
 ///////////////////////////
 // Correr todos los test //
 ///////////////////////////
@@ -419,3 +2632,286 @@ TEST_F(BasicMapInstances, MapDeMap) {
 //	::testing::InitGoogleTest(&argc, argv);
 //  return RUN_ALL_TESTS();
 //}
+
+/////////////////////////////
+// Diccionario en archivo //
+/////////////////////////////
+
+TEST(Archivo, ContraStdMap) {
+	aed2::map<int, double> dicc;
+	std::map<int, double> modelo;
+	std::mt19937 gen(59);
+	for(int i = 0; i < 5000; ++i) {
+		int k = gen() % 20000;
+		dicc.insert({k, k / 2.0});
+		modelo.insert({k, k / 2.0});
+	}
+	std::string ruta = ::testing::TempDir() + "aed2_archivo.map";
+	aed2::mapped_map<int, double>::write(ruta, dicc);
+	aed2::mapped_map<int, double> leido(ruta);
+	ASSERT_TRUE(leido.verificarRep());
+	ASSERT_NO_FATAL_FAILURE(consultasComoStdMap(leido, modelo, -1, 20001));
+	EXPECT_TRUE(std::equal(std::make_reverse_iterator(leido.end()), std::make_reverse_iterator(leido.begin()),
+	                       modelo.rbegin(), modelo.rend()));
+	for(int k = -1; k <= 20001; ++k) {
+		ASSERT_EQ(leido.count(k), modelo.count(k));
+		if(modelo.count(k) == 1) {
+			ASSERT_EQ(leido.at(k), modelo.at(k));
+		}
+	}
+	// el archivo se puede cargar otra vez en un aed2::map
+	aed2::map<int, double> copia(aed2::sorted_unique, leido.begin(), leido.end());
+	EXPECT_EQ(valoresDe(copia), valoresDe(modelo));
+	std::remove(ruta.c_str());
+}
+
+TEST(Archivo, DesdeMapAumentado) {
+	MapConTamanio dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({3 * i, -i});
+	std::string ruta = ::testing::TempDir() + "aed2_aumentado.map";
+	aed2::mapped_map<int, int>::write(ruta, dicc);
+	aed2::mapped_map<int, int> leido(ruta);
+	EXPECT_EQ(leido.size(), dicc.size());
+	EXPECT_EQ(valoresDe(leido), valoresDe(dicc));
+	EXPECT_EQ(leido.at(300), -100);
+	std::remove(ruta.c_str());
+}
+
+TEST(Archivo, VacioYMovimiento) {
+	std::string ruta = ::testing::TempDir() + "aed2_vacio.map";
+	std::vector<std::pair<int, int>> nada;
+	aed2::mapped_map<int, int>::write(ruta, nada.begin(), nada.end());
+	aed2::mapped_map<int, int> vacio(ruta);
+	EXPECT_TRUE(vacio.empty());
+	EXPECT_TRUE(vacio.begin() == vacio.end());
+	EXPECT_TRUE(vacio.find(3) == vacio.end());
+	std::vector<std::pair<int, int>> valores = {{1, 10}, {2, 20}, {3, 30}};
+	aed2::mapped_map<int, int>::write(ruta, valores.begin(), valores.end());
+	aed2::mapped_map<int, int> tres(ruta);
+	EXPECT_EQ(vacio.size(), 0);
+	aed2::mapped_map<int, int> movido = std::move(tres);
+	EXPECT_TRUE(tres.empty());
+	EXPECT_EQ(movido.at(2), 20);
+	vacio = std::move(movido);
+	EXPECT_EQ(vacio.size(), 3);
+	EXPECT_EQ(vacio.lower_bound(0)->second, 10);
+	std::remove(ruta.c_str());
+}
+
+TEST(Archivo, FormatoIncompatible) {
+	std::string ruta = ::testing::TempDir() + "aed2_formato.map";
+	EXPECT_THROW((aed2::mapped_map<int, int>(ruta + ".no_existe")), std::system_error);
+	std::vector<std::pair<int, int>> valores = {{1, 10}, {2, 20}, {3, 30}};
+	aed2::mapped_map<int, int>::write(ruta, valores.begin(), valores.end());
+	EXPECT_THROW((aed2::mapped_map<int, long long>(ruta)), std::runtime_error);
+	EXPECT_THROW((aed2::mapped_map<long long, int>(ruta)), std::runtime_error);
+	ASSERT_EQ(::truncate(ruta.c_str(), 80), 0);
+	EXPECT_THROW((aed2::mapped_map<int, int>(ruta)), std::runtime_error);
+	ASSERT_EQ(::truncate(ruta.c_str(), 10), 0);
+	EXPECT_THROW((aed2::mapped_map<int, int>(ruta)), std::runtime_error);
+	std::remove(ruta.c_str());
+}
+
+TEST(Archivo, NodosDaniados) {
+	std::string ruta = ::testing::TempDir() + "aed2_daniado.map";
+	std::vector<std::pair<int, int>> valores;
+	for(int i = 0; i < 1000; ++i) valores.push_back({2 * i, i});
+	aed2::mapped_map<int, int>::write(ruta, valores.begin(), valores.end());
+	// se pisan los nodos (todo lo que sigue a la cabecera) con basura
+	{
+		std::fstream archivo(ruta, std::ios::in | std::ios::out | std::ios::binary);
+		archivo.seekp(64);
+		std::mt19937 gen(83);
+		for(size_t i = 0; i < valores.size() * 2 * sizeof(int); ++i) archivo.put(char(gen()));
+	}
+	aed2::mapped_map<int, int> dicc(ruta);
+	ASSERT_EQ(dicc.size(), valores.size());
+	// las respuestas pueden estar mal, pero las búsquedas terminan dentro del arreglo
+	for(int k = -10; k < 2010; k += 3) {
+		for(auto it : {dicc.lower_bound(k), dicc.upper_bound(k), dicc.find(k)}) {
+			auto pos = std::distance(dicc.begin(), it);
+			ASSERT_TRUE(0 <= pos and pos <= std::ptrdiff_t(dicc.size())) << k;
+		}
+	}
+	std::remove(ruta.c_str());
+}
+
+/////////////////////////
+// Diccionarios planos //
+/////////////////////////
+
+TEST(Plano, ContraStdMap) {
+	aed2::flat_map<int, int> dicc;
+	std::map<int, int> modelo;
+	ASSERT_NO_FATAL_FAILURE(modificarComoStdMap(dicc, modelo, 71, [](std::mt19937& gen) { return int(gen() % 2000); }));
+	// inserciones con hint en la posición exacta
+	for(int k = 0; k < 2000; k += 7) {
+		auto it = dicc.insert(dicc.lower_bound(k), {k, -k});
+		ASSERT_EQ(it->first, k);
+		modelo.insert({k, -k});
+	}
+	ASSERT_TRUE(dicc.verificarRep());
+	ASSERT_NO_FATAL_FAILURE(consultasComoStdMap(dicc, modelo, -1, 2001));
+	EXPECT_TRUE(std::equal(dicc.rbegin(), dicc.rend(), modelo.rbegin(), modelo.rend(),
+			[](auto a, auto b) { return a.first == b.first and a.second == b.second; }));
+}
+
+TEST(Plano, FreezeDeUnMap) {
+	aed2::map<int, std::string> dicc;
+	for(int i = 0; i < 1000; ++i) dicc.insert({(i * 7919) % 1000, std::to_string(i)});
+
+	aed2::flat_map<int, std::string> plano = aed2::freeze(dicc);
+	ASSERT_TRUE(plano.verificarRep());
+	EXPECT_EQ(plano.size(), dicc.size());
+	EXPECT_TRUE(std::equal(plano.begin(), plano.end(), dicc.begin(), dicc.end(),
+			[](auto a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+
+	aed2::flat_map<int, std::string> movido = aed2::freeze(std::move(dicc));
+	EXPECT_TRUE(dicc.empty());
+	EXPECT_EQ(movido, plano);
+	EXPECT_EQ(movido.at(7919 % 1000), "1");
+}
+
+TEST(Plano, ConstructorPorRango) {
+	std::vector<std::pair<int, int>> ordenados = {{1, 10}, {2, 20}, {5, 50}};
+	aed2::flat_map<int, int> a(ordenados.begin(), ordenados.end());
+	aed2::flat_map<int, int> b(aed2::sorted_unique, ordenados.begin(), ordenados.end());
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(valoresDe(a), ordenados);
+
+	// desordenado y con repetidas: queda el primer valor de cada clave, como al insertar de a uno
+	std::vector<std::pair<int, int>> desordenados = {{3, 0}, {1, 1}, {3, 2}, {2, 3}, {1, 4}, {0, 5}};
+	aed2::flat_map<int, int> c(desordenados.begin(), desordenados.end());
+	aed2::map<int, int> modelo(desordenados.begin(), desordenados.end());
+	ASSERT_TRUE(c.verificarRep());
+	EXPECT_EQ(valoresDe(c), valoresDe(modelo));
+}
+
+TEST(Plano, InsercionConHintComparaPoco) {
+	size_t comparaciones = 0;
+	aed2::flat_map<int, int, ContadorCompare> dicc(ContadorCompare{&comparaciones});
+	for(int i = 0; i < 1000; ++i) dicc.insert(dicc.end(), {i, i});
+	EXPECT_LE(comparaciones, 2 * 1000);
+
+	comparaciones = 0;
+	EXPECT_EQ(dicc.insert(dicc.find(500), {500, -1})->second, 500);
+	EXPECT_LE(comparaciones, 20);
+	auto it = dicc.insert(dicc.begin(), {2000, 0});
+	EXPECT_EQ(it, std::prev(dicc.end()));
+	ASSERT_TRUE(dicc.verificarRep());
+}
+
+TEST(Plano, IteradoresYBusquedaHeterogenea) {
+	aed2::flat_map<std::string, int, std::less<>> dicc;
+	for(int i = 0; i < 100; ++i) dicc[std::to_string(1000 + i)] = i;
+	for(auto [clave, significado] : dicc) significado *= 2;
+	for(auto it = dicc.begin(); it != dicc.end(); ++it) it->second += 1;
+
+	EXPECT_EQ(dicc.at(std::string_view("1010")), 21);
+	EXPECT_EQ(dicc.find("1050")->second, 101);
+	EXPECT_EQ(dicc.lower_bound("10505")->first, "1051");
+	dicc.erase("1099");
+	EXPECT_EQ(dicc.rbegin()->first, "1098");
+	const auto& constante = dicc;
+	EXPECT_EQ(std::distance(constante.begin(), constante.end()), 99);
+	EXPECT_EQ((*constante.begin()).second, 1);
+}
+
+/////////////////////////
+// Índices congelados //
+/////////////////////////
+
+TEST(Congelado, TodosLosTamanios) {
+	for(int n = 0; n < 70; ++n) {
+		aed2::map<int, int> dicc;
+		for(int i = 0; i < n; ++i) dicc.insert({2 * i, i});
+		aed2::frozen_map<int, int> congelado(dicc);
+		ASSERT_TRUE(congelado.verificarRep()) << "n " << n;
+		ASSERT_EQ(congelado.size(), dicc.size());
+		ASSERT_EQ(valoresDe(congelado), valoresDe(dicc));
+
+		std::vector<std::pair<int, int>> alReves;
+		for(auto it = congelado.end(); it != congelado.begin();) {
+			--it;
+			alReves.emplace_back(it->first, it->second);
+		}
+		std::reverse(alReves.begin(), alReves.end());
+		ASSERT_EQ(alReves, valoresDe(dicc));
+
+		for(int k = -1; k <= 2 * n + 1; ++k) {
+			auto it = congelado.lower_bound(k);
+			auto esperado = dicc.lower_bound(k);
+			ASSERT_EQ(it == congelado.end(), esperado == dicc.end()) << "n " << n << " k " << k;
+			if(it != congelado.end()) {
+				ASSERT_EQ(it->first, esperado->first);
+			}
+			ASSERT_EQ(congelado.contains(k), k >= 0 and k < 2 * n and k % 2 == 0);
+		}
+	}
+}
+
+TEST(Congelado, DesdeFlatMapConBusquedaHeterogenea) {
+	aed2::flat_map<std::string, int, std::less<>> plano;
+	for(int i = 0; i < 1000; ++i) plano[std::to_string(10000 + 3 * i)] = i;
+	aed2::frozen_map<std::string, int, std::less<>> congelado(plano);
+	ASSERT_TRUE(congelado.verificarRep());
+	EXPECT_EQ(congelado.at("10300"), 100);
+	EXPECT_EQ(congelado.find(std::string_view("10301")), congelado.end());
+	EXPECT_EQ(congelado.lower_bound("10301")->first, "10303");
+	EXPECT_EQ(congelado.lower_bound("2"), congelado.end());
+
+	aed2::frozen_map<std::string, int, std::less<>> movido = std::move(congelado);
+	EXPECT_TRUE(congelado.empty());
+	EXPECT_EQ(congelado.begin(), congelado.end());
+	EXPECT_EQ(movido.size(), 1000);
+	EXPECT_EQ(movido.find("12997")->second, 999);
+}
+
+/**
+ * Significado cuya copia lanza una excepción después de una cantidad dada de copias.
+ */
+struct CopiaQueFalla
+{
+	static int restantes;
+
+	CopiaQueFalla() = default;
+	CopiaQueFalla(const CopiaQueFalla&) { if(restantes-- == 0) throw std::runtime_error("copia"); }
+
+	std::string relleno = std::string(40, 'x');
+};
+
+int CopiaQueFalla::restantes = 0;
+
+TEST(Congelado, ExcepcionAlConstruir) {
+	aed2::map<std::string, CopiaQueFalla> dicc;
+	for(int i = 0; i < 100; ++i) dicc[std::string(30, 'a') + std::to_string(i)];
+	CopiaQueFalla::restantes = 57;
+	EXPECT_THROW((aed2::frozen_map<std::string, CopiaQueFalla>(dicc)), std::runtime_error);
+	CopiaQueFalla::restantes = 1000;
+	aed2::frozen_map<std::string, CopiaQueFalla> congelado(dicc);
+	EXPECT_EQ(congelado.size(), 100);
+}
+
+/**
+ * Significado para el que std::allocator nunca consigue memoria.
+ */
+struct SinMemoria
+{
+	int v;
+};
+
+template<>
+struct std::allocator<SinMemoria>
+{
+	using value_type = SinMemoria;
+
+	SinMemoria* allocate(size_t) { throw std::bad_alloc(); }
+	void deallocate(SinMemoria*, size_t) {}
+};
+
+TEST(Congelado, SinMemoriaParaLosSignificados) {
+	aed2::map<int, SinMemoria> dicc;
+	for(int i = 0; i < 100; ++i) dicc.insert({i, SinMemoria{i}});
+	// el arreglo de claves ya pedido se libera (lo verifica LeakSanitizer)
+	EXPECT_THROW((aed2::frozen_map<int, SinMemoria>(dicc)), std::bad_alloc);
+}